@@ -0,0 +1,107 @@
+/* hash_index against the linear strcmp scans it replaced, at the key shapes and sizes of its
+   adopters: condition codes (KeyCountList), deficiency keys (ResolvedMap) and photo filenames
+   (photo_collection_find). Half the lookups miss, as first-time keys do on insert. */
+#include "hash_index.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LOOKUPS 400000
+
+static volatile size_t g_sink;
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static size_t linear_find(char **keys, size_t count, const char *key) {
+    for (size_t i = 0; i < count; ++i) {
+        if (strcmp(keys[i], key) == 0) {
+            return i;
+        }
+    }
+    return HASH_INDEX_NONE;
+}
+
+static size_t index_find(const HashIndex *index, char **keys, const char *key) {
+    HashIndexProbe probe;
+    hash_index_probe_init(&probe, index, hash_string(key));
+    for (size_t i; (i = hash_index_probe_next(&probe)) != HASH_INDEX_NONE;) {
+        if (strcmp(keys[i], key) == 0) {
+            return i;
+        }
+    }
+    return HASH_INDEX_NONE;
+}
+
+static char **make_keys(const char *format, size_t count, size_t offset) {
+    char **keys = malloc(count * sizeof(*keys));
+    for (size_t i = 0; keys && i < count; ++i) {
+        char key[96];
+        snprintf(key, sizeof(key), format, (unsigned)(i + offset), (unsigned)((i + offset) * 2654435761u));
+        keys[i] = strdup(key);
+    }
+    return keys;
+}
+
+static void free_keys(char **keys, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        free(keys[i]);
+    }
+    free(keys);
+}
+
+static void run(const char *name, const char *format, size_t count) {
+    char **keys = make_keys(format, count, 0);
+    char **misses = make_keys(format, count, count);
+    HashIndex index;
+    hash_index_init(&index);
+    for (size_t i = 0; i < count; ++i) {
+        hash_index_insert(&index, hash_string(keys[i]), i);
+    }
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < count; ++i) {
+        mismatches += linear_find(keys, count, keys[i]) != index_find(&index, keys, keys[i]);
+        mismatches += linear_find(keys, count, misses[i]) != index_find(&index, keys, misses[i]);
+    }
+
+    int64_t start = now_ns();
+    for (size_t n = 0; n < LOOKUPS; ++n) {
+        const char *key = (n & 1) ? misses[(n >> 1) % count] : keys[(n >> 1) % count];
+        g_sink += linear_find(keys, count, key);
+    }
+    int64_t linear_ns = now_ns() - start;
+    start = now_ns();
+    for (size_t n = 0; n < LOOKUPS; ++n) {
+        const char *key = (n & 1) ? misses[(n >> 1) % count] : keys[(n >> 1) % count];
+        g_sink += index_find(&index, keys, key);
+    }
+    int64_t index_ns = now_ns() - start;
+
+    printf("%-22s %5zu keys  linear %8.1f ns  hash_index %6.1f ns  %zu mismatches\n",
+           name, count, (double)linear_ns / LOOKUPS, (double)index_ns / LOOKUPS, mismatches);
+    hash_index_clear(&index);
+    free_keys(keys, count);
+    free_keys(misses, count);
+}
+
+int main(void) {
+    static const size_t code_sizes[] = { 8, 32 };
+    static const size_t large_sizes[] = { 32, 256, 2048 };
+    for (size_t i = 0; i < sizeof(code_sizes) / sizeof(code_sizes[0]); ++i) {
+        run("condition codes", "C%02u", code_sizes[i]);
+    }
+    for (size_t i = 0; i < sizeof(large_sizes) / sizeof(large_sizes[0]); ++i) {
+        run("deficiency keys", "3f6c1a2e-%04x-4b8e-9d1a-%08x:%u", large_sizes[i]);
+    }
+    for (size_t i = 0; i < sizeof(large_sizes) / sizeof(large_sizes[0]); ++i) {
+        run("photo filenames", "SITE PICTURES/CAR %u/IMG_%08x.jpg", large_sizes[i]);
+    }
+    return 0;
+}
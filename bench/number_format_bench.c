@@ -0,0 +1,107 @@
+/* number_format against the printf/strtod calls it replaced: ns per value and output mismatches. */
+#include "number_format.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define VALUE_COUNT 4096
+#define ROUNDS 200
+
+static volatile size_t g_sink;
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* mismatches < 0 marks the libc baseline, which has nothing to be compared against. */
+static void report(const char *name, int64_t ns, long mismatches) {
+    printf("%-24s %8.1f ns/op", name, (double)ns / ((double)VALUE_COUNT * ROUNDS));
+    if (mismatches >= 0) {
+        printf("  %ld mismatches", mismatches);
+    }
+    putchar('\n');
+}
+
+int main(void) {
+    static double amounts[VALUE_COUNT];
+    static int64_t counts[VALUE_COUNT];
+    static char texts[VALUE_COUNT][NUMBER_FORMAT_MAX];
+    srand(42);
+    for (size_t i = 0; i < VALUE_COUNT; ++i) {
+        /* Shaped like report data: spend in cents up to ~$1M, counts up to a few thousand. */
+        amounts[i] = (double)(rand() % 100000000) / 100.0;
+        counts[i] = rand() % 5000;
+        snprintf(texts[i], sizeof(texts[i]), "%.2f", amounts[i]);
+    }
+
+    char ours[NUMBER_FORMAT_MAX];
+    char theirs[NUMBER_FORMAT_MAX];
+    size_t mismatches = 0;
+    for (size_t i = 0; i < VALUE_COUNT; ++i) {
+        format_double_fixed(ours, amounts[i], 2, false);
+        snprintf(theirs, sizeof(theirs), "%.2f", amounts[i]);
+        mismatches += strcmp(ours, theirs) != 0;
+    }
+    int64_t start = now_ns();
+    for (int r = 0; r < ROUNDS; ++r) {
+        for (size_t i = 0; i < VALUE_COUNT; ++i) {
+            g_sink += format_double_fixed(ours, amounts[i], 2, false);
+        }
+    }
+    report("format_double_fixed(2)", now_ns() - start, (long)mismatches);
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; ++r) {
+        for (size_t i = 0; i < VALUE_COUNT; ++i) {
+            g_sink += (size_t)snprintf(theirs, sizeof(theirs), "%.2f", amounts[i]);
+        }
+    }
+    report("snprintf(\"%.2f\")", now_ns() - start, -1);
+
+    mismatches = 0;
+    for (size_t i = 0; i < VALUE_COUNT; ++i) {
+        format_int64(ours, counts[i]);
+        snprintf(theirs, sizeof(theirs), "%lld", (long long)counts[i]);
+        mismatches += strcmp(ours, theirs) != 0;
+    }
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; ++r) {
+        for (size_t i = 0; i < VALUE_COUNT; ++i) {
+            g_sink += format_int64(ours, counts[i]);
+        }
+    }
+    report("format_int64", now_ns() - start, (long)mismatches);
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; ++r) {
+        for (size_t i = 0; i < VALUE_COUNT; ++i) {
+            g_sink += (size_t)snprintf(theirs, sizeof(theirs), "%lld", (long long)counts[i]);
+        }
+    }
+    report("snprintf(\"%lld\")", now_ns() - start, -1);
+
+    mismatches = 0;
+    for (size_t i = 0; i < VALUE_COUNT; ++i) {
+        mismatches += parse_decimal_double(texts[i], NULL) != strtod(texts[i], NULL);
+    }
+    double total = 0.0;
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; ++r) {
+        for (size_t i = 0; i < VALUE_COUNT; ++i) {
+            total += parse_decimal_double(texts[i], NULL);
+        }
+    }
+    report("parse_decimal_double", now_ns() - start, (long)mismatches);
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; ++r) {
+        for (size_t i = 0; i < VALUE_COUNT; ++i) {
+            total += strtod(texts[i], NULL);
+        }
+    }
+    report("strtod", now_ns() - start, -1);
+    g_sink += (size_t)total;
+    return 0;
+}
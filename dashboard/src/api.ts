@@ -6,6 +6,7 @@ import type {
   LocationListResponse,
   LocationSummary,
   MetricsSummary,
+  PhotoSize,
   ReportJobCreateRequest,
   ReportJobCreateResponse,
   ReportJobStatus
@@ -56,6 +57,11 @@ export function fetchAuditDetail(id: string): Promise<AuditDetailResponse> {
   return fetchJSON<AuditDetailResponse>(`/audits/${id}`);
 }
 
+export function photoUrl(auditId: string, photoId: number, size: PhotoSize = 'original'): string {
+  const path = `/audits/${encodeURIComponent(auditId)}/photos/${photoId}`;
+  return buildUrl(size === 'original' ? path : `${path}?size=${size}`);
+}
+
 export function fetchLocations(params: LocationListParams = {}): Promise<LocationListResponse> {
   const search = new URLSearchParams();
   if (params.page && params.page > 0) {
@@ -1,10 +1,10 @@
 import type { Component } from 'solid-js';
 import { For, Match, Show, Switch, createEffect, createMemo, createResource, createSignal, onCleanup } from 'solid-js';
-import { fetchAuditDetail, updateDeficiencyStatus } from '../api';
+import { fetchAuditDetail, photoUrl, updateDeficiencyStatus } from '../api';
 import LoadingIndicator from '../components/LoadingIndicator';
 import ErrorMessage from '../components/ErrorMessage';
 import type { AuditDetailResponse, Deficiency, PhotoAsset } from '../types';
-import { dataUrl, formatArray, formatBoolean, formatDateTime, formatNumber } from '../utils';
+import { formatArray, formatBoolean, formatDateTime, formatNumber } from '../utils';
 
 interface AuditDetailProps {
   auditId: string;
@@ -372,10 +372,10 @@ const AuditDetail: Component<AuditDetailProps> = (props) => {
                         onClick={() => openPreview(index())}
                         aria-label={`Preview ${photo.photo_filename}`}
                       >
-                        <img src={dataUrl(photo.content_type, photo.photo_bytes)} alt={photo.photo_filename} loading="lazy" />
+                        <img src={photoUrl(props.auditId, photo.id, 'thumb')} alt={photo.photo_filename} loading="lazy" />
                       </button>
                       <figcaption>{photo.photo_filename}</figcaption>
-                      <a href={dataUrl(photo.content_type, photo.photo_bytes)} download={photo.photo_filename}>
+                      <a href={photoUrl(props.auditId, photo.id)} download={photo.photo_filename}>
                         Download
                       </a>
                     </figure>
@@ -397,7 +397,7 @@ const AuditDetail: Component<AuditDetailProps> = (props) => {
               <button type="button" class="photo-modal-close" aria-label="Close" onClick={closePreview}>
                 ×
               </button>
-              <img src={dataUrl(photo().content_type, photo().photo_bytes)} alt={photo().photo_filename} />
+              <img src={photoUrl(props.auditId, photo().id, 'preview')} alt={photo().photo_filename} />
               <p>{photo().photo_filename}</p>
             </div>
             <button type="button" class="photo-modal-nav next" aria-label="Next photo" onClick={(event) => { event.stopPropagation(); navigatePreview(1); }}>
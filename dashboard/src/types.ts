@@ -110,10 +110,14 @@ export interface Deficiency {
   resolved_at?: string | null;
 }
 
+export type PhotoSize = 'thumb' | 'preview' | 'original';
+
 export interface PhotoAsset {
+  id: number;
   photo_filename: string;
   content_type: string;
-  photo_bytes: string;
+  size: number;
+  sha256: string | null;
 }
 
 export interface AuditDetailResponse {
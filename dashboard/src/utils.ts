@@ -79,10 +79,6 @@ export function formatFileSize(value: number | null | undefined): string {
   return `${size.toFixed(unitIndex === 0 ? 0 : 1)} ${units[unitIndex]}`;
 }
 
-export function dataUrl(contentType: string, base64: string): string {
-  return `data:${contentType};base64,${base64}`;
-}
-
 export function slugify(value: string): string {
   return value
     .toLowerCase()
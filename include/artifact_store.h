@@ -0,0 +1,42 @@
+#ifndef ARTIFACT_STORE_H
+#define ARTIFACT_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "sha256.h"
+
+/*
+ * Content-addressed storage for finished report artifacts. Blobs are named by the lowercase
+ * hex SHA-256 of their bytes, so identical reports share one copy and a stored blob never
+ * changes. The database keeps only the digest, size and MIME type. Backends implement
+ * ArtifactStoreOps; the directory backend lays blobs out as <root>/<first two hex>/<digest>.
+ */
+
+typedef struct {
+    const char *name;
+    /* Stores data under digest_hex. Must be durable on return and a no-op if already present. */
+    int (*put)(void *state, const char *digest_hex, const unsigned char *data, size_t len, char **error_out);
+    /* Returns a malloc'd path to a local file the caller may read but must not modify or remove. */
+    char *(*local_path)(void *state, const char *digest_hex, char **error_out);
+    void (*close)(void *state);
+} ArtifactStoreOps;
+
+typedef struct {
+    const ArtifactStoreOps *ops;
+    void *state;
+} ArtifactStore;
+
+/* Opens the filesystem backend rooted at root, creating the directory if needed. */
+int artifact_store_open_directory(ArtifactStore *store, const char *root, char **error_out);
+void artifact_store_close(ArtifactStore *store);
+bool artifact_store_is_open(const ArtifactStore *store);
+
+/* Hashes data, stores it and writes the digest to digest_hex. */
+int artifact_store_put(ArtifactStore *store, const unsigned char *data, size_t len, char digest_hex[SHA256_HEX_SIZE], char **error_out);
+char *artifact_store_local_path(ArtifactStore *store, const char *digest_hex, char **error_out);
+
+/* True for exactly 64 lowercase hex characters, which is all a stored digest may contain. */
+bool artifact_digest_is_valid(const char *digest_hex);
+
+#endif /* ARTIFACT_STORE_H */
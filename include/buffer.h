@@ -2,6 +2,7 @@
 #define BUFFER_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 typedef struct {
     char *data;
@@ -11,9 +12,16 @@ typedef struct {
 
 int buffer_init(Buffer *buf);
 void buffer_free(Buffer *buf);
+int buffer_append_bytes(Buffer *buf, const void *data, size_t len);
 int buffer_append_cstr(Buffer *buf, const char *text);
 int buffer_append_char(Buffer *buf, char c);
 int buffer_appendf(Buffer *buf, const char *fmt, ...);
 int buffer_append_json_string(Buffer *buf, const char *text);
+int buffer_append_json_escaped(Buffer *buf, const char *text, size_t len);
+/* Escapes &, <, >, " and ' for HTML text and attribute values; NULL appends nothing. */
+int buffer_append_html_escaped(Buffer *buf, const char *text);
+int buffer_append_int64(Buffer *buf, int64_t value);
+int buffer_append_fixed(Buffer *buf, double value, int precision);
+int buffer_append_double(Buffer *buf, double value);
 
 #endif /* BUFFER_H */
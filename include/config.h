@@ -11,9 +11,20 @@ extern char *g_database_dsn;
 extern char *g_report_output_dir;
 extern char *g_report_assets_dir;
 extern char *g_xai_api_key;
+extern char *g_xai_api_url;
 extern char *g_google_api_key;
 extern char *g_google_region_code;
+extern char *g_google_address_url;
 extern double g_modernization_cost_per_device;
+extern int g_latex_format_enabled;
+extern int g_native_deficiency_pdf;
+extern int g_latex_fragment_cache_mb;
+extern int g_latex_assembly_threads;
+extern int g_narrative_cache_enabled;
+extern int g_narrative_cache_version;
+extern int g_narrative_cache_max_age_days;
+extern int g_narrative_device_batch_size;
+extern int g_narrative_deadline_seconds;
 
 int load_env_file(const char *path);
 
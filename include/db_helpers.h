@@ -2,13 +2,58 @@
 #define DB_HELPERS_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <libpq-fe.h>
 
+typedef enum {
+    AUDIT_PHOTO_ORIGINAL = 0,
+    AUDIT_PHOTO_PREVIEW,
+    AUDIT_PHOTO_THUMB
+} AuditPhotoSize;
+
+/* One audit photo; the strings and bytes point into res and live until audit_photo_clear. */
+typedef struct {
+    PGresult *res;
+    const char *filename;
+    const char *content_type;
+    const char *sha256;
+    /* The size actually returned: smaller renditions fall back to the next larger one that exists. */
+    AuditPhotoSize served;
+    /* Rendering finished, so a fallback is final: the original already fit that size. */
+    bool renditions_done;
+    const unsigned char *data;
+    size_t size;
+} AuditPhoto;
+
+/* Called once per row as rows arrive; return 0 to stop (the rest of the query is cancelled). */
+typedef int (*DbRowFn)(void *ctx, const PGresult *res, int row);
+/* Receives a piece of a document being written out; return 0 to stop. */
+typedef int (*DbWriteFn)(void *ctx, const void *data, size_t len);
+
+/*
+ * Runs a query without materializing its result: rows are fetched in single-row mode, or
+ * batch_rows at a time with chunked-rows mode on libpq 17+, and handed to on_row. Peak
+ * memory is one batch however large the result is. Returns 1 once every row was delivered.
+ */
+int db_stream_rows(PGconn *conn, const char *sql, int n_params, const char *const *params, int result_format,
+                   int batch_rows, DbRowFn on_row, void *ctx, char **error_out);
+
 bool audit_exists(PGconn *conn, const char *uuid);
 bool db_update_deficiency_status(PGconn *conn, const char *uuid, long deficiency_id, bool resolved, char **resolved_at_out, char **error_out);
 bool db_fetch_deficiency_status(PGconn *conn, const char *uuid, long deficiency_id, bool *resolved_out, char **error_out);
 char *db_fetch_audit_list(PGconn *conn, char **error_out);
-char *db_fetch_audit_detail(PGconn *conn, const char *uuid, char **error_out);
+/* Writes the /audits/{uuid} document through write_fn, photos one row at a time. Returns 1 on
+   success, -1 when the audit does not exist (nothing written), 0 on failure. */
+int db_write_audit_detail(PGconn *conn, const char *uuid, DbWriteFn write_fn, void *ctx, char **error_out);
+/* Loads one photo of an audit at the requested size, its bytes only when include_bytes is set.
+   Returns 1 on success, -1 when there is no such photo, 0 on failure. */
+int db_fetch_audit_photo(PGconn *conn, const char *uuid, long photo_id, AuditPhotoSize size, bool include_bytes,
+                         AuditPhoto *out, char **error_out);
+void audit_photo_clear(AuditPhoto *photo);
+/* Deletes photo_blobs rows no audit photo references any more, limited to the given digests
+   unless sha256 is NULL. A blob referenced by a transaction that commits meanwhile makes the
+   foreign key fail the statement instead of losing the blob; callers just retry later. */
+int db_prune_photo_blobs(PGconn *conn, const char *const *sha256, size_t count, long *removed_out, char **error_out);
 char *db_fetch_location_list(PGconn *conn, int page, int page_size, const char *search, const char *sort, char **error_out);
 char *db_fetch_metrics_summary(PGconn *conn, char **error_out);
 
@@ -0,0 +1,26 @@
+#ifndef FRAGMENT_CACHE_H
+#define FRAGMENT_CACHE_H
+
+#include <stddef.h>
+
+#include "buffer.h"
+#include "sha256.h"
+
+/*
+ * Process-wide cache of rendered document fragments keyed by a SHA-256 digest of every
+ * input that went into them, so an unchanged device or chart is copied instead of rendered
+ * again. Memory is bounded with two generations: entries land in the current one, and once
+ * it holds half the limit the previous generation is dropped and the current one takes its
+ * place. Hits in the previous generation are copied forward, so fragments still in use
+ * survive the flip.
+ */
+
+/* Byte budget for cached text; 0 disables the cache and releases every entry. */
+void fragment_cache_set_limit(size_t max_bytes);
+int fragment_cache_enabled(void);
+
+/* Appends the fragment stored under key to out. Returns 1 on a hit, 0 on a miss. */
+int fragment_cache_fetch(const unsigned char key[SHA256_DIGEST_SIZE], Buffer *out);
+void fragment_cache_store(const unsigned char key[SHA256_DIGEST_SIZE], const char *text, size_t len);
+
+#endif /* FRAGMENT_CACHE_H */
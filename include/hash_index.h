@@ -0,0 +1,38 @@
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Open-addressing index over a caller-owned dense array. The index stores only
+ * (hash, position) pairs, so entries keep living in the caller's array (or arena)
+ * in insertion order and key comparison stays with the caller.
+ */
+typedef struct {
+    uint64_t *slots;
+    size_t capacity;
+    size_t count;
+} HashIndex;
+
+typedef struct {
+    const HashIndex *index;
+    uint32_t hash;
+    size_t slot;
+    size_t probes;
+} HashIndexProbe;
+
+#define HASH_INDEX_NONE ((size_t)-1)
+
+void hash_index_init(HashIndex *index);
+void hash_index_clear(HashIndex *index);
+int hash_index_insert(HashIndex *index, uint32_t hash, size_t position);
+
+void hash_index_probe_init(HashIndexProbe *probe, const HashIndex *index, uint32_t hash);
+size_t hash_index_probe_next(HashIndexProbe *probe);
+
+uint32_t hash_string(const char *key);
+uint32_t hash_uint64(uint64_t key);
+
+#endif /* HASH_INDEX_H */
@@ -10,10 +10,24 @@ char *build_success_response(const StringArray *audits);
 char *build_error_response(const char *message);
 void send_http_response(int client_fd, int status_code, const char *status_text, const char *content_type, const void *body, size_t body_len);
 void send_http_json(int client_fd, int status_code, const char *status_text, const char *json_body);
+/* Chunked responses for bodies built incrementally; each returns 0 once the client is gone. */
+int send_http_stream_start(int client_fd, int status_code, const char *status_text, const char *content_type);
+/* 200 attachment response of unknown length, e.g. an archive assembled while it is sent. */
+int send_http_download_stream_start(int client_fd, const char *content_type, const char *filename);
+int send_http_chunk(int client_fd, const void *data, size_t len);
+int send_http_stream_end(int client_fd);
+/* 200 response carrying an ETag (given unquoted). Immutable content is cacheable for a year;
+   anything else must be revalidated on every use. */
+int send_http_tagged(int client_fd, const char *content_type, const char *etag, bool immutable, const void *body, size_t body_len);
+int send_http_not_modified(int client_fd, const char *etag, bool immutable);
 void send_file_download(int client_fd, const char *path, const char *content_type, const char *filename);
 void serve_static_file(int client_fd, const char *path);
 const char *mime_type_for(const char *path);
 bool path_is_safe(const char *path);
 char *http_extract_query_param(const char *query_string, const char *key);
+/* Value of the named request header from the CRLF-separated lines after the request line. */
+char *http_extract_header(const char *header_lines, const char *name);
+/* True when an If-None-Match value lists etag (unquoted) or is "*". */
+bool http_etag_matches(const char *if_none_match, const char *etag);
 
 #endif /* HTTP_H */
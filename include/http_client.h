@@ -0,0 +1,53 @@
+#ifndef HTTP_CLIENT_H
+#define HTTP_CLIENT_H
+
+#include <stddef.h>
+
+/*
+ * Shared outbound HTTP client. One background thread drives a curl multi handle whose
+ * connection cache, DNS cache and TLS sessions outlive individual requests, so calls to
+ * the same host reuse warm keep-alive connections (and multiplex over HTTP/2 when the
+ * server offers it). Requests beyond the per-host connection limit queue inside curl.
+ * Without a running client, requests fall back to a blocking easy transfer.
+ */
+
+typedef struct {
+    long max_host_connections;
+    long max_total_connections;
+} HttpClientConfig;
+
+typedef struct {
+    long status;         /* HTTP status, 0 when no response arrived */
+    long retry_after;    /* Retry-After seconds, 0 when absent */
+    char *body;          /* NUL-terminated, may be NULL */
+    size_t body_length;
+    char *error;         /* transport error, NULL when a response arrived */
+} HttpClientResponse;
+
+typedef struct HttpClientRequest HttpClientRequest;
+
+int http_client_start(const HttpClientConfig *config);
+void http_client_stop(void);
+
+/* Queues a POST (or GET when body is NULL). Headers are "Name: value" strings. */
+HttpClientRequest *http_client_submit(const char *url,
+                                      const char *const *headers,
+                                      size_t header_count,
+                                      const char *body,
+                                      size_t body_length,
+                                      long timeout_seconds);
+int http_client_is_done(HttpClientRequest *request);
+/* Blocks until the request completes, moves its result into response_out and frees it.
+   Returns 1 when a response (of any status) arrived, 0 on transport failure. */
+int http_client_wait(HttpClientRequest *request, HttpClientResponse *response_out);
+/* submit + wait. */
+int http_client_perform(const char *url,
+                        const char *const *headers,
+                        size_t header_count,
+                        const char *body,
+                        size_t body_length,
+                        long timeout_seconds,
+                        HttpClientResponse *response_out);
+void http_client_response_clear(HttpClientResponse *response);
+
+#endif /* HTTP_CLIENT_H */
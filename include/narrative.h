@@ -1,6 +1,21 @@
 #ifndef NARRATIVE_H
 #define NARRATIVE_H
 
+#define NARRATIVE_DEFAULT_MAX_TOKENS 4000
+
+/* Model every completion is requested from; part of the narrative cache key. */
+const char *narrative_model_name(void);
 int generate_grok_completion(const char *system_prompt, const char *user_prompt, char **response_out, char **error_out);
+/* max_tokens of 0 uses NARRATIVE_DEFAULT_MAX_TOKENS. status_out receives the HTTP status, 0
+   when the request got no response, or -1 when it was never sent; retry_after_out receives the
+   server's Retry-After in seconds (0 when absent). Either may be NULL. A reply cut off at the
+   token limit is an error, never a partial narrative. */
+int generate_grok_completion_ex(const char *system_prompt,
+                                const char *user_prompt,
+                                int max_tokens,
+                                char **response_out,
+                                long *status_out,
+                                long *retry_after_out,
+                                char **error_out);
 
 #endif /* NARRATIVE_H */
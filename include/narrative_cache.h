@@ -0,0 +1,41 @@
+#ifndef NARRATIVE_CACHE_H
+#define NARRATIVE_CACHE_H
+
+#include <libpq-fe.h>
+#include <stddef.h>
+
+#include "sha256.h"
+
+/*
+ * Completed narratives keyed by a SHA-256 fingerprint of (cache version, model, system
+ * prompt, user prompt). Prompts are built only from report data, so an unchanged building
+ * produces the same fingerprints and its narratives come back without calling the model.
+ * Bumping the cache version orphans every existing entry.
+ */
+
+void narrative_cache_key(int version,
+                         const char *model,
+                         const char *system_prompt,
+                         const char *user_prompt,
+                         char key_out[SHA256_HEX_SIZE]);
+
+/* Looks up every key in one round trip. responses_out[i] receives a malloc'd copy of the
+   cached text or stays NULL on a miss. Entries older than max_age_days are ignored unless
+   max_age_days is 0. */
+int db_narrative_cache_lookup(PGconn *conn,
+                              const char *const *keys,
+                              size_t count,
+                              int max_age_days,
+                              char **responses_out,
+                              size_t *hits_out,
+                              char **error_out);
+int db_narrative_cache_store(PGconn *conn,
+                             const char *key,
+                             const char *model,
+                             int version,
+                             const char *response,
+                             char **error_out);
+/* Deletes entries from other cache versions and, when max_age_days > 0, expired ones. */
+int db_narrative_cache_prune(PGconn *conn, int version, int max_age_days, char **error_out);
+
+#endif /* NARRATIVE_CACHE_H */
@@ -0,0 +1,59 @@
+#ifndef NARRATIVE_POOL_H
+#define NARRATIVE_POOL_H
+
+/*
+ * Shared, bounded executor for narrative completions. A fixed set of threads serves
+ * every report job, so the thread count is the global cap on concurrent provider
+ * calls. Jobs are served round-robin so one large building cannot starve the others,
+ * and 429/5xx responses are retried with jittered exponential backoff; a 429 also
+ * pauses the whole pool until the provider's cool-down has passed.
+ */
+
+#include <stdint.h>
+
+typedef struct NarrativeRequest {
+    const char *system_prompt;
+    const char *user_prompt;
+    /* 0 uses the completion default. */
+    int max_tokens;
+    /* Filled in by the pool: response on success, error otherwise. Caller frees both. */
+    char *response;
+    char *error;
+    int success;
+    int attempts;
+    /* Set once the pool is done with the request. A request still running when a timed
+       wait gave up keeps 0 and belongs to the released batch from then on. */
+    int finished;
+    struct NarrativeRequest *next;
+} NarrativeRequest;
+
+typedef struct NarrativeBatch NarrativeBatch;
+
+/* Starts `threads` executor threads. Without a running pool requests execute inline. */
+int narrative_pool_start(int threads, int max_attempts);
+void narrative_pool_stop(void);
+/* Caps how many threads may serve background batches at once (default 1). */
+void narrative_pool_set_background_limit(int threads);
+
+/* CLOCK_MONOTONIC milliseconds, the clock narrative_batch_wait_until deadlines use. */
+int64_t narrative_pool_now_ms(void);
+
+NarrativeBatch *narrative_batch_create(void);
+/* A batch served only when no report batch is waiting. Its requests never run inline
+   and are failed rather than executed once the pool is stopping. */
+NarrativeBatch *narrative_batch_create_background(void);
+/* The request must stay valid until narrative_batch_wait returns. */
+void narrative_batch_submit(NarrativeBatch *batch, NarrativeRequest *request);
+/* Blocks until every submitted request has finished, then frees the batch. */
+void narrative_batch_wait(NarrativeBatch *batch);
+/* Like narrative_batch_wait but gives up at deadline_ms. Returns 1 (batch freed) when
+   everything finished. On timeout returns 0 with the `finished` flags frozen: the caller
+   may use requests marked finished and must hand the batch to narrative_batch_release. */
+int narrative_batch_wait_until(NarrativeBatch *batch, int64_t deadline_ms);
+/* Lets the unfinished requests of a timed-out batch run to completion in the background.
+   on_drained(context) runs once the last one finishes (immediately if none remain), from
+   whichever thread finished it, after which the batch frees itself. Everything those
+   requests reference must stay valid until then. */
+void narrative_batch_release(NarrativeBatch *batch, void (*on_drained)(void *context), void *context);
+
+#endif /* NARRATIVE_POOL_H */
@@ -0,0 +1,18 @@
+#ifndef NUMBER_FORMAT_H
+#define NUMBER_FORMAT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Large enough for any output of the formatters below, including the terminator. */
+#define NUMBER_FORMAT_MAX 64
+
+size_t format_uint64(char *out, uint64_t value);
+size_t format_int64(char *out, int64_t value);
+size_t format_double_fixed(char *out, double value, int precision, bool group_thousands);
+size_t format_double_shortest(char *out, double value);
+
+double parse_decimal_double(const char *text, const char **end_out);
+
+#endif /* NUMBER_FORMAT_H */
@@ -0,0 +1,55 @@
+#ifndef PDF_WRITER_H
+#define PDF_WRITER_H
+
+#include <stddef.h>
+
+#include "util.h"
+
+/*
+ * Minimal PDF 1.4 writer for table-style reports: the standard Helvetica faces (WinAnsi,
+ * no embedding), filled rectangles, lines and 8-bit PNG images with alpha. Coordinates are
+ * points from the bottom-left corner of the page. Text is expected to be ASCII already;
+ * other bytes render as '?'.
+ */
+
+#define PDF_A4_WIDTH 595.276
+#define PDF_A4_HEIGHT 841.890
+
+typedef enum {
+    PDF_FONT_REGULAR = 0,
+    PDF_FONT_BOLD,
+    PDF_FONT_ITALIC,
+    PDF_FONT_COUNT
+} PdfFont;
+
+typedef struct {
+    double r;
+    double g;
+    double b;
+} PdfColor;
+
+typedef struct PdfDocument PdfDocument;
+
+PdfDocument *pdf_document_create(double page_width, double page_height);
+void pdf_document_free(PdfDocument *doc);
+
+/* Decodes an 8-bit non-interlaced PNG; returns an image id for pdf_draw_image or -1. */
+int pdf_document_add_png(PdfDocument *doc, const char *path, char **error_out);
+
+/* Starts a new page; later drawing calls target it. */
+int pdf_begin_page(PdfDocument *doc);
+size_t pdf_page_count(const PdfDocument *doc);
+
+int pdf_draw_text(PdfDocument *doc, PdfFont font, double size, double x, double y, PdfColor color, const char *text);
+int pdf_fill_rect(PdfDocument *doc, double x, double y, double width, double height, PdfColor color);
+int pdf_draw_line(PdfDocument *doc, double x1, double y1, double x2, double y2, double line_width, PdfColor color);
+/* Opacity below 1 goes through a shared ExtGState, e.g. for watermarks. */
+int pdf_draw_image(PdfDocument *doc, int image, double x, double y, double width, double height, double opacity);
+
+double pdf_text_width(PdfFont font, double size, const char *text);
+/* Greedy word wrap; words wider than max_width are broken by character. */
+int pdf_wrap_text(PdfFont font, double size, const char *text, double max_width, StringArray *lines_out);
+
+int pdf_document_save(PdfDocument *doc, const char *path, char **error_out);
+
+#endif /* PDF_WRITER_H */
@@ -0,0 +1,28 @@
+#ifndef PHOTO_DERIVATIVES_H
+#define PHOTO_DERIVATIVES_H
+
+#include <stddef.h>
+
+/*
+ * Downscaled JPEG renditions of audit photos, rendered once at ingest so galleries never
+ * ship the camera original. JPEG and PNG sources are decoded (JPEGs at a reduced DCT scale
+ * when they are much larger than needed), turned upright per their EXIF orientation,
+ * area-averaged down to fit the longest edge and re-encoded as JPEG.
+ */
+
+#define PHOTO_THUMB_MAX_EDGE 320
+#define PHOTO_PREVIEW_MAX_EDGE 1600
+
+typedef struct {
+    /* NULL when the original already fits and is upright; serve the original instead. */
+    unsigned char *thumb;
+    size_t thumb_size;
+    unsigned char *preview;
+    size_t preview_size;
+} PhotoDerivatives;
+
+/* Renders both sizes from one decode. Fails for formats other than JPEG and PNG. */
+int photo_derivatives_render(const unsigned char *data, size_t len, PhotoDerivatives *out, char **error_out);
+void photo_derivatives_free(PhotoDerivatives *derivatives);
+
+#endif /* PHOTO_DERIVATIVES_H */
@@ -7,6 +7,10 @@
 
 #include "util.h"
 
+#define REPORT_JOBS_NOTIFY_CHANNEL "report_jobs"
+/* Claims of a job whose lease keeps lapsing before it is marked failed. */
+#define REPORT_JOB_MAX_ATTEMPTS 3
+
 typedef enum {
     REPORT_JOB_TYPE_AUDIT = 0,
     REPORT_JOB_TYPE_LOCATION_OVERVIEW
@@ -39,16 +43,35 @@ void report_job_init(ReportJob *job);
 void report_job_clear(ReportJob *job);
 
 int db_insert_report_job(PGconn *conn, const char *job_id, const ReportJob *job, char **error_out);
-int db_claim_next_report_job(PGconn *conn, ReportJob *job, char **error_out);
+/* lease_owner must be unique per claim, so a lapsed claim can never pass for the one that
+   replaced it, even within the same process. */
+int db_claim_next_report_job(PGconn *conn, const char *lease_owner, int lease_seconds, ReportJob *job, char **error_out);
+int db_renew_report_job_leases(PGconn *conn, const StringArray *lease_owners, int lease_seconds, char **error_out);
+int db_listen_report_jobs(PGconn *conn, char **error_out);
+/* Waits for a report_jobs notification on a LISTENing connection or for wake_fd to become
+   readable. Returns 1 when notified, 0 on timeout or wake, -1 when the connection failed. */
+int db_wait_report_job_notification(PGconn *conn, int wake_fd, int timeout_ms, char **error_out);
+/* Only applies while lease_owner still holds the job's lease. Returns 1 when recorded, 0 when
+   the lease was lost (the result must be dropped), -1 on error. */
 int db_complete_report_job(PGconn *conn,
                            const char *job_id,
+                           const char *lease_owner,
                            const char *status,
                            const char *error_text,
                            const char *artifact_filename,
                            const char *artifact_mime,
-                           const unsigned char *artifact_bytes,
+                           const char *artifact_sha256,
                            size_t artifact_size,
                            char **error_out);
+/* Records the narrative sections that fell back to deterministic text; empty clears it. */
+int db_set_report_job_degraded_sections(PGconn *conn, const char *job_id, const StringArray *sections, char **error_out);
+int db_set_report_job_fragment_stats(PGconn *conn, const char *job_id, size_t hits, size_t lookups, char **error_out);
+/* Jobs completed before the artifact store, whose PDF still sits in artifact_bytes. */
+int db_list_legacy_report_artifacts(PGconn *conn, StringArray *job_ids, char **error_out);
+/* Fetches artifact_bytes in binary form. Returns 1 with *data_out NULL when the row has none. */
+int db_fetch_legacy_report_artifact(PGconn *conn, const char *job_id, unsigned char **data_out, size_t *size_out, char **error_out);
+/* Points a legacy row at its stored copy and drops the inline bytes. */
+int db_move_report_artifact_to_store(PGconn *conn, const char *job_id, const char *artifact_sha256, char **error_out);
 char *db_fetch_report_job_status(PGconn *conn, const char *job_id, const char *path_prefix, char **error_out);
 int db_find_existing_report_job(PGconn *conn,
                                 const ReportJob *job,
@@ -4,13 +4,6 @@
 #include <stdbool.h>
 #include <libpq-fe.h>
 
-typedef struct {
-    char *path;
-    char *filename;
-    char *mime;
-    char *work_dir;
-} ReportDownloadArtifact;
-
 typedef struct {
     char *address;
     char *location_id;
@@ -21,13 +14,16 @@ typedef struct {
 typedef struct {
     char *(*build_location_detail)(PGconn *conn, const LocationDetailRequest *request, int *status_out, char **error_out);
     char *(*build_report_json)(PGconn *conn, const LocationDetailRequest *request, int *status_out, char **error_out);
-    int (*prepare_report_download)(PGconn *conn, const char *job_id, ReportDownloadArtifact *artifact, char **error_out);
-    void (*cleanup_report_download)(ReportDownloadArtifact *artifact);
+    /* Writes the whole response itself; returns 0 with status and error set if it sent nothing. */
+    int (*stream_report_preview)(int client_fd, PGconn *conn, const LocationDetailRequest *request, int *status_out, char **error_out);
+    /* Same contract as stream_report_preview. */
+    int (*stream_report_download)(int client_fd, PGconn *conn, const char *job_id, int *status_out, char **error_out);
+    char *(*build_report_worker_status)(void);
 } RouteHelpers;
 
 void routes_register_helpers(const RouteHelpers *helpers);
 void routes_set_prefix(const char *prefix);
-void routes_handle_get(int client_fd, PGconn *conn, const char *path, const char *query_string);
+void routes_handle_get(int client_fd, PGconn *conn, const char *path, const char *query_string, const char *header_lines);
 bool routes_handle_patch(int client_fd, PGconn *conn, const char *api_path, const char *body_json);
 
 #endif /* ROUTES_H */
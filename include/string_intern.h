@@ -0,0 +1,16 @@
+#ifndef STRING_INTERN_H
+#define STRING_INTERN_H
+
+#include <stddef.h>
+
+/*
+ * Process-wide table of immutable strings. Equal inputs return the same pointer,
+ * so interned values compare with == and must never be freed. Intended for
+ * small categorical vocabularies (manufacturers, condition labels, device types),
+ * not free text: entries live until exit.
+ */
+const char *string_intern(const char *text);
+const char *string_intern_n(const char *text, size_t len);
+size_t string_intern_count(void);
+
+#endif /* STRING_INTERN_H */
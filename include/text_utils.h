@@ -1,10 +1,23 @@
 #ifndef TEXT_UTILS_H
 #define TEXT_UTILS_H
 
+#include "buffer.h"
+
+enum {
+    LATEX_TEXT_SANITIZE = 1u << 0,
+    LATEX_TEXT_NORMALIZE_CAPS = 1u << 1,
+    LATEX_TEXT_MARKDOWN = 1u << 2
+};
+
 char *sanitize_ascii(const char *text);
 char *latex_escape(const char *text);
 char *latex_escape_with_markdown(const char *text);
 char *normalize_caps_if_all_upper(const char *text);
 void normalize_caps_inplace(char **text);
+int latex_append_text(Buffer *buf, const char *text, unsigned flags);
+/* latex_append_text without the LaTeX escaping, for plain-text output; LATEX_TEXT_MARKDOWN is ignored. */
+int ascii_append_text(Buffer *buf, const char *text, unsigned flags);
+/* sanitize_ascii and normalize_caps_if_all_upper in one pass. */
+char *sanitize_ascii_caps(const char *text);
 
 #endif /* TEXT_UTILS_H */
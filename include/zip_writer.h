@@ -0,0 +1,42 @@
+#ifndef ZIP_WRITER_H
+#define ZIP_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Forward-only ZIP writer. Entries are emitted through a sink callback as they are added,
+ * so an archive can go straight to a socket without touching disk; only the central
+ * directory records (name, sizes, offset) are kept until zip_writer_finish. Every entry's
+ * size and CRC are known before its local header is written, so no data descriptors are
+ * used and streaming readers can unpack stored entries too. ZIP64 records are added only
+ * when an entry, an offset or the entry count outgrows the classic format.
+ */
+
+typedef enum {
+    ZIP_METHOD_STORE = 0,
+    ZIP_METHOD_DEFLATE = 8
+} ZipMethod;
+
+/* Returns 0 to abort the archive, e.g. once the client has disconnected. */
+typedef int (*ZipSinkFn)(void *ctx, const void *data, size_t len);
+
+typedef struct ZipWriter ZipWriter;
+
+ZipWriter *zip_writer_create(ZipSinkFn sink, void *ctx);
+void zip_writer_free(ZipWriter *zw);
+
+/* Stored for formats that are already compressed (JPEG, PNG, PDF, ...), deflate otherwise. */
+ZipMethod zip_method_for_name(const char *name);
+bool zip_writer_contains(const ZipWriter *zw, const char *name);
+
+/* Deflated entries fall back to stored when compression does not shrink them. */
+int zip_writer_add(ZipWriter *zw, const char *name, const void *data, size_t len, ZipMethod method, char **error_out);
+/* Stored entry copied from a file in fixed-size blocks; the file is read twice (CRC, then data). */
+int zip_writer_add_file(ZipWriter *zw, const char *name, const char *path, char **error_out);
+/* Writes the central directory and flushes the sink. */
+int zip_writer_finish(ZipWriter *zw, char **error_out);
+uint64_t zip_writer_bytes_written(const ZipWriter *zw);
+
+#endif /* ZIP_WRITER_H */
@@ -0,0 +1,6 @@
+ALTER TABLE report_jobs
+    ADD COLUMN IF NOT EXISTS lease_owner TEXT,
+    ADD COLUMN IF NOT EXISTS lease_expires_at TIMESTAMPTZ,
+    ADD COLUMN IF NOT EXISTS attempts INTEGER NOT NULL DEFAULT 0;
+
+CREATE INDEX IF NOT EXISTS idx_report_jobs_lease ON report_jobs (lease_expires_at) WHERE status = 'processing';
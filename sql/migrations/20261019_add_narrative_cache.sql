@@ -0,0 +1,9 @@
+CREATE TABLE IF NOT EXISTS narrative_cache (
+    prompt_hash TEXT PRIMARY KEY,
+    model TEXT NOT NULL,
+    cache_version INTEGER NOT NULL,
+    response TEXT NOT NULL,
+    created_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+    last_used_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+    hit_count BIGINT NOT NULL DEFAULT 0
+);
@@ -0,0 +1,3 @@
+ALTER TABLE report_jobs
+    ADD COLUMN IF NOT EXISTS fragment_cache_hits INTEGER,
+    ADD COLUMN IF NOT EXISTS fragment_cache_lookups INTEGER;
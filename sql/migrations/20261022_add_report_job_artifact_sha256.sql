@@ -0,0 +1,2 @@
+ALTER TABLE report_jobs
+    ADD COLUMN IF NOT EXISTS artifact_sha256 TEXT;
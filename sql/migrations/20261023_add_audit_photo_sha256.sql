@@ -0,0 +1,6 @@
+ALTER TABLE audit_photos
+    ADD COLUMN IF NOT EXISTS photo_sha256 TEXT;
+
+UPDATE audit_photos
+SET photo_sha256 = encode(sha256(photo_bytes), 'hex')
+WHERE photo_sha256 IS NULL;
@@ -0,0 +1,3 @@
+ALTER TABLE audit_photos
+    ADD COLUMN IF NOT EXISTS thumb_bytes BYTEA,
+    ADD COLUMN IF NOT EXISTS preview_bytes BYTEA;
@@ -0,0 +1,26 @@
+CREATE TABLE IF NOT EXISTS photo_blobs (
+    sha256 TEXT PRIMARY KEY,
+    photo_bytes BYTEA NOT NULL,
+    thumb_bytes BYTEA,
+    preview_bytes BYTEA,
+    created_at TIMESTAMPTZ NOT NULL DEFAULT now()
+);
+
+UPDATE audit_photos
+SET photo_sha256 = encode(sha256(photo_bytes), 'hex')
+WHERE photo_sha256 IS NULL;
+
+INSERT INTO photo_blobs (sha256, photo_bytes, thumb_bytes, preview_bytes)
+SELECT DISTINCT ON (photo_sha256) photo_sha256, photo_bytes, thumb_bytes, preview_bytes
+FROM audit_photos
+ORDER BY photo_sha256, thumb_bytes IS NULL
+ON CONFLICT (sha256) DO NOTHING;
+
+ALTER TABLE audit_photos
+    DROP COLUMN photo_bytes,
+    DROP COLUMN thumb_bytes,
+    DROP COLUMN preview_bytes,
+    ALTER COLUMN photo_sha256 SET NOT NULL,
+    ADD CONSTRAINT audit_photos_photo_sha256_fkey FOREIGN KEY (photo_sha256) REFERENCES photo_blobs (sha256);
+
+CREATE INDEX IF NOT EXISTS idx_audit_photos_photo_sha256 ON audit_photos (photo_sha256);
@@ -0,0 +1,6 @@
+ALTER TABLE photo_blobs ADD COLUMN IF NOT EXISTS renditions_done BOOLEAN NOT NULL DEFAULT FALSE;
+
+UPDATE photo_blobs
+SET renditions_done = TRUE
+WHERE NOT renditions_done
+  AND (thumb_bytes IS NOT NULL OR preview_bytes IS NOT NULL);
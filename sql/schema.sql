@@ -127,12 +127,21 @@ CREATE TABLE IF NOT EXISTS audit_visits (
     updated_at TIMESTAMPTZ NOT NULL DEFAULT now()
 );
 
+CREATE TABLE IF NOT EXISTS photo_blobs (
+    sha256 TEXT PRIMARY KEY,
+    photo_bytes BYTEA NOT NULL,
+    thumb_bytes BYTEA,
+    preview_bytes BYTEA,
+    renditions_done BOOLEAN NOT NULL DEFAULT FALSE,
+    created_at TIMESTAMPTZ NOT NULL DEFAULT now()
+);
+
 CREATE TABLE IF NOT EXISTS audit_photos (
     id BIGSERIAL PRIMARY KEY,
     audit_uuid UUID NOT NULL REFERENCES audits(audit_uuid) ON DELETE CASCADE,
     photo_filename TEXT NOT NULL,
     content_type TEXT NOT NULL DEFAULT 'image/jpeg',
-    photo_bytes BYTEA NOT NULL,
+    photo_sha256 TEXT NOT NULL REFERENCES photo_blobs(sha256),
     created_at TIMESTAMPTZ NOT NULL DEFAULT now(),
     UNIQUE (audit_uuid, photo_filename)
 );
@@ -154,6 +163,7 @@ CREATE TABLE IF NOT EXISTS audit_deficiencies (
 );
 
 CREATE INDEX IF NOT EXISTS idx_audit_photos_audit_uuid ON audit_photos (audit_uuid);
+CREATE INDEX IF NOT EXISTS idx_audit_photos_photo_sha256 ON audit_photos (photo_sha256);
 CREATE INDEX IF NOT EXISTS idx_audit_deficiencies_audit_uuid ON audit_deficiencies (audit_uuid);
 CREATE INDEX IF NOT EXISTS idx_audit_visits_location_id ON audit_visits (location_id);
 CREATE INDEX IF NOT EXISTS idx_audit_visits_started_at ON audit_visits (started_at);
@@ -161,6 +171,9 @@ CREATE INDEX IF NOT EXISTS idx_audit_visits_started_at ON audit_visits (started_
 ALTER TABLE audit_deficiencies
     ADD COLUMN IF NOT EXISTS resolved_at TIMESTAMPTZ;
 
+ALTER TABLE audit_photos
+    ADD COLUMN IF NOT EXISTS photo_sha256 TEXT;
+
 ALTER TABLE audits
     ADD COLUMN IF NOT EXISTS location_id INTEGER REFERENCES locations(id),
     ADD COLUMN IF NOT EXISTS visit_id UUID REFERENCES audit_visits(visit_id),
@@ -206,7 +219,14 @@ CREATE TABLE IF NOT EXISTS report_jobs (
     started_at TIMESTAMPTZ,
     completed_at TIMESTAMPTZ,
     location_id INTEGER REFERENCES locations(id),
-    include_all BOOLEAN NOT NULL DEFAULT TRUE
+    include_all BOOLEAN NOT NULL DEFAULT TRUE,
+    lease_owner TEXT,
+    lease_expires_at TIMESTAMPTZ,
+    attempts INTEGER NOT NULL DEFAULT 0,
+    degraded_sections TEXT[],
+    fragment_cache_hits INTEGER,
+    fragment_cache_lookups INTEGER,
+    artifact_sha256 TEXT
 );
 
 CREATE UNIQUE INDEX IF NOT EXISTS idx_report_jobs_job_id ON report_jobs (job_id);
@@ -231,7 +251,26 @@ ALTER TABLE report_jobs
     ADD COLUMN IF NOT EXISTS range_end DATE,
     ADD COLUMN IF NOT EXISTS range_preset TEXT,
     ADD COLUMN IF NOT EXISTS location_id INTEGER REFERENCES locations(id),
-    ADD COLUMN IF NOT EXISTS include_all BOOLEAN NOT NULL DEFAULT TRUE;
+    ADD COLUMN IF NOT EXISTS include_all BOOLEAN NOT NULL DEFAULT TRUE,
+    ADD COLUMN IF NOT EXISTS lease_owner TEXT,
+    ADD COLUMN IF NOT EXISTS lease_expires_at TIMESTAMPTZ,
+    ADD COLUMN IF NOT EXISTS attempts INTEGER NOT NULL DEFAULT 0,
+    ADD COLUMN IF NOT EXISTS degraded_sections TEXT[],
+    ADD COLUMN IF NOT EXISTS fragment_cache_hits INTEGER,
+    ADD COLUMN IF NOT EXISTS fragment_cache_lookups INTEGER,
+    ADD COLUMN IF NOT EXISTS artifact_sha256 TEXT;
+
+CREATE INDEX IF NOT EXISTS idx_report_jobs_lease ON report_jobs (lease_expires_at) WHERE status = 'processing';
+
+CREATE TABLE IF NOT EXISTS narrative_cache (
+    prompt_hash TEXT PRIMARY KEY,
+    model TEXT NOT NULL,
+    cache_version INTEGER NOT NULL,
+    response TEXT NOT NULL,
+    created_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+    last_used_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+    hit_count BIGINT NOT NULL DEFAULT 0
+);
 
 CREATE TABLE IF NOT EXISTS report_job_audits (
     job_id UUID NOT NULL REFERENCES report_jobs(job_id) ON DELETE CASCADE,
@@ -2,69 +2,19 @@
 
 #include "buffer.h"
 #include "config.h"
+#include "http_client.h"
 #include "json.h"
 #include "json_utils.h"
 #include "log.h"
 #include "util.h"
 
-#include <curl/curl.h>
 #include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define GOOGLE_ADDRESS_ENDPOINT "https://addressvalidation.googleapis.com/v1:validateAddress"
 
-typedef struct {
-    char *data;
-    size_t length;
-    size_t capacity;
-} HttpBuffer;
-
-static void http_buffer_init(HttpBuffer *buf) {
-    if (!buf) return;
-    buf->data = NULL;
-    buf->length = 0;
-    buf->capacity = 0;
-}
-
-static void http_buffer_free(HttpBuffer *buf) {
-    if (!buf) return;
-    free(buf->data);
-    buf->data = NULL;
-    buf->length = 0;
-    buf->capacity = 0;
-}
-
-static int http_buffer_reserve(HttpBuffer *buf, size_t additional) {
-    if (!buf) return 0;
-    if (buf->length + additional + 1 <= buf->capacity) {
-        return 1;
-    }
-    size_t new_cap = buf->capacity == 0 ? (additional + 1024) : buf->capacity * 2;
-    while (buf->length + additional + 1 > new_cap) {
-        new_cap *= 2;
-    }
-    char *tmp = realloc(buf->data, new_cap);
-    if (!tmp) {
-        return 0;
-    }
-    buf->data = tmp;
-    buf->capacity = new_cap;
-    return 1;
-}
-
-static size_t curl_response_write(void *contents, size_t size, size_t nmemb, void *userp) {
-    size_t total = size * nmemb;
-    HttpBuffer *buf = (HttpBuffer *)userp;
-    if (!http_buffer_reserve(buf, total)) {
-        return 0;
-    }
-    memcpy(buf->data + buf->length, contents, total);
-    buf->length += total;
-    buf->data[buf->length] = '\0';
-    return total;
-}
-
 void normalized_address_init(NormalizedAddress *result) {
     if (!result) return;
     memset(result, 0, sizeof(*result));
@@ -306,17 +256,8 @@ int validate_address_with_google(const char *raw_address, NormalizedAddress *res
         return 0;
     }
 
-    CURL *curl = curl_easy_init();
-    if (!curl) {
-        if (error_out && !*error_out) {
-            *error_out = strdup("Failed to initialize HTTP client");
-        }
-        return 0;
-    }
-
     Buffer body;
     if (!buffer_init(&body)) {
-        curl_easy_cleanup(curl);
         if (error_out && !*error_out) {
             *error_out = strdup("Out of memory preparing request");
         }
@@ -330,7 +271,6 @@ int validate_address_with_google(const char *raw_address, NormalizedAddress *res
         free(escaped_region);
         free(escaped_address);
         buffer_free(&body);
-        curl_easy_cleanup(curl);
         if (error_out && !*error_out) {
             *error_out = strdup("Out of memory preparing JSON body");
         }
@@ -350,72 +290,53 @@ int validate_address_with_google(const char *raw_address, NormalizedAddress *res
     free(escaped_region);
     free(escaped_address);
 
-    char *url = append_query_with_key(GOOGLE_ADDRESS_ENDPOINT);
+    const char *endpoint = (g_google_address_url && g_google_address_url[0]) ? g_google_address_url : GOOGLE_ADDRESS_ENDPOINT;
+    char *url = append_query_with_key(endpoint);
     if (!url) {
         buffer_free(&body);
-        curl_easy_cleanup(curl);
         if (error_out && !*error_out) {
             *error_out = strdup("Failed to construct request URL");
         }
         return 0;
     }
 
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-    headers = curl_slist_append(headers, "Accept: application/json");
-
-    HttpBuffer response;
-    http_buffer_init(&response);
-
-    curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_POST, 1L);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.data);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curl_response_write);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-
-    CURLcode res = curl_easy_perform(curl);
-    long status_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status_code);
-
-    curl_slist_free_all(headers);
+    const char *headers[] = {
+        "Content-Type: application/json",
+        "Accept: application/json"
+    };
+    HttpClientResponse response;
+    int delivered = http_client_perform(url, headers, 2, body.data, body.length, 30L, &response);
     buffer_free(&body);
-    curl_easy_cleanup(curl);
     free(url);
 
-    if (res != CURLE_OK) {
+    if (!delivered) {
         if (error_out && !*error_out) {
-            const char *msg = curl_easy_strerror(res);
-            size_t len = msg ? strlen(msg) : 0;
-            char *copy = malloc(len + 32);
-            if (copy) {
-                snprintf(copy, len + 32, "HTTP request failed: %s", msg ? msg : "unknown error");
-                *error_out = copy;
-            }
+            *error_out = response.error ? response.error : strdup("HTTP request failed");
+            response.error = NULL;
         }
-        http_buffer_free(&response);
+        http_client_response_clear(&response);
         return 0;
     }
 
-    if (status_code != 200) {
+    if (response.status != 200) {
         if (error_out && !*error_out) {
-            if (response.length > 0) {
-                *error_out = strdup(response.data);
+            if (response.body_length > 0) {
+                *error_out = response.body;
+                response.body = NULL;
             } else {
                 char *msg = malloc(64);
                 if (msg) {
-                    snprintf(msg, 64, "HTTP status %ld", status_code);
+                    snprintf(msg, 64, "HTTP status %ld", response.status);
                     *error_out = msg;
                 }
             }
         }
-        http_buffer_free(&response);
+        http_client_response_clear(&response);
         return 0;
     }
 
-    JsonValue *root = json_parse(response.data ? response.data : "", error_out);
-    http_buffer_free(&response);
+    JsonValue *root = json_parse(response.body ? response.body : "", error_out);
+    http_client_response_clear(&response);
     if (!root) {
         return 0;
     }
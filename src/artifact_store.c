@@ -0,0 +1,228 @@
+#include "artifact_store.h"
+
+#include "fsutil.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct {
+    char *root;
+} DirectoryStore;
+
+static void set_error(char **error_out, const char *what, const char *path) {
+    if (!error_out || *error_out) {
+        return;
+    }
+    char msg[512];
+    snprintf(msg, sizeof(msg), "%s %s: %s", what, path ? path : "", strerror(errno));
+    *error_out = strdup(msg);
+}
+
+static char *directory_shard_path(const DirectoryStore *store, const char *digest_hex) {
+    char shard[3] = { digest_hex[0], digest_hex[1], '\0' };
+    return join_path(store->root, shard);
+}
+
+/* A rename is only durable once the directory holding the new name is synced. */
+static int fsync_directory(const char *path) {
+    int fd = open(path, O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        return 0;
+    }
+    int ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+}
+
+static int write_fully(int fd, const unsigned char *data, size_t len) {
+    size_t written = 0;
+    while (written < len) {
+        ssize_t w = write(fd, data + written, len - written);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        written += (size_t)w;
+    }
+    return 1;
+}
+
+static int directory_put(void *state, const char *digest_hex, const unsigned char *data, size_t len, char **error_out) {
+    DirectoryStore *store = (DirectoryStore *)state;
+    char *shard = directory_shard_path(store, digest_hex);
+    char *final_path = shard ? join_path(shard, digest_hex) : NULL;
+    char *temp_path = shard ? join_path(shard, ".incoming-XXXXXX") : NULL;
+    int fd = -1;
+    int success = 0;
+    if (!shard || !final_path || !temp_path) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Out of memory building artifact path");
+        }
+        goto cleanup;
+    }
+
+    /* Same name means same bytes, so an existing blob of the right size is already stored. */
+    struct stat st;
+    if (stat(final_path, &st) == 0 && S_ISREG(st.st_mode) && (size_t)st.st_size == len) {
+        success = 1;
+        goto cleanup;
+    }
+
+    if (ensure_directory_exists(shard) != 0) {
+        set_error(error_out, "Failed to create artifact directory", shard);
+        goto cleanup;
+    }
+    fd = mkstemp(temp_path);
+    if (fd < 0) {
+        set_error(error_out, "Failed to create artifact file in", shard);
+        goto cleanup;
+    }
+    if (!write_fully(fd, data, len) || fchmod(fd, 0644) != 0 || fsync(fd) != 0) {
+        set_error(error_out, "Failed to write artifact", temp_path);
+        goto cleanup;
+    }
+    if (close(fd) != 0) {
+        fd = -1;
+        set_error(error_out, "Failed to write artifact", temp_path);
+        goto cleanup;
+    }
+    fd = -1;
+    if (rename(temp_path, final_path) != 0) {
+        set_error(error_out, "Failed to publish artifact", final_path);
+        goto cleanup;
+    }
+    temp_path[0] = '\0';
+    if (!fsync_directory(shard) || !fsync_directory(store->root)) {
+        set_error(error_out, "Failed to sync artifact directory", shard);
+        goto cleanup;
+    }
+    success = 1;
+
+cleanup:
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (temp_path && temp_path[0] != '\0' && !success) {
+        unlink(temp_path);
+    }
+    free(temp_path);
+    free(final_path);
+    free(shard);
+    return success;
+}
+
+static char *directory_local_path(void *state, const char *digest_hex, char **error_out) {
+    DirectoryStore *store = (DirectoryStore *)state;
+    char *shard = directory_shard_path(store, digest_hex);
+    char *path = shard ? join_path(shard, digest_hex) : NULL;
+    free(shard);
+    if (!path) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Out of memory building artifact path");
+        }
+        return NULL;
+    }
+    if (access(path, R_OK) != 0) {
+        set_error(error_out, "Report artifact unavailable", digest_hex);
+        free(path);
+        return NULL;
+    }
+    return path;
+}
+
+static void directory_close(void *state) {
+    DirectoryStore *store = (DirectoryStore *)state;
+    if (store) {
+        free(store->root);
+        free(store);
+    }
+}
+
+static const ArtifactStoreOps DIRECTORY_STORE_OPS = {
+    .name = "directory",
+    .put = directory_put,
+    .local_path = directory_local_path,
+    .close = directory_close
+};
+
+int artifact_store_open_directory(ArtifactStore *store, const char *root, char **error_out) {
+    if (!store || !root || root[0] == '\0') {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Artifact store directory required");
+        }
+        return 0;
+    }
+    if (ensure_directory_exists(root) != 0) {
+        set_error(error_out, "Failed to create artifact store", root);
+        return 0;
+    }
+    DirectoryStore *state = calloc(1, sizeof(*state));
+    if (!state || !(state->root = strdup(root))) {
+        free(state);
+        if (error_out && !*error_out) {
+            *error_out = strdup("Out of memory opening artifact store");
+        }
+        return 0;
+    }
+    store->ops = &DIRECTORY_STORE_OPS;
+    store->state = state;
+    return 1;
+}
+
+void artifact_store_close(ArtifactStore *store) {
+    if (!store || !store->ops) {
+        return;
+    }
+    if (store->ops->close) {
+        store->ops->close(store->state);
+    }
+    store->ops = NULL;
+    store->state = NULL;
+}
+
+bool artifact_store_is_open(const ArtifactStore *store) {
+    return store && store->ops;
+}
+
+bool artifact_digest_is_valid(const char *digest_hex) {
+    if (!digest_hex) {
+        return false;
+    }
+    size_t i = 0;
+    for (; digest_hex[i] != '\0'; ++i) {
+        char c = digest_hex[i];
+        if (i >= SHA256_HEX_SIZE - 1 || !((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return i == SHA256_HEX_SIZE - 1;
+}
+
+int artifact_store_put(ArtifactStore *store, const unsigned char *data, size_t len, char digest_hex[SHA256_HEX_SIZE], char **error_out) {
+    if (!artifact_store_is_open(store) || !data || len == 0 || !digest_hex) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Invalid artifact store parameters");
+        }
+        return 0;
+    }
+    Sha256 ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, data, len);
+    sha256_final_hex(&ctx, digest_hex);
+    return store->ops->put(store->state, digest_hex, data, len, error_out);
+}
+
+char *artifact_store_local_path(ArtifactStore *store, const char *digest_hex, char **error_out) {
+    if (!artifact_store_is_open(store) || !artifact_digest_is_valid(digest_hex)) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Invalid report artifact digest");
+        }
+        return NULL;
+    }
+    return store->ops->local_path(store->state, digest_hex, error_out);
+}
@@ -1,10 +1,19 @@
 #include "buffer.h"
 
+#include "number_format.h"
+
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 static int buffer_reserve(Buffer *buf, size_t extra) {
     if (!buf) {
         return 0;
@@ -63,6 +72,10 @@ void buffer_free(Buffer *buf) {
     buf->capacity = 0;
 }
 
+int buffer_append_bytes(Buffer *buf, const void *data, size_t len) {
+    return buffer_append(buf, (const char *)data, len);
+}
+
 int buffer_append_cstr(Buffer *buf, const char *text) {
     if (!text) {
         return buffer_append(buf, "", 0);
@@ -106,50 +119,149 @@ int buffer_appendf(Buffer *buf, const char *fmt, ...) {
     return 1;
 }
 
-int buffer_append_json_string(Buffer *buf, const char *text) {
+int buffer_append_int64(Buffer *buf, int64_t value) {
+    char digits[NUMBER_FORMAT_MAX];
+    size_t len = format_int64(digits, value);
+    return buffer_append(buf, digits, len);
+}
+
+int buffer_append_fixed(Buffer *buf, double value, int precision) {
+    char digits[NUMBER_FORMAT_MAX];
+    size_t len = format_double_fixed(digits, value, precision, false);
+    return buffer_append(buf, digits, len);
+}
+
+int buffer_append_double(Buffer *buf, double value) {
+    char digits[NUMBER_FORMAT_MAX];
+    size_t len = format_double_shortest(digits, value);
+    return buffer_append(buf, digits, len);
+}
+
+/* Second byte of the two-character escape for each byte, 'u' for \u00XX, 0 for bytes copied verbatim. */
+static const char JSON_ESCAPE[256] = {
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+    0,   0,   '"', 0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    ['\\'] = '\\'
+};
+
+/* Length of the leading run of bytes that need no JSON escaping. */
+static size_t json_clean_run(const unsigned char *p, size_t len) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i quote32 = _mm256_set1_epi8('"');
+    const __m256i slash32 = _mm256_set1_epi8('\\');
+    const __m256i ctrl32 = _mm256_set1_epi8(0x1F);
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(v, quote32), _mm256_cmpeq_epi8(v, slash32));
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(_mm256_min_epu8(v, ctrl32), v));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hit);
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i slash = _mm_set1_epi8('\\');
+    const __m128i ctrl = _mm_set1_epi8(0x1F);
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, slash));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(_mm_min_epu8(v, ctrl), v));
+        unsigned mask = (unsigned)_mm_movemask_epi8(hit);
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+#endif
+    while (i < len && !JSON_ESCAPE[p[i]]) {
+        i++;
+    }
+    return i;
+}
+
+int buffer_append_json_escaped(Buffer *buf, const char *text, size_t len) {
+    if (!buf || (!text && len > 0)) {
+        return 0;
+    }
+    static const char hex[] = "0123456789abcdef";
+    const unsigned char *p = (const unsigned char *)text;
+    /* Most text needs no escapes, so reserve for the verbatim case and grow only when escapes appear. */
+    if (!buffer_reserve(buf, len)) {
+        return 0;
+    }
+    size_t i = 0;
+    while (i < len) {
+        size_t run = json_clean_run(p + i, len - i);
+        if (run > 0) {
+            if (!buffer_reserve(buf, run)) {
+                return 0;
+            }
+            memcpy(buf->data + buf->length, p + i, run);
+            buf->length += run;
+            i += run;
+            if (i == len) {
+                break;
+            }
+        }
+        unsigned char c = p[i++];
+        if (!buffer_reserve(buf, 6 + (len - i))) {
+            return 0;
+        }
+        char *out = buf->data + buf->length;
+        char esc = JSON_ESCAPE[c];
+        out[0] = '\\';
+        out[1] = esc;
+        if (esc == 'u') {
+            out[2] = '0';
+            out[3] = '0';
+            out[4] = hex[c >> 4];
+            out[5] = hex[c & 0xF];
+            buf->length += 6;
+        } else {
+            buf->length += 2;
+        }
+    }
+    buf->data[buf->length] = '\0';
+    return 1;
+}
+
+int buffer_append_html_escaped(Buffer *buf, const char *text) {
     if (!buf) {
         return 0;
     }
     if (!text) {
-        return buffer_append_cstr(buf, "null");
+        return 1;
+    }
+    const char *run = text;
+    for (const char *p = text; *p; ++p) {
+        const char *entity = NULL;
+        switch (*p) {
+            case '&': entity = "&amp;"; break;
+            case '<': entity = "&lt;"; break;
+            case '>': entity = "&gt;"; break;
+            case '"': entity = "&quot;"; break;
+            case '\'': entity = "&#39;"; break;
+            default: continue;
+        }
+        if (!buffer_append(buf, run, (size_t)(p - run)) || !buffer_append_cstr(buf, entity)) {
+            return 0;
+        }
+        run = p + 1;
     }
-    if (!buffer_append_char(buf, '"')) {
+    return buffer_append_cstr(buf, run);
+}
+
+int buffer_append_json_string(Buffer *buf, const char *text) {
+    if (!buf) {
         return 0;
     }
-    for (const unsigned char *p = (const unsigned char *)text; *p; ++p) {
-        unsigned char c = *p;
-        switch (c) {
-            case '"':
-                if (!buffer_append_cstr(buf, "\\\"")) return 0;
-                break;
-            case '\\':
-                if (!buffer_append_cstr(buf, "\\\\")) return 0;
-                break;
-            case '\b':
-                if (!buffer_append_cstr(buf, "\\b")) return 0;
-                break;
-            case '\f':
-                if (!buffer_append_cstr(buf, "\\f")) return 0;
-                break;
-            case '\n':
-                if (!buffer_append_cstr(buf, "\\n")) return 0;
-                break;
-            case '\r':
-                if (!buffer_append_cstr(buf, "\\r")) return 0;
-                break;
-            case '\t':
-                if (!buffer_append_cstr(buf, "\\t")) return 0;
-                break;
-            default:
-                if (c < 0x20) {
-                    char esc[7];
-                    snprintf(esc, sizeof(esc), "\\u%04x", c);
-                    if (!buffer_append_cstr(buf, esc)) return 0;
-                } else {
-                    if (!buffer_append_char(buf, (char)c)) return 0;
-                }
-                break;
-        }
+    if (!text) {
+        return buffer_append_cstr(buf, "null");
     }
-    return buffer_append_char(buf, '"');
+    return buffer_append_char(buf, '"') &&
+           buffer_append_json_escaped(buf, text, strlen(text)) &&
+           buffer_append_char(buf, '"');
 }
@@ -15,9 +15,20 @@ char *g_database_dsn = NULL;
 char *g_report_output_dir = NULL;
 char *g_report_assets_dir = NULL;
 char *g_xai_api_key = NULL;
+char *g_xai_api_url = NULL;
 char *g_google_api_key = NULL;
 char *g_google_region_code = NULL;
+char *g_google_address_url = NULL;
 double g_modernization_cost_per_device = 250000.0;
+int g_latex_format_enabled = 1;
+int g_native_deficiency_pdf = 1;
+int g_latex_fragment_cache_mb = 64;
+int g_latex_assembly_threads = 0;
+int g_narrative_cache_enabled = 1;
+int g_narrative_cache_version = 1;
+int g_narrative_cache_max_age_days = 90;
+int g_narrative_device_batch_size = 4;
+int g_narrative_deadline_seconds = 300;
 
 static void trim_inplace(char *str) {
     if (!str) {
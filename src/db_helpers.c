@@ -2,6 +2,7 @@
 
 #include "buffer.h"
 #include "log.h"
+#include "number_format.h"
 
 #include <errno.h>
 #include <stdbool.h>
@@ -56,37 +57,303 @@ char *db_fetch_audit_list(PGconn *conn, char **error_out) {
     return json;
 }
 
-char *db_fetch_audit_detail(PGconn *conn, const char *uuid, char **error_out) {
+int db_stream_rows(PGconn *conn, const char *sql, int n_params, const char *const *params, int result_format,
+                   int batch_rows, DbRowFn on_row, void *ctx, char **error_out) {
+    if (!conn || !sql || !on_row) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Invalid row stream parameters");
+        }
+        return 0;
+    }
+    if (!PQsendQueryParams(conn, sql, n_params, NULL, params, NULL, NULL, result_format)) {
+        if (error_out && !*error_out) {
+            *error_out = strdup(PQerrorMessage(conn));
+        }
+        return 0;
+    }
+#ifdef LIBPQ_HAS_CHUNK_MODE
+    if (batch_rows > 1) {
+        PQsetChunkedRowsMode(conn, batch_rows);
+    } else {
+        PQsetSingleRowMode(conn);
+    }
+#else
+    (void)batch_rows;
+    PQsetSingleRowMode(conn);
+#endif
+
+    int ok = 1;
+    PGresult *res;
+    /* Always drain to the terminating NULL so the connection is ready for the next query. */
+    while ((res = PQgetResult(conn)) != NULL) {
+        ExecStatusType status = PQresultStatus(res);
+        bool has_rows = status == PGRES_SINGLE_TUPLE || status == PGRES_TUPLES_OK;
+#ifdef LIBPQ_HAS_CHUNK_MODE
+        has_rows = has_rows || status == PGRES_TUPLES_CHUNK;
+#endif
+        if (ok && has_rows) {
+            int rows = PQntuples(res);
+            for (int row = 0; row < rows; ++row) {
+                if (!on_row(ctx, res, row)) {
+                    ok = 0;
+                    PGcancel *cancel = PQgetCancel(conn);
+                    if (cancel) {
+                        char cancel_error[256];
+                        PQcancel(cancel, cancel_error, sizeof(cancel_error));
+                        PQfreeCancel(cancel);
+                    }
+                    break;
+                }
+            }
+        } else if (ok && !has_rows) {
+            if (error_out && !*error_out) {
+                const char *msg = PQresultErrorMessage(res);
+                *error_out = strdup(msg && msg[0] ? msg : "Database query failed");
+            }
+            ok = 0;
+        }
+        PQclear(res);
+    }
+    return ok;
+}
+
+#define AUDIT_DETAIL_FLUSH_BYTES (64 * 1024)
+
+typedef struct {
+    Buffer out;
+    DbWriteFn write_fn;
+    void *ctx;
+    size_t photos;
+    bool failed;
+} AuditDetailWriter;
+
+static int audit_detail_flush(AuditDetailWriter *writer, size_t threshold) {
+    if (!writer->failed && writer->out.length > 0 && writer->out.length >= threshold) {
+        if (!writer->write_fn(writer->ctx, writer->out.data, writer->out.length)) {
+            writer->failed = true;
+        }
+        writer->out.length = 0;
+    }
+    return !writer->failed;
+}
+
+static int audit_detail_append_field(Buffer *out, const char *key, const PGresult *res, int row, int column) {
+    return buffer_append_json_string(out, key) &&
+           buffer_append_cstr(out, ":") &&
+           (PQgetisnull(res, row, column) ? buffer_append_cstr(out, "null")
+                                          : buffer_append_json_string(out, PQgetvalue(res, row, column)));
+}
+
+static int audit_detail_photo_row(void *ctx, const PGresult *res, int row) {
+    AuditDetailWriter *writer = (AuditDetailWriter *)ctx;
+    Buffer *out = &writer->out;
+    int ok = buffer_append_cstr(out, writer->photos > 0 ? ",{\"id\":" : "{\"id\":") &&
+             buffer_append_cstr(out, PQgetvalue(res, row, 0)) &&
+             buffer_append_cstr(out, ",") &&
+             audit_detail_append_field(out, "photo_filename", res, row, 1) &&
+             buffer_append_cstr(out, ",") &&
+             audit_detail_append_field(out, "content_type", res, row, 2) &&
+             buffer_append_cstr(out, ",\"size\":") &&
+             buffer_append_cstr(out, PQgetvalue(res, row, 3)) &&
+             buffer_append_cstr(out, ",") &&
+             audit_detail_append_field(out, "sha256", res, row, 4) &&
+             buffer_append_cstr(out, "}");
+    writer->photos++;
+    return ok && audit_detail_flush(writer, AUDIT_DETAIL_FLUSH_BYTES);
+}
+
+int db_write_audit_detail(PGconn *conn, const char *uuid, DbWriteFn write_fn, void *ctx, char **error_out) {
+    if (!conn || !uuid || !write_fn) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Invalid audit detail parameters");
+        }
+        return 0;
+    }
     const char *paramValues[1] = { uuid };
-    const char *sql =
-        "SELECT json_build_object("
-        "  'audit', row_to_json(a),"
-        "  'deficiencies', COALESCE((SELECT json_agg(row_to_json(d)) FROM audit_deficiencies d WHERE d.audit_uuid = a.audit_uuid), '[]'::json),"
-        "  'photos', COALESCE((SELECT json_agg(json_build_object("
-        "     'photo_filename', p.photo_filename,"
-        "     'content_type', p.content_type,"
-        "     'photo_bytes', encode(p.photo_bytes, 'base64')"
-        "  )) FROM audit_photos p WHERE p.audit_uuid = a.audit_uuid), '[]'::json)"
-        ")::text "
+    const char *head_sql =
+        "SELECT row_to_json(a)::text,"
+        "  COALESCE((SELECT json_agg(row_to_json(d)) FROM audit_deficiencies d WHERE d.audit_uuid = a.audit_uuid), '[]'::json)::text "
         "FROM audits a "
         "WHERE audit_uuid = $1::uuid;";
-    PGresult *res = PQexecParams(conn, sql, 1, NULL, paramValues, NULL, NULL, 0);
+    PGresult *res = PQexecParams(conn, head_sql, 1, NULL, paramValues, NULL, NULL, 0);
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        if (error_out) {
+        if (error_out && !*error_out) {
             const char *msg = PQresultErrorMessage(res);
             *error_out = strdup(msg ? msg : "Database query failed");
         }
         PQclear(res);
-        return NULL;
+        return 0;
     }
     if (PQntuples(res) == 0 || PQgetisnull(res, 0, 0)) {
         PQclear(res);
-        return NULL;
+        return -1;
+    }
+
+    AuditDetailWriter writer = { .write_fn = write_fn, .ctx = ctx };
+    if (!buffer_init(&writer.out) ||
+        !buffer_append_cstr(&writer.out, "{\"audit\":") ||
+        !buffer_append_cstr(&writer.out, PQgetvalue(res, 0, 0)) ||
+        !buffer_append_cstr(&writer.out, ",\"deficiencies\":") ||
+        !buffer_append_cstr(&writer.out, PQgetisnull(res, 0, 1) ? "[]" : PQgetvalue(res, 0, 1)) ||
+        !buffer_append_cstr(&writer.out, ",\"photos\":[")) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Out of memory building audit detail");
+        }
+        PQclear(res);
+        buffer_free(&writer.out);
+        return 0;
     }
-    const char *value = PQgetvalue(res, 0, 0);
-    char *json = strdup(value ? value : "{}");
     PQclear(res);
-    return json;
+
+    /* Metadata only; the bytes are served by /audits/{uuid}/photos/{id}. octet_length reads
+       the stored size without detoasting the blob. */
+    const char *photo_sql =
+        "SELECT p.id, p.photo_filename, p.content_type, octet_length(b.photo_bytes), p.photo_sha256 "
+        "FROM audit_photos p "
+        "JOIN photo_blobs b ON b.sha256 = p.photo_sha256 "
+        "WHERE p.audit_uuid = $1::uuid "
+        "ORDER BY p.id";
+    int ok = db_stream_rows(conn, photo_sql, 1, paramValues, 0, 256, audit_detail_photo_row, &writer, error_out) &&
+             buffer_append_cstr(&writer.out, "]}") &&
+             audit_detail_flush(&writer, 0);
+    if (!ok && error_out && !*error_out) {
+        *error_out = strdup(writer.failed ? "Client disconnected" : "Out of memory building audit detail");
+    }
+    buffer_free(&writer.out);
+    return ok;
+}
+
+/* Renditions are always JPEG; a request falls back to the next larger size that was rendered. */
+static const char *const AUDIT_PHOTO_SERVED_SQL[] = {
+    [AUDIT_PHOTO_ORIGINAL] = "0",
+    [AUDIT_PHOTO_PREVIEW] = "CASE WHEN b.preview_bytes IS NOT NULL THEN 1 ELSE 0 END",
+    [AUDIT_PHOTO_THUMB] = "CASE WHEN b.thumb_bytes IS NOT NULL THEN 2 WHEN b.preview_bytes IS NOT NULL THEN 1 ELSE 0 END"
+};
+static const char *const AUDIT_PHOTO_BYTES_SQL[] = {
+    [AUDIT_PHOTO_ORIGINAL] = "b.photo_bytes",
+    [AUDIT_PHOTO_PREVIEW] = "COALESCE(b.preview_bytes, b.photo_bytes)",
+    [AUDIT_PHOTO_THUMB] = "COALESCE(b.thumb_bytes, b.preview_bytes, b.photo_bytes)"
+};
+
+int db_fetch_audit_photo(PGconn *conn, const char *uuid, long photo_id, AuditPhotoSize size, bool include_bytes,
+                         AuditPhoto *out, char **error_out) {
+    if (!out) {
+        return 0;
+    }
+    memset(out, 0, sizeof(*out));
+    if (!conn || !uuid || photo_id <= 0 || size < AUDIT_PHOTO_ORIGINAL || size > AUDIT_PHOTO_THUMB) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Invalid audit photo parameters");
+        }
+        return 0;
+    }
+    char id_text[32];
+    snprintf(id_text, sizeof(id_text), "%ld", photo_id);
+    const char *paramValues[2] = { uuid, id_text };
+    /* Binary results hand the bytes over as-is; the text columns are unaffected. */
+    char sql[512];
+    snprintf(sql, sizeof(sql),
+             "SELECT p.photo_filename, p.content_type, p.photo_sha256, (%s)::text, b.renditions_done::text%s%s "
+             "FROM audit_photos p JOIN photo_blobs b ON b.sha256 = p.photo_sha256 "
+             "WHERE p.audit_uuid = $1::uuid AND p.id = $2::bigint",
+             AUDIT_PHOTO_SERVED_SQL[size], include_bytes ? ", " : "", include_bytes ? AUDIT_PHOTO_BYTES_SQL[size] : "");
+    PGresult *res = PQexecParams(conn, sql, 2, NULL, paramValues, NULL, NULL, 1);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        if (error_out && !*error_out) {
+            const char *msg = PQresultErrorMessage(res);
+            *error_out = strdup(msg && msg[0] ? msg : "Database query failed");
+        }
+        PQclear(res);
+        return 0;
+    }
+    if (PQntuples(res) == 0) {
+        PQclear(res);
+        return -1;
+    }
+    out->res = res;
+    out->filename = PQgetvalue(res, 0, 0);
+    out->content_type = PQgetvalue(res, 0, 1);
+    out->sha256 = PQgetvalue(res, 0, 2);
+    out->served = (AuditPhotoSize)atoi(PQgetvalue(res, 0, 3));
+    out->renditions_done = PQgetvalue(res, 0, 4)[0] == 't';
+    if (out->served != AUDIT_PHOTO_ORIGINAL) {
+        out->content_type = "image/jpeg";
+    }
+    if (include_bytes) {
+        out->data = (const unsigned char *)PQgetvalue(res, 0, 5);
+        out->size = (size_t)PQgetlength(res, 0, 5);
+    }
+    return 1;
+}
+
+void audit_photo_clear(AuditPhoto *photo) {
+    if (!photo) {
+        return;
+    }
+    PQclear(photo->res);
+    memset(photo, 0, sizeof(*photo));
+}
+
+int db_prune_photo_blobs(PGconn *conn, const char *const *sha256, size_t count, long *removed_out, char **error_out) {
+    if (removed_out) {
+        *removed_out = 0;
+    }
+    if (!conn) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Database connection unavailable");
+        }
+        return 0;
+    }
+    if (sha256 && count == 0) {
+        return 1;
+    }
+    /* Digests are plain hex, so the array literal needs no quoting. */
+    Buffer candidates;
+    if (!buffer_init(&candidates) || !buffer_append_cstr(&candidates, "{")) {
+        buffer_free(&candidates);
+        if (error_out && !*error_out) {
+            *error_out = strdup("Out of memory pruning photo blobs");
+        }
+        return 0;
+    }
+    for (size_t i = 0; sha256 && i < count; ++i) {
+        if ((i > 0 && !buffer_append_cstr(&candidates, ",")) || !buffer_append_cstr(&candidates, sha256[i])) {
+            buffer_free(&candidates);
+            if (error_out && !*error_out) {
+                *error_out = strdup("Out of memory pruning photo blobs");
+            }
+            return 0;
+        }
+    }
+    if (!buffer_append_cstr(&candidates, "}")) {
+        buffer_free(&candidates);
+        if (error_out && !*error_out) {
+            *error_out = strdup("Out of memory pruning photo blobs");
+        }
+        return 0;
+    }
+
+    const char *sql = sha256
+        ? "DELETE FROM photo_blobs b WHERE b.sha256 = ANY($1::text[]) "
+          "AND NOT EXISTS (SELECT 1 FROM audit_photos p WHERE p.photo_sha256 = b.sha256)"
+        : "DELETE FROM photo_blobs b "
+          "WHERE NOT EXISTS (SELECT 1 FROM audit_photos p WHERE p.photo_sha256 = b.sha256)";
+    const char *paramValues[1] = { candidates.data };
+    PGresult *res = PQexecParams(conn, sql, sha256 ? 1 : 0, NULL, sha256 ? paramValues : NULL, NULL, NULL, 0);
+    buffer_free(&candidates);
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        if (error_out && !*error_out) {
+            const char *msg = PQresultErrorMessage(res);
+            *error_out = strdup(msg && msg[0] ? msg : "Failed to prune photo blobs");
+        }
+        PQclear(res);
+        return 0;
+    }
+    if (removed_out) {
+        *removed_out = strtol(PQcmdTuples(res), NULL, 10);
+    }
+    PQclear(res);
+    return 1;
 }
 
 char *db_fetch_location_list(PGconn *conn, int page, int page_size, const char *search, const char *sort, char **error_out) {
@@ -486,13 +753,13 @@ char *db_fetch_metrics_summary(PGconn *conn, char **error_out) {
     double total_spend = 0.0;
     if (PQntuples(res) > 0) {
         if (!PQgetisnull(res, 0, 0)) {
-            total_savings = strtod(PQgetvalue(res, 0, 0), NULL);
+            total_savings = parse_decimal_double(PQgetvalue(res, 0, 0), NULL);
         }
         if (!PQgetisnull(res, 0, 1)) {
-            total_proposed = strtod(PQgetvalue(res, 0, 1), NULL);
+            total_proposed = parse_decimal_double(PQgetvalue(res, 0, 1), NULL);
         }
         if (!PQgetisnull(res, 0, 2)) {
-            total_spend = strtod(PQgetvalue(res, 0, 2), NULL);
+            total_spend = parse_decimal_double(PQgetvalue(res, 0, 2), NULL);
         }
     }
     PQclear(res);
@@ -507,13 +774,13 @@ char *db_fetch_metrics_summary(PGconn *conn, char **error_out) {
 
     if (!buffer_append_char(&buf, '{')) goto metrics_oom;
     if (!buffer_append_cstr(&buf, "\"total_savings\":")) goto metrics_oom;
-    if (!buffer_appendf(&buf, "%.2f", total_savings)) goto metrics_oom;
+    if (!buffer_append_fixed(&buf, total_savings, 2)) goto metrics_oom;
     if (!buffer_append_char(&buf, ',')) goto metrics_oom;
     if (!buffer_append_cstr(&buf, "\"total_proposed\":")) goto metrics_oom;
-    if (!buffer_appendf(&buf, "%.2f", total_proposed)) goto metrics_oom;
+    if (!buffer_append_fixed(&buf, total_proposed, 2)) goto metrics_oom;
     if (!buffer_append_char(&buf, ',')) goto metrics_oom;
     if (!buffer_append_cstr(&buf, "\"total_spend\":")) goto metrics_oom;
-    if (!buffer_appendf(&buf, "%.2f", total_spend)) goto metrics_oom;
+    if (!buffer_append_fixed(&buf, total_spend, 2)) goto metrics_oom;
     if (!buffer_append_char(&buf, '}')) goto metrics_oom;
 
     return buf.data;
@@ -0,0 +1,142 @@
+#include "fragment_cache.h"
+
+#include "hash_index.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    unsigned char key[SHA256_DIGEST_SIZE];
+    char *text;
+    size_t len;
+} FragmentEntry;
+
+typedef struct {
+    FragmentEntry *entries;
+    size_t count;
+    size_t capacity;
+    size_t bytes;
+    HashIndex index;
+} FragmentGeneration;
+
+static pthread_mutex_t g_fragment_mutex = PTHREAD_MUTEX_INITIALIZER;
+static FragmentGeneration g_fragment_current = {0};
+static FragmentGeneration g_fragment_previous = {0};
+static size_t g_fragment_limit = 0;
+
+static uint32_t fragment_key_hash(const unsigned char key[SHA256_DIGEST_SIZE]) {
+    /* The key is already a digest; its leading bytes are as good as any hash. */
+    return ((uint32_t)key[0] << 24) | ((uint32_t)key[1] << 16) | ((uint32_t)key[2] << 8) | (uint32_t)key[3];
+}
+
+static void fragment_generation_clear(FragmentGeneration *gen) {
+    for (size_t i = 0; i < gen->count; ++i) {
+        free(gen->entries[i].text);
+    }
+    free(gen->entries);
+    hash_index_clear(&gen->index);
+    memset(gen, 0, sizeof(*gen));
+}
+
+static const FragmentEntry *fragment_generation_find(const FragmentGeneration *gen, const unsigned char key[SHA256_DIGEST_SIZE]) {
+    HashIndexProbe probe;
+    hash_index_probe_init(&probe, &gen->index, fragment_key_hash(key));
+    for (size_t i; (i = hash_index_probe_next(&probe)) != HASH_INDEX_NONE;) {
+        if (memcmp(gen->entries[i].key, key, SHA256_DIGEST_SIZE) == 0) {
+            return &gen->entries[i];
+        }
+    }
+    return NULL;
+}
+
+/* Takes ownership of text. */
+static int fragment_generation_insert(FragmentGeneration *gen, const unsigned char key[SHA256_DIGEST_SIZE], char *text, size_t len) {
+    if (gen->count == gen->capacity) {
+        size_t new_cap = gen->capacity == 0 ? 64 : gen->capacity * 2;
+        FragmentEntry *tmp = realloc(gen->entries, new_cap * sizeof(*tmp));
+        if (!tmp) {
+            return 0;
+        }
+        gen->entries = tmp;
+        gen->capacity = new_cap;
+    }
+    if (!hash_index_insert(&gen->index, fragment_key_hash(key), gen->count)) {
+        return 0;
+    }
+    FragmentEntry *entry = &gen->entries[gen->count++];
+    memcpy(entry->key, key, SHA256_DIGEST_SIZE);
+    entry->text = text;
+    entry->len = len;
+    gen->bytes += len;
+    return 1;
+}
+
+/* Caller holds the mutex. Flips generations first when the copy would overfill the current one. */
+static void fragment_cache_insert_locked(const unsigned char key[SHA256_DIGEST_SIZE], const char *text, size_t len) {
+    size_t generation_limit = g_fragment_limit / 2;
+    if (len > generation_limit) {
+        return;
+    }
+    char *copy = malloc(len + 1);
+    if (!copy) {
+        return;
+    }
+    memcpy(copy, text, len);
+    copy[len] = '\0';
+    if (g_fragment_current.bytes + len > generation_limit) {
+        fragment_generation_clear(&g_fragment_previous);
+        g_fragment_previous = g_fragment_current;
+        memset(&g_fragment_current, 0, sizeof(g_fragment_current));
+    }
+    if (!fragment_generation_insert(&g_fragment_current, key, copy, len)) {
+        free(copy);
+    }
+}
+
+void fragment_cache_set_limit(size_t max_bytes) {
+    pthread_mutex_lock(&g_fragment_mutex);
+    g_fragment_limit = max_bytes;
+    fragment_generation_clear(&g_fragment_current);
+    fragment_generation_clear(&g_fragment_previous);
+    pthread_mutex_unlock(&g_fragment_mutex);
+}
+
+int fragment_cache_enabled(void) {
+    pthread_mutex_lock(&g_fragment_mutex);
+    int enabled = g_fragment_limit > 0;
+    pthread_mutex_unlock(&g_fragment_mutex);
+    return enabled;
+}
+
+int fragment_cache_fetch(const unsigned char key[SHA256_DIGEST_SIZE], Buffer *out) {
+    if (!key || !out) {
+        return 0;
+    }
+    int hit = 0;
+    pthread_mutex_lock(&g_fragment_mutex);
+    const FragmentEntry *entry = fragment_generation_find(&g_fragment_current, key);
+    if (entry) {
+        hit = buffer_append_bytes(out, entry->text, entry->len);
+    } else if ((entry = fragment_generation_find(&g_fragment_previous, key)) != NULL) {
+        hit = buffer_append_bytes(out, entry->text, entry->len);
+        /* Promote from the appended copy: a flip during the insert frees the old entry. */
+        if (hit) {
+            fragment_cache_insert_locked(key, out->data + out->length - entry->len, entry->len);
+        }
+    }
+    pthread_mutex_unlock(&g_fragment_mutex);
+    return hit;
+}
+
+void fragment_cache_store(const unsigned char key[SHA256_DIGEST_SIZE], const char *text, size_t len) {
+    if (!key || !text) {
+        return;
+    }
+    pthread_mutex_lock(&g_fragment_mutex);
+    if (g_fragment_limit > 0 && !fragment_generation_find(&g_fragment_current, key)) {
+        fragment_cache_insert_locked(key, text, len);
+    }
+    pthread_mutex_unlock(&g_fragment_mutex);
+}
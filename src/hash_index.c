@@ -0,0 +1,123 @@
+#include "hash_index.h"
+
+#include <stdlib.h>
+
+#define HASH_INDEX_MIN_CAPACITY 16
+
+/* Slot layout: high 32 bits hold the hash, low 32 bits hold position + 1, 0 is empty. */
+static uint64_t make_slot(uint32_t hash, size_t position) {
+    return ((uint64_t)hash << 32) | (uint64_t)(position + 1);
+}
+
+static uint32_t slot_hash(uint64_t slot) {
+    return (uint32_t)(slot >> 32);
+}
+
+static size_t slot_position(uint64_t slot) {
+    return (size_t)(slot & 0xFFFFFFFFu) - 1;
+}
+
+void hash_index_init(HashIndex *index) {
+    if (!index) {
+        return;
+    }
+    index->slots = NULL;
+    index->capacity = 0;
+    index->count = 0;
+}
+
+void hash_index_clear(HashIndex *index) {
+    if (!index) {
+        return;
+    }
+    free(index->slots);
+    index->slots = NULL;
+    index->capacity = 0;
+    index->count = 0;
+}
+
+static void place_slot(uint64_t *slots, size_t capacity, uint64_t slot) {
+    size_t mask = capacity - 1;
+    size_t i = slot_hash(slot) & mask;
+    while (slots[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    slots[i] = slot;
+}
+
+static int hash_index_grow(HashIndex *index) {
+    size_t new_capacity = index->capacity ? index->capacity * 2 : HASH_INDEX_MIN_CAPACITY;
+    uint64_t *slots = calloc(new_capacity, sizeof(uint64_t));
+    if (!slots) {
+        return 0;
+    }
+    for (size_t i = 0; i < index->capacity; ++i) {
+        if (index->slots[i] != 0) {
+            place_slot(slots, new_capacity, index->slots[i]);
+        }
+    }
+    free(index->slots);
+    index->slots = slots;
+    index->capacity = new_capacity;
+    return 1;
+}
+
+int hash_index_insert(HashIndex *index, uint32_t hash, size_t position) {
+    if (!index || position >= 0xFFFFFFFFu) {
+        return 0;
+    }
+    /* Keep the load factor at or below one half so linear probe runs stay short. */
+    if ((index->count + 1) * 2 > index->capacity && !hash_index_grow(index)) {
+        return 0;
+    }
+    place_slot(index->slots, index->capacity, make_slot(hash, position));
+    index->count++;
+    return 1;
+}
+
+void hash_index_probe_init(HashIndexProbe *probe, const HashIndex *index, uint32_t hash) {
+    probe->index = index;
+    probe->hash = hash;
+    probe->slot = (index && index->capacity) ? (hash & (index->capacity - 1)) : 0;
+    probe->probes = 0;
+}
+
+size_t hash_index_probe_next(HashIndexProbe *probe) {
+    const HashIndex *index = probe->index;
+    if (!index || index->capacity == 0) {
+        return HASH_INDEX_NONE;
+    }
+    size_t mask = index->capacity - 1;
+    while (probe->probes < index->capacity) {
+        uint64_t slot = index->slots[probe->slot];
+        if (slot == 0) {
+            return HASH_INDEX_NONE;
+        }
+        probe->slot = (probe->slot + 1) & mask;
+        probe->probes++;
+        if (slot_hash(slot) == probe->hash) {
+            return slot_position(slot);
+        }
+    }
+    return HASH_INDEX_NONE;
+}
+
+uint32_t hash_string(const char *key) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    if (key) {
+        for (const unsigned char *p = (const unsigned char *)key; *p; ++p) {
+            h ^= *p;
+            h *= 0x100000001b3ULL;
+        }
+    }
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+uint32_t hash_uint64(uint64_t key) {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return (uint32_t)key;
+}
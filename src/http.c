@@ -2,7 +2,6 @@
 
 #include "buffer.h"
 #include "config.h"
-#include "json_utils.h"
 
 #include <errno.h>
 #include <fcntl.h>
@@ -50,19 +49,13 @@ char *build_success_response(const StringArray *audits) {
 
 char *build_error_response(const char *message) {
     const char *text = message ? message : "Unknown error";
-    char *escaped = json_escape_string(text);
-    if (!escaped) {
-        return NULL;
-    }
     Buffer buf;
     if (!buffer_init(&buf)) {
-        free(escaped);
         return NULL;
     }
-    bool ok = buffer_append_cstr(&buf, "{\"status\":\"error\",\"message\":\"") &&
-              buffer_append_cstr(&buf, escaped) &&
-              buffer_append_cstr(&buf, "\"}");
-    free(escaped);
+    bool ok = buffer_append_cstr(&buf, "{\"status\":\"error\",\"message\":") &&
+              buffer_append_json_string(&buf, text) &&
+              buffer_append_cstr(&buf, "}");
     if (!ok) {
         buffer_free(&buf);
         return NULL;
@@ -104,6 +97,124 @@ void send_http_json(int client_fd, int status_code, const char *status_text, con
     send_http_response(client_fd, status_code, status_text, "application/json", json_body, len);
 }
 
+static int send_all(int client_fd, const void *data, size_t len) {
+    const char *p = (const char *)data;
+    while (len > 0) {
+        ssize_t sent = send(client_fd, p, len, 0);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return 0;
+        }
+        p += sent;
+        len -= (size_t)sent;
+    }
+    return 1;
+}
+
+int send_http_stream_start(int client_fd, int status_code, const char *status_text, const char *content_type) {
+    if (!status_text) {
+        status_text = "OK";
+    }
+    if (!content_type) {
+        content_type = "application/octet-stream";
+    }
+    char header[512];
+    int header_len = snprintf(header, sizeof(header),
+                              "HTTP/1.1 %d %s\r\n"
+                              "Content-Type: %s\r\n"
+                              "Transfer-Encoding: chunked\r\n"
+                              "Cache-Control: no-store\r\n"
+                              "Access-Control-Allow-Origin: *\r\n"
+                              "Access-Control-Allow-Methods: GET, POST, PATCH, OPTIONS\r\n"
+                              "Access-Control-Allow-Headers: Content-Type, X-API-Key\r\n"
+                              "Connection: close\r\n\r\n",
+                              status_code, status_text, content_type);
+    if (header_len < 0 || header_len >= (int)sizeof(header)) {
+        return 0;
+    }
+    return send_all(client_fd, header, (size_t)header_len);
+}
+
+int send_http_download_stream_start(int client_fd, const char *content_type, const char *filename) {
+    char header[1024];
+    int header_len = snprintf(header, sizeof(header),
+                              "HTTP/1.1 200 OK\r\n"
+                              "Content-Type: %s\r\n"
+                              "Transfer-Encoding: chunked\r\n"
+                              "Content-Disposition: attachment; filename=\"%s\"\r\n"
+                              "Access-Control-Allow-Origin: *\r\n"
+                              "Access-Control-Allow-Methods: GET, POST, PATCH, OPTIONS\r\n"
+                              "Access-Control-Allow-Headers: Content-Type, X-API-Key\r\n"
+                              "Connection: close\r\n\r\n",
+                              content_type ? content_type : "application/octet-stream",
+                              filename ? filename : "download.bin");
+    if (header_len < 0 || header_len >= (int)sizeof(header)) {
+        return 0;
+    }
+    return send_all(client_fd, header, (size_t)header_len);
+}
+
+int send_http_chunk(int client_fd, const void *data, size_t len) {
+    if (len == 0) {
+        /* A zero-length chunk would terminate the body. */
+        return 1;
+    }
+    char size_line[32];
+    int size_len = snprintf(size_line, sizeof(size_line), "%zx\r\n", len);
+    if (size_len < 0) {
+        return 0;
+    }
+    return send_all(client_fd, size_line, (size_t)size_len) &&
+           send_all(client_fd, data, len) &&
+           send_all(client_fd, "\r\n", 2);
+}
+
+int send_http_stream_end(int client_fd) {
+    return send_all(client_fd, "0\r\n\r\n", 5);
+}
+
+static const char *cache_control_for(bool immutable) {
+    return immutable ? "public, max-age=31536000, immutable" : "no-cache";
+}
+
+int send_http_tagged(int client_fd, const char *content_type, const char *etag, bool immutable, const void *body, size_t body_len) {
+    char header[768];
+    int header_len = snprintf(header, sizeof(header),
+                              "HTTP/1.1 200 OK\r\n"
+                              "Content-Type: %s\r\n"
+                              "Content-Length: %zu\r\n"
+                              "ETag: \"%s\"\r\n"
+                              "Cache-Control: %s\r\n"
+                              "Access-Control-Allow-Origin: *\r\n"
+                              "Access-Control-Allow-Methods: GET, POST, PATCH, OPTIONS\r\n"
+                              "Access-Control-Allow-Headers: Content-Type, X-API-Key\r\n"
+                              "Connection: close\r\n\r\n",
+                              content_type ? content_type : "application/octet-stream", body_len, etag ? etag : "",
+                              cache_control_for(immutable));
+    if (header_len < 0 || header_len >= (int)sizeof(header)) {
+        return 0;
+    }
+    return send_all(client_fd, header, (size_t)header_len) &&
+           (body_len == 0 || send_all(client_fd, body, body_len));
+}
+
+int send_http_not_modified(int client_fd, const char *etag, bool immutable) {
+    char header[512];
+    int header_len = snprintf(header, sizeof(header),
+                              "HTTP/1.1 304 Not Modified\r\n"
+                              "ETag: \"%s\"\r\n"
+                              "Cache-Control: %s\r\n"
+                              "Access-Control-Allow-Origin: *\r\n"
+                              "Connection: close\r\n\r\n",
+                              etag ? etag : "", cache_control_for(immutable));
+    if (header_len < 0 || header_len >= (int)sizeof(header)) {
+        return 0;
+    }
+    return send_all(client_fd, header, (size_t)header_len);
+}
+
 const char *mime_type_for(const char *path) {
     const char *ext = strrchr(path, '.');
     if (!ext || ext[1] == '\0') {
@@ -271,6 +382,63 @@ char *http_extract_query_param(const char *query_string, const char *key) {
     return result;
 }
 
+char *http_extract_header(const char *header_lines, const char *name) {
+    if (!header_lines || !name || *name == '\0') {
+        return NULL;
+    }
+    size_t name_len = strlen(name);
+    const char *line = header_lines;
+    while (*line) {
+        const char *next = strstr(line, "\r\n");
+        size_t len = next ? (size_t)(next - line) : strlen(line);
+        if (len == 0) {
+            break;
+        }
+        if (len > name_len && line[name_len] == ':' && strncasecmp(line, name, name_len) == 0) {
+            const char *value = line + name_len + 1;
+            const char *end = line + len;
+            while (value < end && (*value == ' ' || *value == '\t')) value++;
+            while (end > value && (end[-1] == ' ' || end[-1] == '\t')) end--;
+            return strndup(value, (size_t)(end - value));
+        }
+        if (!next) {
+            break;
+        }
+        line = next + 2;
+    }
+    return NULL;
+}
+
+/* Weak comparison (RFC 9110 13.1.2): W/ prefixes are ignored and "*" matches anything. */
+bool http_etag_matches(const char *if_none_match, const char *etag) {
+    if (!if_none_match || !etag) {
+        return false;
+    }
+    size_t etag_len = strlen(etag);
+    const char *p = if_none_match;
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == ',') p++;
+        if (*p == '*') {
+            return true;
+        }
+        if (strncmp(p, "W/", 2) == 0) {
+            p += 2;
+        }
+        if (*p != '"') {
+            break;
+        }
+        const char *close = strchr(p + 1, '"');
+        if (!close) {
+            break;
+        }
+        if ((size_t)(close - p - 1) == etag_len && strncmp(p + 1, etag, etag_len) == 0) {
+            return true;
+        }
+        p = close + 1;
+    }
+    return false;
+}
+
 void serve_static_file(int client_fd, const char *path) {
     if (!g_static_dir) {
         char *body = build_error_response("Static content unavailable");
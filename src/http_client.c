@@ -0,0 +1,327 @@
+#include "http_client.h"
+
+#include "buffer.h"
+#include "log.h"
+
+#include <curl/curl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HTTP_CLIENT_POLL_MS 1000
+
+struct HttpClientRequest {
+    CURL *easy;
+    struct curl_slist *headers;
+    Buffer response;
+    bool response_ok;
+    char error_buffer[CURL_ERROR_SIZE];
+    CURLcode result;
+    long status;
+    long retry_after;
+    bool done;
+    struct HttpClientRequest *next;
+};
+
+static pthread_mutex_t g_client_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_client_done = PTHREAD_COND_INITIALIZER;
+static pthread_t g_client_thread;
+static bool g_client_running = false;
+static bool g_client_stop = false;
+static CURLM *g_client_multi = NULL;
+/* Only touched by easy handles owned by the client thread, so it needs no lock callbacks. */
+static CURLSH *g_client_share = NULL;
+static HttpClientRequest *g_pending_head = NULL;
+static HttpClientRequest *g_pending_tail = NULL;
+
+static size_t http_client_write(void *contents, size_t size, size_t nmemb, void *userp) {
+    HttpClientRequest *request = (HttpClientRequest *)userp;
+    size_t total = size * nmemb;
+    if (!buffer_append_bytes(&request->response, contents, total)) {
+        request->response_ok = false;
+        return 0;
+    }
+    return total;
+}
+
+static void http_client_request_free(HttpClientRequest *request) {
+    if (!request) {
+        return;
+    }
+    if (request->easy) {
+        curl_easy_cleanup(request->easy);
+    }
+    curl_slist_free_all(request->headers);
+    buffer_free(&request->response);
+    free(request);
+}
+
+/* Records the outcome and releases the easy handle on the thread that ran it. */
+static void http_client_finish(HttpClientRequest *request, CURLcode result) {
+    request->result = result;
+    curl_easy_getinfo(request->easy, CURLINFO_RESPONSE_CODE, &request->status);
+    curl_off_t retry_after = 0;
+    if (curl_easy_getinfo(request->easy, CURLINFO_RETRY_AFTER, &retry_after) == CURLE_OK && retry_after > 0) {
+        request->retry_after = (long)retry_after;
+    }
+    curl_easy_cleanup(request->easy);
+    request->easy = NULL;
+}
+
+static void http_client_complete(HttpClientRequest *request, CURLcode result) {
+    http_client_finish(request, result);
+    pthread_mutex_lock(&g_client_mutex);
+    request->done = true;
+    pthread_cond_broadcast(&g_client_done);
+    pthread_mutex_unlock(&g_client_mutex);
+}
+
+static void *http_client_main(void *arg) {
+    (void)arg;
+    int active = 0;
+    for (;;) {
+        pthread_mutex_lock(&g_client_mutex);
+        HttpClientRequest *pending = g_pending_head;
+        g_pending_head = NULL;
+        g_pending_tail = NULL;
+        bool stop = g_client_stop;
+        pthread_mutex_unlock(&g_client_mutex);
+
+        while (pending) {
+            HttpClientRequest *request = pending;
+            pending = pending->next;
+            request->next = NULL;
+            if (curl_multi_add_handle(g_client_multi, request->easy) != CURLM_OK) {
+                snprintf(request->error_buffer, sizeof(request->error_buffer), "failed to schedule transfer");
+                http_client_complete(request, CURLE_FAILED_INIT);
+                continue;
+            }
+            active++;
+        }
+        if (stop && active == 0) {
+            break;
+        }
+
+        int running = 0;
+        curl_multi_perform(g_client_multi, &running);
+        CURLMsg *msg;
+        int remaining = 0;
+        while ((msg = curl_multi_info_read(g_client_multi, &remaining)) != NULL) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+            CURL *easy = msg->easy_handle;
+            CURLcode result = msg->data.result;
+            HttpClientRequest *request = NULL;
+            curl_easy_getinfo(easy, CURLINFO_PRIVATE, (char **)&request);
+            curl_multi_remove_handle(g_client_multi, easy);
+            active--;
+            if (request) {
+                http_client_complete(request, result);
+            }
+        }
+        curl_multi_poll(g_client_multi, NULL, 0, HTTP_CLIENT_POLL_MS, NULL);
+    }
+    return NULL;
+}
+
+int http_client_start(const HttpClientConfig *config) {
+    pthread_mutex_lock(&g_client_mutex);
+    bool running = g_client_running;
+    pthread_mutex_unlock(&g_client_mutex);
+    if (running) {
+        return 1;
+    }
+
+    g_client_multi = curl_multi_init();
+    g_client_share = curl_share_init();
+    if (!g_client_multi || !g_client_share) {
+        log_error("Failed to initialize shared HTTP client");
+        if (g_client_multi) {
+            curl_multi_cleanup(g_client_multi);
+            g_client_multi = NULL;
+        }
+        if (g_client_share) {
+            curl_share_cleanup(g_client_share);
+            g_client_share = NULL;
+        }
+        return 0;
+    }
+    curl_share_setopt(g_client_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(g_client_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+    long per_host = config && config->max_host_connections > 0 ? config->max_host_connections : 8;
+    long total = config && config->max_total_connections > 0 ? config->max_total_connections : 32;
+    curl_multi_setopt(g_client_multi, CURLMOPT_MAX_HOST_CONNECTIONS, per_host);
+    curl_multi_setopt(g_client_multi, CURLMOPT_MAXCONNECTS, total);
+    curl_multi_setopt(g_client_multi, CURLMOPT_PIPELINING, (long)CURLPIPE_MULTIPLEX);
+
+    pthread_mutex_lock(&g_client_mutex);
+    g_client_stop = false;
+    if (pthread_create(&g_client_thread, NULL, http_client_main, NULL) != 0) {
+        pthread_mutex_unlock(&g_client_mutex);
+        log_error("Failed to start HTTP client thread");
+        curl_multi_cleanup(g_client_multi);
+        curl_share_cleanup(g_client_share);
+        g_client_multi = NULL;
+        g_client_share = NULL;
+        return 0;
+    }
+    g_client_running = true;
+    pthread_mutex_unlock(&g_client_mutex);
+    log_info("HTTP client started (%ld connections per host, %ld cached)", per_host, total);
+    return 1;
+}
+
+void http_client_stop(void) {
+    pthread_mutex_lock(&g_client_mutex);
+    if (!g_client_running) {
+        pthread_mutex_unlock(&g_client_mutex);
+        return;
+    }
+    g_client_stop = true;
+    pthread_mutex_unlock(&g_client_mutex);
+    curl_multi_wakeup(g_client_multi);
+    pthread_join(g_client_thread, NULL);
+
+    pthread_mutex_lock(&g_client_mutex);
+    g_client_running = false;
+    pthread_mutex_unlock(&g_client_mutex);
+    curl_multi_cleanup(g_client_multi);
+    curl_share_cleanup(g_client_share);
+    g_client_multi = NULL;
+    g_client_share = NULL;
+}
+
+HttpClientRequest *http_client_submit(const char *url,
+                                      const char *const *headers,
+                                      size_t header_count,
+                                      const char *body,
+                                      size_t body_length,
+                                      long timeout_seconds) {
+    if (!url) {
+        return NULL;
+    }
+    HttpClientRequest *request = calloc(1, sizeof(*request));
+    if (!request) {
+        return NULL;
+    }
+    request->response_ok = buffer_init(&request->response) != 0;
+    request->easy = curl_easy_init();
+    if (!request->easy || !request->response_ok) {
+        http_client_request_free(request);
+        return NULL;
+    }
+    for (size_t i = 0; i < header_count; ++i) {
+        struct curl_slist *next = curl_slist_append(request->headers, headers[i]);
+        if (!next) {
+            http_client_request_free(request);
+            return NULL;
+        }
+        request->headers = next;
+    }
+
+    CURL *easy = request->easy;
+    curl_easy_setopt(easy, CURLOPT_URL, url);
+    curl_easy_setopt(easy, CURLOPT_HTTPHEADER, request->headers);
+    if (body) {
+        curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)body_length);
+        curl_easy_setopt(easy, CURLOPT_COPYPOSTFIELDS, body);
+    }
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT, timeout_seconds > 0 ? timeout_seconds : 30L);
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, http_client_write);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, request);
+    curl_easy_setopt(easy, CURLOPT_ERRORBUFFER, request->error_buffer);
+    curl_easy_setopt(easy, CURLOPT_PRIVATE, (char *)request);
+
+    pthread_mutex_lock(&g_client_mutex);
+    if (g_client_running && !g_client_stop) {
+        curl_easy_setopt(easy, CURLOPT_SHARE, g_client_share);
+        if (g_pending_tail) {
+            g_pending_tail->next = request;
+        } else {
+            g_pending_head = request;
+        }
+        g_pending_tail = request;
+        pthread_mutex_unlock(&g_client_mutex);
+        curl_multi_wakeup(g_client_multi);
+        return request;
+    }
+    pthread_mutex_unlock(&g_client_mutex);
+
+    http_client_finish(request, curl_easy_perform(easy));
+    request->done = true;
+    return request;
+}
+
+int http_client_is_done(HttpClientRequest *request) {
+    if (!request) {
+        return 1;
+    }
+    pthread_mutex_lock(&g_client_mutex);
+    bool done = request->done;
+    pthread_mutex_unlock(&g_client_mutex);
+    return done;
+}
+
+int http_client_wait(HttpClientRequest *request, HttpClientResponse *response_out) {
+    if (response_out) {
+        memset(response_out, 0, sizeof(*response_out));
+    }
+    if (!request) {
+        if (response_out) {
+            response_out->error = strdup("HTTP request failed: out of memory");
+        }
+        return 0;
+    }
+    pthread_mutex_lock(&g_client_mutex);
+    while (!request->done) {
+        pthread_cond_wait(&g_client_done, &g_client_mutex);
+    }
+    pthread_mutex_unlock(&g_client_mutex);
+
+    int ok = request->result == CURLE_OK;
+    if (response_out) {
+        if (ok) {
+            response_out->status = request->status;
+            response_out->retry_after = request->retry_after;
+            response_out->body_length = request->response.length;
+            response_out->body = request->response.data;
+            request->response.data = NULL;
+        } else {
+            const char *detail = request->error_buffer[0] ? request->error_buffer : curl_easy_strerror(request->result);
+            size_t len = strlen(detail) + 32;
+            response_out->error = malloc(len);
+            if (response_out->error) {
+                snprintf(response_out->error, len, "HTTP request failed: %s", detail);
+            }
+        }
+    }
+    http_client_request_free(request);
+    return ok;
+}
+
+int http_client_perform(const char *url,
+                        const char *const *headers,
+                        size_t header_count,
+                        const char *body,
+                        size_t body_length,
+                        long timeout_seconds,
+                        HttpClientResponse *response_out) {
+    HttpClientRequest *request = http_client_submit(url, headers, header_count, body, body_length, timeout_seconds);
+    return http_client_wait(request, response_out);
+}
+
+void http_client_response_clear(HttpClientResponse *response) {
+    if (!response) {
+        return;
+    }
+    free(response->body);
+    free(response->error);
+    memset(response, 0, sizeof(*response));
+}
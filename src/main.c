@@ -10,6 +10,7 @@
 #include <signal.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -20,6 +21,7 @@
 #include <sys/wait.h>
 #include <time.h>
 #include <unistd.h>
+#include <poll.h>
 #include <pthread.h>
 #include <curl/curl.h>
 #include <math.h>
@@ -28,11 +30,14 @@
 #define TEXTOID 25
 #endif
 
+#include "artifact_store.h"
 #include "buffer.h"
 #include "config.h"
 #include "csv.h"
 #include "db_helpers.h"
+#include "fragment_cache.h"
 #include "fsutil.h"
+#include "hash_index.h"
 #include "http.h"
 #include "json.h"
 #include "log.h"
@@ -42,19 +47,91 @@
 #include "server.h"
 #include "text_utils.h"
 #include "narrative.h"
+#include "narrative_cache.h"
+#include "narrative_pool.h"
+#include "http_client.h"
+#include "number_format.h"
 #include "util.h"
+#include "zip_writer.h"
 #include "service_activity.h"
+#include "string_intern.h"
+#include "sha256.h"
+#include "pdf_writer.h"
+#include "photo_derivatives.h"
 
 #define DEFAULT_PORT 8080
 #define MAX_HEADER_SIZE 65536
 #define READ_BUFFER_SIZE 8192
 #define TEMP_DIR_TEMPLATE  "/tmp/audit_unpack_XXXXXX"
-static pthread_t g_report_thread;
+#define REPORT_WORKER_DEFAULT_COUNT 2
+#define REPORT_WORKER_MAX_COUNT 16
+#define REPORT_WORKER_SWEEP_SECONDS 60
+#define REPORT_JOB_LEASE_DEFAULT_SECONDS 120
+#define REPORT_JOB_LEASE_MIN_SECONDS 30
+#define NARRATIVE_DEFAULT_CONCURRENCY 8
+#define NARRATIVE_MAX_CONCURRENCY 64
+#define NARRATIVE_DEFAULT_ATTEMPTS 4
+/* Kept small so several 2-3 paragraph narratives fit in one completion's token limit. */
+#define NARRATIVE_MAX_DEVICE_BATCH 8
+/* Token budget per device in a grouped completion; never below the single-call default. */
+#define NARRATIVE_GROUP_TOKENS_PER_DEVICE 1500
+#define NARRATIVE_PREFETCH_DEFAULT_CONCURRENCY 2
+#define NARRATIVE_PREFETCH_SETTLE_SECONDS 30
+#define NARRATIVE_PREFETCH_MAX_PENDING 256
+/* Upper bound; passes stop early once references and the table of contents settle. */
+#define LATEX_MAX_PASSES 3
+#define LATEX_FRAGMENT_CACHE_MAX_MB 4096
+/* Below this many devices, thread start-up costs more than the sections take to render. */
+#define LATEX_PARALLEL_MIN_DEVICES 8
+#define LATEX_ASSEMBLY_MAX_THREADS 8
+#define DEFICIENCY_PDF_MARGIN_X 36.0
+#define DEFICIENCY_PDF_MARGIN_TOP 72.0
+#define DEFICIENCY_PDF_MARGIN_BOTTOM 72.0
+#define HTTP_CLIENT_DEFAULT_HOST_CONNECTIONS 8
+#define HTTP_CLIENT_DEFAULT_TOTAL_CONNECTIONS 32
+
+/* Built a second time with -DAUDIT_REPORT_WORKER_ONLY=1 as the standalone audit_report_worker. */
+#ifndef AUDIT_REPORT_WORKER_ONLY
+#define AUDIT_REPORT_WORKER_ONLY 0
+#endif
+
+typedef enum {
+    REPORT_WORKER_STARTING = 0,
+    REPORT_WORKER_CONNECTING,
+    REPORT_WORKER_IDLE,
+    REPORT_WORKER_BUSY,
+    REPORT_WORKER_STOPPED
+} ReportWorkerState;
+
+/* Per-worker bookkeeping; every field except thread/started is guarded by g_report_mutex. */
+typedef struct {
+    pthread_t thread;
+    bool started;
+    int index;
+    ReportWorkerState state;
+    char job_id[37];
+    /* Lease owner of the current claim: g_report_worker_id, worker index and claim count. */
+    char lease_owner[192];
+    unsigned long claims;
+    time_t state_since;
+    unsigned long jobs_completed;
+    unsigned long jobs_failed;
+} ReportWorker;
+
+static ReportWorker g_report_workers[REPORT_WORKER_MAX_COUNT];
+static int g_report_worker_count = 0;
 static pthread_mutex_t g_report_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t g_report_cond = PTHREAD_COND_INITIALIZER;
 static bool g_report_stop = false;
-static bool g_report_signal = false;
-static bool g_report_thread_started = false;
+/* Written once at shutdown and never drained, so every worker's poll wakes and stays awake. */
+static int g_report_wake_pipe[2] = {-1, -1};
+/* host:pid, the prefix of every lease owner, so any node can tell whose lease lapsed. */
+static char g_report_worker_id[128];
+static int g_report_lease_seconds = REPORT_JOB_LEASE_DEFAULT_SECONDS;
+static pthread_t g_report_heartbeat_thread;
+static bool g_report_heartbeat_started = false;
+/* Set only after every worker has joined, so leases keep renewing while jobs drain. */
+static bool g_report_heartbeat_stop = false;
+static pthread_cond_t g_report_heartbeat_cond;
 static bool g_curl_initialized = false;
 
 typedef struct {
@@ -105,12 +182,19 @@ typedef struct {
     char *content_type;
     unsigned char *data;
     size_t size;
+    /* Filled by prepare_photo_blobs for photos the audit JSON lists. */
+    char sha256[SHA256_HEX_SIZE];
+    bool blob_stored;
+    /* Rendering succeeded; a NULL rendition means the original already serves that size. */
+    bool renditions_done;
+    PhotoDerivatives derivatives;
 } PhotoFile;
 
 typedef struct {
     PhotoFile *items;
     size_t count;
     size_t capacity;
+    HashIndex index;
 } PhotoCollection;
 
 typedef struct {
@@ -125,7 +209,7 @@ typedef struct {
     char *condition;
     char *remedy;
     char *note;
-    char *condition_code_raw;
+    const char *condition_code_raw;
     OptionalBool resolved;
     char *resolved_at;
 } ReportDeficiency;
@@ -145,6 +229,7 @@ typedef struct {
     KeyCountEntry *items;
     size_t count;
     size_t capacity;
+    HashIndex index;
 } KeyCountList;
 
 typedef struct {
@@ -156,6 +241,7 @@ typedef struct {
     DeviceCodesEntry *items;
     size_t count;
     size_t capacity;
+    HashIndex index;
 } DeviceCodesList;
 
 typedef struct {
@@ -180,19 +266,19 @@ typedef struct {
     char *audit_uuid;
     char *device_id;
     char *submission_id;
-    char *device_type;
+    const char *device_type;
     char *bank_name;
     char *city_id;
     char *general_notes;
-    char *controller_manufacturer;
+    const char *controller_manufacturer;
     char *controller_model;
-    char *controller_type;
-    char *controller_power_system;
-    char *machine_manufacturer;
-    char *machine_type;
-    char *roping;
-    char *door_operation;
-    char *door_operation_type;
+    const char *controller_type;
+    const char *controller_power_system;
+    const char *machine_manufacturer;
+    const char *machine_type;
+    const char *roping;
+    const char *door_operation;
+    const char *door_operation_type;
     char *cat1_tag_date;
     char *cat5_tag_date;
     char *submitted_on_iso;
@@ -672,6 +758,45 @@ typedef struct {
     char *conclusion;
 } NarrativeSet;
 
+/* Cached report fragments looked up by a job; the ratio is recorded on the job. */
+typedef struct {
+    size_t lookups;
+    size_t hits;
+} LatexFragmentStats;
+
+static const char *REPORT_SECTION_SYSTEM_PROMPT =
+    "You are an expert vertical transportation safety consultant. Provide concise, professional narrative text suitable for a building owner. Use plain ASCII punctuation (no smart quotes or em dashes). Do not include LaTeX syntax or markdown.";
+
+typedef struct {
+    const char *title;
+    size_t slot_offset;
+    const char *instructions;
+    bool include_notes;
+    bool include_recommendations;
+} ReportSectionSpec;
+
+/* Narrative sections of the full audit report, in document order. */
+static const ReportSectionSpec REPORT_SECTION_SPECS[] = {
+    {"Executive Summary", offsetof(NarrativeSet, executive_summary),
+     "Write an executive summary highlighting equipment condition, total device count, total deficiencies, and the most critical safety issues.\nProvide actionable context appropriate for ownership decisions.", true, false},
+    {"Key Findings", offsetof(NarrativeSet, key_findings),
+     "List the top findings from the audit with concise explanations. Focus on safety, compliance, and maintenance trends across devices.", true, false},
+    {"Methodology", offsetof(NarrativeSet, methodology),
+     "Describe the inspection methodology, standards referenced, and scope of the audit. Mention any limitations or assumptions.", false, false},
+    {"Maintenance Performance", offsetof(NarrativeSet, maintenance_performance),
+     "Analyze maintenance performance and recurring issues observed in the audit. Discuss patterns tied to equipment age, usage, or contractor performance.", true, false},
+    {"Recommendations", offsetof(NarrativeSet, recommendations),
+     "Provide prioritized recommendations for remediation, including immediate safety concerns, short-term actions, and long-term planning guidance.", true, true},
+    {"Conclusion", offsetof(NarrativeSet, conclusion),
+     "Deliver a closing narrative summarizing risk outlook, benefits of addressing recommendations, and next steps for maintaining compliance.", false, false}
+};
+
+#define REPORT_SECTION_COUNT ARRAY_LEN(REPORT_SECTION_SPECS)
+
+static char **narrative_set_slot(NarrativeSet *set, const ReportSectionSpec *spec) {
+    return (char **)((char *)set + spec->slot_offset);
+}
+
 typedef struct {
     char *raw_address;
     char *key;
@@ -1082,7 +1207,10 @@ static int buffer_append_currency(Buffer *buf, double amount) {
     if (!isfinite(amount)) {
         amount = 0.0;
     }
-    return buffer_appendf(buf, "\\$%.2f", amount);
+    char digits[NUMBER_FORMAT_MAX];
+    format_double_fixed(digits, amount, 2, true);
+    return buffer_append_cstr(buf, "\\$") &&
+           buffer_append_cstr(buf, digits);
 }
 
 static int buffer_append_percent(Buffer *buf, double ratio, int precision) {
@@ -1094,9 +1222,7 @@ static int buffer_append_percent(Buffer *buf, double ratio, int precision) {
     }
     if (precision < 0) precision = 1;
     if (precision > 3) precision = 3;
-    char fmt[16];
-    snprintf(fmt, sizeof(fmt), "%%.%df", precision);
-    return buffer_appendf(buf, fmt, ratio * 100.0) &&
+    return buffer_append_fixed(buf, ratio * 100.0, precision) &&
            buffer_append_cstr(buf, "\\%");
 }
 
@@ -1109,9 +1235,11 @@ static int buffer_append_signed_percent(Buffer *buf, double ratio, int precision
     }
     if (precision < 0) precision = 1;
     if (precision > 3) precision = 3;
-    char fmt[16];
-    snprintf(fmt, sizeof(fmt), "%%+.%df", precision);
-    return buffer_appendf(buf, fmt, ratio * 100.0) &&
+    double percent = ratio * 100.0;
+    if (!signbit(percent) && !buffer_append_char(buf, '+')) {
+        return 0;
+    }
+    return buffer_append_fixed(buf, percent, precision) &&
            buffer_append_cstr(buf, "\\%");
 }
 
@@ -1754,6 +1882,20 @@ static int collect_overview_windows(PGconn *conn,
     return 1;
 }
 
+static int report_open_deficiency_count(const ReportData *report) {
+    int open = 0;
+    for (size_t i = 0; i < report->devices.count; ++i) {
+        const ReportDevice *device = &report->devices.items[i];
+        for (size_t j = 0; j < device->deficiencies.count; ++j) {
+            const ReportDeficiency *def = &device->deficiencies.items[j];
+            if (!(def->resolved.has_value && def->resolved.value)) {
+                open += 1;
+            }
+        }
+    }
+    return open;
+}
+
 static char *format_window_range_label(const OverviewWindow *window, const ReportData *report) {
     if (!window) {
         return strdup("All available data");
@@ -2464,8 +2606,8 @@ static int generate_overview_callouts(const ReportData *report, OverviewWindow *
 static char *format_window_range_label(const OverviewWindow *window, const ReportData *report);
 static int buffer_append_signed_percent(Buffer *buf, double ratio, int precision);
 static int build_location_overview_tex(const ReportJob *job, const LocationProfile *profile, const ReportData *report, OverviewWindow *windows, size_t window_count, const char *output_path, char **error_out);
-static TimelineEntry *timeline_find_entry(TimelineEntry *entries, size_t count, const char *month);
-static int timeline_ensure_entry(TimelineEntry **entries, size_t *count, size_t *capacity, const char *month, TimelineEntry **out_entry);
+static TimelineEntry *timeline_find_entry(TimelineEntry *entries, const HashIndex *index, const char *month);
+static int timeline_ensure_entry(TimelineEntry **entries, size_t *count, size_t *capacity, HashIndex *index, const char *month, TimelineEntry **out_entry);
 static void timeline_free_entries(TimelineEntry *entries, size_t count);
 static int compare_timeline_entries(const void *a, const void *b);
 static int parse_year_month(const char *text, int *year_out, int *month_out);
@@ -2950,19 +3092,40 @@ static int process_report_job(PGconn *conn,
                               size_t *pdf_size_out,
                               char **artifact_name_out,
                               char **error_out);
-static int prepare_report_download(PGconn *conn, const char *job_id, ReportDownloadArtifact *artifact, char **error_out);
-static void cleanup_report_download(ReportDownloadArtifact *artifact);
+static int stream_report_download(int client_fd, PGconn *conn, const char *job_id, int *status_out, char **error_out);
+static int migrate_report_artifact(PGconn *conn, const char *job_id, char digest_hex[SHA256_HEX_SIZE], char **error_out);
+static int migrate_report_artifacts(PGconn *conn);
+static int backfill_photo_derivatives(PGconn *conn);
 static void *report_worker_main(void *arg);
-static void signal_report_worker(void);
 static char *slugify_filename_component(const char *text);
 static void normalized_date_component(char *dest, size_t dest_size, const char *candidate);
 static char *build_report_artifact_name(const ReportJob *job, const ReportData *report);
 static void narrative_set_init(NarrativeSet *set);
 static void narrative_set_clear(NarrativeSet *set);
-static int build_report_latex(PGconn *conn, const ReportData *report, const NarrativeSet *narratives, const ReportJob *job, const LocationProfile *profile, const char *output_path, char **error_out);
-static int run_pdflatex(const char *working_dir, const char *tex_filename, char **error_out);
+static int build_report_latex(PGconn *conn, const ReportData *report, const NarrativeSet *narratives, const ReportJob *job, const LocationProfile *profile, LatexFragmentStats *fragments, const char *output_path, char **error_out);
+static int build_deficiency_list_pdf(const ReportData *report, const ReportJob *job, const char *job_dir, const char *output_path, char **error_out);
+static int stream_report_preview(int client_fd, PGconn *conn, const LocationDetailRequest *request, int *status_out, char **error_out);
+typedef enum {
+    LATEX_FORMAT_UNTRIED = 0,
+    LATEX_FORMAT_READY,
+    LATEX_FORMAT_FAILED
+} LatexFormatState;
+
+typedef struct {
+    const char *name;
+    const char *marker;
+    const char *preamble;
+    LatexFormatState state;
+    char *path; /* without the .fmt suffix, as -fmt expects */
+} LatexFormat;
+
+static LatexFormat g_report_latex_format;
+static LatexFormat g_overview_latex_format;
+/* Finished PDFs live here; report_jobs rows only carry their digest. */
+static ArtifactStore g_artifact_store;
+static int append_latex_preamble(Buffer *buf, const LatexFormat *format);
+static int run_pdflatex(const char *working_dir, const char *tex_filename, LatexFormat *format, char **error_out);
 static void normalize_heading_text(char *text);
-static char *format_closed_cell(const char *text, bool closed, const char *suffix);
 static bool read_request_body(int client_fd,
                               const char *header_lines,
                               char *body_start,
@@ -2984,16 +3147,16 @@ static bool handle_zip_upload(int client_fd,
                               StringArray *processed_audits,
                               int *status_out,
                               char **error_out);
-static int export_building_photos(PGconn *conn, const ReportData *report, const char *root_dir, char **error_out);
+static int stream_building_photos(ZipWriter *zip, PGconn *conn, const ReportData *report, char **error_out);
 static char *sanitize_path_component(const char *input);
 static int copy_file_contents(const char *src_path, const char *dst_path);
-static int create_report_archive(PGconn *conn, const ReportJob *job, const ReportData *report,
-                                 const char *job_dir, const char *pdf_path, char **zip_path_out, char **error_out);
+static int stream_report_package(int client_fd, PGconn *conn, const ReportData *report, const char *pdf_path,
+                                 const char *download_name, char **error_out);
 static const char *determine_consultant_type(const ReportSummary *summary);
 static char *build_device_system_prompt(const char *consultant_type);
 static char *build_device_prompt(const ReportData *report, const ReportDevice *device, const ReportJob *job, const char *consultant_type);
 static char *build_device_narrative_fallback(const ReportDevice *device);
-static int append_device_deficiencies(Buffer *buf, const ReportDevice *device, bool omit_heading, bool include_summary);
+static int append_device_deficiencies(Buffer *buf, const ReportDevice *device, bool omit_heading, bool include_summary, LatexFragmentStats *fragments);
 typedef enum {
     NARRATIVE_TASK_SECTION,
     NARRATIVE_TASK_DEVICE
@@ -3005,15 +3168,60 @@ typedef struct {
     char **slot;
     char *error;
     int success;
-    pthread_t thread;
-    bool thread_started;
+    NarrativeRequest request;
     NarrativeTaskKind kind;
     ReportDevice *device;
     char *system_prompt_owned;
+    char cache_key[SHA256_HEX_SIZE];
+    bool cached;
+    /* Section title for degraded-section reporting; NULL for devices. */
+    const char *label;
+    bool late;
 } NarrativeTask;
 
-static void narrative_task_execute(NarrativeTask *task);
-static void *narrative_thread_main(void *arg);
+/* Several device prompts sent as one completion; see narrative_groups_resolve. */
+typedef struct {
+    NarrativeRequest request;
+    NarrativeTask **members;
+    size_t count;
+    char *system_prompt;
+    char *prompt;
+} NarrativeDeviceGroup;
+
+static int narrative_tasks_add_sections(NarrativeTask *tasks,
+                                        size_t slots,
+                                        size_t *created,
+                                        NarrativeSet *narratives,
+                                        const char *report_json,
+                                        const ReportJob *job,
+                                        char **error_out);
+static int narrative_tasks_add_devices(NarrativeTask *tasks,
+                                       size_t slots,
+                                       size_t *created,
+                                       ReportData *report,
+                                       const ReportJob *job,
+                                       char **error_out);
+static size_t narrative_tasks_fill_cached(PGconn *conn, NarrativeTask *tasks, size_t count);
+static void narrative_task_submit(NarrativeBatch *batch, NarrativeTask *task);
+static void narrative_tasks_dispatch(PGconn *conn,
+                                     NarrativeBatch *batch,
+                                     NarrativeTask *tasks,
+                                     size_t count,
+                                     NarrativeDeviceGroup **groups_out,
+                                     size_t *group_count_out);
+static NarrativeBatch *narrative_groups_resolve(NarrativeDeviceGroup *groups, size_t count, bool retry_failures, bool background);
+static void narrative_groups_free(NarrativeDeviceGroup *groups, size_t count);
+static void narrative_tasks_hand_off(NarrativeBatch *late_batch,
+                                     NarrativeTask *tasks,
+                                     size_t task_count,
+                                     NarrativeDeviceGroup *groups,
+                                     size_t group_count);
+static int narrative_wait(NarrativeBatch *batch, int64_t deadline_ms);
+static void late_narratives_flush(PGconn *conn);
+static void narrative_prefetch_enqueue(const char *address, const OptionalInt *location);
+static char *build_section_narrative_fallback(const char *title, const ReportSummary *summary);
+static void narrative_tasks_store(PGconn *conn, NarrativeTask *tasks, size_t count);
+static void narrative_task_collect(NarrativeTask *task);
 static bool read_request_body(int client_fd,
                               const char *header_lines,
                               char *body_start,
@@ -3121,12 +3329,14 @@ typedef struct {
     ResolvedEntry *entries;
     size_t count;
     size_t capacity;
+    HashIndex index;
 } ResolvedMap;
 
 static void resolved_map_init(ResolvedMap *map) {
     map->entries = NULL;
     map->count = 0;
     map->capacity = 0;
+    hash_index_init(&map->index);
 }
 
 static void resolved_map_clear(ResolvedMap *map) {
@@ -3139,13 +3349,17 @@ static void resolved_map_clear(ResolvedMap *map) {
     map->entries = NULL;
     map->count = 0;
     map->capacity = 0;
+    hash_index_clear(&map->index);
 }
 
 static int resolved_map_put(ResolvedMap *map, const char *key, const char *resolved_at) {
     if (!key) {
         return 1;
     }
-    for (size_t i = 0; i < map->count; ++i) {
+    uint32_t hash = hash_string(key);
+    HashIndexProbe probe;
+    hash_index_probe_init(&probe, &map->index, hash);
+    for (size_t i; (i = hash_index_probe_next(&probe)) != HASH_INDEX_NONE;) {
         if (strcmp(map->entries[i].key, key) == 0) {
             if (!map->entries[i].resolved_at && resolved_at) {
                 map->entries[i].resolved_at = strdup(resolved_at);
@@ -3167,7 +3381,8 @@ static int resolved_map_put(ResolvedMap *map, const char *key, const char *resol
     }
     map->entries[map->count].key = strdup(key);
     map->entries[map->count].resolved_at = resolved_at ? strdup(resolved_at) : NULL;
-    if (!map->entries[map->count].key || (resolved_at && !map->entries[map->count].resolved_at)) {
+    if (!map->entries[map->count].key || (resolved_at && !map->entries[map->count].resolved_at) ||
+        !hash_index_insert(&map->index, hash, map->count)) {
         free(map->entries[map->count].key);
         free(map->entries[map->count].resolved_at);
         return 0;
@@ -3180,7 +3395,9 @@ static const char *resolved_map_get(const ResolvedMap *map, const char *key) {
     if (!map || !key) {
         return NULL;
     }
-    for (size_t i = 0; i < map->count; ++i) {
+    HashIndexProbe probe;
+    hash_index_probe_init(&probe, &map->index, hash_string(key));
+    for (size_t i; (i = hash_index_probe_next(&probe)) != HASH_INDEX_NONE;) {
         if (strcmp(map->entries[i].key, key) == 0) {
             return map->entries[i].resolved_at;
         }
@@ -3205,11 +3422,16 @@ static void report_deficiency_free(ReportDeficiency *def) {
     if (!def) return;
     def->deficiency_id = 0;
     free(def->equipment);
+    def->equipment = NULL;
     free(def->condition);
+    def->condition = NULL;
     free(def->remedy);
+    def->remedy = NULL;
     free(def->note);
-    free(def->condition_code_raw);
+    def->note = NULL;
+    def->condition_code_raw = NULL;
     free(def->resolved_at);
+    def->resolved_at = NULL;
     optional_bool_clear(&def->resolved);
 }
 
@@ -3249,11 +3471,12 @@ static int report_deficiency_list_append(ReportDeficiencyList *list,
     memset(def, 0, sizeof(*def));
 
     def->deficiency_id = deficiency_id;
+    /* Only the code is interned; equipment, condition and remedy are free text. */
     def->equipment = strdup_safe(equipment);
     def->condition = strdup_safe(condition);
     def->remedy = strdup_safe(remedy);
     def->note = strdup_safe(note);
-    def->condition_code_raw = strdup_safe(condition_raw);
+    def->condition_code_raw = string_intern(condition_raw);
     def->resolved_at = strdup_safe(resolved_at);
     def->resolved = resolved_flag;
 
@@ -3275,6 +3498,7 @@ static void key_count_list_init(KeyCountList *list) {
     list->items = NULL;
     list->count = 0;
     list->capacity = 0;
+    hash_index_init(&list->index);
 }
 
 static void key_count_list_clear(KeyCountList *list) {
@@ -3286,12 +3510,17 @@ static void key_count_list_clear(KeyCountList *list) {
     list->items = NULL;
     list->count = 0;
     list->capacity = 0;
+    hash_index_clear(&list->index);
 }
 
 static int key_count_list_increment(KeyCountList *list, const char *key, int delta) {
     if (!list) return 0;
+    /* Keys fall back to free-text conditions, so they are owned copies, not interned. */
     const char *effective = (key && key[0]) ? key : "Unspecified";
-    for (size_t i = 0; i < list->count; ++i) {
+    uint32_t hash = hash_string(effective);
+    HashIndexProbe probe;
+    hash_index_probe_init(&probe, &list->index, hash);
+    for (size_t i; (i = hash_index_probe_next(&probe)) != HASH_INDEX_NONE;) {
         if (strcmp(list->items[i].key, effective) == 0) {
             list->items[i].count += delta;
             return 1;
@@ -3310,6 +3539,10 @@ static int key_count_list_increment(KeyCountList *list, const char *key, int del
     if (!list->items[list->count].key) {
         return 0;
     }
+    if (!hash_index_insert(&list->index, hash, list->count)) {
+        free(list->items[list->count].key);
+        return 0;
+    }
     list->items[list->count].count = delta;
     list->count++;
     return 1;
@@ -3319,6 +3552,7 @@ static void device_codes_list_init(DeviceCodesList *list) {
     list->items = NULL;
     list->count = 0;
     list->capacity = 0;
+    hash_index_init(&list->index);
 }
 
 static void device_codes_list_clear(DeviceCodesList *list) {
@@ -3331,11 +3565,15 @@ static void device_codes_list_clear(DeviceCodesList *list) {
     list->items = NULL;
     list->count = 0;
     list->capacity = 0;
+    hash_index_clear(&list->index);
 }
 
 static StringArray *device_codes_list_get(DeviceCodesList *list, const char *device_id, bool create) {
     if (!list || !device_id) return NULL;
-    for (size_t i = 0; i < list->count; ++i) {
+    uint32_t hash = hash_string(device_id);
+    HashIndexProbe probe;
+    hash_index_probe_init(&probe, &list->index, hash);
+    for (size_t i; (i = hash_index_probe_next(&probe)) != HASH_INDEX_NONE;) {
         if (strcmp(list->items[i].device_id, device_id) == 0) {
             return &list->items[i].codes;
         }
@@ -3357,6 +3595,10 @@ static StringArray *device_codes_list_get(DeviceCodesList *list, const char *dev
     if (!entry->device_id) {
         return NULL;
     }
+    if (!hash_index_insert(&list->index, hash, list->count)) {
+        free(entry->device_id);
+        return NULL;
+    }
     string_array_init(&entry->codes);
     list->count++;
     return &entry->codes;
@@ -3508,18 +3750,35 @@ static int assign_string_from_pg(char **dest, PGresult *res, int row, int col) {
     return assign_string(dest, PQgetvalue(res, row, col));
 }
 
+static int assign_interned_from_pg(const char **dest, PGresult *res, int row, int col) {
+    if (!dest) return 0;
+    if (!res || PQgetisnull(res, row, col)) {
+        return 1;
+    }
+    const char *value = PQgetvalue(res, row, col);
+    if (value[0] == '\0') {
+        return 1;
+    }
+    const char *interned = string_intern(value);
+    if (!interned) {
+        return 0;
+    }
+    *dest = interned;
+    return 1;
+}
+
 static int buffer_append_optional_int(Buffer *buf, const OptionalInt *value) {
     if (!value || !value->has_value) {
         return buffer_append_cstr(buf, "null");
     }
-    return buffer_appendf(buf, "%d", value->value);
+    return buffer_append_int64(buf, value->value);
 }
 
 static int buffer_append_optional_double(Buffer *buf, const OptionalDouble *value) {
     if (!value || !value->has_value) {
         return buffer_append_cstr(buf, "null");
     }
-    return buffer_appendf(buf, "%g", value->value);
+    return buffer_append_double(buf, value->value);
 }
 
 static int buffer_append_optional_bool(Buffer *buf, const OptionalBool *value) {
@@ -3694,10 +3953,8 @@ static char *build_device_prompt(const ReportData *report, const ReportDevice *d
         return NULL;
     }
     const char *device_type_raw = device->device_type ? device->device_type : "Device";
-    char *device_type_ascii = sanitize_ascii(device_type_raw);
-    const char *device_type_text = device_type_ascii ? device_type_ascii : device_type_raw;
-    char *device_type_case = normalize_caps_if_all_upper(device_type_text);
-    const char *device_type_display = device_type_case ? device_type_case : device_type_text;
+    char *device_type_case = sanitize_ascii_caps(device_type_raw);
+    const char *device_type_display = device_type_case ? device_type_case : device_type_raw;
 
     const char *device_id_raw = device->device_id ? device->device_id : (device->submission_id ? device->submission_id : "Device");
     char *device_id_ascii = sanitize_ascii(device_id_raw);
@@ -3705,7 +3962,6 @@ static char *build_device_prompt(const ReportData *report, const ReportDevice *d
 
     Buffer buf;
     if (!buffer_init(&buf)) {
-        free(device_type_ascii);
         free(device_type_case);
         free(device_id_ascii);
         return NULL;
@@ -3876,14 +4132,12 @@ static char *build_device_prompt(const ReportData *report, const ReportDevice *d
     char *result = buf.data;
     buf.data = NULL;
     buffer_free(&buf);
-    free(device_type_ascii);
     free(device_type_case);
     free(device_id_ascii);
     return result;
 
 fail:
     buffer_free(&buf);
-    free(device_type_ascii);
     free(device_type_case);
     free(device_id_ascii);
     return NULL;
@@ -3893,32 +4147,31 @@ static char *build_device_narrative_fallback(const ReportDevice *device) {
     if (!device) {
         return NULL;
     }
-    const char *device_type_raw = device->device_type ? device->device_type : "Device";
-    char *device_type_case = normalize_caps_if_all_upper(device_type_raw);
-    const char *device_type = device_type_case ? device_type_case : device_type_raw;
+    const char *device_type = device->device_type ? device->device_type : "Device";
     const char *device_id = device->device_id ? device->device_id : (device->submission_id ? device->submission_id : "Device");
 
     Buffer buf;
     if (!buffer_init(&buf)) {
-        free(device_type_case);
+        return NULL;
+    }
+    if (!ascii_append_text(&buf, device_type, LATEX_TEXT_NORMALIZE_CAPS)) {
+        buffer_free(&buf);
         return NULL;
     }
 
     size_t deficiency_count = device->deficiencies.count;
     if (deficiency_count > 0) {
         if (!buffer_appendf(&buf,
-                "%s %s has %zu documented deficiencies that require targeted maintenance attention. The detailed findings listed above should be prioritized to keep the unit compliant and operating reliably.\n",
-                device_type, device_id, deficiency_count)) {
+                " %s has %zu documented deficiencies that require targeted maintenance attention. The detailed findings listed above should be prioritized to keep the unit compliant and operating reliably.\n",
+                device_id, deficiency_count)) {
             buffer_free(&buf);
-            free(device_type_case);
             return NULL;
         }
     } else {
         if (!buffer_appendf(&buf,
-                "%s %s did not present any documented deficiencies during this audit. Continue routine maintenance and monitoring to preserve the current condition.\n",
-                device_type, device_id)) {
+                " %s did not present any documented deficiencies during this audit. Continue routine maintenance and monitoring to preserve the current condition.\n",
+                device_id)) {
             buffer_free(&buf);
-            free(device_type_case);
             return NULL;
         }
     }
@@ -3926,7 +4179,29 @@ static char *build_device_narrative_fallback(const ReportDevice *device) {
     char *result = buf.data;
     buf.data = NULL;
     buffer_free(&buf);
-    free(device_type_case);
+    return result;
+}
+
+static char *build_section_narrative_fallback(const char *title, const ReportSummary *summary) {
+    Buffer buf;
+    if (!buffer_init(&buf)) {
+        return NULL;
+    }
+    int devices = summary ? summary->total_devices : 0;
+    int deficiencies = summary ? summary->total_deficiencies : 0;
+    if (!buffer_appendf(&buf,
+            "The %s narrative was not available when this report was generated. This audit covered %d device%s with %d documented deficienc%s; the device sections and deficiency listings in this report reflect the complete findings.\n",
+            title ? title : "section",
+            devices,
+            devices == 1 ? "" : "s",
+            deficiencies,
+            deficiencies == 1 ? "y" : "ies")) {
+        buffer_free(&buf);
+        return NULL;
+    }
+    char *result = buf.data;
+    buf.data = NULL;
+    buffer_free(&buf);
     return result;
 }
 
@@ -3987,7 +4262,7 @@ static char *build_location_detail_json(const ReportData *report, const Location
 
     if (!buffer_append_cstr(&buf, "\"location_row_id\":")) goto oom;
     if (profile && profile->row_id.has_value) {
-        if (!buffer_appendf(&buf, "%d", profile->row_id.value)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)profile->row_id.value)) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     }
@@ -4046,11 +4321,11 @@ static char *build_location_detail_json(const ReportData *report, const Location
     if (!buffer_append_char(&buf, ',')) goto oom;
 
     if (!buffer_append_cstr(&buf, "\"device_count\":")) goto oom;
-    if (!buffer_appendf(&buf, "%d", device_count)) goto oom;
+    if (!buffer_append_int64(&buf, (int64_t)device_count)) goto oom;
     if (!buffer_append_char(&buf, ',')) goto oom;
 
     if (!buffer_append_cstr(&buf, "\"audit_count\":")) goto oom;
-    if (!buffer_appendf(&buf, "%d", report->summary.audit_count)) goto oom;
+    if (!buffer_append_int64(&buf, (int64_t)report->summary.audit_count)) goto oom;
     if (!buffer_append_char(&buf, ',')) goto oom;
 
     if (!buffer_append_cstr(&buf, "\"first_audit\":")) goto oom;
@@ -4062,7 +4337,7 @@ static char *build_location_detail_json(const ReportData *report, const Location
     if (!buffer_append_char(&buf, ',')) goto oom;
 
     if (!buffer_append_cstr(&buf, "\"total_deficiencies\":")) goto oom;
-    if (!buffer_appendf(&buf, "%d", report->summary.total_deficiencies)) goto oom;
+    if (!buffer_append_int64(&buf, (int64_t)report->summary.total_deficiencies)) goto oom;
     if (!buffer_append_char(&buf, ',')) goto oom;
 
     size_t total_open = 0;
@@ -4078,7 +4353,7 @@ static char *build_location_detail_json(const ReportData *report, const Location
     }
 
     if (!buffer_append_cstr(&buf, "\"open_deficiencies\":")) goto oom;
-    if (!buffer_appendf(&buf, "%zu", total_open)) goto oom;
+    if (!buffer_append_int64(&buf, (int64_t)total_open)) goto oom;
     if (!buffer_append_char(&buf, ',')) goto oom;
 
     if (open_deficiencies_out) {
@@ -4087,7 +4362,7 @@ static char *build_location_detail_json(const ReportData *report, const Location
 
     if (!buffer_append_cstr(&buf, "\"location_row_id\":")) goto oom;
     if (profile && profile->row_id.has_value) {
-        if (!buffer_appendf(&buf, "%d", profile->row_id.value)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)profile->row_id.value)) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     }
@@ -4102,7 +4377,7 @@ static char *build_location_detail_json(const ReportData *report, const Location
         if (i > 0 && !buffer_append_char(&buf, ',')) goto oom;
         if (!buffer_append_json_string(&buf, report->summary.deficiencies_by_code.items[i].key)) goto oom;
         if (!buffer_append_char(&buf, ':')) goto oom;
-        if (!buffer_appendf(&buf, "%d", report->summary.deficiencies_by_code.items[i].count)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)report->summary.deficiencies_by_code.items[i].count)) goto oom;
     }
     if (!buffer_append_char(&buf, '}')) goto oom;
     if (!buffer_append_char(&buf, '}')) goto oom; // close summary
@@ -4176,11 +4451,11 @@ static char *build_location_detail_json(const ReportData *report, const Location
         if (!buffer_append_char(&buf, ',')) goto oom;
 
         if (!buffer_append_cstr(&buf, "\"total_deficiencies\":")) goto oom;
-        if (!buffer_appendf(&buf, "%zu", device_total)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)device_total)) goto oom;
         if (!buffer_append_char(&buf, ',')) goto oom;
 
         if (!buffer_append_cstr(&buf, "\"open_deficiencies\":")) goto oom;
-        if (!buffer_appendf(&buf, "%zu", device_open)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)device_open)) goto oom;
         if (!buffer_append_char(&buf, ',')) goto oom;
 
         if (!buffer_append_cstr(&buf, "\"cars_in_bank\":")) goto oom;
@@ -4201,7 +4476,7 @@ static char *build_location_detail_json(const ReportData *report, const Location
             if (j > 0 && !buffer_append_char(&buf, ',')) goto oom;
             if (!buffer_append_char(&buf, '{')) goto oom;
             if (!buffer_append_cstr(&buf, "\"id\":")) goto oom;
-            if (!buffer_appendf(&buf, "%ld", def->deficiency_id)) goto oom;
+            if (!buffer_append_int64(&buf, (int64_t)def->deficiency_id)) goto oom;
             if (!buffer_append_char(&buf, ',')) goto oom;
             if (!buffer_append_cstr(&buf, "\"equipment\":")) goto oom;
             if (!buffer_append_json_string(&buf, def->equipment)) goto oom;
@@ -4752,7 +5027,7 @@ static int append_service_summary_section(Buffer *buf, PGconn *conn, const Repor
             total_tickets = strtol(PQgetvalue(summary_res, 0, 0), NULL, 10);
         }
         if (!PQgetisnull(summary_res, 0, 1)) {
-            total_hours = strtod(PQgetvalue(summary_res, 0, 1), NULL);
+            total_hours = parse_decimal_double(PQgetvalue(summary_res, 0, 1), NULL);
         }
         if (!PQgetisnull(summary_res, 0, 2)) {
             last_service = strdup(PQgetvalue(summary_res, 0, 2));
@@ -4809,14 +5084,13 @@ static int append_service_summary_section(Buffer *buf, PGconn *conn, const Repor
         goto cleanup_vendor;
     }
 
-    char number_buf[64];
-    snprintf(number_buf, sizeof(number_buf), "%ld", total_tickets);
-    if (!buffer_appendf(buf, "Total Tickets & %s \\\\ \n", number_buf)) {
+    if (!buffer_append_cstr(buf, "Total Tickets & ") || !buffer_append_int64(buf, total_tickets) ||
+        !buffer_append_cstr(buf, " \\\\ \n")) {
         free(last_service);
         goto cleanup_vendor;
     }
-    snprintf(number_buf, sizeof(number_buf), "%.1f", total_hours);
-    if (!buffer_appendf(buf, "Total Hours & %s \\\\ \n", number_buf)) {
+    if (!buffer_append_cstr(buf, "Total Hours & ") || !buffer_append_fixed(buf, total_hours, 1) ||
+        !buffer_append_cstr(buf, " \\\\ \n")) {
         free(last_service);
         goto cleanup_vendor;
     }
@@ -4908,10 +5182,10 @@ static int append_service_summary_section(Buffer *buf, PGconn *conn, const Repor
                 goto cleanup_vendor;
             }
             long month_tickets = PQgetisnull(trend_res, i, 1) ? 0 : strtol(PQgetvalue(trend_res, i, 1), NULL, 10);
-            double month_hours = PQgetisnull(trend_res, i, 2) ? 0.0 : strtod(PQgetvalue(trend_res, i, 2), NULL);
-            char hours_buf[32];
-            snprintf(hours_buf, sizeof(hours_buf), "%.1f", month_hours);
-            if (!buffer_appendf(buf, "%s & %ld & %s \\\\ \n", month_tex, month_tickets, hours_buf)) {
+            double month_hours = PQgetisnull(trend_res, i, 2) ? 0.0 : parse_decimal_double(PQgetvalue(trend_res, i, 2), NULL);
+            if (!buffer_appendf(buf, "%s & ", month_tex) || !buffer_append_int64(buf, month_tickets) ||
+                !buffer_append_cstr(buf, " & ") || !buffer_append_fixed(buf, month_hours, 1) ||
+                !buffer_append_cstr(buf, " \\\\ \n")) {
                 free(month_tex);
                 goto cleanup_vendor;
             }
@@ -5100,13 +5374,13 @@ static int append_financial_summary_section(Buffer *buf, PGconn *conn, const Rep
             total_records = strtol(PQgetvalue(summary_res, 0, 0), NULL, 10);
         }
         if (!PQgetisnull(summary_res, 0, 1)) {
-            total_spend = strtod(PQgetvalue(summary_res, 0, 1), NULL);
+            total_spend = parse_decimal_double(PQgetvalue(summary_res, 0, 1), NULL);
         }
         if (!PQgetisnull(summary_res, 0, 2)) {
-            approved_spend = strtod(PQgetvalue(summary_res, 0, 2), NULL);
+            approved_spend = parse_decimal_double(PQgetvalue(summary_res, 0, 2), NULL);
         }
         if (!PQgetisnull(summary_res, 0, 3)) {
-            open_spend = strtod(PQgetvalue(summary_res, 0, 3), NULL);
+            open_spend = parse_decimal_double(PQgetvalue(summary_res, 0, 3), NULL);
         }
         if (!PQgetisnull(summary_res, 0, 4)) {
             last_statement = strdup(PQgetvalue(summary_res, 0, 4));
@@ -5160,24 +5434,23 @@ static int append_financial_summary_section(Buffer *buf, PGconn *conn, const Rep
         goto fin_cleanup_status;
     }
 
-    char value_buf[64];
-    snprintf(value_buf, sizeof(value_buf), "%ld", total_records);
-    if (!buffer_appendf(buf, "Total Records & %s \\\\ \n", value_buf)) {
+    if (!buffer_append_cstr(buf, "Total Records & ") || !buffer_append_int64(buf, total_records) ||
+        !buffer_append_cstr(buf, " \\\\ \n")) {
         free(last_statement);
         goto fin_cleanup_status;
     }
-    snprintf(value_buf, sizeof(value_buf), "$%.2f", total_spend);
-    if (!buffer_appendf(buf, "Total Spend & %s \\\\ \n", value_buf)) {
+    if (!buffer_append_cstr(buf, "Total Spend & ") || !buffer_append_currency(buf, total_spend) ||
+        !buffer_append_cstr(buf, " \\\\ \n")) {
         free(last_statement);
         goto fin_cleanup_status;
     }
-    snprintf(value_buf, sizeof(value_buf), "$%.2f", approved_spend);
-    if (!buffer_appendf(buf, "Approved Spend & %s \\\\ \n", value_buf)) {
+    if (!buffer_append_cstr(buf, "Approved Spend & ") || !buffer_append_currency(buf, approved_spend) ||
+        !buffer_append_cstr(buf, " \\\\ \n")) {
         free(last_statement);
         goto fin_cleanup_status;
     }
-    snprintf(value_buf, sizeof(value_buf), "$%.2f", open_spend);
-    if (!buffer_appendf(buf, "Open Spend & %s \\\\ \n", value_buf)) {
+    if (!buffer_append_cstr(buf, "Open Spend & ") || !buffer_append_currency(buf, open_spend) ||
+        !buffer_append_cstr(buf, " \\\\ \n")) {
         free(last_statement);
         goto fin_cleanup_status;
     }
@@ -5213,9 +5486,9 @@ static int append_financial_summary_section(Buffer *buf, PGconn *conn, const Rep
             if (!category_tex) {
                 goto fin_cleanup_status;
             }
-            double spend = PQgetisnull(category_res, i, 1) ? 0.0 : strtod(PQgetvalue(category_res, i, 1), NULL);
-            snprintf(value_buf, sizeof(value_buf), "$%.2f", spend);
-            if (!buffer_appendf(buf, "%s & %s \\\\ \n", category_tex, value_buf)) {
+            double spend = PQgetisnull(category_res, i, 1) ? 0.0 : parse_decimal_double(PQgetvalue(category_res, i, 1), NULL);
+            if (!buffer_appendf(buf, "%s & ", category_tex) || !buffer_append_currency(buf, spend) ||
+                !buffer_append_cstr(buf, " \\\\ \n")) {
                 free(category_tex);
                 goto fin_cleanup_status;
             }
@@ -5239,9 +5512,9 @@ static int append_financial_summary_section(Buffer *buf, PGconn *conn, const Rep
             if (!status_tex) {
                 goto fin_cleanup_status;
             }
-            double spend = PQgetisnull(status_res, i, 1) ? 0.0 : strtod(PQgetvalue(status_res, i, 1), NULL);
-            snprintf(value_buf, sizeof(value_buf), "$%.2f", spend);
-            if (!buffer_appendf(buf, "%s & %s \\\\ \n", status_tex, value_buf)) {
+            double spend = PQgetisnull(status_res, i, 1) ? 0.0 : parse_decimal_double(PQgetvalue(status_res, i, 1), NULL);
+            if (!buffer_appendf(buf, "%s & ", status_tex) || !buffer_append_currency(buf, spend) ||
+                !buffer_append_cstr(buf, " \\\\ \n")) {
                 free(status_tex);
                 goto fin_cleanup_status;
             }
@@ -5269,9 +5542,9 @@ static int append_financial_summary_section(Buffer *buf, PGconn *conn, const Rep
             if (!month_tex) {
                 goto fin_cleanup_status;
             }
-            double spend = PQgetisnull(trend_res, i, 1) ? 0.0 : strtod(PQgetvalue(trend_res, i, 1), NULL);
-            snprintf(value_buf, sizeof(value_buf), "$%.2f", spend);
-            if (!buffer_appendf(buf, "%s & %s \\\\ \n", month_tex, value_buf)) {
+            double spend = PQgetisnull(trend_res, i, 1) ? 0.0 : parse_decimal_double(PQgetvalue(trend_res, i, 1), NULL);
+            if (!buffer_appendf(buf, "%s & ", month_tex) || !buffer_append_currency(buf, spend) ||
+                !buffer_append_cstr(buf, " \\\\ \n")) {
                 free(month_tex);
                 goto fin_cleanup_status;
             }
@@ -5661,19 +5934,19 @@ static int load_report_for_building(PGconn *conn, const char *building_address,
         if (!assign_string_from_pg(&device.audit_uuid, res, row, 0) ||
             !assign_string_from_pg(&device.submission_id, res, row, 0) ||
             !assign_string_from_pg(&device.device_id, res, row, 1) ||
-            !assign_string_from_pg(&device.device_type, res, row, 2) ||
+            !assign_interned_from_pg(&device.device_type, res, row, 2) ||
             !assign_string_from_pg(&device.bank_name, res, row, 3) ||
             !assign_string_from_pg(&device.city_id, res, row, 36) ||
             !assign_string_from_pg(&device.general_notes, res, row, 4) ||
-            !assign_string_from_pg(&device.controller_manufacturer, res, row, 6) ||
+            !assign_interned_from_pg(&device.controller_manufacturer, res, row, 6) ||
             !assign_string_from_pg(&device.controller_model, res, row, 7) ||
-            !assign_string_from_pg(&device.controller_type, res, row, 8) ||
-            !assign_string_from_pg(&device.controller_power_system, res, row, 9) ||
-            !assign_string_from_pg(&device.machine_manufacturer, res, row, 10) ||
-            !assign_string_from_pg(&device.machine_type, res, row, 11) ||
-            !assign_string_from_pg(&device.roping, res, row, 12) ||
-            !assign_string_from_pg(&device.door_operation, res, row, 13) ||
-            !assign_string_from_pg(&device.door_operation_type, res, row, 14) ||
+            !assign_interned_from_pg(&device.controller_type, res, row, 8) ||
+            !assign_interned_from_pg(&device.controller_power_system, res, row, 9) ||
+            !assign_interned_from_pg(&device.machine_manufacturer, res, row, 10) ||
+            !assign_interned_from_pg(&device.machine_type, res, row, 11) ||
+            !assign_interned_from_pg(&device.roping, res, row, 12) ||
+            !assign_interned_from_pg(&device.door_operation, res, row, 13) ||
+            !assign_interned_from_pg(&device.door_operation_type, res, row, 14) ||
             !assign_string_from_pg(&device.cat1_tag_date, res, row, 21) ||
             !assign_string_from_pg(&device.cat5_tag_date, res, row, 23) ||
             !assign_string_from_pg(&device.submitted_on_iso, res, row, 29)) {
@@ -5836,23 +6109,23 @@ static char *report_data_to_json(const ReportData *report) {
     if (!buffer_append_char(&buf, ',')) goto fail;
 
     if (!buffer_append_cstr(&buf, "\"total_devices\":")) goto fail;
-    if (!buffer_appendf(&buf, "%d", report->summary.total_devices)) goto fail;
+    if (!buffer_append_int64(&buf, (int64_t)report->summary.total_devices)) goto fail;
     if (!buffer_append_char(&buf, ',')) goto fail;
 
     if (!buffer_append_cstr(&buf, "\"elevator_count\":")) goto fail;
-    if (!buffer_appendf(&buf, "%d", report->summary.elevator_count)) goto fail;
+    if (!buffer_append_int64(&buf, (int64_t)report->summary.elevator_count)) goto fail;
     if (!buffer_append_char(&buf, ',')) goto fail;
 
     if (!buffer_append_cstr(&buf, "\"escalator_count\":")) goto fail;
-    if (!buffer_appendf(&buf, "%d", report->summary.escalator_count)) goto fail;
+    if (!buffer_append_int64(&buf, (int64_t)report->summary.escalator_count)) goto fail;
     if (!buffer_append_char(&buf, ',')) goto fail;
 
     if (!buffer_append_cstr(&buf, "\"audit_count\":")) goto fail;
-    if (!buffer_appendf(&buf, "%d", report->summary.audit_count)) goto fail;
+    if (!buffer_append_int64(&buf, (int64_t)report->summary.audit_count)) goto fail;
     if (!buffer_append_char(&buf, ',')) goto fail;
 
     if (!buffer_append_cstr(&buf, "\"total_deficiencies\":")) goto fail;
-    if (!buffer_appendf(&buf, "%d", report->summary.total_deficiencies)) goto fail;
+    if (!buffer_append_int64(&buf, (int64_t)report->summary.total_deficiencies)) goto fail;
     if (!buffer_append_char(&buf, ',')) goto fail;
 
     if (!buffer_append_cstr(&buf, "\"average_deficiencies_per_device\":")) goto fail;
@@ -5879,7 +6152,7 @@ static char *report_data_to_json(const ReportData *report) {
         if (i > 0 && !buffer_append_char(&buf, ',')) goto fail;
         if (!buffer_append_json_string(&buf, report->summary.deficiencies_by_code.items[i].key)) goto fail;
         if (!buffer_append_char(&buf, ':')) goto fail;
-        if (!buffer_appendf(&buf, "%d", report->summary.deficiencies_by_code.items[i].count)) goto fail;
+        if (!buffer_append_int64(&buf, (int64_t)report->summary.deficiencies_by_code.items[i].count)) goto fail;
     }
     if (!buffer_append_char(&buf, '}')) goto fail;
     if (!buffer_append_char(&buf, ',')) goto fail;
@@ -5893,7 +6166,7 @@ static char *report_data_to_json(const ReportData *report) {
         if (!buffer_append_char(&buf, ',')) goto fail;
         if (!buffer_append_json_string(&buf, device->device_id)) goto fail;
         if (!buffer_append_char(&buf, ':')) goto fail;
-        if (!buffer_appendf(&buf, "%zu", device->deficiencies.count)) goto fail;
+        if (!buffer_append_int64(&buf, (int64_t)device->deficiencies.count)) goto fail;
     }
     if (!buffer_append_char(&buf, '}')) goto fail;
     if (!buffer_append_char(&buf, ',')) goto fail;
@@ -6154,19 +6427,19 @@ static void report_device_clear(ReportDevice *device) {
     free(device->audit_uuid);
     free(device->device_id);
     free(device->submission_id);
-    free(device->device_type);
+    device->device_type = NULL;
     free(device->bank_name);
     free(device->city_id);
     free(device->general_notes);
-    free(device->controller_manufacturer);
+    device->controller_manufacturer = NULL;
     free(device->controller_model);
-    free(device->controller_type);
-    free(device->controller_power_system);
-    free(device->machine_manufacturer);
-    free(device->machine_type);
-    free(device->roping);
-    free(device->door_operation);
-    free(device->door_operation_type);
+    device->controller_type = NULL;
+    device->controller_power_system = NULL;
+    device->machine_manufacturer = NULL;
+    device->machine_type = NULL;
+    device->roping = NULL;
+    device->door_operation = NULL;
+    device->door_operation_type = NULL;
     free(device->cat1_tag_date);
     free(device->cat5_tag_date);
     free(device->submitted_on_iso);
@@ -6314,6 +6587,7 @@ static void photo_collection_init(PhotoCollection *collection) {
     collection->items = NULL;
     collection->count = 0;
     collection->capacity = 0;
+    hash_index_init(&collection->index);
 }
 
 static void photo_file_clear(PhotoFile *file) {
@@ -6321,6 +6595,7 @@ static void photo_file_clear(PhotoFile *file) {
     free(file->filename);
     free(file->content_type);
     free(file->data);
+    photo_derivatives_free(&file->derivatives);
     file->filename = NULL;
     file->content_type = NULL;
     file->data = NULL;
@@ -6336,6 +6611,7 @@ static void photo_collection_clear(PhotoCollection *collection) {
     collection->items = NULL;
     collection->count = 0;
     collection->capacity = 0;
+    hash_index_clear(&collection->index);
 }
 
 static int photo_collection_append(PhotoCollection *collection, const char *filename, const char *content_type, unsigned char *data, size_t size) {
@@ -6353,7 +6629,13 @@ static int photo_collection_append(PhotoCollection *collection, const char *file
     dest->content_type = strdup(content_type ? content_type : "application/octet-stream");
     dest->data = data;
     dest->size = size;
-    if (!dest->filename || !dest->content_type) {
+    dest->sha256[0] = '\0';
+    dest->blob_stored = false;
+    dest->renditions_done = false;
+    memset(&dest->derivatives, 0, sizeof(dest->derivatives));
+    if (!dest->filename || !dest->content_type ||
+        !hash_index_insert(&collection->index, hash_string(dest->filename), collection->count)) {
+        dest->data = NULL;
         photo_file_clear(dest);
         return 0;
     }
@@ -6365,7 +6647,9 @@ static const PhotoFile *photo_collection_find(const PhotoCollection *collection,
     if (!collection || !filename) {
         return NULL;
     }
-    for (size_t i = 0; i < collection->count; ++i) {
+    HashIndexProbe probe;
+    hash_index_probe_init(&probe, &collection->index, hash_string(filename));
+    for (size_t i; (i = hash_index_probe_next(&probe)) != HASH_INDEX_NONE;) {
         if (strcmp(collection->items[i].filename, filename) == 0) {
             return &collection->items[i];
         }
@@ -6694,8 +6978,8 @@ static OptionalDouble parse_optional_double(const char *text) {
         free(trimmed);
         return result;
     }
-    char *endptr = NULL;
-    double value = strtod(trimmed, &endptr);
+    const char *endptr = NULL;
+    double value = parse_decimal_double(trimmed, &endptr);
     if (endptr && *endptr == '\0') {
         result.has_value = true;
         result.value = value;
@@ -7810,8 +8094,8 @@ static int audit_visit_lookup_location(PGconn *conn, AuditVisit *visit, char **e
                 int best_row = -1;
                 double best_score = 0.0;
                 for (int row = 0; row < tuples; ++row) {
-                    double street_score = PQgetisnull(score_res, row, 6) ? 0.0 : strtod(PQgetvalue(score_res, row, 6), NULL);
-                    double site_score = PQgetisnull(score_res, row, 7) ? 0.0 : strtod(PQgetvalue(score_res, row, 7), NULL);
+                    double street_score = PQgetisnull(score_res, row, 6) ? 0.0 : parse_decimal_double(PQgetvalue(score_res, row, 6), NULL);
+                    double site_score = PQgetisnull(score_res, row, 7) ? 0.0 : parse_decimal_double(PQgetvalue(score_res, row, 7), NULL);
                     const char *street_val = PQgetisnull(score_res, row, 1) ? NULL : PQgetvalue(score_res, row, 1);
                     const char *site_val = PQgetisnull(score_res, row, 5) ? NULL : PQgetvalue(score_res, row, 5);
                     double lev_street = street_val ? normalized_levenshtein_casefold(visit->building_address, street_val) : 0.0;
@@ -8263,7 +8547,7 @@ static char *build_location_profile_json(const LocationProfile *profile) {
     if (!buffer_append_char(&buf, '{')) goto oom;
     if (!buffer_append_cstr(&buf, "\"row_id\":")) goto oom;
     if (profile && profile->row_id.has_value) {
-        if (!buffer_appendf(&buf, "%d", profile->row_id.value)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)profile->row_id.value)) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     }
@@ -8299,7 +8583,7 @@ static char *build_location_profile_json(const LocationProfile *profile) {
 
     if (!buffer_append_cstr(&buf, "\"device_count\":")) goto oom;
     if (profile && profile->device_count.has_value) {
-        if (!buffer_appendf(&buf, "%d", profile->device_count.value)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)profile->device_count.value)) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     }
@@ -8394,7 +8678,7 @@ static char *build_service_summary_json(PGconn *conn, const LocationProfile *pro
             total_tickets = strtol(PQgetvalue(res, 0, 0), NULL, 10);
         }
         if (!PQgetisnull(res, 0, 1)) {
-            total_hours = strtod(PQgetvalue(res, 0, 1), NULL);
+            total_hours = parse_decimal_double(PQgetvalue(res, 0, 1), NULL);
         }
         if (!PQgetisnull(res, 0, 2)) {
             last_service = strdup(PQgetvalue(res, 0, 2));
@@ -8537,11 +8821,11 @@ static char *build_service_summary_json(PGconn *conn, const LocationProfile *pro
 
     if (!buffer_append_char(&buf, '{')) goto oom;
     if (!buffer_append_cstr(&buf, "\"total_tickets\":")) goto oom;
-    if (!buffer_appendf(&buf, "%ld", total_tickets)) goto oom;
+    if (!buffer_append_int64(&buf, (int64_t)total_tickets)) goto oom;
     if (!buffer_append_char(&buf, ',')) goto oom;
 
     if (!buffer_append_cstr(&buf, "\"total_hours\":")) goto oom;
-    if (!buffer_appendf(&buf, "%.2f", total_hours)) goto oom;
+    if (!buffer_append_fixed(&buf, total_hours, 2)) goto oom;
     if (!buffer_append_char(&buf, ',')) goto oom;
 
     if (!buffer_append_cstr(&buf, "\"last_service\":")) goto oom;
@@ -8561,7 +8845,7 @@ static char *build_service_summary_json(PGconn *conn, const LocationProfile *pro
         if (!buffer_append_char(&buf, ',')) goto oom;
         if (!buffer_append_cstr(&buf, "\"count\":")) goto oom;
         long count = PQgetisnull(problem_res, i, 1) ? 0 : strtol(PQgetvalue(problem_res, i, 1), NULL, 10);
-        if (!buffer_appendf(&buf, "%ld", count)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)count)) goto oom;
         if (!buffer_append_char(&buf, '}')) goto oom;
         if (i + 1 < problem_rows && !buffer_append_char(&buf, ',')) goto oom;
     }
@@ -8579,7 +8863,7 @@ static char *build_service_summary_json(PGconn *conn, const LocationProfile *pro
             latest_tickets = strtol(PQgetvalue(trend_res, 0, 1), NULL, 10);
         }
         if (!PQgetisnull(trend_res, 0, 9)) {
-            latest_hours = strtod(PQgetvalue(trend_res, 0, 9), NULL);
+            latest_hours = parse_decimal_double(PQgetvalue(trend_res, 0, 9), NULL);
         }
     }
     if (trend_rows > 1) {
@@ -8587,7 +8871,7 @@ static char *build_service_summary_json(PGconn *conn, const LocationProfile *pro
             previous_tickets = strtol(PQgetvalue(trend_res, 1, 1), NULL, 10);
         }
         if (!PQgetisnull(trend_res, 1, 9)) {
-            previous_hours = strtod(PQgetvalue(trend_res, 1, 9), NULL);
+            previous_hours = parse_decimal_double(PQgetvalue(trend_res, 1, 9), NULL);
         }
     }
     for (int i = trend_rows - 1; i >= 0; --i) {
@@ -8597,7 +8881,7 @@ static char *build_service_summary_json(PGconn *conn, const LocationProfile *pro
         if (!buffer_append_char(&buf, ',')) goto oom;
         if (!buffer_append_cstr(&buf, "\"tickets\":")) goto oom;
         long tickets = PQgetisnull(trend_res, i, 1) ? 0 : strtol(PQgetvalue(trend_res, i, 1), NULL, 10);
-        if (!buffer_appendf(&buf, "%ld", tickets)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)tickets)) goto oom;
         if (!buffer_append_char(&buf, ',')) goto oom;
         long pm = PQgetisnull(trend_res, i, 2) ? 0 : strtol(PQgetvalue(trend_res, i, 2), NULL, 10);
         long cb_emergency = PQgetisnull(trend_res, i, 3) ? 0 : strtol(PQgetvalue(trend_res, i, 3), NULL, 10);
@@ -8607,29 +8891,29 @@ static char *build_service_summary_json(PGconn *conn, const LocationProfile *pro
         long rp = PQgetisnull(trend_res, i, 7) ? 0 : strtol(PQgetvalue(trend_res, i, 7), NULL, 10);
         long misc = PQgetisnull(trend_res, i, 8) ? 0 : strtol(PQgetvalue(trend_res, i, 8), NULL, 10);
         if (!buffer_append_cstr(&buf, "\"pm\":")) goto oom;
-        if (!buffer_appendf(&buf, "%ld", pm)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)pm)) goto oom;
         if (!buffer_append_char(&buf, ',')) goto oom;
         if (!buffer_append_cstr(&buf, "\"cb_emergency\":")) goto oom;
-        if (!buffer_appendf(&buf, "%ld", cb_emergency)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)cb_emergency)) goto oom;
         if (!buffer_append_char(&buf, ',')) goto oom;
         if (!buffer_append_cstr(&buf, "\"cb_env\":")) goto oom;
-        if (!buffer_appendf(&buf, "%ld", cb_env)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)cb_env)) goto oom;
         if (!buffer_append_char(&buf, ',')) goto oom;
         if (!buffer_append_cstr(&buf, "\"cb_other\":")) goto oom;
-        if (!buffer_appendf(&buf, "%ld", cb_other)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)cb_other)) goto oom;
         if (!buffer_append_char(&buf, ',')) goto oom;
         if (!buffer_append_cstr(&buf, "\"tst\":")) goto oom;
-        if (!buffer_appendf(&buf, "%ld", tst)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)tst)) goto oom;
         if (!buffer_append_char(&buf, ',')) goto oom;
         if (!buffer_append_cstr(&buf, "\"rp\":")) goto oom;
-        if (!buffer_appendf(&buf, "%ld", rp)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)rp)) goto oom;
         if (!buffer_append_char(&buf, ',')) goto oom;
         if (!buffer_append_cstr(&buf, "\"misc\":")) goto oom;
-        if (!buffer_appendf(&buf, "%ld", misc)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)misc)) goto oom;
         if (!buffer_append_char(&buf, ',')) goto oom;
         if (!buffer_append_cstr(&buf, "\"hours\":")) goto oom;
-        double hours = PQgetisnull(trend_res, i, 9) ? 0.0 : strtod(PQgetvalue(trend_res, i, 9), NULL);
-        if (!buffer_appendf(&buf, "%.2f", hours)) goto oom;
+        double hours = PQgetisnull(trend_res, i, 9) ? 0.0 : parse_decimal_double(PQgetvalue(trend_res, i, 9), NULL);
+        if (!buffer_append_fixed(&buf, hours, 2)) goto oom;
         if (!buffer_append_char(&buf, '}')) goto oom;
         if (i > 0 && !buffer_append_char(&buf, ',')) goto oom;
     }
@@ -8656,7 +8940,7 @@ static char *build_service_summary_json(PGconn *conn, const LocationProfile *pro
         if (!buffer_append_char(&buf, ',')) goto oom;
         if (!buffer_append_cstr(&buf, "\"tickets\":")) goto oom;
         long count = PQgetisnull(vendor_res, i, 1) ? 0 : strtol(PQgetvalue(vendor_res, i, 1), NULL, 10);
-        if (!buffer_appendf(&buf, "%ld", count)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)count)) goto oom;
         if (!buffer_append_char(&buf, '}')) goto oom;
         if (i + 1 < vendor_rows && !buffer_append_char(&buf, ',')) goto oom;
     }
@@ -8675,7 +8959,7 @@ static char *build_service_summary_json(PGconn *conn, const LocationProfile *pro
         const ServiceActivityInfo *info = service_activity_lookup(code);
         ServiceActivityCategory category = info ? info->category : SERVICE_ACTIVITY_UNKNOWN;
         long tickets = PQgetisnull(activity_res, i, 1) ? 0 : strtol(PQgetvalue(activity_res, i, 1), NULL, 10);
-        double hours = PQgetisnull(activity_res, i, 2) ? 0.0 : strtod(PQgetvalue(activity_res, i, 2), NULL);
+        double hours = PQgetisnull(activity_res, i, 2) ? 0.0 : parse_decimal_double(PQgetvalue(activity_res, i, 2), NULL);
         total_activity_tickets += tickets;
         total_activity_hours += hours;
         if (category < 0 || category > SERVICE_ACTIVITY_UNKNOWN) {
@@ -8696,10 +8980,10 @@ static char *build_service_summary_json(PGconn *conn, const LocationProfile *pro
         ok = ok && buffer_append_json_string(&buf, service_activity_category_name(category));
         ok = ok && buffer_append_char(&buf, ',');
         ok = ok && buffer_append_cstr(&buf, "\"tickets\":");
-        ok = ok && buffer_appendf(&buf, "%ld", tickets);
+        ok = ok && buffer_append_int64(&buf, tickets);
         ok = ok && buffer_append_char(&buf, ',');
         ok = ok && buffer_append_cstr(&buf, "\"hours\":");
-        ok = ok && buffer_appendf(&buf, "%.2f", hours);
+        ok = ok && buffer_append_fixed(&buf, hours, 2);
         ok = ok && buffer_append_char(&buf, ',');
         ok = ok && buffer_append_cstr(&buf, "\"description\":");
         ok = ok && buffer_append_json_string(&buf, info ? info->description : "Unclassified or missing activity code");
@@ -8731,14 +9015,14 @@ static char *build_service_summary_json(PGconn *conn, const LocationProfile *pro
         if (!buffer_append_json_string(&buf, service_activity_category_name((ServiceActivityCategory)cat))) goto oom;
         if (!buffer_append_char(&buf, ',')) goto oom;
         if (!buffer_append_cstr(&buf, "\"tickets\":")) goto oom;
-        if (!buffer_appendf(&buf, "%ld", category_tickets[cat])) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)category_tickets[cat])) goto oom;
         if (!buffer_append_char(&buf, ',')) goto oom;
         if (!buffer_append_cstr(&buf, "\"hours\":")) goto oom;
-        if (!buffer_appendf(&buf, "%.2f", category_hours[cat])) goto oom;
+        if (!buffer_append_fixed(&buf, category_hours[cat], 2)) goto oom;
         if (!buffer_append_char(&buf, ',')) goto oom;
         if (!buffer_append_cstr(&buf, "\"share\":")) goto oom;
         double share = (total_activity_tickets > 0) ? ((double)category_tickets[cat] / (double)total_activity_tickets) : 0.0;
-        if (!buffer_appendf(&buf, "%.4f", share)) goto oom;
+        if (!buffer_append_fixed(&buf, share, 4)) goto oom;
         if (!buffer_append_char(&buf, ',')) goto oom;
         if (!buffer_append_cstr(&buf, "\"short_label\":")) goto oom;
         if (!buffer_append_json_string(&buf, service_activity_category_short((ServiceActivityCategory)cat))) goto oom;
@@ -8869,19 +9153,19 @@ static char *build_financial_summary_json(PGconn *conn, const LocationProfile *p
             total_records = strtol(PQgetvalue(res, 0, 0), NULL, 10);
         }
         if (!PQgetisnull(res, 0, 1)) {
-            total_spend = strtod(PQgetvalue(res, 0, 1), NULL);
+            total_spend = parse_decimal_double(PQgetvalue(res, 0, 1), NULL);
         }
         if (!PQgetisnull(res, 0, 2)) {
-            proposed_spend = strtod(PQgetvalue(res, 0, 2), NULL);
+            proposed_spend = parse_decimal_double(PQgetvalue(res, 0, 2), NULL);
         }
         if (!PQgetisnull(res, 0, 3)) {
-            approved_spend = strtod(PQgetvalue(res, 0, 3), NULL);
+            approved_spend = parse_decimal_double(PQgetvalue(res, 0, 3), NULL);
         }
         if (!PQgetisnull(res, 0, 4)) {
-            open_spend = strtod(PQgetvalue(res, 0, 4), NULL);
+            open_spend = parse_decimal_double(PQgetvalue(res, 0, 4), NULL);
         }
         if (!PQgetisnull(res, 0, 5)) {
-            total_savings = strtod(PQgetvalue(res, 0, 5), NULL);
+            total_savings = parse_decimal_double(PQgetvalue(res, 0, 5), NULL);
         }
         if (!PQgetisnull(res, 0, 6)) {
             last_statement = strdup(PQgetvalue(res, 0, 6));
@@ -8927,7 +9211,7 @@ static char *build_financial_summary_json(PGconn *conn, const LocationProfile *p
             challenged_count = strtol(PQgetvalue(quality_res, 0, 2), NULL, 10);
         }
         if (!PQgetisnull(quality_res, 0, 3)) {
-            negotiated_savings = strtod(PQgetvalue(quality_res, 0, 3), NULL);
+            negotiated_savings = parse_decimal_double(PQgetvalue(quality_res, 0, 3), NULL);
         }
     }
     PQclear(quality_res);
@@ -9170,31 +9454,31 @@ static char *build_financial_summary_json(PGconn *conn, const LocationProfile *p
 
     if (!buffer_append_char(&buf, '{')) goto fin_oom;
     if (!buffer_append_cstr(&buf, "\"total_records\":")) goto fin_oom;
-    if (!buffer_appendf(&buf, "%ld", total_records)) goto fin_oom;
+    if (!buffer_append_int64(&buf, (int64_t)total_records)) goto fin_oom;
     if (!buffer_append_char(&buf, ',')) goto fin_oom;
 
     if (!buffer_append_cstr(&buf, "\"total_spend\":")) goto fin_oom;
-    if (!buffer_appendf(&buf, "%.2f", total_spend)) goto fin_oom;
+    if (!buffer_append_fixed(&buf, total_spend, 2)) goto fin_oom;
     if (!buffer_append_char(&buf, ',')) goto fin_oom;
 
     if (!buffer_append_cstr(&buf, "\"proposed_spend\":")) goto fin_oom;
-    if (!buffer_appendf(&buf, "%.2f", proposed_spend)) goto fin_oom;
+    if (!buffer_append_fixed(&buf, proposed_spend, 2)) goto fin_oom;
     if (!buffer_append_char(&buf, ',')) goto fin_oom;
 
     if (!buffer_append_cstr(&buf, "\"approved_spend\":")) goto fin_oom;
-    if (!buffer_appendf(&buf, "%.2f", approved_spend)) goto fin_oom;
+    if (!buffer_append_fixed(&buf, approved_spend, 2)) goto fin_oom;
     if (!buffer_append_char(&buf, ',')) goto fin_oom;
 
     if (!buffer_append_cstr(&buf, "\"open_spend\":")) goto fin_oom;
-    if (!buffer_appendf(&buf, "%.2f", open_spend)) goto fin_oom;
+    if (!buffer_append_fixed(&buf, open_spend, 2)) goto fin_oom;
     if (!buffer_append_char(&buf, ',')) goto fin_oom;
 
     if (!buffer_append_cstr(&buf, "\"total_savings\":")) goto fin_oom;
-    if (!buffer_appendf(&buf, "%.2f", total_savings)) goto fin_oom;
+    if (!buffer_append_fixed(&buf, total_savings, 2)) goto fin_oom;
     if (!buffer_append_char(&buf, ',')) goto fin_oom;
 
     if (!buffer_append_cstr(&buf, "\"savings_rate\":")) goto fin_oom;
-    if (!buffer_appendf(&buf, "%.4f", savings_rate)) goto fin_oom;
+    if (!buffer_append_fixed(&buf, savings_rate, 4)) goto fin_oom;
     if (!buffer_append_char(&buf, ',')) goto fin_oom;
 
     if (!buffer_append_cstr(&buf, "\"last_statement\":")) goto fin_oom;
@@ -9210,10 +9494,10 @@ static char *build_financial_summary_json(PGconn *conn, const LocationProfile *p
     double latest_spend = 0.0;
     double previous_spend = 0.0;
     if (trend_rows > 0 && !PQgetisnull(trend_res, 0, 1)) {
-        latest_spend = strtod(PQgetvalue(trend_res, 0, 1), NULL);
+        latest_spend = parse_decimal_double(PQgetvalue(trend_res, 0, 1), NULL);
     }
     if (trend_rows > 1 && !PQgetisnull(trend_res, 1, 1)) {
-        previous_spend = strtod(PQgetvalue(trend_res, 1, 1), NULL);
+        previous_spend = parse_decimal_double(PQgetvalue(trend_res, 1, 1), NULL);
     }
     for (int i = trend_rows - 1; i >= 0; --i) {
         if (!buffer_append_char(&buf, '{')) goto fin_oom;
@@ -9221,29 +9505,29 @@ static char *build_financial_summary_json(PGconn *conn, const LocationProfile *p
         if (!buffer_append_json_string(&buf, PQgetisnull(trend_res, i, 0) ? NULL : PQgetvalue(trend_res, i, 0))) goto fin_oom;
         if (!buffer_append_char(&buf, ',')) goto fin_oom;
         if (!buffer_append_cstr(&buf, "\"spend\":")) goto fin_oom;
-        double spend = PQgetisnull(trend_res, i, 1) ? 0.0 : strtod(PQgetvalue(trend_res, i, 1), NULL);
-        double spend_bc = PQgetisnull(trend_res, i, 2) ? 0.0 : strtod(PQgetvalue(trend_res, i, 2), NULL);
-        double spend_opex = PQgetisnull(trend_res, i, 3) ? 0.0 : strtod(PQgetvalue(trend_res, i, 3), NULL);
-        double spend_capex = PQgetisnull(trend_res, i, 4) ? 0.0 : strtod(PQgetvalue(trend_res, i, 4), NULL);
+        double spend = PQgetisnull(trend_res, i, 1) ? 0.0 : parse_decimal_double(PQgetvalue(trend_res, i, 1), NULL);
+        double spend_bc = PQgetisnull(trend_res, i, 2) ? 0.0 : parse_decimal_double(PQgetvalue(trend_res, i, 2), NULL);
+        double spend_opex = PQgetisnull(trend_res, i, 3) ? 0.0 : parse_decimal_double(PQgetvalue(trend_res, i, 3), NULL);
+        double spend_capex = PQgetisnull(trend_res, i, 4) ? 0.0 : parse_decimal_double(PQgetvalue(trend_res, i, 4), NULL);
         double spend_other = spend - spend_bc - spend_opex - spend_capex;
         if (fabs(spend_other) < 0.01) {
             spend_other = 0.0;
         } else if (spend_other < 0.0) {
             spend_other = 0.0;
         }
-        if (!buffer_appendf(&buf, "%.2f", spend)) goto fin_oom;
+        if (!buffer_append_fixed(&buf, spend, 2)) goto fin_oom;
         if (!buffer_append_char(&buf, ',')) goto fin_oom;
         if (!buffer_append_cstr(&buf, "\"bc\":")) goto fin_oom;
-        if (!buffer_appendf(&buf, "%.2f", spend_bc)) goto fin_oom;
+        if (!buffer_append_fixed(&buf, spend_bc, 2)) goto fin_oom;
         if (!buffer_append_char(&buf, ',')) goto fin_oom;
         if (!buffer_append_cstr(&buf, "\"opex\":")) goto fin_oom;
-        if (!buffer_appendf(&buf, "%.2f", spend_opex)) goto fin_oom;
+        if (!buffer_append_fixed(&buf, spend_opex, 2)) goto fin_oom;
         if (!buffer_append_char(&buf, ',')) goto fin_oom;
         if (!buffer_append_cstr(&buf, "\"capex\":")) goto fin_oom;
-        if (!buffer_appendf(&buf, "%.2f", spend_capex)) goto fin_oom;
+        if (!buffer_append_fixed(&buf, spend_capex, 2)) goto fin_oom;
         if (!buffer_append_char(&buf, ',')) goto fin_oom;
         if (!buffer_append_cstr(&buf, "\"other\":")) goto fin_oom;
-        if (!buffer_appendf(&buf, "%.2f", spend_other)) goto fin_oom;
+        if (!buffer_append_fixed(&buf, spend_other, 2)) goto fin_oom;
         if (!buffer_append_char(&buf, '}')) goto fin_oom;
         if (i > 0 && !buffer_append_char(&buf, ',')) goto fin_oom;
     }
@@ -9258,8 +9542,8 @@ static char *build_financial_summary_json(PGconn *conn, const LocationProfile *p
         if (!buffer_append_json_string(&buf, PQgetisnull(classification_res, i, 0) ? NULL : PQgetvalue(classification_res, i, 0))) goto fin_oom;
         if (!buffer_append_char(&buf, ',')) goto fin_oom;
         if (!buffer_append_cstr(&buf, "\"spend\":")) goto fin_oom;
-        double spend = PQgetisnull(classification_res, i, 1) ? 0.0 : strtod(PQgetvalue(classification_res, i, 1), NULL);
-        if (!buffer_appendf(&buf, "%.2f", spend)) goto fin_oom;
+        double spend = PQgetisnull(classification_res, i, 1) ? 0.0 : parse_decimal_double(PQgetvalue(classification_res, i, 1), NULL);
+        if (!buffer_append_fixed(&buf, spend, 2)) goto fin_oom;
         if (!buffer_append_char(&buf, '}')) goto fin_oom;
         if (i + 1 < classification_rows && !buffer_append_char(&buf, ',')) goto fin_oom;
     }
@@ -9274,8 +9558,8 @@ static char *build_financial_summary_json(PGconn *conn, const LocationProfile *p
         if (!buffer_append_json_string(&buf, PQgetisnull(type_res, i, 0) ? NULL : PQgetvalue(type_res, i, 0))) goto fin_oom;
         if (!buffer_append_char(&buf, ',')) goto fin_oom;
         if (!buffer_append_cstr(&buf, "\"spend\":")) goto fin_oom;
-        double spend = PQgetisnull(type_res, i, 1) ? 0.0 : strtod(PQgetvalue(type_res, i, 1), NULL);
-        if (!buffer_appendf(&buf, "%.2f", spend)) goto fin_oom;
+        double spend = PQgetisnull(type_res, i, 1) ? 0.0 : parse_decimal_double(PQgetvalue(type_res, i, 1), NULL);
+        if (!buffer_append_fixed(&buf, spend, 2)) goto fin_oom;
         if (!buffer_append_char(&buf, '}')) goto fin_oom;
         if (i + 1 < type_rows && !buffer_append_char(&buf, ',')) goto fin_oom;
     }
@@ -9293,8 +9577,8 @@ static char *build_financial_summary_json(PGconn *conn, const LocationProfile *p
         if (!buffer_append_json_string(&buf, PQgetisnull(vendor_res, i, 1) ? NULL : PQgetvalue(vendor_res, i, 1))) goto fin_oom;
         if (!buffer_append_char(&buf, ',')) goto fin_oom;
         if (!buffer_append_cstr(&buf, "\"spend\":")) goto fin_oom;
-        double spend = PQgetisnull(vendor_res, i, 2) ? 0.0 : strtod(PQgetvalue(vendor_res, i, 2), NULL);
-        if (!buffer_appendf(&buf, "%.2f", spend)) goto fin_oom;
+        double spend = PQgetisnull(vendor_res, i, 2) ? 0.0 : parse_decimal_double(PQgetvalue(vendor_res, i, 2), NULL);
+        if (!buffer_append_fixed(&buf, spend, 2)) goto fin_oom;
         if (!buffer_append_char(&buf, '}')) goto fin_oom;
         if (i + 1 < vendor_rows && !buffer_append_char(&buf, ',')) goto fin_oom;
     }
@@ -9309,12 +9593,12 @@ static char *build_financial_summary_json(PGconn *conn, const LocationProfile *p
         if (!buffer_append_json_string(&buf, PQgetisnull(work_res, i, 0) ? NULL : PQgetvalue(work_res, i, 0))) goto fin_oom;
         if (!buffer_append_char(&buf, ',')) goto fin_oom;
         if (!buffer_append_cstr(&buf, "\"spend\":")) goto fin_oom;
-        double spend = PQgetisnull(work_res, i, 1) ? 0.0 : strtod(PQgetvalue(work_res, i, 1), NULL);
-        if (!buffer_appendf(&buf, "%.2f", spend)) goto fin_oom;
+        double spend = PQgetisnull(work_res, i, 1) ? 0.0 : parse_decimal_double(PQgetvalue(work_res, i, 1), NULL);
+        if (!buffer_append_fixed(&buf, spend, 2)) goto fin_oom;
         if (!buffer_append_char(&buf, ',')) goto fin_oom;
         if (!buffer_append_cstr(&buf, "\"records\":")) goto fin_oom;
         long records = PQgetisnull(work_res, i, 2) ? 0 : strtol(PQgetvalue(work_res, i, 2), NULL, 10);
-        if (!buffer_appendf(&buf, "%ld", records)) goto fin_oom;
+        if (!buffer_append_int64(&buf, (int64_t)records)) goto fin_oom;
         if (!buffer_append_char(&buf, '}')) goto fin_oom;
         if (i + 1 < work_rows && !buffer_append_char(&buf, ',')) goto fin_oom;
     }
@@ -9329,7 +9613,7 @@ static char *build_financial_summary_json(PGconn *conn, const LocationProfile *p
     int savings_limit = savings_rows > 64 ? 64 : savings_rows;
     for (int i = 0; i < savings_limit; ++i) {
         savings_months[i] = PQgetisnull(savings_res, i, 0) ? NULL : PQgetvalue(savings_res, i, 0);
-        savings_values[i] = PQgetisnull(savings_res, i, 1) ? 0.0 : strtod(PQgetvalue(savings_res, i, 1), NULL);
+        savings_values[i] = PQgetisnull(savings_res, i, 1) ? 0.0 : parse_decimal_double(PQgetvalue(savings_res, i, 1), NULL);
     }
     double cumulative_total = 0.0;
     for (int i = savings_limit - 1; i >= 0; --i) {
@@ -9342,7 +9626,7 @@ static char *build_financial_summary_json(PGconn *conn, const LocationProfile *p
         if (!buffer_append_json_string(&buf, month)) goto fin_oom;
         if (!buffer_append_char(&buf, ',')) goto fin_oom;
         if (!buffer_append_cstr(&buf, "\"savings\":")) goto fin_oom;
-        if (!buffer_appendf(&buf, "%.2f", savings)) goto fin_oom;
+        if (!buffer_append_fixed(&buf, savings, 2)) goto fin_oom;
         if (!buffer_append_char(&buf, '}')) goto fin_oom;
         if (i > 0 && !buffer_append_char(&buf, ',')) goto fin_oom;
     }
@@ -9356,7 +9640,7 @@ static char *build_financial_summary_json(PGconn *conn, const LocationProfile *p
         if (!buffer_append_json_string(&buf, savings_months[i])) goto fin_oom;
         if (!buffer_append_char(&buf, ',')) goto fin_oom;
         if (!buffer_append_cstr(&buf, "\"savings\":")) goto fin_oom;
-        if (!buffer_appendf(&buf, "%.2f", cumulative_values[i])) goto fin_oom;
+        if (!buffer_append_fixed(&buf, cumulative_values[i], 2)) goto fin_oom;
         if (!buffer_append_char(&buf, '}')) goto fin_oom;
         if (i > 0 && !buffer_append_char(&buf, ',')) goto fin_oom;
     }
@@ -9371,8 +9655,8 @@ static char *build_financial_summary_json(PGconn *conn, const LocationProfile *p
         if (!buffer_append_json_string(&buf, PQgetisnull(category_res, i, 0) ? NULL : PQgetvalue(category_res, i, 0))) goto fin_oom;
         if (!buffer_append_char(&buf, ',')) goto fin_oom;
         if (!buffer_append_cstr(&buf, "\"spend\":")) goto fin_oom;
-        double spend = PQgetisnull(category_res, i, 1) ? 0.0 : strtod(PQgetvalue(category_res, i, 1), NULL);
-        if (!buffer_appendf(&buf, "%.2f", spend)) goto fin_oom;
+        double spend = PQgetisnull(category_res, i, 1) ? 0.0 : parse_decimal_double(PQgetvalue(category_res, i, 1), NULL);
+        if (!buffer_append_fixed(&buf, spend, 2)) goto fin_oom;
         if (!buffer_append_char(&buf, '}')) goto fin_oom;
         if (i + 1 < cat_rows && !buffer_append_char(&buf, ',')) goto fin_oom;
     }
@@ -9387,8 +9671,8 @@ static char *build_financial_summary_json(PGconn *conn, const LocationProfile *p
         if (!buffer_append_json_string(&buf, PQgetisnull(status_res, i, 0) ? NULL : PQgetvalue(status_res, i, 0))) goto fin_oom;
         if (!buffer_append_char(&buf, ',')) goto fin_oom;
         if (!buffer_append_cstr(&buf, "\"spend\":")) goto fin_oom;
-        double spend = PQgetisnull(status_res, i, 1) ? 0.0 : strtod(PQgetvalue(status_res, i, 1), NULL);
-        if (!buffer_appendf(&buf, "%.2f", spend)) goto fin_oom;
+        double spend = PQgetisnull(status_res, i, 1) ? 0.0 : parse_decimal_double(PQgetvalue(status_res, i, 1), NULL);
+        if (!buffer_append_fixed(&buf, spend, 2)) goto fin_oom;
         if (!buffer_append_char(&buf, '}')) goto fin_oom;
         if (i + 1 < status_rows && !buffer_append_char(&buf, ',')) goto fin_oom;
     }
@@ -9404,8 +9688,8 @@ static char *build_financial_summary_json(PGconn *conn, const LocationProfile *p
             analytics_out->has_records = true;
         }
         analytics_out->savings_points = savings_limit;
-        analytics_out->latest_savings = (savings_rows > 0 && !PQgetisnull(savings_res, 0, 1)) ? strtod(PQgetvalue(savings_res, 0, 1), NULL) : 0.0;
-        analytics_out->previous_savings = (savings_rows > 1 && !PQgetisnull(savings_res, 1, 1)) ? strtod(PQgetvalue(savings_res, 1, 1), NULL) : 0.0;
+        analytics_out->latest_savings = (savings_rows > 0 && !PQgetisnull(savings_res, 0, 1)) ? parse_decimal_double(PQgetvalue(savings_res, 0, 1), NULL) : 0.0;
+        analytics_out->previous_savings = (savings_rows > 1 && !PQgetisnull(savings_res, 1, 1)) ? parse_decimal_double(PQgetvalue(savings_res, 1, 1), NULL) : 0.0;
     }
 
     PQclear(savings_res);
@@ -9485,11 +9769,13 @@ static bool string_is_integer(const char *text) {
     return true;
 }
 
-static TimelineEntry *timeline_find_entry(TimelineEntry *entries, size_t count, const char *month) {
-    if (!entries || !month) {
+static TimelineEntry *timeline_find_entry(TimelineEntry *entries, const HashIndex *index, const char *month) {
+    if (!entries || !index || !month) {
         return NULL;
     }
-    for (size_t i = 0; i < count; ++i) {
+    HashIndexProbe probe;
+    hash_index_probe_init(&probe, index, hash_string(month));
+    for (size_t i; (i = hash_index_probe_next(&probe)) != HASH_INDEX_NONE;) {
         if (entries[i].month && strcmp(entries[i].month, month) == 0) {
             return &entries[i];
         }
@@ -9497,11 +9783,11 @@ static TimelineEntry *timeline_find_entry(TimelineEntry *entries, size_t count,
     return NULL;
 }
 
-static int timeline_ensure_entry(TimelineEntry **entries, size_t *count, size_t *capacity, const char *month, TimelineEntry **out_entry) {
-    if (!entries || !count || !capacity || !month || !out_entry) {
+static int timeline_ensure_entry(TimelineEntry **entries, size_t *count, size_t *capacity, HashIndex *index, const char *month, TimelineEntry **out_entry) {
+    if (!entries || !count || !capacity || !index || !month || !out_entry) {
         return 0;
     }
-    TimelineEntry *existing = timeline_find_entry(*entries, *count, month);
+    TimelineEntry *existing = timeline_find_entry(*entries, index, month);
     if (existing) {
         *out_entry = existing;
         return 1;
@@ -9520,6 +9806,10 @@ static int timeline_ensure_entry(TimelineEntry **entries, size_t *count, size_t
     if (!entry->month) {
         return 0;
     }
+    if (!hash_index_insert(index, hash_string(month), *count)) {
+        free(entry->month);
+        return 0;
+    }
     entry->pm_count = 0;
     entry->cb_emergency_count = 0;
     entry->cb_equipment_count = 0;
@@ -9663,6 +9953,8 @@ static char *build_service_financial_timeline_json(PGconn *conn, const LocationP
     TimelineEntry *entries = NULL;
     size_t entry_count = 0;
     size_t entry_capacity = 0;
+    HashIndex entry_index;
+    hash_index_init(&entry_index);
 
     if (service_res && PQresultStatus(service_res) == PGRES_TUPLES_OK) {
         int service_rows = PQntuples(service_res);
@@ -9676,11 +9968,12 @@ static char *build_service_financial_timeline_json(PGconn *conn, const LocationP
             const ServiceActivityInfo *activity = service_activity_lookup(raw_code);
             ServiceActivityCategory category = activity ? activity->category : SERVICE_ACTIVITY_UNKNOWN;
             TimelineEntry *entry = NULL;
-            if (!timeline_ensure_entry(&entries, &entry_count, &entry_capacity, month, &entry)) {
+            if (!timeline_ensure_entry(&entries, &entry_count, &entry_capacity, &entry_index, month, &entry)) {
                 if (error_out && !*error_out) {
                     *error_out = strdup("Out of memory building timeline");
                 }
                 timeline_free_entries(entries, entry_count);
+                hash_index_clear(&entry_index);
                 PQclear(service_res);
                 if (finance_res) PQclear(finance_res);
                 free(street_trim);
@@ -9744,21 +10037,22 @@ static char *build_service_financial_timeline_json(PGconn *conn, const LocationP
             }
             const char *month = PQgetvalue(finance_res, i, 0);
             TimelineEntry *entry = NULL;
-            if (!timeline_ensure_entry(&entries, &entry_count, &entry_capacity, month, &entry)) {
+            if (!timeline_ensure_entry(&entries, &entry_count, &entry_capacity, &entry_index, month, &entry)) {
                 if (error_out && !*error_out) {
                     *error_out = strdup("Out of memory building timeline");
                 }
                 timeline_free_entries(entries, entry_count);
+                hash_index_clear(&entry_index);
                 PQclear(finance_res);
                 free(street_trim);
                 free(city_trim);
                 free(state_trim);
                 return NULL;
             }
-            double spend_total = PQgetisnull(finance_res, i, 1) ? 0.0 : strtod(PQgetvalue(finance_res, i, 1), NULL);
-            double spend_bc = PQgetisnull(finance_res, i, 2) ? 0.0 : strtod(PQgetvalue(finance_res, i, 2), NULL);
-            double spend_opex = PQgetisnull(finance_res, i, 3) ? 0.0 : strtod(PQgetvalue(finance_res, i, 3), NULL);
-            double spend_capex = PQgetisnull(finance_res, i, 4) ? 0.0 : strtod(PQgetvalue(finance_res, i, 4), NULL);
+            double spend_total = PQgetisnull(finance_res, i, 1) ? 0.0 : parse_decimal_double(PQgetvalue(finance_res, i, 1), NULL);
+            double spend_bc = PQgetisnull(finance_res, i, 2) ? 0.0 : parse_decimal_double(PQgetvalue(finance_res, i, 2), NULL);
+            double spend_opex = PQgetisnull(finance_res, i, 3) ? 0.0 : parse_decimal_double(PQgetvalue(finance_res, i, 3), NULL);
+            double spend_capex = PQgetisnull(finance_res, i, 4) ? 0.0 : parse_decimal_double(PQgetvalue(finance_res, i, 4), NULL);
             double spend_other = spend_total - spend_bc - spend_opex - spend_capex;
             if (fabs(spend_other) < 0.01) {
                 spend_other = 0.0;
@@ -9778,6 +10072,7 @@ static char *build_service_financial_timeline_json(PGconn *conn, const LocationP
     free(street_trim);
     free(city_trim);
     free(state_trim);
+    hash_index_clear(&entry_index);
 
     if (entry_count == 0) {
         if (service_available) *service_available = false;
@@ -9809,6 +10104,7 @@ static char *build_service_financial_timeline_json(PGconn *conn, const LocationP
                 }
                 TimelineEntry *original_entries = entries;
                 size_t original_count = entry_count;
+                size_t source_pos = 0;
                 int year = start_year;
                 int month = start_month;
                 for (size_t idx = 0; idx < needed; ++idx) {
@@ -9823,7 +10119,14 @@ static char *build_service_financial_timeline_json(PGconn *conn, const LocationP
                         }
                         return NULL;
                     }
-                    TimelineEntry *source = timeline_find_entry(original_entries, original_count, label);
+                    /* Both sequences ascend by month, so the sorted originals merge in with one cursor. */
+                    while (source_pos < original_count && strcmp(original_entries[source_pos].month, label) < 0) {
+                        source_pos++;
+                    }
+                    TimelineEntry *source = NULL;
+                    if (source_pos < original_count && strcmp(original_entries[source_pos].month, label) == 0) {
+                        source = &original_entries[source_pos];
+                    }
                     if (source) {
                     expanded[idx].pm_count = source->pm_count;
                         expanded[idx].cb_emergency_count = source->cb_emergency_count;
@@ -9953,35 +10256,35 @@ static char *build_service_financial_timeline_json(PGconn *conn, const LocationP
         if (!buffer_append_cstr(&buf, "\"month\":")) goto timeline_oom;
         if (!buffer_append_json_string(&buf, entries[i].month)) goto timeline_oom;
         if (!buffer_append_cstr(&buf, ",\"pm\":")) goto timeline_oom;
-        if (!buffer_appendf(&buf, "%ld", entries[i].pm_count)) goto timeline_oom;
+        if (!buffer_append_int64(&buf, (int64_t)entries[i].pm_count)) goto timeline_oom;
         if (!buffer_append_cstr(&buf, ",\"cb_emergency\":")) goto timeline_oom;
-        if (!buffer_appendf(&buf, "%ld", entries[i].cb_emergency_count)) goto timeline_oom;
+        if (!buffer_append_int64(&buf, (int64_t)entries[i].cb_emergency_count)) goto timeline_oom;
         if (!buffer_append_cstr(&buf, ",\"cb_equipment\":")) goto timeline_oom;
-        if (!buffer_appendf(&buf, "%ld", entries[i].cb_equipment_count)) goto timeline_oom;
+        if (!buffer_append_int64(&buf, (int64_t)entries[i].cb_equipment_count)) goto timeline_oom;
         if (!buffer_append_cstr(&buf, ",\"cb_env\":")) goto timeline_oom;
-        if (!buffer_appendf(&buf, "%ld", entries[i].cb_env_count)) goto timeline_oom;
+        if (!buffer_append_int64(&buf, (int64_t)entries[i].cb_env_count)) goto timeline_oom;
         if (!buffer_append_cstr(&buf, ",\"cb_other\":")) goto timeline_oom;
-        if (!buffer_appendf(&buf, "%ld", entries[i].cb_other_count)) goto timeline_oom;
+        if (!buffer_append_int64(&buf, (int64_t)entries[i].cb_other_count)) goto timeline_oom;
         if (!buffer_append_cstr(&buf, ",\"tst\":")) goto timeline_oom;
-        if (!buffer_appendf(&buf, "%ld", entries[i].tst_count)) goto timeline_oom;
+        if (!buffer_append_int64(&buf, (int64_t)entries[i].tst_count)) goto timeline_oom;
         if (!buffer_append_cstr(&buf, ",\"rp\":")) goto timeline_oom;
-        if (!buffer_appendf(&buf, "%ld", entries[i].rp_count)) goto timeline_oom;
+        if (!buffer_append_int64(&buf, (int64_t)entries[i].rp_count)) goto timeline_oom;
         if (!buffer_append_cstr(&buf, ",\"misc\":")) goto timeline_oom;
-        if (!buffer_appendf(&buf, "%ld", entries[i].misc_count)) goto timeline_oom;
+        if (!buffer_append_int64(&buf, (int64_t)entries[i].misc_count)) goto timeline_oom;
         if (!buffer_append_cstr(&buf, ",\"total\":")) goto timeline_oom;
-        if (!buffer_appendf(&buf, "%ld", entries[i].total_count)) goto timeline_oom;
+        if (!buffer_append_int64(&buf, (int64_t)entries[i].total_count)) goto timeline_oom;
         if (!buffer_append_cstr(&buf, ",\"callback_visits\":")) goto timeline_oom;
-        if (!buffer_appendf(&buf, "%ld", entries[i].callback_count)) goto timeline_oom;
+        if (!buffer_append_int64(&buf, (int64_t)entries[i].callback_count)) goto timeline_oom;
         if (!buffer_append_cstr(&buf, ",\"spend\":")) goto timeline_oom;
-        if (!buffer_appendf(&buf, "%.2f", entries[i].spend_amount)) goto timeline_oom;
+        if (!buffer_append_fixed(&buf, entries[i].spend_amount, 2)) goto timeline_oom;
         if (!buffer_append_cstr(&buf, ",\"bc\":")) goto timeline_oom;
-        if (!buffer_appendf(&buf, "%.2f", entries[i].spend_bc)) goto timeline_oom;
+        if (!buffer_append_fixed(&buf, entries[i].spend_bc, 2)) goto timeline_oom;
         if (!buffer_append_cstr(&buf, ",\"opex\":")) goto timeline_oom;
-        if (!buffer_appendf(&buf, "%.2f", entries[i].spend_opex)) goto timeline_oom;
+        if (!buffer_append_fixed(&buf, entries[i].spend_opex, 2)) goto timeline_oom;
         if (!buffer_append_cstr(&buf, ",\"capex\":")) goto timeline_oom;
-        if (!buffer_appendf(&buf, "%.2f", entries[i].spend_capex)) goto timeline_oom;
+        if (!buffer_append_fixed(&buf, entries[i].spend_capex, 2)) goto timeline_oom;
         if (!buffer_append_cstr(&buf, ",\"other\":")) goto timeline_oom;
-        if (!buffer_appendf(&buf, "%.2f", entries[i].spend_other)) goto timeline_oom;
+        if (!buffer_append_fixed(&buf, entries[i].spend_other, 2)) goto timeline_oom;
         if (!buffer_append_char(&buf, '}')) goto timeline_oom;
     }
     if (!buffer_append_char(&buf, ']')) goto timeline_oom;
@@ -10026,14 +10329,12 @@ static int buffer_append_double_or_null(Buffer *buf, double value, int precision
     if (!isfinite(value)) {
         return buffer_append_cstr(buf, "null");
     }
-    char fmt[16];
     if (precision < 0) {
         precision = 0;
     } else if (precision > 6) {
         precision = 6;
     }
-    snprintf(fmt, sizeof(fmt), "%%.%df", precision);
-    return buffer_appendf(buf, fmt, value);
+    return buffer_append_fixed(buf, value, precision);
 }
 
 static char *build_location_analytics_json(const ReportData *report, const LocationProfile *profile, size_t open_deficiencies, const ServiceAnalytics *service_stats, const FinancialAnalytics *financial_stats, const char *timeline_json, const TimelineStats *timeline_stats, bool timeline_has_service, bool timeline_has_financial, const OverviewWindow *overview_windows, size_t overview_window_count) {
@@ -10197,7 +10498,7 @@ static char *build_location_analytics_json(const ReportData *report, const Locat
 
     if (!buffer_append_cstr(&buf, "\"overview\":{")) goto oom;
     if (!buffer_append_cstr(&buf, "\"device_count\":")) goto oom;
-    if (!buffer_appendf(&buf, "%d", device_count)) goto oom;
+    if (!buffer_append_int64(&buf, (int64_t)device_count)) goto oom;
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"data_coverage\":{")) goto oom;
     if (!buffer_append_cstr(&buf, "\"deficiencies\":")) goto oom;
@@ -10277,11 +10578,11 @@ static char *build_location_analytics_json(const ReportData *report, const Locat
         if (!buffer_append_cstr(&buf, win->deficiencies_available ? "true" : "false")) goto oom;
         if (!buffer_append_cstr(&buf, ",\"metrics\":{")) goto oom;
         if (!buffer_append_cstr(&buf, "\"device_count\":")) goto oom;
-        if (!buffer_appendf(&buf, "%d", win->device_count)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)win->device_count)) goto oom;
         if (!buffer_append_cstr(&buf, ",\"total_deficiencies\":")) goto oom;
-        if (!buffer_appendf(&buf, "%d", win->total_deficiencies)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)win->total_deficiencies)) goto oom;
         if (!buffer_append_cstr(&buf, ",\"open_deficiencies\":")) goto oom;
-        if (!buffer_appendf(&buf, "%d", win->open_deficiencies)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)win->open_deficiencies)) goto oom;
         if (!buffer_append_cstr(&buf, ",\"tickets_per_device\":")) goto oom;
         if (!buffer_append_double_or_null(&buf, win->tickets_per_device, 3)) goto oom;
         if (!buffer_append_cstr(&buf, ",\"service_hours\":")) goto oom;
@@ -10325,19 +10626,19 @@ static char *build_location_analytics_json(const ReportData *report, const Locat
     if (!buffer_append_cstr(&buf, "\"status\":")) goto oom;
     if (!buffer_append_json_string(&buf, maintenance_status)) goto oom;
     if (!buffer_append_cstr(&buf, ",\"pm_actual\":")) goto oom;
-    if (!buffer_appendf(&buf, "%ld", pm_actual_count)) goto oom;
+    if (!buffer_append_int64(&buf, (int64_t)pm_actual_count)) goto oom;
     if (!buffer_append_cstr(&buf, ",\"pm_expected\":")) goto oom;
     if (!buffer_append_double_or_null(&buf, pm_expected, 2)) goto oom;
     if (!buffer_append_cstr(&buf, ",\"pm_ratio\":")) goto oom;
     if (!buffer_append_double_or_null(&buf, pm_ratio, 3)) goto oom;
     if (!buffer_append_cstr(&buf, ",\"tst_actual\":")) goto oom;
-    if (!buffer_appendf(&buf, "%ld", tst_actual_count)) goto oom;
+    if (!buffer_append_int64(&buf, (int64_t)tst_actual_count)) goto oom;
     if (!buffer_append_cstr(&buf, ",\"tst_expected\":")) goto oom;
     if (!buffer_append_double_or_null(&buf, tst_expected, 2)) goto oom;
     if (!buffer_append_cstr(&buf, ",\"tst_ratio\":")) goto oom;
     if (!buffer_append_double_or_null(&buf, tst_ratio, 3)) goto oom;
     if (!buffer_append_cstr(&buf, ",\"window_months\":")) goto oom;
-    if (!buffer_appendf(&buf, "%d", timeline_window_months)) goto oom;
+    if (!buffer_append_int64(&buf, (int64_t)timeline_window_months)) goto oom;
     if (!buffer_append_cstr(&buf, ",\"message\":")) goto oom;
     if (!buffer_append_json_string(&buf, maintenance_message)) goto oom;
     if (!buffer_append_char(&buf, '}')) goto oom;
@@ -10351,7 +10652,7 @@ static char *build_location_analytics_json(const ReportData *report, const Locat
     if (!buffer_append_cstr(&buf, ",\"callbacks_per_device_per_year\":")) goto oom;
     if (!buffer_append_double_or_null(&buf, callbacks_per_device_per_year, 2)) goto oom;
     if (!buffer_append_cstr(&buf, ",\"callback_events\":")) goto oom;
-    if (!buffer_appendf(&buf, "%ld", cb_equipment_count)) goto oom;
+    if (!buffer_append_int64(&buf, (int64_t)cb_equipment_count)) goto oom;
     if (!buffer_append_cstr(&buf, ",\"opex_annual\":")) goto oom;
     if (!buffer_append_double_or_null(&buf, opex_annualized, 0)) goto oom;
     if (!buffer_append_cstr(&buf, ",\"expected_savings\":")) goto oom;
@@ -10388,30 +10689,30 @@ static char *build_location_analytics_json(const ReportData *report, const Locat
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"metrics\":{")) goto oom;
     if (!buffer_append_cstr(&buf, "\"total\":")) goto oom;
-    if (!buffer_appendf(&buf, "%d", total_deficiencies)) goto oom;
+    if (!buffer_append_int64(&buf, (int64_t)total_deficiencies)) goto oom;
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"open\":")) goto oom;
-    if (!buffer_appendf(&buf, "%zu", open_deficiencies)) goto oom;
+    if (!buffer_append_int64(&buf, (int64_t)open_deficiencies)) goto oom;
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"closure_rate\":")) goto oom;
     if (isnan(closure_rate)) {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     } else {
-        if (!buffer_appendf(&buf, "%.4f", closure_rate)) goto oom;
+        if (!buffer_append_fixed(&buf, closure_rate, 4)) goto oom;
     }
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"open_per_device\":")) goto oom;
     if (isnan(open_per_device)) {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     } else {
-        if (!buffer_appendf(&buf, "%.2f", open_per_device)) goto oom;
+        if (!buffer_append_fixed(&buf, open_per_device, 2)) goto oom;
     }
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"avg_per_device\":")) goto oom;
     if (isnan(avg_per_device)) {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     } else {
-        if (!buffer_appendf(&buf, "%.2f", avg_per_device)) goto oom;
+        if (!buffer_append_fixed(&buf, avg_per_device, 2)) goto oom;
     }
     if (!buffer_append_char(&buf, '}')) goto oom;
     if (!buffer_append_char(&buf, ',')) goto oom;
@@ -10432,14 +10733,14 @@ static char *build_location_analytics_json(const ReportData *report, const Locat
     if (!buffer_append_cstr(&buf, "\"metrics\":{")) goto oom;
     if (!buffer_append_cstr(&buf, "\"tickets\":")) goto oom;
     if (service_available) {
-        if (!buffer_appendf(&buf, "%ld", service_tickets)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)service_tickets)) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     }
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"hours\":")) goto oom;
     if (service_available) {
-        if (!buffer_appendf(&buf, "%.2f", service_hours)) goto oom;
+        if (!buffer_append_fixed(&buf, service_hours, 2)) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     }
@@ -10448,7 +10749,7 @@ static char *build_location_analytics_json(const ReportData *report, const Locat
     if (isnan(service_per_device)) {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     } else {
-        if (!buffer_appendf(&buf, "%.2f", service_per_device)) goto oom;
+        if (!buffer_append_fixed(&buf, service_per_device, 2)) goto oom;
     }
     if (!buffer_append_char(&buf, '}')) goto oom;
     if (!buffer_append_char(&buf, ',')) goto oom;
@@ -10458,14 +10759,14 @@ static char *build_location_analytics_json(const ReportData *report, const Locat
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"percent_change\":")) goto oom;
     if (service_percent_valid) {
-        if (!buffer_appendf(&buf, "%.2f", service_percent_change)) goto oom;
+        if (!buffer_append_fixed(&buf, service_percent_change, 2)) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     }
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"forecast\":")) goto oom;
     if (service_forecast_valid) {
-        if (!buffer_appendf(&buf, "%.2f", service_forecast)) goto oom;
+        if (!buffer_append_fixed(&buf, service_forecast, 2)) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     }
@@ -10492,14 +10793,14 @@ static char *build_location_analytics_json(const ReportData *report, const Locat
             if (!buffer_append_json_string(&buf, service_activity_category_short((ServiceActivityCategory)cat))) goto oom;
             if (!buffer_append_char(&buf, ',')) goto oom;
             if (!buffer_append_cstr(&buf, "\"tickets\":")) goto oom;
-            if (!buffer_appendf(&buf, "%ld", cat_tickets)) goto oom;
+            if (!buffer_append_int64(&buf, (int64_t)cat_tickets)) goto oom;
             if (!buffer_append_char(&buf, ',')) goto oom;
             if (!buffer_append_cstr(&buf, "\"hours\":")) goto oom;
-            if (!buffer_appendf(&buf, "%.2f", cat_hours)) goto oom;
+            if (!buffer_append_fixed(&buf, cat_hours, 2)) goto oom;
             if (!buffer_append_char(&buf, ',')) goto oom;
             if (!buffer_append_cstr(&buf, "\"share\":")) goto oom;
             double share = (service_activity_total > 0.0) ? ((double)cat_tickets / service_activity_total) : 0.0;
-            if (!buffer_appendf(&buf, "%.4f", share)) goto oom;
+            if (!buffer_append_fixed(&buf, share, 4)) goto oom;
             if (!buffer_append_char(&buf, '}')) goto oom;
         }
     }
@@ -10513,35 +10814,35 @@ static char *build_location_analytics_json(const ReportData *report, const Locat
     if (!buffer_append_cstr(&buf, "\"metrics\":{")) goto oom;
     if (!buffer_append_cstr(&buf, "\"total_spend\":")) goto oom;
     if (financial_available) {
-        if (!buffer_appendf(&buf, "%.2f", financial_total_spend)) goto oom;
+        if (!buffer_append_fixed(&buf, financial_total_spend, 2)) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     }
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"proposed_spend\":")) goto oom;
     if (financial_available) {
-        if (!buffer_appendf(&buf, "%.2f", financial_proposed)) goto oom;
+        if (!buffer_append_fixed(&buf, financial_proposed, 2)) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     }
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"proposed_spend\":")) goto oom;
     if (financial_available) {
-        if (!buffer_appendf(&buf, "%.2f", financial_proposed)) goto oom;
+        if (!buffer_append_fixed(&buf, financial_proposed, 2)) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     }
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"approved_spend\":")) goto oom;
     if (financial_available) {
-        if (!buffer_appendf(&buf, "%.2f", financial_approved)) goto oom;
+        if (!buffer_append_fixed(&buf, financial_approved, 2)) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     }
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"open_spend\":")) goto oom;
     if (financial_available) {
-        if (!buffer_appendf(&buf, "%.2f", financial_open)) goto oom;
+        if (!buffer_append_fixed(&buf, financial_open, 2)) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     }
@@ -10550,12 +10851,12 @@ static char *build_location_analytics_json(const ReportData *report, const Locat
     if (isnan(financial_per_device)) {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     } else {
-        if (!buffer_appendf(&buf, "%.2f", financial_per_device)) goto oom;
+        if (!buffer_append_fixed(&buf, financial_per_device, 2)) goto oom;
     }
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"savings_total\":")) goto oom;
     if (financial_available) {
-        if (!buffer_appendf(&buf, "%.2f", savings_total_amount)) goto oom;
+        if (!buffer_append_fixed(&buf, savings_total_amount, 2)) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     }
@@ -10564,14 +10865,14 @@ static char *build_location_analytics_json(const ReportData *report, const Locat
     if (isnan(savings_rate_decimal)) {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     } else {
-        if (!buffer_appendf(&buf, "%.4f", savings_rate_decimal)) goto oom;
+        if (!buffer_append_fixed(&buf, savings_rate_decimal, 4)) goto oom;
     }
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"savings_per_device\":")) goto oom;
     if (isnan(savings_per_device)) {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     } else {
-        if (!buffer_appendf(&buf, "%.2f", savings_per_device)) goto oom;
+        if (!buffer_append_fixed(&buf, savings_per_device, 2)) goto oom;
     }
     if (!buffer_append_char(&buf, '}')) goto oom;
     if (!buffer_append_char(&buf, ',')) goto oom;
@@ -10581,14 +10882,14 @@ static char *build_location_analytics_json(const ReportData *report, const Locat
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"percent_change\":")) goto oom;
     if (financial_percent_valid) {
-        if (!buffer_appendf(&buf, "%.2f", financial_percent_change)) goto oom;
+        if (!buffer_append_fixed(&buf, financial_percent_change, 2)) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     }
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"forecast\":")) goto oom;
     if (financial_forecast_valid) {
-        if (!buffer_appendf(&buf, "%.2f", financial_forecast)) goto oom;
+        if (!buffer_append_fixed(&buf, financial_forecast, 2)) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     }
@@ -10600,14 +10901,14 @@ static char *build_location_analytics_json(const ReportData *report, const Locat
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"percent_change\":")) goto oom;
     if (savings_percent_valid) {
-        if (!buffer_appendf(&buf, "%.2f", savings_percent_change)) goto oom;
+        if (!buffer_append_fixed(&buf, savings_percent_change, 2)) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     }
     if (!buffer_append_char(&buf, ',')) goto oom;
     if (!buffer_append_cstr(&buf, "\"forecast\":")) goto oom;
     if (savings_forecast_valid) {
-        if (!buffer_appendf(&buf, "%.2f", savings_forecast)) goto oom;
+        if (!buffer_append_fixed(&buf, savings_forecast, 2)) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
     }
@@ -10618,9 +10919,9 @@ static char *build_location_analytics_json(const ReportData *report, const Locat
         if (!buffer_append_char(&buf, '{')) goto oom;
         if (!buffer_append_cstr(&buf, "\"measure\":\"callbacks_vs_spend\",")) goto oom;
         if (!buffer_append_cstr(&buf, "\"coefficient\":")) goto oom;
-        if (!buffer_appendf(&buf, "%.4f", timeline_stats->correlation)) goto oom;
+        if (!buffer_append_fixed(&buf, timeline_stats->correlation, 4)) goto oom;
         if (!buffer_append_cstr(&buf, ",\"sample_months\":")) goto oom;
-        if (!buffer_appendf(&buf, "%d", timeline_stats->sample_count)) goto oom;
+        if (!buffer_append_int64(&buf, (int64_t)timeline_stats->sample_count)) goto oom;
         if (!buffer_append_char(&buf, '}')) goto oom;
     } else {
         if (!buffer_append_cstr(&buf, "null")) goto oom;
@@ -10741,15 +11042,15 @@ static char *build_visit_summary_json(PGconn *conn, const LocationProfile *profi
         if (!buffer_append_char(&buf, ',')) goto visit_oom;
         if (!buffer_append_cstr(&buf, "\"audit_count\":")) goto visit_oom;
         long audit_count = PQgetisnull(res, i, 4) ? 0 : strtol(PQgetvalue(res, i, 4), NULL, 10);
-        if (!buffer_appendf(&buf, "%ld", audit_count)) goto visit_oom;
+        if (!buffer_append_int64(&buf, (int64_t)audit_count)) goto visit_oom;
         if (!buffer_append_char(&buf, ',')) goto visit_oom;
         if (!buffer_append_cstr(&buf, "\"device_count\":")) goto visit_oom;
         long device_count = PQgetisnull(res, i, 5) ? 0 : strtol(PQgetvalue(res, i, 5), NULL, 10);
-        if (!buffer_appendf(&buf, "%ld", device_count)) goto visit_oom;
+        if (!buffer_append_int64(&buf, (int64_t)device_count)) goto visit_oom;
         if (!buffer_append_char(&buf, ',')) goto visit_oom;
         if (!buffer_append_cstr(&buf, "\"open_deficiencies\":")) goto visit_oom;
         long open_defs = PQgetisnull(res, i, 6) ? 0 : strtol(PQgetvalue(res, i, 6), NULL, 10);
-        if (!buffer_appendf(&buf, "%ld", open_defs)) goto visit_oom;
+        if (!buffer_append_int64(&buf, (int64_t)open_defs)) goto visit_oom;
         if (!buffer_append_char(&buf, '}')) goto visit_oom;
         if (i + 1 < rows && !buffer_append_char(&buf, ',')) goto visit_oom;
     }
@@ -10973,6 +11274,72 @@ static int collect_files_recursive(const char *root, char **csv_path, char **jso
     return 1;
 }
 
+/* Marks photos whose blob is already stored. On failure every photo is simply uploaded. */
+static void mark_stored_photo_blobs(PGconn *conn, PhotoCollection *photos, const char *digest_array) {
+    const char *sql = "SELECT sha256 FROM photo_blobs WHERE sha256 = ANY($1::text[])";
+    const char *params[1] = { digest_array };
+    PGresult *res = PQexecParams(conn, sql, 1, NULL, params, NULL, NULL, 0);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        log_error("Failed to look up stored photo blobs: %s", PQresultErrorMessage(res));
+        PQclear(res);
+        return;
+    }
+    int rows = PQntuples(res);
+    for (int row = 0; row < rows; ++row) {
+        const char *stored = PQgetvalue(res, row, 0);
+        for (size_t i = 0; i < photos->count; ++i) {
+            if (strcmp(photos->items[i].sha256, stored) == 0) {
+                photos->items[i].blob_stored = true;
+            }
+        }
+    }
+    PQclear(res);
+}
+
+/* Hashes the listed photos and renders thumbnails and previews for those whose blob is not
+   stored yet, so a re-submitted audit costs neither rendering nor upload. Runs once per
+   archive, outside the upsert transaction; a photo that cannot be decoded is still stored
+   and is then served at full size. */
+static void prepare_photo_blobs(PGconn *conn, PhotoCollection *photos, const StringArray *photo_order) {
+    Buffer digests = {0};
+    bool have_digests = buffer_init(&digests) && buffer_append_cstr(&digests, "{");
+    size_t hashed = 0;
+    for (size_t i = 0; i < photo_order->count; ++i) {
+        const PhotoFile *found = photo_collection_find(photos, photo_order->values[i]);
+        if (!found || found->sha256[0] != '\0') {
+            continue;
+        }
+        PhotoFile *photo = &photos->items[found - photos->items];
+        Sha256 digest;
+        sha256_init(&digest);
+        sha256_update(&digest, photo->data, photo->size);
+        sha256_final_hex(&digest, photo->sha256);
+        /* Digests are plain hex, so the array literal needs no quoting. */
+        have_digests = have_digests &&
+                       (hashed == 0 || buffer_append_cstr(&digests, ",")) &&
+                       buffer_append_cstr(&digests, photo->sha256);
+        hashed++;
+    }
+    if (hashed > 0 && have_digests && buffer_append_cstr(&digests, "}")) {
+        mark_stored_photo_blobs(conn, photos, digests.data);
+    }
+    buffer_free(&digests);
+
+    for (size_t i = 0; i < photos->count; ++i) {
+        PhotoFile *photo = &photos->items[i];
+        if (photo->sha256[0] == '\0' || photo->blob_stored) {
+            continue;
+        }
+        char *error = NULL;
+        if (photo_derivatives_render(photo->data, photo->size, &photo->derivatives, &error)) {
+            photo->renditions_done = true;
+        } else {
+            log_info("No thumbnail or preview for photo %s: %s", photo->filename, error ? error : "unknown error");
+        }
+        free(error);
+    }
+}
+
 static int collect_files(const char *root_dir, char **csv_path, char **json_path, PhotoCollection *photos) {
     *csv_path = NULL;
     *json_path = NULL;
@@ -11861,11 +12228,56 @@ oom_params:
     allocation_list_clear(&pool);
     return 0;
 }
-static int db_replace_photos(PGconn *conn, const char *audit_uuid, const PhotoCollection *photos, const StringArray *photo_order, char **error_out) {
-    const char *delete_sql = "DELETE FROM audit_photos WHERE audit_uuid = $1";
+/* Uploads the photo's blob unless one with the same digest exists. The existing row is locked
+   so a concurrent prune cannot delete it before this transaction references it. */
+static int db_store_photo_blob(PGconn *conn, const PhotoFile *photo, char **error_out) {
+    const char *lock_sql = "SELECT 1 FROM photo_blobs WHERE sha256 = $1 FOR KEY SHARE";
+    const char *lock_params[1] = { photo->sha256 };
+    PGresult *res = PQexecParams(conn, lock_sql, 1, NULL, lock_params, NULL, NULL, 0);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        if (error_out) {
+            const char *errmsg = PQresultErrorMessage(res);
+            *error_out = strdup(errmsg ? errmsg : "Failed looking up photo blob");
+        }
+        PQclear(res);
+        return 0;
+    }
+    bool exists = PQntuples(res) > 0;
+    PQclear(res);
+    if (exists) {
+        return 1;
+    }
+
+    /* Renditions are missing only if the blob was pruned after prepare_photo_blobs saw it;
+       --render-photo-derivatives fills them in. */
+    const char *blob_sql =
+        "INSERT INTO photo_blobs (sha256, photo_bytes, thumb_bytes, preview_bytes, renditions_done) VALUES ($1,$2,$3,$4,$5) "
+        "ON CONFLICT (sha256) DO NOTHING";
+    const PhotoDerivatives *derived = &photo->derivatives;
+    const char *params[5] = { photo->sha256, (const char *)photo->data, (const char *)derived->thumb, (const char *)derived->preview,
+                              photo->renditions_done ? "true" : "false" };
+    int lengths[5] = { 0, (int)photo->size, (int)derived->thumb_size, (int)derived->preview_size, 0 };
+    int formats[5] = { 0, 1, 1, 1, 0 };
+    res = PQexecParams(conn, blob_sql, 5, NULL, params, lengths, formats, 0);
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        if (error_out) {
+            const char *errmsg = PQresultErrorMessage(res);
+            *error_out = strdup(errmsg ? errmsg : "Failed storing photo blob");
+        }
+        PQclear(res);
+        return 0;
+    }
+    PQclear(res);
+    return 1;
+}
+
+/* Digests of the replaced rows go to released_out so their blobs can be pruned after commit. */
+static int db_replace_photos(PGconn *conn, const char *audit_uuid, const PhotoCollection *photos, const StringArray *photo_order,
+                             StringArray *released_out, char **error_out) {
+    const char *delete_sql = "DELETE FROM audit_photos WHERE audit_uuid = $1 RETURNING photo_sha256";
     const char *del_params[1] = { audit_uuid };
     PGresult *del_res = PQexecParams(conn, delete_sql, 1, NULL, del_params, NULL, NULL, 0);
-    if (PQresultStatus(del_res) != PGRES_COMMAND_OK) {
+    if (PQresultStatus(del_res) != PGRES_TUPLES_OK) {
         if (error_out) {
             const char *errmsg = PQresultErrorMessage(del_res);
             *error_out = strdup(errmsg ? errmsg : "Failed clearing existing photos");
@@ -11873,13 +12285,20 @@ static int db_replace_photos(PGconn *conn, const char *audit_uuid, const PhotoCo
         PQclear(del_res);
         return 0;
     }
+    for (int row = 0; row < PQntuples(del_res); ++row) {
+        if (!string_array_append_copy(released_out, PQgetvalue(del_res, row, 0))) {
+            if (error_out) *error_out = strdup("Out of memory");
+            PQclear(del_res);
+            return 0;
+        }
+    }
     PQclear(del_res);
 
     if (!photo_order || photo_order->count == 0) {
         return 1;
     }
 
-    const char *insert_sql = "INSERT INTO audit_photos (audit_uuid, photo_filename, content_type, photo_bytes) VALUES ($1,$2,$3,$4)";
+    const char *insert_sql = "INSERT INTO audit_photos (audit_uuid, photo_filename, content_type, photo_sha256) VALUES ($1,$2,$3,$4)";
 
     for (size_t i = 0; i < photo_order->count; ++i) {
         const char *filename = photo_order->values[i];
@@ -11888,15 +12307,17 @@ static int db_replace_photos(PGconn *conn, const char *audit_uuid, const PhotoCo
             log_info("Photo %s listed in JSON but missing from archive", filename);
             continue;
         }
+        if (!db_store_photo_blob(conn, photo, error_out)) {
+            return 0;
+        }
+
         const char *params[4];
-        int lengths[4] = {0, 0, 0, (int)photo->size};
-        int formats[4] = {0, 0, 0, 1};
         params[0] = audit_uuid;
         params[1] = photo->filename;
         params[2] = photo->content_type ? photo->content_type : "application/octet-stream";
-        params[3] = (const char *)photo->data;
+        params[3] = photo->sha256;
 
-        PGresult *res = PQexecParams(conn, insert_sql, 4, NULL, params, lengths, formats, 0);
+        PGresult *res = PQexecParams(conn, insert_sql, 4, NULL, params, NULL, NULL, 0);
         if (PQresultStatus(res) != PGRES_COMMAND_OK) {
             if (error_out) {
                 const char *errmsg = PQresultErrorMessage(res);
@@ -12027,8 +12448,11 @@ static int db_upsert_audit(PGconn *conn, const AuditRecord *record, const PhotoC
         }
         return 0;
     }
-    if (!db_replace_photos(conn, record->audit_uuid, photos, photo_order, &step_error)) {
+    StringArray released;
+    string_array_init(&released);
+    if (!db_replace_photos(conn, record->audit_uuid, photos, photo_order, &released, &step_error)) {
         db_rollback(conn);
+        string_array_clear(&released);
         if (step_error) {
             if (error_out) *error_out = step_error; else free(step_error);
         }
@@ -12036,6 +12460,7 @@ static int db_upsert_audit(PGconn *conn, const AuditRecord *record, const PhotoC
     }
     if (!db_replace_deficiencies(conn, record->audit_uuid, deficiencies, &step_error)) {
         db_rollback(conn);
+        string_array_clear(&released);
         if (step_error) {
             if (error_out) *error_out = step_error; else free(step_error);
         }
@@ -12043,8 +12468,23 @@ static int db_upsert_audit(PGconn *conn, const AuditRecord *record, const PhotoC
     }
     if (!db_commit(conn, error_out)) {
         db_rollback(conn);
+        string_array_clear(&released);
         return 0;
     }
+
+    /* Usually the re-submitted photos reference the same blobs again and nothing is pruned.
+       A failure only leaves garbage for the startup sweep. */
+    if (released.count > 0) {
+        long pruned = 0;
+        char *prune_error = NULL;
+        if (!db_prune_photo_blobs(conn, (const char *const *)released.values, released.count, &pruned, &prune_error)) {
+            log_error("Failed to prune photo blobs: %s", prune_error ? prune_error : "unknown error");
+        } else if (pruned > 0) {
+            log_info("Pruned %ld unreferenced photo blobs", pruned);
+        }
+        free(prune_error);
+    }
+    string_array_clear(&released);
     return 1;
 }
 
@@ -12121,6 +12561,7 @@ static int process_extracted_archive(char *temp_dir, PGconn *conn, StringArray *
         goto cleanup;
     }
     photo_order_init = true;
+    prepare_photo_blobs(conn, &photos, &photo_order);
 
     if (!parse_deficiencies(json_root, &deficiency_list)) {
         if (error_out && !*error_out) *error_out = strdup("Failed to parse deficiencies from JSON");
@@ -12234,6 +12675,7 @@ static int process_extracted_archive(char *temp_dir, PGconn *conn, StringArray *
     }
 
     success = 1;
+    narrative_prefetch_enqueue(visit.building_address, &visit.location_id);
 
 cleanup:
     if (visit_inserted && !success) {
@@ -12690,35 +13132,82 @@ static int copy_file_contents(const char *src_path, const char *dst_path) {
     return 0;
 }
 
-static int export_building_photos(PGconn *conn, const ReportData *report, const char *root_dir, char **error_out) {
-    if (!conn || !report || !root_dir) {
-        if (error_out && !*error_out) {
-            *error_out = strdup("Invalid export parameters");
+/* "SITE PICTURES/<device>/<photo>": the same names the old on-disk export produced, with the
+   extension reduced to alphanumerics so no entry can climb out of its folder. */
+static char *build_photo_entry_name(const char *device_dir, const char *filename, size_t ordinal) {
+    char generated_name[64];
+    const char *orig_name = (filename && *filename) ? filename : NULL;
+    if (!orig_name) {
+        snprintf(generated_name, sizeof(generated_name), "photo-%zu.jpg", ordinal);
+        orig_name = generated_name;
+    }
+    char *base_name = sanitize_path_component(orig_name);
+    if (!base_name) {
+        return NULL;
+    }
+    char ext[16] = "";
+    const char *dot = strrchr(orig_name, '.');
+    if (dot && dot[1]) {
+        size_t pos = 0;
+        ext[pos++] = '.';
+        for (const char *c = dot + 1; *c && pos < sizeof(ext) - 1; ++c) {
+            if (isalnum((unsigned char)*c)) {
+                ext[pos++] = *c;
+            }
         }
-        return 0;
+        ext[pos > 1 ? pos : 0] = '\0';
+    }
+    Buffer name;
+    if (!buffer_init(&name) ||
+        !buffer_appendf(&name, "SITE PICTURES/%s/%s%s", device_dir, base_name, ext)) {
+        buffer_free(&name);
+        free(base_name);
+        return NULL;
     }
+    free(base_name);
+    return name.data;
+}
 
-    char *site_dir = join_path(root_dir, "SITE PICTURES");
-    if (!site_dir) {
-        if (error_out && !*error_out) {
-            *error_out = strdup("Out of memory creating site pictures directory");
+typedef struct {
+    ZipWriter *zip;
+    const char *device_dir;
+    size_t row;
+    char **error_out;
+} PhotoExport;
+
+static int stream_photo_row(void *ctx, const PGresult *res, int row) {
+    PhotoExport *export = (PhotoExport *)ctx;
+    const char *filename = PQgetisnull(res, row, 0) ? NULL : PQgetvalue(res, row, 0);
+    char *entry_name = build_photo_entry_name(export->device_dir, filename, ++export->row);
+    if (!entry_name) {
+        if (export->error_out && !*export->error_out) {
+            *export->error_out = strdup("Out of memory creating photo filename");
         }
         return 0;
     }
-    if (ensure_directory_exists(site_dir) != 0) {
+    int ok = zip_writer_contains(export->zip, entry_name) ||
+             zip_writer_add(export->zip, entry_name, PQgetvalue(res, row, 2), (size_t)PQgetlength(res, row, 2),
+                            zip_method_for_name(entry_name), export->error_out);
+    free(entry_name);
+    return ok;
+}
+
+/* Photos are streamed a row at a time straight into the archive, so memory holds at most
+   one photo however many the building has. */
+static int stream_building_photos(ZipWriter *zip, PGconn *conn, const ReportData *report, char **error_out) {
+    if (!zip || !conn || !report) {
         if (error_out && !*error_out) {
-            char msg[160];
-            snprintf(msg, sizeof(msg), "Failed to create %s: %s", site_dir, strerror(errno));
-            *error_out = strdup(msg);
+            *error_out = strdup("Invalid export parameters");
         }
-        free(site_dir);
         return 0;
     }
 
     const char *sql =
-        "SELECT photo_filename, content_type, photo_bytes "
-        "FROM audit_photos "
-        "WHERE audit_uuid = $1::uuid";
+        "SELECT p.photo_filename, p.content_type, b.photo_bytes "
+        "FROM audit_photos p "
+        "JOIN photo_blobs b ON b.sha256 = p.photo_sha256 "
+        "WHERE p.audit_uuid = $1::uuid "
+        "ORDER BY p.id";
 
     for (size_t i = 0; i < report->devices.count; ++i) {
         const ReportDevice *device = &report->devices.items[i];
@@ -12727,253 +13216,77 @@ static int export_building_photos(PGconn *conn, const ReportData *report, const
         }
 
         const char *name_source = device->device_id ? device->device_id : (device->submission_id ? device->submission_id : device->audit_uuid);
-        char *safe_name = sanitize_path_component(name_source);
-        if (!safe_name) {
-            if (error_out && !*error_out) {
-                *error_out = strdup("Out of memory creating device directory");
-            }
-            free(site_dir);
-            return 0;
-        }
-        char *device_dir = join_path(site_dir, safe_name);
-        free(safe_name);
+        char *device_dir = sanitize_path_component(name_source);
         if (!device_dir) {
             if (error_out && !*error_out) {
-                *error_out = strdup("Out of memory creating device directory path");
-            }
-            free(site_dir);
-            return 0;
-        }
-        if (ensure_directory_exists(device_dir) != 0) {
-            if (error_out && !*error_out) {
-                char msg[160];
-                snprintf(msg, sizeof(msg), "Failed to create %s: %s", device_dir, strerror(errno));
-                *error_out = strdup(msg);
+                *error_out = strdup("Out of memory creating device directory");
             }
-            free(device_dir);
-            free(site_dir);
             return 0;
         }
 
         const char *params[1] = { device->audit_uuid };
-        int resultFormat = 1; // binary for photo_bytes
-        PGresult *res = PQexecParams(conn, sql, 1, NULL, params, NULL, NULL, resultFormat);
-        if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-            if (error_out && !*error_out) {
-                const char *msg = PQresultErrorMessage(res);
-                *error_out = strdup(msg ? msg : "Failed to fetch device photos");
-            }
-            PQclear(res);
-            free(device_dir);
-            free(site_dir);
+        PhotoExport export = { .zip = zip, .device_dir = device_dir, .row = 0, .error_out = error_out };
+        int ok = db_stream_rows(conn, sql, 1, params, 1, 1, stream_photo_row, &export, error_out);
+        free(device_dir);
+        if (!ok) {
             return 0;
         }
-
-        int rows = PQntuples(res);
-        for (int row = 0; row < rows; ++row) {
-            const char *filename = PQgetisnull(res, row, 0) ? NULL : PQgetvalue(res, row, 0);
-            const char *orig_name = (filename && *filename) ? filename : NULL;
-            char generated_name[64];
-            if (!orig_name) {
-                snprintf(generated_name, sizeof(generated_name), "photo-%d.jpg", row + 1);
-                orig_name = generated_name;
-            }
-            char *base_name = sanitize_path_component(orig_name);
-            if (!base_name) {
-                if (error_out && !*error_out) {
-                    *error_out = strdup("Out of memory creating photo filename");
-                }
-                PQclear(res);
-                free(device_dir);
-                free(site_dir);
-                return 0;
-            }
-
-            const char *ext = strrchr(orig_name, '.');
-            char *final_name = NULL;
-            if (ext && *(ext + 1)) {
-                size_t base_len = strlen(base_name);
-                size_t ext_len = strlen(ext);
-                final_name = malloc(base_len + ext_len + 1);
-                if (!final_name) {
-                    if (error_out && !*error_out) {
-                        *error_out = strdup("Out of memory creating photo filename");
-                    }
-                    free(base_name);
-                    PQclear(res);
-                    free(device_dir);
-                    free(site_dir);
-                    return 0;
-                }
-                memcpy(final_name, base_name, base_len);
-                memcpy(final_name + base_len, ext, ext_len + 1);
-            } else {
-                final_name = base_name;
-                base_name = NULL;
-            }
-
-            char *photo_path = join_path(device_dir, final_name);
-            if (!photo_path) {
-                if (error_out && !*error_out) {
-                    *error_out = strdup("Out of memory assembling photo path");
-                }
-                free(final_name);
-                free(base_name);
-                PQclear(res);
-                free(device_dir);
-                free(site_dir);
-                return 0;
-            }
-
-            free(base_name);
-
-            const unsigned char *bytes = (const unsigned char *)PQgetvalue(res, row, 2);
-            size_t length = (size_t)PQgetlength(res, row, 2);
-            FILE *fp = fopen(photo_path, "wb");
-            if (!fp) {
-                if (error_out && !*error_out) {
-                    char msg[160];
-                    snprintf(msg, sizeof(msg), "Failed to write %s: %s", photo_path, strerror(errno));
-                    *error_out = strdup(msg);
-                }
-                free(photo_path);
-                PQclear(res);
-                free(device_dir);
-                free(site_dir);
-                free(final_name);
-                return 0;
-            }
-            if (length > 0 && fwrite(bytes, 1, length, fp) != length) {
-                if (error_out && !*error_out) {
-                    char msg[160];
-                    snprintf(msg, sizeof(msg), "Failed to write %s: %s", photo_path, "short write");
-                    *error_out = strdup(msg);
-                }
-                fclose(fp);
-                unlink(photo_path);
-                free(photo_path);
-                PQclear(res);
-                free(device_dir);
-                free(site_dir);
-                free(final_name);
-                return 0;
-            }
-            fclose(fp);
-            free(photo_path);
-            free(final_name);
-        }
-        PQclear(res);
-        free(device_dir);
     }
-
-    free(site_dir);
     return 1;
 }
 
-static int create_report_archive(PGconn *conn, const ReportJob *job, const ReportData *report,
-                                 const char *job_dir, const char *pdf_path, char **zip_path_out, char **error_out) {
-    if (zip_path_out) {
-        *zip_path_out = NULL;
-    }
-    if (!conn || !job_dir || !pdf_path) {
+static int zip_sink_http_chunk(void *ctx, const void *data, size_t len) {
+    return send_http_chunk(*(const int *)ctx, data, len);
+}
+
+/* Streams the package as chunked ZIP; nothing is staged on disk. Returns 0 only while the
+   response has not started, so the caller can still send a JSON error. A failure after the
+   headers went out drops the connection without the final chunk, so clients see a
+   truncated transfer rather than a damaged archive. */
+static int stream_report_package(int client_fd, PGconn *conn, const ReportData *report, const char *pdf_path,
+                                 const char *download_name, char **error_out) {
+    if (!conn || !report || !pdf_path) {
         if (error_out && !*error_out) {
             *error_out = strdup("Invalid archive parameters");
         }
         return 0;
     }
-
-    char *package_dir = create_temp_dir();
-    if (!package_dir) {
+    if (access(pdf_path, R_OK) != 0) {
         if (error_out && !*error_out) {
-            *error_out = strdup("Failed to create package directory");
+            *error_out = strdup("Failed to prepare report PDF");
         }
         return 0;
     }
-
-    bool archive_deficiency = job && job->deficiency_only;
-    bool archive_overview = job && job->type == REPORT_JOB_TYPE_LOCATION_OVERVIEW;
-    const char *pdf_filename = archive_deficiency ? "deficiency_list.pdf" : (archive_overview ? "location_overview.pdf" : "audit_report.pdf");
-    const char *zip_filename = archive_deficiency ? "deficiency_list_package.zip" : (archive_overview ? "location_overview_package.zip" : "audit_report_package.zip");
-    char *pdf_copy_path = join_path(package_dir, pdf_filename);
-    if (!pdf_copy_path || copy_file_contents(pdf_path, pdf_copy_path) != 0) {
+    ZipWriter *zip = zip_writer_create(zip_sink_http_chunk, &client_fd);
+    if (!zip) {
         if (error_out && !*error_out) {
-            *error_out = strdup("Failed to prepare report PDF");
+            *error_out = strdup("Out of memory creating report archive");
         }
-        free(pdf_copy_path);
-        remove_directory_recursive(package_dir);
-        free(package_dir);
         return 0;
     }
-
-    if (!job || !job->deficiency_only) {
-        char *photo_error = NULL;
-        if (!export_building_photos(conn, report, package_dir, &photo_error)) {
-            if (error_out && !*error_out) {
-                *error_out = photo_error ? photo_error : strdup("Failed to export photos");
-            } else {
-                free(photo_error);
-            }
-            free(pdf_copy_path);
-            remove_directory_recursive(package_dir);
-            free(package_dir);
-            return 0;
-        }
-        free(photo_error);
+    if (!send_http_download_stream_start(client_fd, "application/zip", download_name)) {
+        zip_writer_free(zip);
+        return 1;
     }
-    free(pdf_copy_path);
 
-    char *zip_path = join_path(job_dir, zip_filename);
-    if (!zip_path) {
-        if (error_out && !*error_out) {
-            *error_out = strdup("Out of memory creating zip path");
-        }
-        remove_directory_recursive(package_dir);
-        free(package_dir);
-        return 0;
+    char *package_error = NULL;
+    if (zip_writer_add_file(zip, "audit_report.pdf", pdf_path, &package_error) &&
+        stream_building_photos(zip, conn, report, &package_error) &&
+        zip_writer_finish(zip, &package_error)) {
+        send_http_stream_end(client_fd);
+    } else {
+        log_error("Report package %s aborted after %llu bytes: %s",
+                  download_name ? download_name : "(unnamed)",
+                  (unsigned long long)zip_writer_bytes_written(zip),
+                  package_error ? package_error : "unknown error");
     }
+    free(package_error);
+    zip_writer_free(zip);
+    return 1;
+}
 
-    pid_t pid = fork();
-    if (pid < 0) {
-        if (error_out && !*error_out) {
-            *error_out = strdup("Failed to fork zip process");
-        }
-        free(zip_path);
-        remove_directory_recursive(package_dir);
-        free(package_dir);
-        return 0;
-    }
-    if (pid == 0) {
-        if (chdir(package_dir) != 0) {
-            _exit(127);
-        }
-        execlp("zip", "zip", "-r", "-q", zip_path, ".", (char *)NULL);
-        _exit(127);
-    }
-
-    int status = 0;
-    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
-        if (error_out && !*error_out) {
-            *error_out = strdup("Failed to create report archive");
-        }
-        free(zip_path);
-        remove_directory_recursive(package_dir);
-        free(package_dir);
-        return 0;
-    }
-
-    remove_directory_recursive(package_dir);
-    free(package_dir);
-
-    if (zip_path_out) {
-        *zip_path_out = zip_path;
-    } else {
-        free(zip_path);
-    }
-    return 1;
-}
-
-static int ensure_report_job_schema(PGconn *conn) {
-    if (!conn) {
+static int ensure_report_job_schema(PGconn *conn) {
+    if (!conn) {
         return 0;
     }
 
@@ -12984,7 +13297,57 @@ static int ensure_report_job_schema(PGconn *conn) {
         "ALTER TABLE report_jobs ADD COLUMN IF NOT EXISTS range_preset TEXT",
         "ALTER TABLE report_jobs ALTER COLUMN job_type SET DEFAULT 'audit'",
         "UPDATE report_jobs SET job_type = 'audit' WHERE job_type IS NULL",
-        "ALTER TABLE report_jobs ALTER COLUMN job_type SET NOT NULL"
+        "ALTER TABLE report_jobs ALTER COLUMN job_type SET NOT NULL",
+        "ALTER TABLE report_jobs ADD COLUMN IF NOT EXISTS lease_owner TEXT",
+        "ALTER TABLE report_jobs ADD COLUMN IF NOT EXISTS lease_expires_at TIMESTAMPTZ",
+        "ALTER TABLE report_jobs ADD COLUMN IF NOT EXISTS attempts INTEGER NOT NULL DEFAULT 0",
+        "CREATE TABLE IF NOT EXISTS narrative_cache ("
+        "prompt_hash TEXT PRIMARY KEY, "
+        "model TEXT NOT NULL, "
+        "cache_version INTEGER NOT NULL, "
+        "response TEXT NOT NULL, "
+        "created_at TIMESTAMPTZ NOT NULL DEFAULT now(), "
+        "last_used_at TIMESTAMPTZ NOT NULL DEFAULT now(), "
+        "hit_count BIGINT NOT NULL DEFAULT 0)",
+        "ALTER TABLE report_jobs ADD COLUMN IF NOT EXISTS degraded_sections TEXT[]",
+        "ALTER TABLE report_jobs "
+        "ADD COLUMN IF NOT EXISTS fragment_cache_hits INTEGER, "
+        "ADD COLUMN IF NOT EXISTS fragment_cache_lookups INTEGER",
+        "ALTER TABLE report_jobs ADD COLUMN IF NOT EXISTS artifact_sha256 TEXT",
+        "ALTER TABLE audit_photos ADD COLUMN IF NOT EXISTS photo_sha256 TEXT",
+        "CREATE TABLE IF NOT EXISTS photo_blobs ("
+        "sha256 TEXT PRIMARY KEY, "
+        "photo_bytes BYTEA NOT NULL, "
+        "thumb_bytes BYTEA, "
+        "preview_bytes BYTEA, "
+        "created_at TIMESTAMPTZ NOT NULL DEFAULT now())",
+        /* One-time move of inline photo bytes into photo_blobs; the advisory lock keeps the
+           API and worker processes from racing each other through it at startup. */
+        "DO $$ BEGIN "
+        "PERFORM pg_advisory_xact_lock(hashtext('audit_photos_photo_blobs')); "
+        "IF EXISTS (SELECT 1 FROM information_schema.columns "
+        "WHERE table_schema = current_schema() AND table_name = 'audit_photos' AND column_name = 'photo_bytes') THEN "
+        "ALTER TABLE audit_photos ADD COLUMN IF NOT EXISTS thumb_bytes BYTEA, ADD COLUMN IF NOT EXISTS preview_bytes BYTEA; "
+        "UPDATE audit_photos SET photo_sha256 = encode(sha256(photo_bytes), 'hex') WHERE photo_sha256 IS NULL; "
+        "INSERT INTO photo_blobs (sha256, photo_bytes, thumb_bytes, preview_bytes) "
+        "SELECT DISTINCT ON (photo_sha256) photo_sha256, photo_bytes, thumb_bytes, preview_bytes "
+        "FROM audit_photos ORDER BY photo_sha256, thumb_bytes IS NULL "
+        "ON CONFLICT (sha256) DO NOTHING; "
+        "ALTER TABLE audit_photos DROP COLUMN photo_bytes, DROP COLUMN thumb_bytes, DROP COLUMN preview_bytes, "
+        "ALTER COLUMN photo_sha256 SET NOT NULL, "
+        "ADD CONSTRAINT audit_photos_photo_sha256_fkey FOREIGN KEY (photo_sha256) REFERENCES photo_blobs (sha256); "
+        "END IF; "
+        "END $$",
+        "CREATE INDEX IF NOT EXISTS idx_audit_photos_photo_sha256 ON audit_photos (photo_sha256)",
+        /* Blobs with a rendition were rendered; those with none are settled by --render-photo-derivatives. */
+        "DO $$ BEGIN "
+        "IF NOT EXISTS (SELECT 1 FROM information_schema.columns "
+        "WHERE table_schema = current_schema() AND table_name = 'photo_blobs' AND column_name = 'renditions_done') THEN "
+        "ALTER TABLE photo_blobs ADD COLUMN IF NOT EXISTS renditions_done BOOLEAN NOT NULL DEFAULT FALSE; "
+        "UPDATE photo_blobs SET renditions_done = TRUE "
+        "WHERE NOT renditions_done AND (thumb_bytes IS NOT NULL OR preview_bytes IS NOT NULL); "
+        "END IF; "
+        "END $$"
     };
 
     for (size_t i = 0; i < sizeof(statements) / sizeof(statements[0]); ++i) {
@@ -13003,14 +13366,13 @@ static int ensure_report_job_schema(PGconn *conn) {
     return 1;
 }
 
-static int prepare_report_download(PGconn *conn, const char *job_id, ReportDownloadArtifact *artifact, char **error_out) {
-    if (artifact) {
-        artifact->path = NULL;
-        artifact->filename = NULL;
-        artifact->mime = NULL;
-        artifact->work_dir = NULL;
+/* PDF-only jobs are sent straight from the artifact store; full reports are packaged with
+   the building's photos as a ZIP built on the fly. */
+static int stream_report_download(int client_fd, PGconn *conn, const char *job_id, int *status_out, char **error_out) {
+    if (status_out) {
+        *status_out = 500;
     }
-    if (!conn || !job_id || !artifact) {
+    if (!conn || !job_id) {
         if (error_out && !*error_out) {
             *error_out = strdup("Invalid download parameters");
         }
@@ -13019,12 +13381,8 @@ static int prepare_report_download(PGconn *conn, const char *job_id, ReportDownl
 
     int success = 0;
     PGresult *res = NULL;
-    unsigned char *pdf_data = NULL;
-    size_t pdf_size = 0;
     char *address_copy = NULL;
-    char *pdf_temp_path = NULL;
-    char *zip_path = NULL;
-    char *job_dir = NULL;
+    char *pdf_store_path = NULL;
     ReportData report;
     report_data_init(&report);
     char *load_error = NULL;
@@ -13033,7 +13391,7 @@ static int prepare_report_download(PGconn *conn, const char *job_id, ReportDownl
 
     const char *params[1] = { job_id };
     const char *sql =
-        "SELECT address, status, artifact_filename, artifact_mime, artifact_bytes, artifact_size, artifact_version, deficiency_only, include_all, location_id, job_type "
+        "SELECT address, status, artifact_filename, artifact_mime, artifact_sha256, artifact_size, artifact_version, deficiency_only, include_all, location_id, job_type "
         "FROM report_jobs "
         "WHERE job_id = $1::uuid";
 
@@ -13046,6 +13404,9 @@ static int prepare_report_download(PGconn *conn, const char *job_id, ReportDownl
         goto cleanup;
     }
     if (PQntuples(res) == 0) {
+        if (status_out) {
+            *status_out = 404;
+        }
         if (error_out && !*error_out) {
             *error_out = strdup("Report job not found");
         }
@@ -13055,7 +13416,7 @@ static int prepare_report_download(PGconn *conn, const char *job_id, ReportDownl
     const char *address_val = PQgetisnull(res, 0, 0) ? NULL : PQgetvalue(res, 0, 0);
     const char *status_val = PQgetisnull(res, 0, 1) ? NULL : PQgetvalue(res, 0, 1);
     const char *artifact_filename_val = PQgetisnull(res, 0, 2) ? NULL : PQgetvalue(res, 0, 2);
-    const char *artifact_bytes_val = PQgetisnull(res, 0, 4) ? NULL : PQgetvalue(res, 0, 4);
+    const char *artifact_sha_val = PQgetisnull(res, 0, 4) ? NULL : PQgetvalue(res, 0, 4);
     const char *artifact_version_val = PQgetisnull(res, 0, 6) ? NULL : PQgetvalue(res, 0, 6);
     const char *deficiency_only_val = PQgetisnull(res, 0, 7) ? NULL : PQgetvalue(res, 0, 7);
     const char *include_all_val = PQgetisnull(res, 0, 8) ? NULL : PQgetvalue(res, 0, 8);
@@ -13063,6 +13424,9 @@ static int prepare_report_download(PGconn *conn, const char *job_id, ReportDownl
     const char *job_type_val = PQgetisnull(res, 0, 10) ? NULL : PQgetvalue(res, 0, 10);
 
     if (!status_val || strcmp(status_val, "completed") != 0) {
+        if (status_out) {
+            *status_out = 409;
+        }
         if (error_out && !*error_out) {
             *error_out = strdup("Report not ready");
         }
@@ -13076,7 +13440,6 @@ static int prepare_report_download(PGconn *conn, const char *job_id, ReportDownl
             overview_job = true;
         }
     }
-    const char *pdf_filename = deficiency_only ? "deficiency_list.pdf" : (overview_job ? "location_overview.pdf" : "audit_report.pdf");
     bool deliver_pdf_only = deficiency_only || overview_job;
 
     OptionalInt job_location_id;
@@ -13086,14 +13449,25 @@ static int prepare_report_download(PGconn *conn, const char *job_id, ReportDownl
         job_location_id.value = atoi(location_id_val);
     }
 
-    if (!artifact_bytes_val) {
-        if (error_out && !*error_out) {
-            *error_out = strdup("Report not ready");
+    char migrated_digest[SHA256_HEX_SIZE];
+    if (!artifact_sha_val) {
+        /* Completed before the artifact store existed: move it over on first download. */
+        char *migrate_error = NULL;
+        if (!migrate_report_artifact(conn, job_id, migrated_digest, &migrate_error)) {
+            log_error("Failed to move report job %s artifact to the store: %s", job_id, migrate_error ? migrate_error : "unknown error");
+            free(migrate_error);
+            if (error_out && !*error_out) {
+                *error_out = strdup("Report artifact missing");
+            }
+            goto cleanup;
         }
-        goto cleanup;
+        artifact_sha_val = migrated_digest;
     }
-    pdf_data = PQunescapeBytea((const unsigned char *)artifact_bytes_val, &pdf_size);
-    if (!pdf_data || pdf_size == 0) {
+    char *store_error = NULL;
+    pdf_store_path = artifact_store_local_path(&g_artifact_store, artifact_sha_val, &store_error);
+    if (!pdf_store_path) {
+        log_error("Report job %s artifact unavailable: %s", job_id, store_error ? store_error : "unknown error");
+        free(store_error);
         if (error_out && !*error_out) {
             *error_out = strdup("Report artifact missing");
         }
@@ -13108,40 +13482,6 @@ static int prepare_report_download(PGconn *conn, const char *job_id, ReportDownl
         goto cleanup;
     }
 
-    job_dir = create_temp_dir();
-    if (!job_dir) {
-        if (error_out && !*error_out) {
-            *error_out = strdup("Failed to create temporary directory");
-        }
-        goto cleanup;
-    }
-
-    pdf_temp_path = join_path(job_dir, pdf_filename);
-    if (!pdf_temp_path) {
-        if (error_out && !*error_out) {
-            *error_out = strdup("Out of memory preparing download");
-        }
-        goto cleanup;
-    }
-
-    int fd = open(pdf_temp_path, O_CREAT | O_WRONLY | O_TRUNC, 0600);
-    if (fd < 0) {
-        if (error_out && !*error_out) {
-            char msg[160];
-            snprintf(msg, sizeof(msg), "Failed to write PDF: %s", strerror(errno));
-            *error_out = strdup(msg);
-        }
-        goto cleanup;
-    }
-    if (!write_all(fd, pdf_data, pdf_size)) {
-        close(fd);
-        if (error_out && !*error_out) {
-            *error_out = strdup("Failed to persist PDF");
-        }
-        goto cleanup;
-    }
-    close(fd);
-
     if (artifact_filename_val && artifact_filename_val[0] == '\0') {
         artifact_filename_val = NULL;
     }
@@ -13160,25 +13500,8 @@ static int prepare_report_download(PGconn *conn, const char *job_id, ReportDownl
         }
         const char *chosen_name = (artifact_filename_val && artifact_filename_val[0]) ? artifact_filename_val : generated_name;
 
-        artifact->path = pdf_temp_path;
-        pdf_temp_path = NULL;
-        artifact->work_dir = job_dir;
-        job_dir = NULL;
-        artifact->mime = strdup("application/pdf");
-        if (!artifact->mime) {
-            if (error_out && !*error_out) {
-                *error_out = strdup("Out of memory allocating mime");
-            }
-            goto cleanup;
-        }
-        artifact->filename = strdup(chosen_name);
-        if (!artifact->filename) {
-            if (error_out && !*error_out) {
-                *error_out = strdup("Out of memory allocating download name");
-            }
-            goto cleanup;
-        }
-
+        /* Stored blobs never change, so the download streams straight from the store. */
+        send_file_download(client_fd, pdf_store_path, "application/pdf", chosen_name);
         success = 1;
         goto cleanup;
     }
@@ -13222,72 +13545,16 @@ static int prepare_report_download(PGconn *conn, const char *job_id, ReportDownl
     free(load_error);
     load_error = NULL;
 
-    char *archive_error = NULL;
-    ReportJob archive_job;
-    report_job_init(&archive_job);
-    archive_job.deficiency_only = false;
-    if (!create_report_archive(conn, &archive_job, &report, job_dir, pdf_temp_path, &zip_path, &archive_error)) {
-        if (error_out && !*error_out) {
-            *error_out = archive_error ? archive_error : strdup("Failed to package report");
-        } else {
-            free(archive_error);
-        }
-        goto cleanup;
-    }
-    report_job_clear(&archive_job);
-    free(archive_error);
-    archive_error = NULL;
-
-    unlink(pdf_temp_path);
-    pdf_temp_path = NULL;
-
     char download_name[160];
     if (version_number > 0) {
         snprintf(download_name, sizeof(download_name), "audit-report-%s-v%d.zip", job_id, version_number);
     } else {
         snprintf(download_name, sizeof(download_name), "audit-report-%s.zip", job_id);
     }
-
-    artifact->path = zip_path;
-    zip_path = NULL;
-    artifact->work_dir = job_dir;
-    job_dir = NULL;
-    artifact->mime = strdup("application/zip");
-    if (!artifact->mime) {
-        if (error_out && !*error_out) {
-            *error_out = strdup("Out of memory allocating mime");
-        }
-        goto cleanup;
-    }
-    artifact->filename = strdup(download_name);
-    if (!artifact->filename) {
-        if (error_out && !*error_out) {
-            *error_out = strdup("Out of memory allocating download name");
-        }
-        goto cleanup;
-    }
-
-    success = 1;
+    success = stream_report_package(client_fd, conn, &report, pdf_store_path, download_name, error_out);
 
 cleanup:
-    if (!success) {
-        cleanup_report_download(artifact);
-    }
-    if (zip_path) {
-        unlink(zip_path);
-        free(zip_path);
-    }
-    if (job_dir) {
-        remove_directory_recursive(job_dir);
-        free(job_dir);
-    }
-    if (pdf_temp_path) {
-        unlink(pdf_temp_path);
-        free(pdf_temp_path);
-    }
-    if (pdf_data) {
-        PQfreemem(pdf_data);
-    }
+    free(pdf_store_path);
     report_data_clear(&report);
     string_array_clear(&job_audits);
     free(address_copy);
@@ -13298,28 +13565,107 @@ cleanup:
     return success;
 }
 
-static void cleanup_report_download(ReportDownloadArtifact *artifact) {
-    if (!artifact) {
-        return;
+/* Copies a legacy artifact_bytes PDF into the artifact store and clears the column. */
+static int migrate_report_artifact(PGconn *conn, const char *job_id, char digest_hex[SHA256_HEX_SIZE], char **error_out) {
+    unsigned char *data = NULL;
+    size_t size = 0;
+    if (!db_fetch_legacy_report_artifact(conn, job_id, &data, &size, error_out)) {
+        return 0;
     }
-    if (artifact->path) {
-        unlink(artifact->path);
-        free(artifact->path);
-        artifact->path = NULL;
+    if (!data) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Report artifact missing");
+        }
+        return 0;
     }
-    if (artifact->work_dir) {
-        remove_directory_recursive(artifact->work_dir);
-        free(artifact->work_dir);
-        artifact->work_dir = NULL;
+    int ok = artifact_store_put(&g_artifact_store, data, size, digest_hex, error_out) &&
+             db_move_report_artifact_to_store(conn, job_id, digest_hex, error_out);
+    free(data);
+    return ok;
+}
+
+/* One-shot --migrate-artifacts pass; one row at a time so memory stays at one PDF. */
+static int migrate_report_artifacts(PGconn *conn) {
+    StringArray job_ids;
+    string_array_init(&job_ids);
+    char *error = NULL;
+    if (!db_list_legacy_report_artifacts(conn, &job_ids, &error)) {
+        log_error("Failed to list report artifacts to migrate: %s", error ? error : "unknown error");
+        free(error);
+        string_array_clear(&job_ids);
+        return 0;
     }
-    if (artifact->filename) {
-        free(artifact->filename);
-        artifact->filename = NULL;
+    size_t moved = 0;
+    for (size_t i = 0; i < job_ids.count; ++i) {
+        char digest[SHA256_HEX_SIZE];
+        error = NULL;
+        if (migrate_report_artifact(conn, job_ids.values[i], digest, &error)) {
+            moved++;
+        } else {
+            log_error("Failed to migrate artifact for report job %s: %s", job_ids.values[i], error ? error : "unknown error");
+        }
+        free(error);
     }
-    if (artifact->mime) {
-        free(artifact->mime);
-        artifact->mime = NULL;
+    log_info("Moved %zu of %zu report artifacts to the artifact store%s",
+             moved, job_ids.count, moved > 0 ? "; run VACUUM FULL report_jobs to return the space" : "");
+    int ok = moved == job_ids.count;
+    string_array_clear(&job_ids);
+    return ok;
+}
+
+/* One-shot --render-photo-derivatives pass over photo blobs stored before ingest rendered
+   them; one row at a time so memory stays at one original. Blobs that need no rendition are
+   marked done too, so later runs skip them. */
+static int backfill_photo_derivatives(PGconn *conn) {
+    const char *select_sql =
+        "SELECT sha256, photo_bytes FROM photo_blobs "
+        "WHERE sha256 > $1 AND NOT renditions_done "
+        "ORDER BY sha256 LIMIT 1";
+    const char *update_sql =
+        "UPDATE photo_blobs SET thumb_bytes = $2, preview_bytes = $3, renditions_done = TRUE WHERE sha256 = $1";
+    char last_id[SHA256_HEX_SIZE] = "";
+    size_t scanned = 0;
+    size_t rendered = 0;
+    int ok = 1;
+    for (;;) {
+        const char *select_params[1] = { last_id };
+        PGresult *res = PQexecParams(conn, select_sql, 1, NULL, select_params, NULL, NULL, 1);
+        if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+            log_error("Failed to load photo for derivatives: %s", PQresultErrorMessage(res));
+            PQclear(res);
+            ok = 0;
+            break;
+        }
+        if (PQntuples(res) == 0) {
+            PQclear(res);
+            break;
+        }
+        snprintf(last_id, sizeof(last_id), "%s", PQgetvalue(res, 0, 0));
+        scanned++;
+
+        PhotoDerivatives derived;
+        char *error = NULL;
+        if (!photo_derivatives_render((const unsigned char *)PQgetvalue(res, 0, 1), (size_t)PQgetlength(res, 0, 1), &derived, &error)) {
+            log_info("No thumbnail or preview for photo %s: %s", last_id, error ? error : "unknown error");
+        } else {
+            const char *params[3] = { last_id, (const char *)derived.thumb, (const char *)derived.preview };
+            int lengths[3] = { 0, (int)derived.thumb_size, (int)derived.preview_size };
+            int formats[3] = { 0, 1, 1 };
+            PGresult *update = PQexecParams(conn, update_sql, 3, NULL, params, lengths, formats, 0);
+            if (PQresultStatus(update) == PGRES_COMMAND_OK) {
+                rendered++;
+            } else {
+                log_error("Failed to store derivatives for photo %s: %s", last_id, PQresultErrorMessage(update));
+                ok = 0;
+            }
+            PQclear(update);
+        }
+        free(error);
+        photo_derivatives_free(&derived);
+        PQclear(res);
     }
+    log_info("Rendered thumbnails and previews for %zu of %zu photos", rendered, scanned);
+    return ok;
 }
 
 static int process_report_job(PGconn *conn,
@@ -13364,9 +13710,17 @@ static int process_report_job(PGconn *conn,
     narrative_set_init(&narratives);
 
     NarrativeTask *tasks = NULL;
-    size_t section_count = 0;
     size_t total_task_slots = 0;
     size_t tasks_created = 0;
+    NarrativeBatch *narrative_batch = NULL;
+    NarrativeDeviceGroup *narrative_groups = NULL;
+    size_t narrative_group_count = 0;
+    NarrativeBatch *late_narrative_batch = NULL;
+    StringArray degraded_sections;
+    string_array_init(&degraded_sections);
+    const int64_t narrative_deadline = g_narrative_deadline_seconds > 0
+                                           ? narrative_pool_now_ms() + (int64_t)g_narrative_deadline_seconds * 1000
+                                           : 0;
     char *narrative_build_error = NULL;
     char *generated_artifact_name = NULL;
     unsigned char *pdf_bytes = NULL;
@@ -13478,163 +13832,47 @@ static int process_report_job(PGconn *conn,
             goto cleanup;
         }
 
-        const char *system_prompt = "You are an expert vertical transportation safety consultant. Provide concise, professional narrative text suitable for a building owner. Use plain ASCII punctuation (no smart quotes or em dashes). Do not include LaTeX syntax or markdown.";
-
-        struct {
-            const char *title;
-            char **slot;
-            const char *instructions;
-            bool include_notes;
-            bool include_recommendations;
-        } sections[] = {
-            {"Executive Summary", &narratives.executive_summary,
-             "Write an executive summary highlighting equipment condition, total device count, total deficiencies, and the most critical safety issues.\nProvide actionable context appropriate for ownership decisions.", true, false},
-            {"Key Findings", &narratives.key_findings,
-             "List the top findings from the audit with concise explanations. Focus on safety, compliance, and maintenance trends across devices.", true, false},
-            {"Methodology", &narratives.methodology,
-             "Describe the inspection methodology, standards referenced, and scope of the audit. Mention any limitations or assumptions.", false, false},
-            {"Maintenance Performance", &narratives.maintenance_performance,
-             "Analyze maintenance performance and recurring issues observed in the audit. Discuss patterns tied to equipment age, usage, or contractor performance.", true, false},
-            {"Recommendations", &narratives.recommendations,
-             "Provide prioritized recommendations for remediation, including immediate safety concerns, short-term actions, and long-term planning guidance.", true, true},
-            {"Conclusion", &narratives.conclusion,
-             "Deliver a closing narrative summarizing risk outlook, benefits of addressing recommendations, and next steps for maintaining compliance.", false, false}
-        };
-
-        section_count = sizeof(sections) / sizeof(sections[0]);
-        total_task_slots = section_count + report.devices.count;
-        if (total_task_slots == 0) {
-            narrative_build_error = strdup("No narrative tasks to execute");
-            goto cleanup;
-        }
-
+        total_task_slots = REPORT_SECTION_COUNT + report.devices.count;
         tasks = calloc(total_task_slots, sizeof(NarrativeTask));
         if (!tasks) {
             narrative_build_error = strdup("Out of memory");
             goto cleanup;
         }
-
-        for (size_t i = 0; i < section_count; ++i) {
-            Buffer prompt;
-            if (!buffer_init(&prompt)) {
-                if (!narrative_build_error) {
-                    narrative_build_error = strdup("Out of memory");
-                }
-                goto narrative_join;
-            }
-
-            if (!buffer_appendf(&prompt, "%s\n\nAudit Data:\n%s", sections[i].instructions, report_json)) {
-                buffer_free(&prompt);
-                if (!narrative_build_error) {
-                    narrative_build_error = strdup("Out of memory");
-                }
-                goto narrative_join;
-            }
-
-            if (sections[i].include_notes && job->notes && job->notes[0]) {
-                if (!buffer_appendf(&prompt, "\n\nInspector Notes:\n%s", job->notes)) {
-                    buffer_free(&prompt);
-                    if (!narrative_build_error) {
-                        narrative_build_error = strdup("Out of memory");
-                    }
-                    goto narrative_join;
-                }
-            }
-            if (sections[i].include_recommendations && job->recommendations && job->recommendations[0]) {
-                if (!buffer_appendf(&prompt, "\n\nClient Guidance:\n%s", job->recommendations)) {
-                    buffer_free(&prompt);
-                    if (!narrative_build_error) {
-                        narrative_build_error = strdup("Out of memory");
-                    }
-                    goto narrative_join;
-                }
-            }
-
-            char *prompt_str = prompt.data;
-            prompt.data = NULL;
-            buffer_free(&prompt);
-            if (!prompt_str) {
-                if (!narrative_build_error) {
-                    narrative_build_error = strdup("Out of memory");
-                }
-                goto narrative_join;
-            }
-
-            NarrativeTask *task = &tasks[tasks_created];
-            task->system_prompt = system_prompt;
-            task->prompt = prompt_str;
-            task->slot = sections[i].slot;
-            task->error = NULL;
-            task->success = 0;
-            task->thread_started = false;
-            task->kind = NARRATIVE_TASK_SECTION;
-            task->device = NULL;
-            task->system_prompt_owned = NULL;
-
-            if (pthread_create(&task->thread, NULL, narrative_thread_main, task) == 0) {
-                task->thread_started = true;
-            } else {
-                narrative_task_execute(task);
-            }
-            tasks_created += 1;
+        narrative_batch = narrative_batch_create();
+        if (!narrative_batch) {
+            narrative_build_error = strdup("Out of memory");
+            goto cleanup;
         }
 
-        const char *consultant_type = determine_consultant_type(&report.summary);
-        for (size_t i = 0; i < report.devices.count; ++i) {
-            ReportDevice *device = &report.devices.items[i];
-            char *prompt_str = build_device_prompt(&report, device, job, consultant_type);
-            if (!prompt_str) {
-                if (!narrative_build_error) {
-                    narrative_build_error = strdup("Out of memory");
-                }
-                goto narrative_join;
-            }
-            char *system_prompt_device = build_device_system_prompt(consultant_type);
-            if (!system_prompt_device) {
-                free(prompt_str);
-                if (!narrative_build_error) {
-                    narrative_build_error = strdup("Out of memory");
-                }
-                goto narrative_join;
-            }
-
-            if (tasks_created >= total_task_slots) {
-                free(prompt_str);
-                free(system_prompt_device);
-                if (!narrative_build_error) {
-                    narrative_build_error = strdup("Task overflow");
-                }
-                goto narrative_join;
-            }
-
-            NarrativeTask *task = &tasks[tasks_created];
-            task->system_prompt = system_prompt_device;
-            task->system_prompt_owned = system_prompt_device;
-            task->prompt = prompt_str;
-            task->slot = &device->narrative;
-            task->error = NULL;
-            task->success = 0;
-            task->thread_started = false;
-            task->kind = NARRATIVE_TASK_DEVICE;
-            task->device = device;
-
-            if (pthread_create(&task->thread, NULL, narrative_thread_main, task) == 0) {
-                task->thread_started = true;
-            } else {
-                narrative_task_execute(task);
-            }
-            tasks_created += 1;
+        if (!narrative_tasks_add_sections(tasks, total_task_slots, &tasks_created, &narratives, report_json, job, &narrative_build_error)) {
+            goto narrative_join;
         }
+        if (!narrative_tasks_add_devices(tasks, total_task_slots, &tasks_created, &report, job, &narrative_build_error)) {
+            goto narrative_join;
+        }
+
+        narrative_tasks_dispatch(conn, narrative_batch, tasks, tasks_created, &narrative_groups, &narrative_group_count);
     }
 
 narrative_join:
-    if (tasks) {
-        for (size_t i = 0; i < tasks_created; ++i) {
-            if (tasks[i].thread_started) {
-                pthread_join(tasks[i].thread, NULL);
-                tasks[i].thread_started = false;
+    if (narrative_batch) {
+        if (narrative_wait(narrative_batch, narrative_deadline)) {
+            NarrativeBatch *retry_batch = narrative_groups_resolve(narrative_groups, narrative_group_count, true, false);
+            if (retry_batch && !narrative_wait(retry_batch, narrative_deadline)) {
+                late_narrative_batch = retry_batch;
             }
+        } else {
+            /* Past the deadline: take what finished and leave the rest to run into the cache. */
+            narrative_groups_resolve(narrative_groups, narrative_group_count, false, false);
+            late_narrative_batch = narrative_batch;
         }
+        narrative_batch = NULL;
+    }
+    for (size_t i = 0; i < tasks_created; ++i) {
+        narrative_task_collect(&tasks[i]);
+    }
+    if (!narrative_build_error) {
+        narrative_tasks_store(conn, tasks, tasks_created);
     }
 
     if (narrative_build_error) {
@@ -13652,6 +13890,21 @@ narrative_join:
         if (task->success) {
             continue;
         }
+        if (task->kind == NARRATIVE_TASK_SECTION && task->late && task->slot && !*(task->slot)) {
+            char *fallback = build_section_narrative_fallback(task->label, &report.summary);
+            if (!fallback || !string_array_append_copy(&degraded_sections, task->label ? task->label : "Narrative")) {
+                free(fallback);
+                if (error_out && !*error_out) {
+                    *error_out = strdup("Section narrative fallback failed");
+                }
+                goto cleanup;
+            }
+            *(task->slot) = fallback;
+            log_info("Section %s missed the narrative deadline; using fallback text", task->label ? task->label : "(unnamed)");
+            free(task->error);
+            task->error = NULL;
+            continue;
+        }
         if (task->kind == NARRATIVE_TASK_DEVICE && task->device) {
             if (task->slot && !*(task->slot)) {
                 char *fallback = build_device_narrative_fallback(task->device);
@@ -13671,8 +13924,16 @@ narrative_join:
                 }
                 *(task->slot) = fallback;
             }
+            const char *device_id = task->device->device_id ? task->device->device_id : "unknown";
+            char degraded_label[160];
+            snprintf(degraded_label, sizeof(degraded_label), "Device %s", device_id);
+            if (!string_array_append_copy(&degraded_sections, degraded_label)) {
+                if (error_out && !*error_out) {
+                    *error_out = strdup("Out of memory");
+                }
+                goto cleanup;
+            }
             if (task->error) {
-                const char *device_id = task->device->device_id ? task->device->device_id : "unknown";
                 log_info("Falling back to deterministic narrative for device %s: %s", device_id, task->error);
                 free(task->error);
                 task->error = NULL;
@@ -13693,8 +13954,26 @@ narrative_join:
         goto cleanup;
     }
 
+    if (!is_deficiency && !is_overview) {
+        char *degraded_error = NULL;
+        if (!db_set_report_job_degraded_sections(conn, job->job_id, &degraded_sections, &degraded_error)) {
+            log_error("Failed to record degraded sections for report job %s: %s",
+                      job->job_id,
+                      degraded_error ? degraded_error : "unknown error");
+        }
+        free(degraded_error);
+        if (degraded_sections.count > 0) {
+            log_info("Report job %s degraded %zu narrative section%s",
+                     job->job_id,
+                     degraded_sections.count,
+                     degraded_sections.count == 1 ? "" : "s");
+        }
+    }
+
     char *latex_error = NULL;
     const LocationProfile *profile_ptr = profile_available ? &profile : NULL;
+    /* Deficiency lists are plain tables; they skip LaTeX unless the native writer is turned off. */
+    const bool native_pdf = is_deficiency && g_native_deficiency_pdf;
 
     if (is_overview) {
         OverviewWindowSpec specs[OVERVIEW_WINDOW_MAX];
@@ -13767,17 +14046,7 @@ narrative_join:
         int audited_devices = report.summary.total_devices;
         int device_count = installed_devices > 0 ? installed_devices : audited_devices;
         int total_deficiencies = report.summary.total_deficiencies;
-        int open_deficiencies = 0;
-        for (size_t i = 0; i < report.devices.count; ++i) {
-            const ReportDevice *device = &report.devices.items[i];
-            for (size_t j = 0; j < device->deficiencies.count; ++j) {
-                const ReportDeficiency *def = &device->deficiencies.items[j];
-                bool resolved = def->resolved.has_value && def->resolved.value;
-                if (!resolved) {
-                    open_deficiencies += 1;
-                }
-            }
-        }
+        int open_deficiencies = report_open_deficiency_count(&report);
         double closure_rate = (total_deficiencies > 0)
                                   ? safe_divide((double)(total_deficiencies - open_deficiencies), (double)total_deficiencies)
                                   : NAN;
@@ -13836,8 +14105,20 @@ narrative_join:
         for (size_t label_idx = OVERVIEW_WINDOW_COUNT; label_idx < spec_count; ++label_idx) {
             free(dynamic_labels[label_idx]);
         }
+    } else if (native_pdf) {
+        if (!build_deficiency_list_pdf(&report, job, job_dir, pdf_path, &latex_error)) {
+            if (error_out && !*error_out) {
+                *error_out = latex_error ? latex_error : strdup("Failed to build deficiency list PDF");
+            } else {
+                free(latex_error);
+            }
+            goto cleanup;
+        }
+        free(latex_error);
+        latex_error = NULL;
     } else {
-        if (!build_report_latex(conn, &report, &narratives, job, profile_ptr, tex_path, &latex_error)) {
+        LatexFragmentStats fragment_stats = {0, 0};
+        if (!build_report_latex(conn, &report, &narratives, job, profile_ptr, &fragment_stats, tex_path, &latex_error)) {
             if (error_out && !*error_out) {
                 *error_out = latex_error ? latex_error : strdup("Failed to build LaTeX");
             } else {
@@ -13847,10 +14128,21 @@ narrative_join:
         }
         free(latex_error);
         latex_error = NULL;
+        if (fragment_stats.lookups > 0) {
+            log_info("Report job %s reused %zu of %zu cached LaTeX fragments",
+                     job->job_id, fragment_stats.hits, fragment_stats.lookups);
+            char *fragment_error = NULL;
+            if (!db_set_report_job_fragment_stats(conn, job->job_id, fragment_stats.hits, fragment_stats.lookups, &fragment_error)) {
+                log_error("Failed to record fragment cache stats for report job %s: %s",
+                          job->job_id,
+                          fragment_error ? fragment_error : "unknown error");
+            }
+            free(fragment_error);
+        }
     }
 
     char *compile_error = NULL;
-    if (!run_pdflatex(job_dir, tex_filename, &compile_error)) {
+    if (!native_pdf && !run_pdflatex(job_dir, tex_filename, is_overview ? &g_overview_latex_format : &g_report_latex_format, &compile_error)) {
         if (error_out && !*error_out) {
             *error_out = compile_error ? compile_error : strdup("Failed compiling PDF");
         } else {
@@ -13879,6 +14171,16 @@ narrative_join:
     success = 1;
 
 cleanup:
+    if (late_narrative_batch) {
+        narrative_tasks_hand_off(late_narrative_batch, tasks, total_task_slots, narrative_groups, narrative_group_count);
+        late_narrative_batch = NULL;
+        tasks = NULL;
+        narrative_groups = NULL;
+        narrative_group_count = 0;
+    }
+    narrative_groups_free(narrative_groups, narrative_group_count);
+    narrative_groups = NULL;
+    string_array_clear(&degraded_sections);
     if (tasks) {
         for (size_t i = 0; i < total_task_slots; ++i) {
             free(tasks[i].prompt);
@@ -13920,83 +14222,160 @@ cleanup:
     return success;
 }
 
-static void signal_report_worker(void) {
+static void report_worker_set_state(ReportWorker *worker, ReportWorkerState state, const char *job_id) {
+    pthread_mutex_lock(&g_report_mutex);
+    worker->state = state;
+    worker->state_since = time(NULL);
+    if (job_id) {
+        snprintf(worker->job_id, sizeof(worker->job_id), "%s", job_id);
+    } else {
+        worker->job_id[0] = '\0';
+    }
+    pthread_mutex_unlock(&g_report_mutex);
+}
+
+static bool report_workers_stopping(void) {
+    pthread_mutex_lock(&g_report_mutex);
+    bool stop_requested = g_report_stop;
+    pthread_mutex_unlock(&g_report_mutex);
+    return stop_requested;
+}
+
+/* Sleeps for `seconds` unless shutdown begins first. Returns true when the pool is stopping. */
+static bool report_worker_sleep(int seconds) {
+    struct pollfd wake = { .fd = g_report_wake_pipe[0], .events = POLLIN, .revents = 0 };
+    poll(&wake, 1, seconds * 1000);
+    return report_workers_stopping();
+}
+
+static const char *report_worker_state_name(ReportWorkerState state) {
+    switch (state) {
+        case REPORT_WORKER_STARTING:
+            return "starting";
+        case REPORT_WORKER_CONNECTING:
+            return "connecting";
+        case REPORT_WORKER_IDLE:
+            return "idle";
+        case REPORT_WORKER_BUSY:
+            return "busy";
+        case REPORT_WORKER_STOPPED:
+            return "stopped";
+    }
+    return "unknown";
+}
+
+static char *build_report_worker_status_json(void) {
+    Buffer buf;
+    if (!buffer_init(&buf)) {
+        return NULL;
+    }
+    bool ok = buffer_append_char(&buf, '[');
+    time_t now = time(NULL);
     pthread_mutex_lock(&g_report_mutex);
-    g_report_signal = true;
-    pthread_cond_signal(&g_report_cond);
+    for (int i = 0; ok && i < g_report_worker_count; ++i) {
+        const ReportWorker *worker = &g_report_workers[i];
+        ok = (i == 0 || buffer_append_char(&buf, ',')) &&
+             buffer_append_cstr(&buf, "{\"worker\":") &&
+             buffer_append_int64(&buf, worker->index) &&
+             buffer_append_cstr(&buf, ",\"state\":") &&
+             buffer_append_json_string(&buf, report_worker_state_name(worker->state)) &&
+             buffer_append_cstr(&buf, ",\"job_id\":");
+        if (ok) {
+            ok = worker->job_id[0] ? buffer_append_json_string(&buf, worker->job_id)
+                                   : buffer_append_cstr(&buf, "null");
+        }
+        ok = ok &&
+             buffer_append_cstr(&buf, ",\"state_seconds\":") &&
+             buffer_append_int64(&buf, (int64_t)(now - worker->state_since)) &&
+             buffer_append_cstr(&buf, ",\"jobs_completed\":") &&
+             buffer_append_int64(&buf, (int64_t)worker->jobs_completed) &&
+             buffer_append_cstr(&buf, ",\"jobs_failed\":") &&
+             buffer_append_int64(&buf, (int64_t)worker->jobs_failed) &&
+             buffer_append_char(&buf, '}');
+    }
     pthread_mutex_unlock(&g_report_mutex);
+    if (!ok || !buffer_append_char(&buf, ']')) {
+        buffer_free(&buf);
+        return NULL;
+    }
+    return buf.data;
 }
 
 static void *report_worker_main(void *arg) {
-    (void)arg;
+    ReportWorker *worker = (ReportWorker *)arg;
     PGconn *conn = NULL;
 
-    for (;;) {
-        pthread_mutex_lock(&g_report_mutex);
-        bool stop_requested = g_report_stop;
-        pthread_mutex_unlock(&g_report_mutex);
-        if (stop_requested) {
-            break;
-        }
-
+    while (!report_workers_stopping()) {
         if (!g_database_dsn) {
-            struct timespec ts;
-            clock_gettime(CLOCK_REALTIME, &ts);
-            ts.tv_sec += 5;
-            pthread_mutex_lock(&g_report_mutex);
-            if (!g_report_stop) {
-                pthread_cond_timedwait(&g_report_cond, &g_report_mutex, &ts);
-            }
-            g_report_signal = false;
-            pthread_mutex_unlock(&g_report_mutex);
+            report_worker_sleep(5);
             continue;
         }
 
         if (!conn) {
+            report_worker_set_state(worker, REPORT_WORKER_CONNECTING, NULL);
             conn = PQconnectdb(g_database_dsn);
+            char *listen_error = NULL;
             if (PQstatus(conn) != CONNECTION_OK) {
-                log_error("Report worker failed to connect to database: %s", PQerrorMessage(conn));
+                log_error("Report worker %d failed to connect to database: %s", worker->index, PQerrorMessage(conn));
+                PQfinish(conn);
+                conn = NULL;
+                report_worker_sleep(5);
+                continue;
+            }
+            if (!db_listen_report_jobs(conn, &listen_error)) {
+                log_error("Report worker %d failed to listen for jobs: %s", worker->index, listen_error ? listen_error : "unknown error");
+                free(listen_error);
                 PQfinish(conn);
                 conn = NULL;
-                sleep(5);
+                report_worker_sleep(5);
                 continue;
             }
+            report_worker_set_state(worker, REPORT_WORKER_IDLE, NULL);
         }
 
+        late_narratives_flush(conn);
+
+        char lease_owner[sizeof(worker->lease_owner)];
+        pthread_mutex_lock(&g_report_mutex);
+        worker->claims++;
+        snprintf(worker->lease_owner, sizeof(worker->lease_owner), "%s:%d:%lu", g_report_worker_id, worker->index, worker->claims);
+        memcpy(lease_owner, worker->lease_owner, sizeof(lease_owner));
+        pthread_mutex_unlock(&g_report_mutex);
+
         ReportJob job;
         report_job_init(&job);
         char *claim_error = NULL;
-        int claimed = db_claim_next_report_job(conn, &job, &claim_error);
+        int claimed = db_claim_next_report_job(conn, lease_owner, g_report_lease_seconds, &job, &claim_error);
         if (claimed < 0) {
-            log_error("Failed to claim report job: %s", claim_error ? claim_error : "unknown error");
+            log_error("Report worker %d failed to claim report job: %s", worker->index, claim_error ? claim_error : "unknown error");
             free(claim_error);
             report_job_clear(&job);
             PQfinish(conn);
             conn = NULL;
-            sleep(2);
+            report_worker_sleep(2);
             continue;
         }
         free(claim_error);
 
         if (claimed == 0) {
             report_job_clear(&job);
-            pthread_mutex_lock(&g_report_mutex);
-            if (!g_report_stop) {
-                struct timespec ts;
-                clock_gettime(CLOCK_REALTIME, &ts);
-                ts.tv_sec += 5;
-                pthread_cond_timedwait(&g_report_cond, &g_report_mutex, &ts);
-            }
-            g_report_signal = false;
-            stop_requested = g_report_stop;
-            pthread_mutex_unlock(&g_report_mutex);
-            if (stop_requested) {
-                break;
+            /* Idle until a NOTIFY from any node; the sweep timeout only covers notifications
+               dropped while the connection was being re-established. */
+            char *wait_error = NULL;
+            if (db_wait_report_job_notification(conn, g_report_wake_pipe[0], REPORT_WORKER_SWEEP_SECONDS * 1000, &wait_error) < 0) {
+                log_error("Report worker %d lost its job listener: %s", worker->index, wait_error ? wait_error : "unknown error");
+                PQfinish(conn);
+                conn = NULL;
             }
+            free(wait_error);
             continue;
         }
 
-        log_info("Processing report job %s for %s", job.job_id, job.address ? job.address : "(unknown address)");
+        report_worker_set_state(worker, REPORT_WORKER_BUSY, job.job_id);
+        log_info("Report worker %d processing report job %s for %s",
+                 worker->index,
+                 job.job_id,
+                 job.address ? job.address : "(unknown address)");
 
         unsigned char *pdf_data = NULL;
         size_t pdf_size = 0;
@@ -14004,6 +14383,11 @@ static void *report_worker_main(void *arg) {
         char *process_error = NULL;
         int success = process_report_job(conn, &job, &pdf_data, &pdf_size, &artifact_name, &process_error);
         char *update_error = NULL;
+        int recorded = 0;
+        char artifact_digest[SHA256_HEX_SIZE];
+        if (success && !artifact_store_put(&g_artifact_store, pdf_data, pdf_size, artifact_digest, &process_error)) {
+            success = 0;
+        }
         if (success) {
             if (!artifact_name) {
                 artifact_name = build_report_artifact_name(&job, NULL);
@@ -14012,38 +14396,55 @@ static void *report_worker_main(void *arg) {
                                                           : (job.deficiency_only ? "deficiency-list.pdf"
                                                                                  : (job.type == REPORT_JOB_TYPE_LOCATION_OVERVIEW ? "location_overview.pdf"
                                                                                                                                 : "audit_report.pdf"));
-            if (!db_complete_report_job(conn,
-                                        job.job_id,
-                                        "completed",
-                                        NULL,
-                                        artifact_filename,
-                                        "application/pdf",
-                                        pdf_data,
-                                        pdf_size,
-                                        &update_error)) {
+            recorded = db_complete_report_job(conn,
+                                              job.job_id,
+                                              lease_owner,
+                                              "completed",
+                                              NULL,
+                                              artifact_filename,
+                                              "application/pdf",
+                                              artifact_digest,
+                                              pdf_size,
+                                              &update_error);
+            if (recorded < 0) {
                 log_error("Failed to mark report job %s completed: %s", job.job_id, update_error ? update_error : "unknown error");
-            } else {
+            } else if (recorded > 0) {
                 log_info("Report job %s completed", job.job_id);
             }
         } else {
             const char *message = process_error ? process_error : "Report generation failed";
-            if (!db_complete_report_job(conn,
-                                        job.job_id,
-                                        "failed",
-                                        message,
-                                        NULL,
-                                        NULL,
-                                        NULL,
-                                        0,
-                                        &update_error)) {
+            recorded = db_complete_report_job(conn,
+                                              job.job_id,
+                                              lease_owner,
+                                              "failed",
+                                              message,
+                                              NULL,
+                                              NULL,
+                                              NULL,
+                                              0,
+                                              &update_error);
+            if (recorded < 0) {
                 log_error("Failed to mark report job %s failed: %s", job.job_id, update_error ? update_error : "unknown error");
-            } else {
+            } else if (recorded > 0) {
                 log_error("Report job %s failed: %s", job.job_id, message);
             }
         }
-        free(update_error);
-        free(process_error);
-        free(pdf_data);
+        if (recorded == 0) {
+            /* Another worker reclaimed the job after our lease lapsed; its result stands. */
+            log_error("Report worker %d lost the lease on report job %s; dropping its result", worker->index, job.job_id);
+        } else {
+            pthread_mutex_lock(&g_report_mutex);
+            if (success) {
+                worker->jobs_completed++;
+            } else {
+                worker->jobs_failed++;
+            }
+            pthread_mutex_unlock(&g_report_mutex);
+        }
+        report_worker_set_state(worker, REPORT_WORKER_IDLE, NULL);
+        free(update_error);
+        free(process_error);
+        free(pdf_data);
         free(artifact_name);
         report_job_clear(&job);
     }
@@ -14051,39 +14452,744 @@ static void *report_worker_main(void *arg) {
     if (conn) {
         PQfinish(conn);
     }
+    report_worker_set_state(worker, REPORT_WORKER_STOPPED, NULL);
     return NULL;
 }
 
-static int run_pdflatex(const char *working_dir, const char *tex_filename, char **error_out) {
-    if (!working_dir || !tex_filename) {
-        if (error_out && !*error_out) {
-            *error_out = strdup("Invalid LaTeX arguments");
+/* Like report_worker_sleep, but wakes only for g_report_heartbeat_stop. */
+static bool report_heartbeat_sleep(int seconds) {
+    int64_t due = narrative_pool_now_ms() + (int64_t)seconds * 1000;
+    struct timespec deadline = { (time_t)(due / 1000), (long)(due % 1000) * 1000000L };
+    pthread_mutex_lock(&g_report_mutex);
+    while (!g_report_heartbeat_stop && narrative_pool_now_ms() < due) {
+        pthread_cond_timedwait(&g_report_heartbeat_cond, &g_report_mutex, &deadline);
+    }
+    bool stop_requested = g_report_heartbeat_stop;
+    pthread_mutex_unlock(&g_report_mutex);
+    return stop_requested;
+}
+
+/* Extends the leases of every job this process is running, on a connection of its own
+   because each worker's connection is busy for the whole job. Runs until the workers have
+   joined, so jobs finishing during shutdown keep their leases. */
+static void *report_heartbeat_main(void *arg) {
+    (void)arg;
+    PGconn *conn = NULL;
+    int interval = g_report_lease_seconds / 3;
+
+    while (!report_heartbeat_sleep(interval)) {
+        StringArray busy;
+        string_array_init(&busy);
+        bool ok = true;
+        pthread_mutex_lock(&g_report_mutex);
+        for (int i = 0; ok && i < g_report_worker_count; ++i) {
+            if (g_report_workers[i].state == REPORT_WORKER_BUSY && g_report_workers[i].job_id[0]) {
+                ok = string_array_append_copy(&busy, g_report_workers[i].lease_owner);
+            }
         }
+        pthread_mutex_unlock(&g_report_mutex);
+        if (!ok || busy.count == 0) {
+            string_array_clear(&busy);
+            continue;
+        }
+
+        if (!conn) {
+            conn = PQconnectdb(g_database_dsn);
+            if (PQstatus(conn) != CONNECTION_OK) {
+                log_error("Report heartbeat failed to connect to database: %s", PQerrorMessage(conn));
+                PQfinish(conn);
+                conn = NULL;
+                string_array_clear(&busy);
+                continue;
+            }
+        }
+        char *renew_error = NULL;
+        if (!db_renew_report_job_leases(conn, &busy, g_report_lease_seconds, &renew_error)) {
+            log_error("Failed to renew report job leases: %s", renew_error ? renew_error : "unknown error");
+            PQfinish(conn);
+            conn = NULL;
+        }
+        free(renew_error);
+        string_array_clear(&busy);
+    }
+
+    if (conn) {
+        PQfinish(conn);
+    }
+    return NULL;
+}
+
+static void resolve_report_lease_settings(void) {
+    char host[64];
+    if (gethostname(host, sizeof(host)) != 0) {
+        snprintf(host, sizeof(host), "unknown");
+    }
+    host[sizeof(host) - 1] = '\0';
+    snprintf(g_report_worker_id, sizeof(g_report_worker_id), "%s:%ld", host, (long)getpid());
+
+    const char *lease_env = getenv("REPORT_JOB_LEASE_SECONDS");
+    if (lease_env && lease_env[0] != '\0') {
+        int seconds = atoi(lease_env);
+        if (seconds >= REPORT_JOB_LEASE_MIN_SECONDS) {
+            g_report_lease_seconds = seconds;
+        } else {
+            log_info("Ignoring invalid REPORT_JOB_LEASE_SECONDS value: %s", lease_env);
+        }
+    }
+}
+
+static int resolve_report_worker_count(void) {
+    int count = REPORT_WORKER_DEFAULT_COUNT;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus / 2 > count) {
+        /* pdflatex saturates a core while narrative calls mostly wait on the network,
+           so half the cores keeps both kinds of work overlapping without oversubscribing. */
+        count = (int)(cpus / 2);
+    }
+    if (count > REPORT_WORKER_MAX_COUNT) {
+        count = REPORT_WORKER_MAX_COUNT;
+    }
+    char *count_env = trim_copy(getenv("REPORT_WORKER_COUNT"));
+    if (count_env && count_env[0] != '\0') {
+        char *end = NULL;
+        long parsed = strtol(count_env, &end, 10);
+        /* Zero leaves rendering entirely to standalone audit_report_worker processes. */
+        if (end && *end == '\0' && (parsed > 0 || (parsed == 0 && !AUDIT_REPORT_WORKER_ONLY))) {
+            count = (int)(parsed < REPORT_WORKER_MAX_COUNT ? parsed : REPORT_WORKER_MAX_COUNT);
+        } else {
+            log_info("Invalid REPORT_WORKER_COUNT '%s'; using %d", count_env, count);
+        }
+    }
+    free(count_env);
+    return count;
+}
+
+static int start_report_workers(int count) {
+    if (pipe(g_report_wake_pipe) != 0) {
+        log_error("Failed to create report worker wake pipe: %s", strerror(errno));
         return 0;
     }
-    for (int pass = 0; pass < 3; ++pass) {
-        pid_t pid = fork();
-        if (pid == 0) {
-            if (chdir(working_dir) != 0) {
-                _exit(1);
+    fcntl(g_report_wake_pipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(g_report_wake_pipe[1], F_SETFD, FD_CLOEXEC);
+    for (int i = 0; i < count; ++i) {
+        ReportWorker *worker = &g_report_workers[i];
+        pthread_mutex_lock(&g_report_mutex);
+        memset(worker, 0, sizeof(*worker));
+        worker->index = i;
+        worker->state = REPORT_WORKER_STARTING;
+        worker->state_since = time(NULL);
+        g_report_worker_count = i + 1;
+        pthread_mutex_unlock(&g_report_mutex);
+        if (pthread_create(&worker->thread, NULL, report_worker_main, worker) != 0) {
+            log_error("Failed to start report worker thread %d", i);
+            report_worker_set_state(worker, REPORT_WORKER_STOPPED, NULL);
+            return 0;
+        }
+        worker->started = true;
+    }
+    if (count > 0) {
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&g_report_heartbeat_cond, &attr);
+        pthread_condattr_destroy(&attr);
+        g_report_heartbeat_stop = false;
+        if (pthread_create(&g_report_heartbeat_thread, NULL, report_heartbeat_main, NULL) != 0) {
+            log_error("Failed to start report lease heartbeat thread");
+            return 0;
+        }
+        g_report_heartbeat_started = true;
+    }
+    log_info("Started %d report worker%s as %s", count, count == 1 ? "" : "s", g_report_worker_id);
+    return 1;
+}
+
+static void stop_report_workers(void) {
+    pthread_mutex_lock(&g_report_mutex);
+    g_report_stop = true;
+    int count = g_report_worker_count;
+    pthread_mutex_unlock(&g_report_mutex);
+    if (g_report_wake_pipe[1] >= 0) {
+        ssize_t written;
+        do {
+            written = write(g_report_wake_pipe[1], "x", 1);
+        } while (written < 0 && errno == EINTR);
+    }
+    for (int i = 0; i < count; ++i) {
+        ReportWorker *worker = &g_report_workers[i];
+        if (worker->started) {
+            pthread_join(worker->thread, NULL);
+            worker->started = false;
+        }
+    }
+    if (g_report_heartbeat_started) {
+        pthread_mutex_lock(&g_report_mutex);
+        g_report_heartbeat_stop = true;
+        pthread_cond_signal(&g_report_heartbeat_cond);
+        pthread_mutex_unlock(&g_report_mutex);
+        pthread_join(g_report_heartbeat_thread, NULL);
+        g_report_heartbeat_started = false;
+    }
+    for (int i = 0; i < 2; ++i) {
+        if (g_report_wake_pipe[i] >= 0) {
+            close(g_report_wake_pipe[i]);
+            g_report_wake_pipe[i] = -1;
+        }
+    }
+}
+
+/* Buildings whose device narratives should be generated ahead of a report request. An
+   entry waits NARRATIVE_PREFETCH_SETTLE_SECONDS after the building's latest upload so a
+   batch of audits for one building is prefetched once. */
+typedef struct NarrativePrefetch {
+    char *address;
+    OptionalInt location;
+    int64_t due_ms;
+    struct NarrativePrefetch *next;
+} NarrativePrefetch;
+
+static pthread_mutex_t g_prefetch_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_prefetch_cond;
+static pthread_t g_prefetch_thread;
+static bool g_prefetch_started = false;
+static bool g_prefetch_stop = false;
+static NarrativePrefetch *g_prefetch_queue = NULL;
+static size_t g_prefetch_pending = 0;
+
+static void narrative_prefetch_enqueue(const char *address, const OptionalInt *location) {
+    bool has_location = location && location->has_value && location->value > 0;
+    if (!has_location && (!address || !address[0])) {
+        return;
+    }
+    pthread_mutex_lock(&g_prefetch_mutex);
+    if (!g_prefetch_started || g_prefetch_stop) {
+        pthread_mutex_unlock(&g_prefetch_mutex);
+        return;
+    }
+    int64_t due = narrative_pool_now_ms() + (int64_t)NARRATIVE_PREFETCH_SETTLE_SECONDS * 1000;
+    for (NarrativePrefetch *entry = g_prefetch_queue; entry; entry = entry->next) {
+        bool same_location = has_location ? (entry->location.has_value && entry->location.value == location->value)
+                                          : !entry->location.has_value;
+        if (same_location && entry->address && address && strcasecmp(entry->address, address) == 0) {
+            entry->due_ms = due;
+            pthread_mutex_unlock(&g_prefetch_mutex);
+            return;
+        }
+    }
+    if (g_prefetch_pending >= NARRATIVE_PREFETCH_MAX_PENDING) {
+        pthread_mutex_unlock(&g_prefetch_mutex);
+        log_info("Narrative prefetch queue full; skipping %s", address ? address : "(location only)");
+        return;
+    }
+    NarrativePrefetch *entry = calloc(1, sizeof(*entry));
+    if (!entry || (address && !(entry->address = strdup(address)))) {
+        pthread_mutex_unlock(&g_prefetch_mutex);
+        free(entry);
+        return;
+    }
+    optional_int_clear(&entry->location);
+    if (has_location) {
+        entry->location = *location;
+    }
+    entry->due_ms = due;
+    NarrativePrefetch **tail = &g_prefetch_queue;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = entry;
+    g_prefetch_pending++;
+    pthread_cond_signal(&g_prefetch_cond);
+    pthread_mutex_unlock(&g_prefetch_mutex);
+}
+
+/* Generates and caches every uncached device narrative for one building, as a report job
+   without notes would request them. Runs on a background batch, so report jobs always
+   get the narrative pool first. */
+static void prefetch_building_narratives(PGconn *conn, const NarrativePrefetch *entry) {
+    ReportData report;
+    report_data_init(&report);
+    ReportJob job;
+    report_job_init(&job);
+    NarrativeTask *tasks = NULL;
+    size_t task_count = 0;
+    NarrativeDeviceGroup *groups = NULL;
+    size_t group_count = 0;
+    const char *label = entry->address ? entry->address : "(location only)";
+
+    char *error = NULL;
+    if (!load_report_for_building(conn, entry->address, &entry->location, NULL, &report, &error)) {
+        log_error("Narrative prefetch for %s could not load audits: %s", label, error ? error : "unknown error");
+        goto cleanup;
+    }
+    if (report.devices.count == 0) {
+        goto cleanup;
+    }
+    tasks = calloc(report.devices.count, sizeof(*tasks));
+    if (!tasks || !narrative_tasks_add_devices(tasks, report.devices.count, &task_count, &report, &job, &error)) {
+        log_error("Narrative prefetch for %s failed: %s", label, error ? error : "Out of memory");
+        goto cleanup;
+    }
+
+    NarrativeBatch *batch = narrative_batch_create_background();
+    if (!batch) {
+        goto cleanup;
+    }
+    narrative_tasks_dispatch(conn, batch, tasks, task_count, &groups, &group_count);
+    narrative_batch_wait(batch);
+    NarrativeBatch *retry_batch = narrative_groups_resolve(groups, group_count, true, true);
+    if (retry_batch) {
+        narrative_batch_wait(retry_batch);
+    }
+    size_t generated = 0;
+    for (size_t i = 0; i < task_count; ++i) {
+        narrative_task_collect(&tasks[i]);
+        if (tasks[i].success && !tasks[i].cached) {
+            generated++;
+        }
+    }
+    narrative_tasks_store(conn, tasks, task_count);
+    if (generated > 0) {
+        log_info("Prefetched %zu of %zu device narratives for %s", generated, task_count, label);
+    }
+
+cleanup:
+    free(error);
+    narrative_groups_free(groups, group_count);
+    for (size_t i = 0; tasks && i < task_count; ++i) {
+        free(tasks[i].prompt);
+        free(tasks[i].error);
+        free(tasks[i].system_prompt_owned);
+    }
+    free(tasks);
+    report_job_clear(&job);
+    report_data_clear(&report);
+}
+
+static void *narrative_prefetch_main(void *arg) {
+    (void)arg;
+    PGconn *conn = NULL;
+    pthread_mutex_lock(&g_prefetch_mutex);
+    while (!g_prefetch_stop) {
+        NarrativePrefetch **next = NULL;
+        for (NarrativePrefetch **link = &g_prefetch_queue; *link; link = &(*link)->next) {
+            if (!next || (*link)->due_ms < (*next)->due_ms) {
+                next = link;
             }
-            execlp("pdflatex", "pdflatex", "-interaction=nonstopmode", tex_filename, (char *)NULL);
-            _exit(1);
-        } else if (pid < 0) {
-            if (error_out && !*error_out) {
-                *error_out = strdup("Failed to spawn pdflatex");
+        }
+        if (!next) {
+            pthread_cond_wait(&g_prefetch_cond, &g_prefetch_mutex);
+            continue;
+        }
+        int64_t due = (*next)->due_ms;
+        if (due > narrative_pool_now_ms()) {
+            struct timespec deadline = { (time_t)(due / 1000), (long)(due % 1000) * 1000000L };
+            pthread_cond_timedwait(&g_prefetch_cond, &g_prefetch_mutex, &deadline);
+            continue;
+        }
+        NarrativePrefetch *entry = *next;
+        *next = entry->next;
+        g_prefetch_pending--;
+        pthread_mutex_unlock(&g_prefetch_mutex);
+
+        if (conn && PQstatus(conn) != CONNECTION_OK) {
+            PQfinish(conn);
+            conn = NULL;
+        }
+        if (!conn) {
+            conn = PQconnectdb(g_database_dsn);
+            if (PQstatus(conn) != CONNECTION_OK) {
+                log_error("Narrative prefetch failed to connect to database: %s", PQerrorMessage(conn));
+                PQfinish(conn);
+                conn = NULL;
             }
-            return 0;
         }
+        if (conn) {
+            prefetch_building_narratives(conn, entry);
+        }
+        free(entry->address);
+        free(entry);
+        pthread_mutex_lock(&g_prefetch_mutex);
+    }
+    while (g_prefetch_queue) {
+        NarrativePrefetch *entry = g_prefetch_queue;
+        g_prefetch_queue = entry->next;
+        free(entry->address);
+        free(entry);
+    }
+    g_prefetch_pending = 0;
+    pthread_mutex_unlock(&g_prefetch_mutex);
+    if (conn) {
+        PQfinish(conn);
+    }
+    return NULL;
+}
 
-        int status = 0;
-        if (waitpid(pid, &status, 0) < 0) {
-            if (error_out && !*error_out) {
-                *error_out = strdup("pdflatex wait failed");
+static int start_narrative_prefetch(void) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_prefetch_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_lock(&g_prefetch_mutex);
+    g_prefetch_stop = false;
+    if (pthread_create(&g_prefetch_thread, NULL, narrative_prefetch_main, NULL) != 0) {
+        pthread_mutex_unlock(&g_prefetch_mutex);
+        log_error("Failed to start narrative prefetch thread");
+        return 0;
+    }
+    g_prefetch_started = true;
+    pthread_mutex_unlock(&g_prefetch_mutex);
+    return 1;
+}
+
+/* Call after narrative_pool_stop so an in-flight prefetch sees its batch fail fast. */
+static void stop_narrative_prefetch(void) {
+    pthread_mutex_lock(&g_prefetch_mutex);
+    if (!g_prefetch_started) {
+        pthread_mutex_unlock(&g_prefetch_mutex);
+        return;
+    }
+    g_prefetch_stop = true;
+    pthread_cond_signal(&g_prefetch_cond);
+    pthread_mutex_unlock(&g_prefetch_mutex);
+    pthread_join(g_prefetch_thread, NULL);
+    pthread_mutex_lock(&g_prefetch_mutex);
+    g_prefetch_started = false;
+    pthread_mutex_unlock(&g_prefetch_mutex);
+}
+
+/*
+ * Shared preambles are compiled once into a pdflatex format (pdflatex -ini ... \dump) so each
+ * job skips re-parsing TikZ/pgfplots and friends. The generated .tex still carries the full
+ * preamble behind an \ifdefined guard on the marker the format defines, so the same file
+ * compiles with or without the format.
+ */
+static const char REPORT_LATEX_PREAMBLE[] =
+    "\\PassOptionsToPackage{table}{xcolor}\n"
+    "\\documentclass[12pt]{article}\n"
+    "\\usepackage[utf8]{inputenc}\n"
+    "\\usepackage[T1]{fontenc}\n"
+    "\\usepackage{geometry}\n"
+    "\\usepackage{fancyhdr}\n"
+    "\\usepackage{graphicx}\n"
+    "\\usepackage{datetime}\n"
+    "\\usepackage{hyperref}\n"
+    "\\usepackage{etoolbox}\n"
+    "\\usepackage{array}\n"
+    "\\usepackage{helvet}\n"
+    "\\usepackage{tabularx}\n"
+    "\\usepackage{booktabs}\n"
+    "\\usepackage{pgfplots}\n"
+    "\\usepackage{tikz}\n"
+    "\\usepackage{lmodern}\n"
+    "\\usepackage{xcolor}\n"
+    "\\usepackage{float}\n"
+    "\\usepackage{eso-pic}\n"
+    "\\geometry{a4paper, left=0.5in, right=0.5in, top=1in, bottom=1in}\n"
+    "\\setlength{\\headheight}{26pt}\n"
+    "\\pgfplotsset{compat=1.18}\n"
+    "\\graphicspath{{./}{./assets/}}\n"
+    "\\usepgfplotslibrary{colorbrewer}\n"
+    "\\definecolor{tabblue}{RGB}{31,119,180}\n"
+    "\\definecolor{CitywideAccent}{HTML}{46A6B4}\n"
+    "\\newcommand{\\generatedtimestamp}{\\today~\\currenttime}\n";
+
+static const char OVERVIEW_LATEX_PREAMBLE[] =
+    "\\documentclass[12pt]{article}\n"
+    "\\usepackage{geometry}\n"
+    "\\usepackage{booktabs}\n"
+    "\\usepackage{array}\n"
+    "\\usepackage{longtable}\n"
+    "\\usepackage{xcolor}\n"
+    "\\usepackage{graphicx}\n"
+    "\\usepackage{hyperref}\n"
+    "\\usepackage{tikz}\n"
+    "\\usepackage{pgfplots}\n"
+    "\\usepackage{pgfplotstable}\n"
+    "\\usepackage{tabularx}\n"
+    "\\usepackage[most]{tcolorbox}\n"
+    "\\usepackage{textcomp}\n"
+    "\\usepackage{helvet}\n"
+    "\\pgfplotsset{compat=1.18}\n"
+    "\\usepgfplotslibrary{colorbrewer}\n"
+    "\\definecolor{Set2-1}{HTML}{66C2A5}\n"
+    "\\definecolor{Set2-2}{HTML}{FC8D62}\n"
+    "\\definecolor{Set2-3}{HTML}{8DA0CB}\n"
+    "\\definecolor{Set2-4}{HTML}{E78AC3}\n"
+    "\\definecolor{Set2-5}{HTML}{A6D854}\n"
+    "\\definecolor{Set2-6}{HTML}{FFD92F}\n"
+    "\\definecolor{Set3-4}{HTML}{FB8072}\n"
+    "\\definecolor{CalloutAlert}{HTML}{F94144}\n"
+    "\\definecolor{CalloutWarning}{HTML}{F3722C}\n"
+    "\\definecolor{CalloutInfo}{HTML}{577590}\n"
+    "\\definecolor{CalloutPositive}{HTML}{43AA8B}\n"
+    "\\definecolor{AccentPrimary}{HTML}{1F2933}\n"
+    "\\definecolor{AccentSecondary}{HTML}{3D5AFE}\n"
+    "\\definecolor{NeutralLight}{HTML}{F5F7FA}\n"
+    "\\definecolor{NeutralBorder}{HTML}{D5DBE5}\n"
+    "\\renewcommand{\\familydefault}{\\sfdefault}\n"
+    "\\newcommand{\\sectiondivider}{\\noindent\\color{AccentPrimary}\\rule{\\textwidth}{0.8pt}\\par\\medskip}\n"
+    "\\geometry{margin=1in}\n"
+    "\\hypersetup{colorlinks=false}\n";
+
+static pthread_mutex_t g_latex_format_mutex = PTHREAD_MUTEX_INITIALIZER;
+static LatexFormat g_report_latex_format = {"report", "CitywideReportFormat", REPORT_LATEX_PREAMBLE, LATEX_FORMAT_UNTRIED, NULL};
+static LatexFormat g_overview_latex_format = {"overview", "CitywideOverviewFormat", OVERVIEW_LATEX_PREAMBLE, LATEX_FORMAT_UNTRIED, NULL};
+
+static int append_latex_preamble(Buffer *buf, const LatexFormat *format) {
+    return buffer_appendf(buf, "\\ifdefined\\%s\\else\n", format->marker) &&
+           buffer_append_cstr(buf, format->preamble) &&
+           buffer_append_cstr(buf, "\\fi\n");
+}
+
+/* Forks pdflatex in working_dir. Returns 0 only when it could not be run; the exit result lands in exit_ok_out. */
+static int spawn_pdflatex(const char *working_dir, char *const argv[], bool *exit_ok_out, char **error_out) {
+    *exit_ok_out = false;
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (chdir(working_dir) != 0) {
+            _exit(1);
+        }
+        execvp("pdflatex", argv);
+        _exit(1);
+    } else if (pid < 0) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Failed to spawn pdflatex");
+        }
+        return 0;
+    }
+
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("pdflatex wait failed");
+        }
+        return 0;
+    }
+    *exit_ok_out = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    return 1;
+}
+
+/* Runs pdflatex -ini over the preamble and moves the dump next to the report output. */
+static void latex_format_build(LatexFormat *format) {
+    format->state = LATEX_FORMAT_FAILED;
+    if (!g_latex_format_enabled || !g_report_output_dir) {
+        return;
+    }
+
+    Sha256 ctx;
+    char digest[SHA256_HEX_SIZE];
+    sha256_init(&ctx);
+    sha256_update(&ctx, format->preamble, strlen(format->preamble));
+    sha256_final_hex(&ctx, digest);
+
+    char *format_dir = join_path(g_report_output_dir, ".latex-formats");
+    char *work_dir = create_temp_dir();
+    char *tex_path = NULL;
+    char *built_path = NULL;
+    char *staged_path = NULL;
+    char *final_path = NULL;
+    char *error = NULL;
+    Buffer source;
+    bool source_ready = buffer_init(&source) != 0;
+    char file_name[64];
+    char job_arg[64];
+    char format_name[96];
+    snprintf(file_name, sizeof(file_name), "%s.tex", format->name);
+    snprintf(job_arg, sizeof(job_arg), "-jobname=%s", format->name);
+    snprintf(format_name, sizeof(format_name), "%s-%.16s", format->name, digest);
+
+    if (!format_dir || !work_dir || !source_ready || ensure_directory_exists(format_dir) != 0) {
+        log_error("Failed to prepare LaTeX format directory for %s", format->name);
+        goto cleanup;
+    }
+    tex_path = join_path(work_dir, file_name);
+    if (!tex_path ||
+        !append_latex_preamble(&source, format) ||
+        !buffer_appendf(&source, "\\def\\%s{}\n\\dump\n", format->marker) ||
+        write_buffer_to_file(tex_path, source.data, source.length) != 0) {
+        log_error("Failed to write LaTeX format source for %s", format->name);
+        goto cleanup;
+    }
+
+    char *argv[] = {"pdflatex", "-ini", "-interaction=nonstopmode", "-halt-on-error", job_arg, "&pdflatex", file_name, NULL};
+    bool exit_ok = false;
+    if (!spawn_pdflatex(work_dir, argv, &exit_ok, &error) || !exit_ok) {
+        log_error("Building LaTeX format %s failed: %s", format->name, error ? error : "pdflatex -ini exited with an error");
+        goto cleanup;
+    }
+
+    char built_name[80];
+    char staged_name[128];
+    char final_name[128];
+    snprintf(built_name, sizeof(built_name), "%s.fmt", format->name);
+    snprintf(staged_name, sizeof(staged_name), "%s.fmt.%ld.tmp", format_name, (long)getpid());
+    snprintf(final_name, sizeof(final_name), "%s.fmt", format_name);
+    built_path = join_path(work_dir, built_name);
+    staged_path = join_path(format_dir, staged_name);
+    final_path = join_path(format_dir, final_name);
+    if (!built_path || !staged_path || !final_path ||
+        copy_file_contents(built_path, staged_path) != 0 ||
+        rename(staged_path, final_path) != 0) {
+        log_error("Failed to install LaTeX format %s: %s", format->name, strerror(errno));
+        if (staged_path) {
+            unlink(staged_path);
+        }
+        goto cleanup;
+    }
+    format->path = join_path(format_dir, format_name);
+    if (format->path) {
+        format->state = LATEX_FORMAT_READY;
+        log_info("Built LaTeX format %s", format->path);
+    }
+
+cleanup:
+    if (work_dir) {
+        remove_directory_recursive(work_dir);
+    }
+    if (source_ready) {
+        buffer_free(&source);
+    }
+    free(error);
+    free(final_path);
+    free(staged_path);
+    free(built_path);
+    free(tex_path);
+    free(work_dir);
+    free(format_dir);
+}
+
+/* Builds the format on first use; returns a copy of its -fmt path or NULL to compile without it. */
+static char *latex_format_acquire(LatexFormat *format) {
+    if (!format) {
+        return NULL;
+    }
+    pthread_mutex_lock(&g_latex_format_mutex);
+    if (format->state == LATEX_FORMAT_UNTRIED) {
+        latex_format_build(format);
+    }
+    char *path = format->state == LATEX_FORMAT_READY ? strdup(format->path) : NULL;
+    pthread_mutex_unlock(&g_latex_format_mutex);
+    return path;
+}
+
+static void latex_format_disable(LatexFormat *format) {
+    pthread_mutex_lock(&g_latex_format_mutex);
+    if (format->state == LATEX_FORMAT_READY) {
+        log_error("Disabling LaTeX format %s after a compile that only succeeded without it", format->path);
+        format->state = LATEX_FORMAT_FAILED;
+    }
+    pthread_mutex_unlock(&g_latex_format_mutex);
+}
+
+static void latex_file_digest(const char *path, char digest[SHA256_HEX_SIZE]) {
+    digest[0] = '\0';
+    FILE *fp = path ? fopen(path, "rb") : NULL;
+    if (!fp) {
+        return;
+    }
+    Sha256 ctx;
+    unsigned char chunk[4096];
+    size_t read;
+    sha256_init(&ctx);
+    while ((read = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+        sha256_update(&ctx, chunk, read);
+    }
+    fclose(fp);
+    sha256_final_hex(&ctx, digest);
+}
+
+/* Another pass is needed when LaTeX asks for one (labels, outlines, longtable widths) or the
+   table of contents changed, since its page numbers only settle once it is read back. */
+static bool latex_needs_rerun(const char *log_path, const char *toc_path, const char *toc_before) {
+    char toc_after[SHA256_HEX_SIZE];
+    latex_file_digest(toc_path, toc_after);
+    if (strcmp(toc_before, toc_after) != 0) {
+        return true;
+    }
+
+    static const char *const markers[] = {
+        "Rerun to get",
+        "Label(s) may have changed",
+        "Rerun LaTeX"
+    };
+    FILE *fp = fopen(log_path, "r");
+    if (!fp) {
+        return true;
+    }
+    bool rerun = false;
+    char line[1024];
+    while (!rerun && fgets(line, sizeof(line), fp)) {
+        for (size_t i = 0; i < sizeof(markers) / sizeof(markers[0]); ++i) {
+            if (strstr(line, markers[i])) {
+                rerun = true;
+                break;
             }
-            return 0;
         }
-        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    }
+    fclose(fp);
+    return rerun;
+}
+
+static int run_pdflatex(const char *working_dir, const char *tex_filename, LatexFormat *format, char **error_out) {
+    if (!working_dir || !tex_filename) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Invalid LaTeX arguments");
+        }
+        return 0;
+    }
+
+    size_t stem_len = strlen(tex_filename);
+    if (stem_len > 4 && strcmp(tex_filename + stem_len - 4, ".tex") == 0) {
+        stem_len -= 4;
+    }
+    char log_name[PATH_MAX];
+    char toc_name[PATH_MAX];
+    snprintf(log_name, sizeof(log_name), "%.*s.log", (int)stem_len, tex_filename);
+    snprintf(toc_name, sizeof(toc_name), "%.*s.toc", (int)stem_len, tex_filename);
+    char *log_path = join_path(working_dir, log_name);
+    char *toc_path = join_path(working_dir, toc_name);
+    if (!log_path || !toc_path) {
+        free(log_path);
+        free(toc_path);
+        if (error_out && !*error_out) {
+            *error_out = strdup("Out of memory");
+        }
+        return 0;
+    }
+
+    char *format_path = latex_format_acquire(format);
+    bool format_failed = false;
+    int ok = 0;
+    for (int pass = 0; pass < LATEX_MAX_PASSES;) {
+        char toc_before[SHA256_HEX_SIZE];
+        latex_file_digest(toc_path, toc_before);
+
+        char format_arg[PATH_MAX + 8];
+        char *argv[5];
+        size_t argc = 0;
+        argv[argc++] = "pdflatex";
+        argv[argc++] = "-interaction=nonstopmode";
+        if (format_path) {
+            snprintf(format_arg, sizeof(format_arg), "-fmt=%s", format_path);
+            argv[argc++] = format_arg;
+        }
+        argv[argc++] = (char *)tex_filename;
+        argv[argc] = NULL;
+
+        bool exit_ok = false;
+        if (!spawn_pdflatex(working_dir, argv, &exit_ok, error_out)) {
+            goto cleanup;
+        }
+        if (!exit_ok) {
+            if (format_path && pass == 0) {
+                /* Retry with the full preamble; if that works the format was the problem. */
+                log_info("pdflatex failed with format %s, retrying without it", format_path);
+                free(format_path);
+                format_path = NULL;
+                format_failed = true;
+                continue;
+            }
             if (error_out && !*error_out) {
                 char *msg = malloc(64);
                 if (msg) {
@@ -14091,10 +15197,23 @@ static int run_pdflatex(const char *working_dir, const char *tex_filename, char
                     *error_out = msg;
                 }
             }
-            return 0;
+            goto cleanup;
+        }
+        pass++;
+        if (pass < LATEX_MAX_PASSES && !latex_needs_rerun(log_path, toc_path, toc_before)) {
+            break;
         }
     }
-    return 1;
+    if (format_failed) {
+        latex_format_disable(format);
+    }
+    ok = 1;
+
+cleanup:
+    free(format_path);
+    free(log_path);
+    free(toc_path);
+    return ok;
 }
 
 static char *make_pgf_identifier(const char *label) {
@@ -14127,7 +15246,7 @@ static char *make_pgf_identifier(const char *label) {
     return out;
 }
 
-static int append_deficiency_code_chart(Buffer *buf, const ReportData *report) {
+static int render_deficiency_code_chart(Buffer *buf, const ReportData *report) {
     if (!report || !buf) {
         return 0;
     }
@@ -14204,7 +15323,7 @@ static int append_deficiency_code_chart(Buffer *buf, const ReportData *report) {
     return ok;
 }
 
-static int append_deficiencies_per_device_chart(Buffer *buf, const ReportData *report) {
+static int render_deficiencies_per_device_chart(Buffer *buf, const ReportData *report) {
     if (!buf || !report) {
         return 0;
     }
@@ -14281,7 +15400,7 @@ static int append_deficiencies_per_device_chart(Buffer *buf, const ReportData *r
     return ok;
 }
 
-static int append_controller_age_chart(Buffer *buf, const ReportData *report) {
+static int render_controller_age_chart(Buffer *buf, const ReportData *report) {
     if (!buf || !report) {
         return 0;
     }
@@ -14324,7 +15443,30 @@ static int append_controller_age_chart(Buffer *buf, const ReportData *report) {
     return ok;
 }
 
-static int append_device_deficiencies(Buffer *buf, const ReportDevice *device, bool omit_heading, bool include_summary) {
+static int append_latex_cell(Buffer *buf, const char *text, bool closed, const char *suffix) {
+    if (closed && !buffer_append_cstr(buf, "\\ClosedText{")) {
+        return 0;
+    }
+    if (!latex_append_text(buf, text ? text : "", LATEX_TEXT_SANITIZE)) {
+        return 0;
+    }
+    if (closed && !buffer_append_cstr(buf, "}")) {
+        return 0;
+    }
+    if (suffix && suffix[0]) {
+        return buffer_append_cstr(buf, " ") && buffer_append_cstr(buf, suffix);
+    }
+    return 1;
+}
+
+static int append_latex_table_row(Buffer *buf, const char *label, const char *value) {
+    return latex_append_text(buf, label, LATEX_TEXT_SANITIZE) &&
+           buffer_append_cstr(buf, " & ") &&
+           latex_append_text(buf, value, LATEX_TEXT_SANITIZE) &&
+           buffer_append_cstr(buf, " \\\\ \n");
+}
+
+static int render_device_deficiencies(Buffer *buf, const ReportDevice *device, bool omit_heading, bool include_summary) {
     if (!buf || !device) {
         return 0;
     }
@@ -14369,272 +15511,423 @@ static int append_device_deficiencies(Buffer *buf, const ReportDevice *device, b
     }
 
     for (size_t j = 0; j < device->deficiencies.count; ++j) {
-        ReportDeficiency *def = &device->deficiencies.items[j];
+        const ReportDeficiency *def = &device->deficiencies.items[j];
         const char *equip_src = def->equipment ? def->equipment : "—";
         const char *cond_src = def->condition ? def->condition : "—";
         const char *remedy_src = def->remedy ? def->remedy : "—";
         const char *note_src = def->note ? def->note : "—";
         bool closed = def->resolved.has_value && def->resolved.value;
 
-        char *equip_clean = sanitize_ascii(equip_src);
-        char *cond_clean = sanitize_ascii(cond_src);
-        char *remedy_clean = sanitize_ascii(remedy_src);
-        char *note_clean = sanitize_ascii(note_src);
-
-        const char *equip_text = equip_clean ? equip_clean : equip_src;
-        const char *cond_text = cond_clean ? cond_clean : cond_src;
-        const char *remedy_text = remedy_clean ? remedy_clean : remedy_src;
-        const char *note_text = note_clean ? note_clean : note_src;
-
-        char *equip_tex = latex_escape(equip_text);
-        char *cond_tex = latex_escape(cond_text);
-        char *remedy_tex = latex_escape(remedy_text);
-        char *note_tex = latex_escape(note_text);
-
-        free(equip_clean);
-        free(cond_clean);
-        free(remedy_clean);
-        free(note_clean);
-
-        if (!equip_tex || !cond_tex || !remedy_tex || !note_tex) {
-            free(equip_tex);
-            free(cond_tex);
-            free(remedy_tex);
-            free(note_tex);
+        if (!append_latex_cell(buf, equip_src, closed, NULL) ||
+            !buffer_append_cstr(buf, " & ") ||
+            !append_latex_cell(buf, cond_src, closed, NULL) ||
+            !buffer_append_cstr(buf, " & ") ||
+            !append_latex_cell(buf, remedy_src, closed, NULL) ||
+            !buffer_append_cstr(buf, " & ") ||
+            !append_latex_cell(buf, note_src, closed, closed ? "\\ClosedMarker" : NULL) ||
+            !buffer_append_cstr(buf, " \\\\ \n")) {
             return 0;
         }
+    }
 
-        const char *note_suffix = closed ? "\\ClosedMarker" : NULL;
-        char *equip_cell = format_closed_cell(equip_tex, closed, NULL);
-        char *cond_cell = format_closed_cell(cond_tex, closed, NULL);
-        char *remedy_cell = format_closed_cell(remedy_tex, closed, NULL);
-        char *note_cell = format_closed_cell(note_tex, closed, note_suffix);
+    if (!buffer_append_cstr(buf, "\\bottomrule\n\\end{tabularx}}\n\n")) {
+        return 0;
+    }
+    return 1;
+}
 
-        free(equip_tex);
-        free(cond_tex);
-        free(remedy_tex);
-        free(note_tex);
+static int render_device_section(Buffer *buf, const ReportDevice *device) {
+    const char *id_src = device->device_id ? device->device_id :
+                        (device->submission_id ? device->submission_id : device->audit_uuid);
+    if (!buffer_append_cstr(buf, "\\subsubsection{Unit ") ||
+        !latex_append_text(buf, id_src ? id_src : "Device", LATEX_TEXT_SANITIZE) ||
+        !buffer_append_cstr(buf, "}\n\n")) {
+        return 0;
+    }
+
+    if (!buffer_append_cstr(buf, "{\\small\\rowcolors{2}{DeviceRow}{white}\n\\begin{tabularx}{\\textwidth}{@{}lX@{}}\\toprule\n")) {
+        return 0;
+    }
+
+    if (device->device_type && device->device_type[0]) {
+        if (!append_latex_table_row(buf, "Device Type", device->device_type)) {
+            return 0;
+        }
+    }
+
+    const struct {
+        const char *label;
+        const char *value;
+    } info_rows[] = {
+        {"Bank", device->bank_name},
+        {"Controller Manufacturer", device->controller_manufacturer},
+        {"Controller Model", device->controller_model},
+        {"Machine Manufacturer", device->machine_manufacturer},
+        {"Machine Type", device->machine_type},
+        {"Roping", device->roping},
+        {"Door Operation", device->door_operation}
+    };
+
+    for (size_t j = 0; j < sizeof(info_rows) / sizeof(info_rows[0]); ++j) {
+        if (!info_rows[j].value || info_rows[j].value[0] == '\0') {
+            continue;
+        }
+        if (!append_latex_table_row(buf, info_rows[j].label, info_rows[j].value)) {
+            return 0;
+        }
+    }
+
+    struct {
+        const char *label;
+        const OptionalInt *value;
+    } numeric_rows[] = {
+        {"Capacity", &device->metrics.capacity},
+        {"Car Speed", &device->metrics.car_speed},
+        {"Controller Installation Year", &device->metrics.controller_install_year},
+        {"Number of Stops", &device->metrics.number_of_stops},
+        {"Code Data Year", &device->metrics.code_data_year}
+    };
+
+    char numeric[32];
+    for (size_t j = 0; j < sizeof(numeric_rows) / sizeof(numeric_rows[0]); ++j) {
+        const char *value_text = optional_int_to_text(numeric_rows[j].value, numeric, sizeof(numeric));
+        if (!value_text || value_text[0] == '\0' || strcmp(value_text, "—") == 0) {
+            continue;
+        }
+        if (!append_latex_table_row(buf, numeric_rows[j].label, value_text)) {
+            return 0;
+        }
+    }
+
+    const struct {
+        const char *label;
+        const OptionalBool *value;
+    } bool_rows[] = {
+        {"DLM Compliant", &device->metrics.dlm_compliant},
+        {"Cat 1 Tag Current", &device->metrics.cat1_tag_current},
+        {"Cat 5 Tag Current", &device->metrics.cat5_tag_current},
+        {"Maintenance Log Up to Date", &device->metrics.maintenance_log_up_to_date}
+    };
 
-        if (!equip_cell || !cond_cell || !remedy_cell || !note_cell) {
-            free(equip_cell);
-            free(cond_cell);
-            free(remedy_cell);
-            free(note_cell);
+    for (size_t j = 0; j < sizeof(bool_rows) / sizeof(bool_rows[0]); ++j) {
+        const char *bool_text = optional_bool_to_text(bool_rows[j].value);
+        if (!bool_text || !bool_text[0]) {
+            continue;
+        }
+        if (!append_latex_table_row(buf, bool_rows[j].label, bool_text)) {
             return 0;
         }
+    }
+
+    if (!buffer_append_cstr(buf, "\\bottomrule\n\\end{tabularx}}\n\n")) {
+        return 0;
+    }
 
-        if (!buffer_appendf(buf, "%s & %s & %s & %s \\\\ \n", equip_cell, cond_cell, remedy_cell, note_cell)) {
-            free(equip_cell);
-            free(cond_cell);
-            free(remedy_cell);
-            free(note_cell);
+    if (device->narrative && device->narrative[0]) {
+        if (!latex_append_text(buf, device->narrative, LATEX_TEXT_SANITIZE | LATEX_TEXT_MARKDOWN) ||
+            !buffer_append_cstr(buf, "\n\n")) {
             return 0;
         }
+    }
+
+    return render_device_deficiencies(buf, device, false, false);
+}
+
+/* Length-prefixed so adjacent fields cannot run together; NULL hashes differently from "". */
+static void fragment_key_text(Sha256 *key, const char *text) {
+    uint64_t len = text ? (uint64_t)strlen(text) + 1 : 0;
+    sha256_update(key, &len, sizeof(len));
+    if (text) {
+        sha256_update(key, text, (size_t)len - 1);
+    }
+}
+
+static void fragment_key_int(Sha256 *key, int64_t value) {
+    sha256_update(key, &value, sizeof(value));
+}
+
+static void fragment_key_optional_int(Sha256 *key, const OptionalInt *value) {
+    fragment_key_int(key, value->has_value ? (int64_t)value->value : INT64_MIN);
+}
+
+static void fragment_key_optional_bool(Sha256 *key, const OptionalBool *value) {
+    fragment_key_int(key, value->has_value ? (int64_t)value->value : -1);
+}
 
-        free(equip_cell);
-        free(cond_cell);
-        free(remedy_cell);
-        free(note_cell);
+static void fragment_key_deficiencies(Sha256 *key, const ReportDevice *device) {
+    fragment_key_int(key, (int64_t)device->deficiencies.count);
+    for (size_t i = 0; i < device->deficiencies.count; ++i) {
+        const ReportDeficiency *def = &device->deficiencies.items[i];
+        fragment_key_text(key, def->equipment);
+        fragment_key_text(key, def->condition);
+        fragment_key_text(key, def->remedy);
+        fragment_key_text(key, def->note);
+        fragment_key_optional_bool(key, &def->resolved);
+    }
+}
+
+/* Every input render_device_section reads. */
+static void fragment_key_device(Sha256 *key, const ReportDevice *device) {
+    const char *texts[] = {
+        device->device_id, device->submission_id, device->audit_uuid, device->device_type,
+        device->bank_name, device->controller_manufacturer, device->controller_model,
+        device->machine_manufacturer, device->machine_type, device->roping, device->door_operation,
+        device->narrative
+    };
+    for (size_t i = 0; i < ARRAY_LEN(texts); ++i) {
+        fragment_key_text(key, texts[i]);
+    }
+    const ReportDeviceMetrics *metrics = &device->metrics;
+    fragment_key_optional_int(key, &metrics->capacity);
+    fragment_key_optional_int(key, &metrics->car_speed);
+    fragment_key_optional_int(key, &metrics->controller_install_year);
+    fragment_key_optional_int(key, &metrics->number_of_stops);
+    fragment_key_optional_int(key, &metrics->code_data_year);
+    fragment_key_optional_bool(key, &metrics->dlm_compliant);
+    fragment_key_optional_bool(key, &metrics->cat1_tag_current);
+    fragment_key_optional_bool(key, &metrics->cat5_tag_current);
+    fragment_key_optional_bool(key, &metrics->maintenance_log_up_to_date);
+    fragment_key_deficiencies(key, device);
+}
+
+typedef struct {
+    unsigned char key[SHA256_DIGEST_SIZE];
+    size_t start;
+    bool enabled;
+} LatexFragment;
+
+/* Finishes the key and appends the cached fragment on a hit (returns 1). On a miss the caller
+   renders into buf and then calls latex_fragment_store. */
+static int latex_fragment_lookup(LatexFragment *fragment, Sha256 *key, Buffer *buf, LatexFragmentStats *stats) {
+    fragment->enabled = fragment_cache_enabled();
+    fragment->start = buf->length;
+    if (!fragment->enabled) {
+        return 0;
+    }
+    sha256_final(key, fragment->key);
+    stats->lookups++;
+    if (fragment_cache_fetch(fragment->key, buf)) {
+        stats->hits++;
+        return 1;
+    }
+    return 0;
+}
+
+static void latex_fragment_store(const LatexFragment *fragment, const Buffer *buf) {
+    if (fragment->enabled && buf->length >= fragment->start) {
+        fragment_cache_store(fragment->key, buf->data + fragment->start, buf->length - fragment->start);
+    }
+}
+
+static void latex_fragment_key_init(Sha256 *key, const char *kind) {
+    sha256_init(key);
+    fragment_key_text(key, kind);
+}
+
+static int append_deficiency_code_chart(Buffer *buf, const ReportData *report, LatexFragmentStats *fragments) {
+    if (!buf || !report) {
+        return 0;
+    }
+    Sha256 key;
+    latex_fragment_key_init(&key, "deficiency-code-chart");
+    const KeyCountList *codes = &report->summary.deficiencies_by_code;
+    fragment_key_int(&key, (int64_t)codes->count);
+    for (size_t i = 0; i < codes->count; ++i) {
+        fragment_key_text(&key, codes->items[i].key);
+        fragment_key_int(&key, codes->items[i].count);
+    }
+    LatexFragment fragment;
+    if (latex_fragment_lookup(&fragment, &key, buf, fragments)) {
+        return 1;
+    }
+    if (!render_deficiency_code_chart(buf, report)) {
+        return 0;
+    }
+    latex_fragment_store(&fragment, buf);
+    return 1;
+}
+
+static int append_deficiencies_per_device_chart(Buffer *buf, const ReportData *report, LatexFragmentStats *fragments) {
+    if (!buf || !report) {
+        return 0;
+    }
+    Sha256 key;
+    latex_fragment_key_init(&key, "deficiencies-per-device-chart");
+    fragment_key_int(&key, (int64_t)report->devices.count);
+    for (size_t i = 0; i < report->devices.count; ++i) {
+        const ReportDevice *device = &report->devices.items[i];
+        fragment_key_text(&key, device->device_id);
+        fragment_key_text(&key, device->submission_id);
+        fragment_key_text(&key, device->audit_uuid);
+        fragment_key_int(&key, (int64_t)device->deficiencies.count);
+    }
+    LatexFragment fragment;
+    if (latex_fragment_lookup(&fragment, &key, buf, fragments)) {
+        return 1;
+    }
+    if (!render_deficiencies_per_device_chart(buf, report)) {
+        return 0;
+    }
+    latex_fragment_store(&fragment, buf);
+    return 1;
+}
+
+static int append_controller_age_chart(Buffer *buf, const ReportData *report, LatexFragmentStats *fragments) {
+    if (!buf || !report) {
+        return 0;
+    }
+    Sha256 key;
+    latex_fragment_key_init(&key, "controller-age-chart");
+    fragment_key_int(&key, (int64_t)report->devices.count);
+    for (size_t i = 0; i < report->devices.count; ++i) {
+        const ReportDevice *device = &report->devices.items[i];
+        fragment_key_optional_int(&key, &device->metrics.controller_age);
+        fragment_key_int(&key, (int64_t)device->deficiencies.count);
     }
-
-    if (!buffer_append_cstr(buf, "\\bottomrule\n\\end{tabularx}}\n\n")) {
+    LatexFragment fragment;
+    if (latex_fragment_lookup(&fragment, &key, buf, fragments)) {
+        return 1;
+    }
+    if (!render_controller_age_chart(buf, report)) {
         return 0;
     }
+    latex_fragment_store(&fragment, buf);
     return 1;
 }
 
-static int append_device_sections(Buffer *buf, const ReportData *report) {
-    if (!buf || !report) {
+static int append_device_deficiencies(Buffer *buf, const ReportDevice *device, bool omit_heading, bool include_summary, LatexFragmentStats *fragments) {
+    if (!buf || !device) {
         return 0;
     }
-
-    if (!buffer_append_cstr(buf, "\\subsection{Per-Device Equipment Condition}\n\n")) {
+    Sha256 key;
+    latex_fragment_key_init(&key, "device-deficiencies");
+    fragment_key_int(&key, omit_heading);
+    fragment_key_int(&key, include_summary);
+    fragment_key_deficiencies(&key, device);
+    LatexFragment fragment;
+    if (latex_fragment_lookup(&fragment, &key, buf, fragments)) {
+        return 1;
+    }
+    if (!render_device_deficiencies(buf, device, omit_heading, include_summary)) {
         return 0;
     }
+    latex_fragment_store(&fragment, buf);
+    return 1;
+}
 
-    for (size_t i = 0; i < report->devices.count; ++i) {
-        ReportDevice *device = &report->devices.items[i];
-        const char *id_src = device->device_id ? device->device_id :
-                            (device->submission_id ? device->submission_id : device->audit_uuid);
-        char *device_id_clean = sanitize_ascii(id_src);
-        const char *device_id_text = device_id_clean ? device_id_clean : (id_src ? id_src : "Device");
-        char *device_id_tex = latex_escape(device_id_text);
-        free(device_id_clean);
-
-        if (!device_id_tex) {
-            free(device_id_tex);
-            return 0;
-        }
-
-        if (!buffer_appendf(buf, "\\subsubsection{Unit %s}\n\n", device_id_tex)) {
-            free(device_id_tex);
-            return 0;
-        }
-
-        free(device_id_tex);
-
-        if (!buffer_append_cstr(buf, "{\\small\\rowcolors{2}{DeviceRow}{white}\n\\begin{tabularx}{\\textwidth}{@{}lX@{}}\\toprule\n")) {
-            return 0;
-        }
-
-        if (device->device_type && device->device_type[0]) {
-            char *type_clean = sanitize_ascii(device->device_type);
-            const char *type_text = type_clean ? type_clean : device->device_type;
-            char *label_tex = latex_escape("Device Type");
-            char *value_tex = latex_escape(type_text);
-            free(type_clean);
-            if (!label_tex || !value_tex || !buffer_appendf(buf, "%s & %s \\\\ \n", label_tex, value_tex)) {
-                free(label_tex);
-                free(value_tex);
-                return 0;
-            }
-            free(label_tex);
-            free(value_tex);
-        }
-
-        const struct {
-            const char *label;
-            const char *value;
-        } info_rows[] = {
-            {"Bank", device->bank_name},
-            {"Controller Manufacturer", device->controller_manufacturer},
-            {"Controller Model", device->controller_model},
-            {"Machine Manufacturer", device->machine_manufacturer},
-            {"Machine Type", device->machine_type},
-            {"Roping", device->roping},
-            {"Door Operation", device->door_operation}
-        };
-
-        for (size_t j = 0; j < sizeof(info_rows) / sizeof(info_rows[0]); ++j) {
-            if (!info_rows[j].value || info_rows[j].value[0] == '\0') {
-                continue;
-            }
-            char *label_clean = sanitize_ascii(info_rows[j].label);
-            char *value_clean = sanitize_ascii(info_rows[j].value);
-            const char *label_text = label_clean ? label_clean : info_rows[j].label;
-            const char *value_text = value_clean ? value_clean : info_rows[j].value;
-            char *label_tex = latex_escape(label_text);
-            char *value_tex = latex_escape(value_text);
-            free(label_clean);
-            free(value_clean);
-            if (!label_tex || !value_tex) {
-                free(label_tex);
-                free(value_tex);
-                return 0;
-            }
-            if (!buffer_appendf(buf, "%s & %s \\\\ \n", label_tex, value_tex)) {
-                free(label_tex);
-                free(value_tex);
-                return 0;
-            }
-            free(label_tex);
-            free(value_tex);
-        }
-
-        struct {
-            const char *label;
-            const OptionalInt *value;
-        } numeric_rows[] = {
-            {"Capacity", &device->metrics.capacity},
-            {"Car Speed", &device->metrics.car_speed},
-            {"Controller Installation Year", &device->metrics.controller_install_year},
-            {"Number of Stops", &device->metrics.number_of_stops},
-            {"Code Data Year", &device->metrics.code_data_year}
-        };
-
-        char numeric[32];
-        for (size_t j = 0; j < sizeof(numeric_rows) / sizeof(numeric_rows[0]); ++j) {
-            const char *value_text = optional_int_to_text(numeric_rows[j].value, numeric, sizeof(numeric));
-            if (!value_text || value_text[0] == '\0' || strcmp(value_text, "—") == 0) {
-                continue;
-            }
-            char *label_tex = latex_escape(numeric_rows[j].label);
-            char *value_tex = latex_escape(value_text);
-            if (!label_tex || !value_tex || !buffer_appendf(buf, "%s & %s \\\\ \n", label_tex, value_tex)) {
-                free(label_tex);
-                free(value_tex);
-                return 0;
-            }
-            free(label_tex);
-            free(value_tex);
-        }
-
-        const char *bool_text = optional_bool_to_text(&device->metrics.dlm_compliant);
-        if (bool_text && bool_text[0]) {
-            char *label_tex = latex_escape("DLM Compliant");
-            char *value_tex = latex_escape(bool_text);
-            if (!label_tex || !value_tex || !buffer_appendf(buf, "%s & %s \\\\ \n", label_tex, value_tex)) {
-                free(label_tex);
-                free(value_tex);
-                return 0;
-            }
-            free(label_tex);
-            free(value_tex);
-        }
+/* One cached fragment per device, so closing a deficiency re-renders only that unit. */
+static int append_device_section(Buffer *buf, const ReportDevice *device, LatexFragmentStats *fragments) {
+    Sha256 key;
+    latex_fragment_key_init(&key, "device-section");
+    fragment_key_device(&key, device);
+    LatexFragment fragment;
+    if (latex_fragment_lookup(&fragment, &key, buf, fragments)) {
+        return 1;
+    }
+    if (!render_device_section(buf, device)) {
+        return 0;
+    }
+    latex_fragment_store(&fragment, buf);
+    return 1;
+}
 
-        bool_text = optional_bool_to_text(&device->metrics.cat1_tag_current);
-        if (bool_text && bool_text[0]) {
-            char *label_tex = latex_escape("Cat 1 Tag Current");
-            char *value_tex = latex_escape(bool_text);
-            if (!label_tex || !value_tex || !buffer_appendf(buf, "%s & %s \\\\ \n", label_tex, value_tex)) {
-                free(label_tex);
-                free(value_tex);
-                return 0;
-            }
-            free(label_tex);
-            free(value_tex);
+typedef struct {
+    const ReportData *report;
+    Buffer *sections;
+    LatexFragmentStats *stats;
+    int *ok;
+    size_t next;
+    pthread_mutex_t mutex;
+} DeviceSectionWork;
+
+static void *device_section_worker(void *arg) {
+    DeviceSectionWork *work = (DeviceSectionWork *)arg;
+    for (;;) {
+        pthread_mutex_lock(&work->mutex);
+        size_t i = work->next++;
+        pthread_mutex_unlock(&work->mutex);
+        if (i >= work->report->devices.count) {
+            break;
         }
+        work->ok[i] = buffer_init(&work->sections[i]) &&
+                      append_device_section(&work->sections[i], &work->report->devices.items[i], &work->stats[i]);
+    }
+    return NULL;
+}
 
-        bool_text = optional_bool_to_text(&device->metrics.cat5_tag_current);
-        if (bool_text && bool_text[0]) {
-            char *label_tex = latex_escape("Cat 5 Tag Current");
-            char *value_tex = latex_escape(bool_text);
-            if (!label_tex || !value_tex || !buffer_appendf(buf, "%s & %s \\\\ \n", label_tex, value_tex)) {
-                free(label_tex);
-                free(value_tex);
-                return 0;
-            }
-            free(label_tex);
-            free(value_tex);
-        }
+static int latex_assembly_thread_count(void) {
+    long threads = g_latex_assembly_threads;
+    if (threads <= 0) {
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    return (int)(threads < LATEX_ASSEMBLY_MAX_THREADS ? threads : LATEX_ASSEMBLY_MAX_THREADS);
+}
 
-        bool_text = optional_bool_to_text(&device->metrics.maintenance_log_up_to_date);
-        if (bool_text && bool_text[0]) {
-            char *label_tex = latex_escape("Maintenance Log Up to Date");
-            char *value_tex = latex_escape(bool_text);
-            if (!label_tex || !value_tex || !buffer_appendf(buf, "%s & %s \\\\ \n", label_tex, value_tex)) {
-                free(label_tex);
-                free(value_tex);
-                return 0;
-            }
-            free(label_tex);
-            free(value_tex);
-        }
+/* Device sections only read the report, so large buildings render them on several threads
+   into one buffer per device and splice the buffers back in device order. */
+static int append_device_sections(Buffer *buf, const ReportData *report, LatexFragmentStats *fragments) {
+    if (!buf || !report) {
+        return 0;
+    }
 
-        if (!buffer_append_cstr(buf, "\\bottomrule\n\\end{tabularx}}\n\n")) {
-            return 0;
-        }
+    if (!buffer_append_cstr(buf, "\\subsection{Per-Device Equipment Condition}\n\n")) {
+        return 0;
+    }
 
-        if (device->narrative && device->narrative[0]) {
-            char *narrative_clean = sanitize_ascii(device->narrative);
-            const char *narrative_text = narrative_clean ? narrative_clean : device->narrative;
-            char *narrative_tex = latex_escape_with_markdown(narrative_text);
-            free(narrative_clean);
-            if (!narrative_tex) {
-                return 0;
-            }
-            int ok = buffer_appendf(buf, "%s\n\n", narrative_tex);
-            free(narrative_tex);
-            if (!ok) {
+    size_t count = report->devices.count;
+    int threads = latex_assembly_thread_count();
+    if (count < LATEX_PARALLEL_MIN_DEVICES || threads < 2) {
+        for (size_t i = 0; i < count; ++i) {
+            if (!append_device_section(buf, &report->devices.items[i], fragments)) {
                 return 0;
             }
         }
+        return 1;
+    }
 
-        if (!append_device_deficiencies(buf, device, false, false)) {
-            return 0;
+    DeviceSectionWork work = {
+        .report = report,
+        .sections = calloc(count, sizeof(Buffer)),
+        .stats = calloc(count, sizeof(LatexFragmentStats)),
+        .ok = calloc(count, sizeof(int)),
+        .next = 0
+    };
+    if (!work.sections || !work.stats || !work.ok) {
+        free(work.sections);
+        free(work.stats);
+        free(work.ok);
+        return 0;
+    }
+    pthread_mutex_init(&work.mutex, NULL);
+    pthread_t helpers[LATEX_ASSEMBLY_MAX_THREADS];
+    int started = 0;
+    /* The calling thread takes a share too, so a failed pthread_create only costs speed. */
+    for (int t = 1; t < threads && (size_t)t < count; ++t) {
+        if (pthread_create(&helpers[started], NULL, device_section_worker, &work) != 0) {
+            break;
         }
+        started++;
     }
-    return 1;
+    device_section_worker(&work);
+    for (int t = 0; t < started; ++t) {
+        pthread_join(helpers[t], NULL);
+    }
+    pthread_mutex_destroy(&work.mutex);
+
+    int ok = 1;
+    for (size_t i = 0; i < count; ++i) {
+        ok = ok && work.ok[i] && buffer_append_bytes(buf, work.sections[i].data, work.sections[i].length);
+        fragments->lookups += work.stats[i].lookups;
+        fragments->hits += work.stats[i].hits;
+        buffer_free(&work.sections[i]);
+    }
+    free(work.sections);
+    free(work.stats);
+    free(work.ok);
+    return ok;
 }
 
 static int append_narrative_block(Buffer *buf, const char *content) {
@@ -14757,89 +16050,661 @@ static int append_narrative_block(Buffer *buf, const char *content) {
             continue;
         }
 
-        bool bullet = false;
-        if (*p == '-' || *p == '*') {
-            bullet = true;
-            p++;
-            while (*p == ' ' || *p == '\t') {
-                p++;
-            }
-            if (*p == '*' && p[1] != '*') {
-                p++;
-                while (*p == ' ' || *p == '\t') {
-                    p++;
+        bool bullet = false;
+        if (*p == '-' || *p == '*') {
+            bullet = true;
+            p++;
+            while (*p == ' ' || *p == '\t') {
+                p++;
+            }
+            if (*p == '*' && p[1] != '*') {
+                p++;
+                while (*p == ' ' || *p == '\t') {
+                    p++;
+                }
+            }
+        } else if ((*p == 'o' || *p == 'O') && (p[1] == ' ' || p[1] == '\t')) {
+            bullet = true;
+            p += 2;
+            while (*p == ' ' || *p == '\t') {
+                p++;
+            }
+            if (*p == '*' && p[1] != '*') {
+                p++;
+                while (*p == ' ' || *p == '\t') {
+                    p++;
+                }
+            }
+        }
+
+        if (bullet) {
+            if (!in_list) {
+                ok = buffer_append_cstr(buf, "\\begin{itemize}\n");
+                in_list = true;
+            }
+            if (ok) {
+                char *escaped = latex_escape_with_markdown(p);
+                if (!escaped) {
+                    ok = false;
+                } else {
+                    ok = buffer_appendf(buf, "  \\item %s\n", escaped);
+                    free(escaped);
+                }
+            }
+        } else {
+            if (in_list) {
+                ok = buffer_append_cstr(buf, "\\end{itemize}\n\n");
+                in_list = false;
+            }
+            if (ok) {
+                char *escaped = latex_escape_with_markdown(trimmed);
+                if (!escaped) {
+                    ok = false;
+                } else {
+                    ok = buffer_appendf(buf, "%s\n\n", escaped);
+                    free(escaped);
+                }
+            }
+        }
+
+        free(trimmed);
+        line = next;
+    }
+
+    if (ok && in_list) {
+        ok = buffer_append_cstr(buf, "\\end{itemize}\n\n");
+    }
+
+    free(work);
+    free(clean);
+    return ok;
+}
+
+/* Appends one task per device. Report jobs and narrative prefetch both build device
+   prompts here, so a prefetched narrative lands under the key a later report looks up. */
+static int narrative_tasks_add_sections(NarrativeTask *tasks,
+                                        size_t slots,
+                                        size_t *created,
+                                        NarrativeSet *narratives,
+                                        const char *report_json,
+                                        const ReportJob *job,
+                                        char **error_out) {
+    for (size_t i = 0; i < REPORT_SECTION_COUNT; ++i) {
+        const ReportSectionSpec *spec = &REPORT_SECTION_SPECS[i];
+        if (*created >= slots) {
+            if (error_out && !*error_out) {
+                *error_out = strdup("Task overflow");
+            }
+            return 0;
+        }
+        Buffer prompt;
+        if (!buffer_init(&prompt)) {
+            if (error_out && !*error_out) {
+                *error_out = strdup("Out of memory");
+            }
+            return 0;
+        }
+        bool ok = buffer_appendf(&prompt, "%s\n\nAudit Data:\n%s", spec->instructions, report_json ? report_json : "{}");
+        if (ok && spec->include_notes && job && job->notes && job->notes[0]) {
+            ok = buffer_appendf(&prompt, "\n\nInspector Notes:\n%s", job->notes);
+        }
+        if (ok && spec->include_recommendations && job && job->recommendations && job->recommendations[0]) {
+            ok = buffer_appendf(&prompt, "\n\nClient Guidance:\n%s", job->recommendations);
+        }
+        if (!ok || !prompt.data) {
+            buffer_free(&prompt);
+            if (error_out && !*error_out) {
+                *error_out = strdup("Out of memory");
+            }
+            return 0;
+        }
+
+        NarrativeTask *task = &tasks[*created];
+        task->system_prompt = REPORT_SECTION_SYSTEM_PROMPT;
+        task->prompt = prompt.data;
+        prompt.data = NULL;
+        buffer_free(&prompt);
+        task->slot = narrative_set_slot(narratives, spec);
+        task->error = NULL;
+        task->success = 0;
+        task->kind = NARRATIVE_TASK_SECTION;
+        task->device = NULL;
+        task->system_prompt_owned = NULL;
+        task->label = spec->title;
+        *created += 1;
+    }
+    return 1;
+}
+
+static int narrative_tasks_add_devices(NarrativeTask *tasks,
+                                       size_t slots,
+                                       size_t *created,
+                                       ReportData *report,
+                                       const ReportJob *job,
+                                       char **error_out) {
+    const char *consultant_type = determine_consultant_type(&report->summary);
+    for (size_t i = 0; i < report->devices.count; ++i) {
+        ReportDevice *device = &report->devices.items[i];
+        if (*created >= slots) {
+            if (error_out && !*error_out) {
+                *error_out = strdup("Task overflow");
+            }
+            return 0;
+        }
+        char *prompt_str = build_device_prompt(report, device, job, consultant_type);
+        char *system_prompt_device = prompt_str ? build_device_system_prompt(consultant_type) : NULL;
+        if (!prompt_str || !system_prompt_device) {
+            free(prompt_str);
+            if (error_out && !*error_out) {
+                *error_out = strdup("Out of memory");
+            }
+            return 0;
+        }
+
+        NarrativeTask *task = &tasks[*created];
+        task->system_prompt = system_prompt_device;
+        task->system_prompt_owned = system_prompt_device;
+        task->prompt = prompt_str;
+        task->slot = &device->narrative;
+        task->error = NULL;
+        task->success = 0;
+        task->kind = NARRATIVE_TASK_DEVICE;
+        task->device = device;
+        *created += 1;
+    }
+    return 1;
+}
+
+static void narrative_task_submit(NarrativeBatch *batch, NarrativeTask *task) {
+    task->request.system_prompt = task->system_prompt;
+    task->request.user_prompt = task->prompt;
+    narrative_batch_submit(batch, &task->request);
+}
+
+static char *build_device_group_system_prompt(const char *device_system_prompt, size_t count) {
+    Buffer buf;
+    if (!buffer_init(&buf)) {
+        return NULL;
+    }
+    if (!buffer_appendf(&buf,
+        "%s\n\nThis request covers %zu separate devices. Write an independent narrative for each device "
+        "following that device's own instructions, and never refer to one device in another device's narrative. "
+        "Begin each narrative with a line containing only [[DEVICE n]], where n is the device number, "
+        "and write nothing outside those sections.",
+        device_system_prompt ? device_system_prompt : "", count)) {
+        buffer_free(&buf);
+        return NULL;
+    }
+    char *prompt = buf.data;
+    buf.data = NULL;
+    buffer_free(&buf);
+    return prompt;
+}
+
+static char *build_device_group_prompt(NarrativeTask *const *members, size_t count) {
+    Buffer buf;
+    if (!buffer_init(&buf)) {
+        return NULL;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (!buffer_appendf(&buf, "=== Device %zu of %zu ===\n%s\n\n", i + 1, count, members[i]->prompt)) {
+            buffer_free(&buf);
+            return NULL;
+        }
+    }
+    if (!buffer_appendf(&buf, "Respond with exactly %zu sections, [[DEVICE 1]] through [[DEVICE %zu]], in order.\n", count, count)) {
+        buffer_free(&buf);
+        return NULL;
+    }
+    char *prompt = buf.data;
+    buf.data = NULL;
+    buffer_free(&buf);
+    return prompt;
+}
+
+/* Returns the device number when the line [line, end) is a [[DEVICE n]] marker, otherwise 0. */
+static size_t parse_device_group_marker(const char *line, const char *end) {
+    while (line < end && isspace((unsigned char)*line)) {
+        line++;
+    }
+    while (end > line && isspace((unsigned char)end[-1])) {
+        end--;
+    }
+    static const char prefix[] = "[[DEVICE ";
+    size_t prefix_len = sizeof(prefix) - 1;
+    if ((size_t)(end - line) < prefix_len + 3 || strncasecmp(line, prefix, prefix_len) != 0 || end[-1] != ']' || end[-2] != ']') {
+        return 0;
+    }
+    size_t number = 0;
+    for (const char *p = line + prefix_len; p < end - 2; ++p) {
+        if (!isdigit((unsigned char)*p) || number > 1000) {
+            return 0;
+        }
+        number = number * 10 + (size_t)(*p - '0');
+    }
+    return number;
+}
+
+/* Splits a grouped completion into one malloc'd narrative per device. Fails unless every
+   device from 1 to count appears exactly once with non-empty text and nothing but
+   whitespace precedes the first marker. */
+static int split_device_group_response(const char *response, size_t count, char **parts_out) {
+    for (size_t i = 0; i < count; ++i) {
+        parts_out[i] = NULL;
+    }
+    if (!response) {
+        return 0;
+    }
+    size_t current = 0;
+    const char *section_start = NULL;
+    const char *p = response;
+    for (;;) {
+        const char *line_end = strchr(p, '\n');
+        if (!line_end) {
+            line_end = p + strlen(p);
+        }
+        bool at_end = *line_end == '\0';
+        size_t marker = parse_device_group_marker(p, line_end);
+        if (marker || at_end) {
+            const char *section_end = marker ? p : line_end;
+            if (current) {
+                size_t len = (size_t)(section_end - section_start);
+                char *text = malloc(len + 1);
+                if (!text) {
+                    goto fail;
+                }
+                memcpy(text, section_start, len);
+                text[len] = '\0';
+                char *trimmed = trim_copy(text);
+                free(text);
+                if (!trimmed || !trimmed[0]) {
+                    free(trimmed);
+                    goto fail;
+                }
+                parts_out[current - 1] = trimmed;
+            } else {
+                for (const char *q = response; q < section_end; ++q) {
+                    if (!isspace((unsigned char)*q)) {
+                        goto fail;
+                    }
                 }
             }
-        } else if ((*p == 'o' || *p == 'O') && (p[1] == ' ' || p[1] == '\t')) {
-            bullet = true;
-            p += 2;
-            while (*p == ' ' || *p == '\t') {
-                p++;
-            }
-            if (*p == '*' && p[1] != '*') {
-                p++;
-                while (*p == ' ' || *p == '\t') {
-                    p++;
+            if (marker) {
+                if (marker > count || parts_out[marker - 1]) {
+                    goto fail;
                 }
+                current = marker;
+                section_start = at_end ? line_end : line_end + 1;
             }
         }
+        if (at_end) {
+            break;
+        }
+        p = line_end + 1;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (!parts_out[i]) {
+            goto fail;
+        }
+    }
+    return 1;
 
-        if (bullet) {
-            if (!in_list) {
-                ok = buffer_append_cstr(buf, "\\begin{itemize}\n");
-                in_list = true;
+fail:
+    for (size_t i = 0; i < count; ++i) {
+        free(parts_out[i]);
+        parts_out[i] = NULL;
+    }
+    return 0;
+}
+
+/* Packs pending device tasks into groups of up to g_narrative_device_batch_size. Tasks left
+   alone, or whose group cannot be built, are submitted individually. */
+static void narrative_tasks_group_devices(NarrativeBatch *batch,
+                                          NarrativeTask **pending,
+                                          size_t pending_count,
+                                          NarrativeDeviceGroup **groups_out,
+                                          size_t *group_count_out) {
+    size_t batch_size = g_narrative_device_batch_size > 1 ? (size_t)g_narrative_device_batch_size : 1;
+    size_t group_count = batch_size > 1 ? (pending_count + batch_size - 1) / batch_size : 0;
+    NarrativeDeviceGroup *groups = group_count > 0 ? calloc(group_count, sizeof(*groups)) : NULL;
+    if (!groups) {
+        for (size_t i = 0; i < pending_count; ++i) {
+            narrative_task_submit(batch, pending[i]);
+        }
+        return;
+    }
+
+    size_t built = 0;
+    size_t offset = 0;
+    for (size_t g = 0; g < group_count; ++g) {
+        /* Spread devices evenly so the last group is not left with a single straggler. */
+        size_t size = pending_count / group_count + (g < pending_count % group_count ? 1 : 0);
+        NarrativeTask **members = &pending[offset];
+        offset += size;
+        NarrativeDeviceGroup *group = &groups[built];
+        if (size > 1) {
+            group->members = malloc(size * sizeof(*group->members));
+            group->system_prompt = build_device_group_system_prompt(members[0]->system_prompt, size);
+            group->prompt = build_device_group_prompt(members, size);
+        }
+        if (size < 2 || !group->members || !group->system_prompt || !group->prompt) {
+            free(group->members);
+            free(group->system_prompt);
+            free(group->prompt);
+            memset(group, 0, sizeof(*group));
+            for (size_t i = 0; i < size; ++i) {
+                narrative_task_submit(batch, members[i]);
             }
-            if (ok) {
-                char *escaped = latex_escape_with_markdown(p);
-                if (!escaped) {
-                    ok = false;
-                } else {
-                    ok = buffer_appendf(buf, "  \\item %s\n", escaped);
-                    free(escaped);
-                }
+            continue;
+        }
+        memcpy(group->members, members, size * sizeof(*group->members));
+        group->count = size;
+        group->request.system_prompt = group->system_prompt;
+        group->request.user_prompt = group->prompt;
+        group->request.max_tokens = (int)size * NARRATIVE_GROUP_TOKENS_PER_DEVICE;
+        if (group->request.max_tokens < NARRATIVE_DEFAULT_MAX_TOKENS) {
+            group->request.max_tokens = NARRATIVE_DEFAULT_MAX_TOKENS;
+        }
+        narrative_batch_submit(batch, &group->request);
+        built++;
+    }
+    if (built == 0) {
+        free(groups);
+        return;
+    }
+    *groups_out = groups;
+    *group_count_out = built;
+}
+
+/* Marks tasks whose prompts are already cached as finished with the cached text; returns the hit count. */
+static size_t narrative_tasks_fill_cached(PGconn *conn, NarrativeTask *tasks, size_t count) {
+    if (!g_narrative_cache_enabled || count == 0) {
+        return 0;
+    }
+    const char **keys = calloc(count, sizeof(*keys));
+    char **responses = calloc(count, sizeof(*responses));
+    size_t hits = 0;
+    if (keys && responses) {
+        const char *model = narrative_model_name();
+        for (size_t i = 0; i < count; ++i) {
+            narrative_cache_key(g_narrative_cache_version, model, tasks[i].system_prompt, tasks[i].prompt, tasks[i].cache_key);
+            keys[i] = tasks[i].cache_key;
+        }
+        char *cache_error = NULL;
+        if (!db_narrative_cache_lookup(conn, keys, count, g_narrative_cache_max_age_days, responses, &hits, &cache_error)) {
+            log_error("Narrative cache lookup failed: %s", cache_error ? cache_error : "unknown error");
+            hits = 0;
+        }
+        free(cache_error);
+        for (size_t i = 0; i < count; ++i) {
+            if (!responses[i]) {
+                continue;
             }
+            tasks[i].cached = true;
+            tasks[i].request.response = responses[i];
+            tasks[i].request.success = 1;
+            tasks[i].request.finished = 1;
+        }
+    }
+    free(keys);
+    free(responses);
+    return hits;
+}
+
+/* Fills tasks whose prompts are already cached and hands the rest to the narrative pool. */
+static void narrative_tasks_dispatch(PGconn *conn,
+                                     NarrativeBatch *batch,
+                                     NarrativeTask *tasks,
+                                     size_t count,
+                                     NarrativeDeviceGroup **groups_out,
+                                     size_t *group_count_out) {
+    *groups_out = NULL;
+    *group_count_out = 0;
+    if (count == 0) {
+        return;
+    }
+    size_t hits = narrative_tasks_fill_cached(conn, tasks, count);
+
+    NarrativeTask **pending_devices = g_narrative_device_batch_size > 1 ? calloc(count, sizeof(*pending_devices)) : NULL;
+    size_t pending_count = 0;
+    for (size_t i = 0; i < count; ++i) {
+        NarrativeTask *task = &tasks[i];
+        if (task->cached) {
+            continue;
+        }
+        if (pending_devices && task->kind == NARRATIVE_TASK_DEVICE) {
+            pending_devices[pending_count++] = task;
+            continue;
+        }
+        narrative_task_submit(batch, task);
+    }
+    if (pending_count > 0) {
+        narrative_tasks_group_devices(batch, pending_devices, pending_count, groups_out, group_count_out);
+    }
+    if (g_narrative_cache_enabled) {
+        log_info("Narrative cache: %zu of %zu prompts served from cache", hits, count);
+    }
+    free(pending_devices);
+}
+
+/* Splits each finished group back into its member tasks. When retry_failures is set, the
+   members of groups whose completion failed or did not parse are resubmitted one device per
+   request on the returned batch; otherwise they are left unfinished. */
+static NarrativeBatch *narrative_groups_resolve(NarrativeDeviceGroup *groups, size_t count, bool retry_failures, bool background) {
+    NarrativeBatch *retry_batch = NULL;
+    for (size_t g = 0; groups && g < count; ++g) {
+        NarrativeDeviceGroup *group = &groups[g];
+        if (!group->request.finished) {
+            continue;
+        }
+        char **parts = calloc(group->count, sizeof(*parts));
+        bool split = parts && group->request.success &&
+                     split_device_group_response(group->request.response, group->count, parts);
+        if (split) {
+            for (size_t i = 0; i < group->count; ++i) {
+                group->members[i]->request.response = parts[i];
+                group->members[i]->request.success = 1;
+                group->members[i]->request.finished = 1;
+            }
+        } else if (retry_failures) {
+            log_info("Grouped narrative for %zu devices %s; retrying per device",
+                     group->count,
+                     group->request.success ? "did not parse" : "failed");
+            if (!retry_batch) {
+                retry_batch = background ? narrative_batch_create_background() : narrative_batch_create();
+            }
+            for (size_t i = 0; retry_batch && i < group->count; ++i) {
+                narrative_task_submit(retry_batch, group->members[i]);
+            }
+        }
+        free(parts);
+        free(group->request.response);
+        free(group->request.error);
+        group->request.response = NULL;
+        group->request.error = NULL;
+    }
+    return retry_batch;
+}
+
+static void narrative_groups_free(NarrativeDeviceGroup *groups, size_t count) {
+    if (!groups) {
+        return;
+    }
+    for (size_t g = 0; g < count; ++g) {
+        free(groups[g].request.response);
+        free(groups[g].request.error);
+        free(groups[g].members);
+        free(groups[g].system_prompt);
+        free(groups[g].prompt);
+    }
+    free(groups);
+}
+
+static int narrative_wait(NarrativeBatch *batch, int64_t deadline_ms) {
+    if (deadline_ms <= 0) {
+        narrative_batch_wait(batch);
+        return 1;
+    }
+    return narrative_batch_wait_until(batch, deadline_ms);
+}
+
+/* Completions that arrived after their job's deadline, waiting for a report worker to
+   write them to the narrative cache. */
+typedef struct LateNarrative {
+    char cache_key[SHA256_HEX_SIZE];
+    char *response;
+    struct LateNarrative *next;
+} LateNarrative;
+
+static pthread_mutex_t g_late_narrative_mutex = PTHREAD_MUTEX_INITIALIZER;
+static LateNarrative *g_late_narratives = NULL;
+
+static void late_narrative_push(const char *cache_key, char *response) {
+    LateNarrative *entry = calloc(1, sizeof(*entry));
+    if (!entry) {
+        free(response);
+        return;
+    }
+    memcpy(entry->cache_key, cache_key, SHA256_HEX_SIZE);
+    entry->response = response;
+    pthread_mutex_lock(&g_late_narrative_mutex);
+    entry->next = g_late_narratives;
+    g_late_narratives = entry;
+    pthread_mutex_unlock(&g_late_narrative_mutex);
+}
+
+static void late_narratives_flush(PGconn *conn) {
+    pthread_mutex_lock(&g_late_narrative_mutex);
+    LateNarrative *entry = g_late_narratives;
+    g_late_narratives = NULL;
+    pthread_mutex_unlock(&g_late_narrative_mutex);
+
+    size_t stored = 0;
+    const char *model = narrative_model_name();
+    while (entry) {
+        LateNarrative *next = entry->next;
+        char *cache_error = NULL;
+        if (db_narrative_cache_store(conn, entry->cache_key, model, g_narrative_cache_version, entry->response, &cache_error)) {
+            stored++;
         } else {
-            if (in_list) {
-                ok = buffer_append_cstr(buf, "\\end{itemize}\n\n");
-                in_list = false;
-            }
-            if (ok) {
-                char *escaped = latex_escape_with_markdown(trimmed);
-                if (!escaped) {
-                    ok = false;
+            log_error("Failed to cache late narrative: %s", cache_error ? cache_error : "unknown error");
+        }
+        free(cache_error);
+        free(entry->response);
+        free(entry);
+        entry = next;
+    }
+    if (stored > 0) {
+        log_info("Cached %zu narrative%s that finished after their report deadline", stored, stored == 1 ? "" : "s");
+    }
+}
+
+typedef struct {
+    NarrativeTask *tasks;
+    size_t task_count;
+    NarrativeDeviceGroup *groups;
+    size_t group_count;
+} NarrativeLateWork;
+
+/* Runs once every request of a released batch has finished: queues the late successes for
+   the cache and frees what the job left behind. */
+static void narrative_late_work_finish(NarrativeLateWork *work) {
+    bool cache = g_narrative_cache_enabled != 0;
+    for (size_t g = 0; g < work->group_count; ++g) {
+        NarrativeDeviceGroup *group = &work->groups[g];
+        if (!cache || !group->request.success || !group->request.response) {
+            continue;
+        }
+        char **parts = calloc(group->count, sizeof(*parts));
+        if (parts && split_device_group_response(group->request.response, group->count, parts)) {
+            for (size_t i = 0; i < group->count; ++i) {
+                if (group->members[i]->cache_key[0]) {
+                    late_narrative_push(group->members[i]->cache_key, parts[i]);
                 } else {
-                    ok = buffer_appendf(buf, "%s\n\n", escaped);
-                    free(escaped);
+                    free(parts[i]);
                 }
             }
         }
-
-        free(trimmed);
-        line = next;
+        free(parts);
     }
-
-    if (ok && in_list) {
-        ok = buffer_append_cstr(buf, "\\end{itemize}\n\n");
+    for (size_t i = 0; i < work->task_count; ++i) {
+        NarrativeTask *task = &work->tasks[i];
+        if (cache && task->request.success && task->request.response && !task->cached && task->cache_key[0]) {
+            late_narrative_push(task->cache_key, task->request.response);
+            task->request.response = NULL;
+        }
+        free(task->request.response);
+        free(task->request.error);
+        free(task->prompt);
+        free(task->error);
+        free(task->system_prompt_owned);
     }
+    free(work->tasks);
+    narrative_groups_free(work->groups, work->group_count);
+}
 
-    free(work);
-    free(clean);
-    return ok;
+static void narrative_late_work_drained(void *context) {
+    narrative_late_work_finish((NarrativeLateWork *)context);
+    free(context);
 }
 
-static void narrative_task_execute(NarrativeTask *task) {
-    if (!task) {
+/* Gives the tasks and groups still referenced by a timed-out batch to that batch. */
+static void narrative_tasks_hand_off(NarrativeBatch *late_batch,
+                                     NarrativeTask *tasks,
+                                     size_t task_count,
+                                     NarrativeDeviceGroup *groups,
+                                     size_t group_count) {
+    NarrativeLateWork *work = calloc(1, sizeof(*work));
+    if (!work) {
+        /* Nothing may be freed while requests still point at it, so wait them out instead. */
+        narrative_batch_wait(late_batch);
+        NarrativeLateWork local = { tasks, task_count, groups, group_count };
+        narrative_late_work_finish(&local);
         return;
     }
-    task->success = 0;
-    char *response = NULL;
-    char *error = NULL;
-    if (!generate_grok_completion(task->system_prompt, task->prompt, &response, &error)) {
-        task->error = error ? error : strdup("Narrative generation failed");
+    work->tasks = tasks;
+    work->task_count = task_count;
+    work->groups = groups;
+    work->group_count = group_count;
+    narrative_batch_release(late_batch, narrative_late_work_drained, work);
+}
+
+static void narrative_tasks_store(PGconn *conn, NarrativeTask *tasks, size_t count) {
+    if (!g_narrative_cache_enabled) {
+        return;
+    }
+    const char *model = narrative_model_name();
+    for (size_t i = 0; i < count; ++i) {
+        NarrativeTask *task = &tasks[i];
+        if (!task->success || task->cached || !task->cache_key[0] || !task->slot || !*(task->slot)) {
+            continue;
+        }
+        char *cache_error = NULL;
+        if (!db_narrative_cache_store(conn, task->cache_key, model, g_narrative_cache_version, *(task->slot), &cache_error)) {
+            log_error("Failed to cache narrative: %s", cache_error ? cache_error : "unknown error");
+            free(cache_error);
+            return;
+        }
+    }
+}
+
+static void narrative_task_collect(NarrativeTask *task) {
+    if (!task->request.finished) {
+        /* Still running (or never sent): the pool may yet write the request, so leave it be. */
+        task->success = 0;
+        task->late = true;
+        task->error = strdup("Narrative missed the report deadline");
         return;
     }
-    *(task->slot) = response;
-    task->success = 1;
+    task->success = task->request.success;
+    if (task->success) {
+        *(task->slot) = task->request.response;
+    } else {
+        free(task->request.response);
+        task->error = task->request.error ? task->request.error : strdup("Narrative generation failed");
+        task->request.error = NULL;
+    }
+    task->request.response = NULL;
 }
 
 static void normalize_heading_text(char *text) {
@@ -14892,42 +16757,6 @@ static void normalize_heading_text(char *text) {
     }
 }
 
-static char *format_closed_cell(const char *text, bool closed, const char *suffix) {
-    if (!text) {
-        text = "";
-    }
-    Buffer buf;
-    if (!buffer_init(&buf)) {
-        return NULL;
-    }
-    int ok = 1;
-    if (closed) {
-        ok = ok && buffer_append_cstr(&buf, "\\ClosedText{") && buffer_append_cstr(&buf, text) && buffer_append_cstr(&buf, "}");
-    } else {
-        ok = ok && buffer_append_cstr(&buf, text);
-    }
-    if (ok && suffix && suffix[0]) {
-        ok = buffer_append_cstr(&buf, " ") && buffer_append_cstr(&buf, suffix);
-    }
-    if (!ok) {
-        buffer_free(&buf);
-        return NULL;
-    }
-    char *out = buf.data;
-    buf.data = NULL;
-    buffer_free(&buf);
-    if (!out) {
-        out = strdup("");
-    }
-    return out;
-}
-
-static void *narrative_thread_main(void *arg) {
-    NarrativeTask *task = (NarrativeTask *)arg;
-    narrative_task_execute(task);
-    return NULL;
-}
-
 static int append_narrative_section(Buffer *buf, const char *title, const char *content) {
     if (!buf || !title) {
         return 0;
@@ -15203,44 +17032,8 @@ static int build_location_overview_tex(const ReportJob *job,
     long service_bucket_counts[SERVICE_BUCKET_COUNT] = {0};
 
     fail_stage = "writing cover page";
-    if (!buffer_append_cstr(&buf,
-        "\\documentclass[12pt]{article}\n"
-        "\\usepackage{geometry}\n"
-        "\\usepackage{booktabs}\n"
-        "\\usepackage{array}\n"
-        "\\usepackage{longtable}\n"
-        "\\usepackage{xcolor}\n"
-        "\\usepackage{graphicx}\n"
-        "\\usepackage{hyperref}\n"
-        "\\usepackage{tikz}\n"
-        "\\usepackage{pgfplots}\n"
-        "\\usepackage{pgfplotstable}\n"
-        "\\usepackage{tabularx}\n"
-        "\\usepackage[most]{tcolorbox}\n"
-        "\\usepackage{textcomp}\n"
-        "\\usepackage{helvet}\n"
-        "\\pgfplotsset{compat=1.18}\n"
-        "\\usepgfplotslibrary{colorbrewer}\n"
-        "\\definecolor{Set2-1}{HTML}{66C2A5}\n"
-        "\\definecolor{Set2-2}{HTML}{FC8D62}\n"
-        "\\definecolor{Set2-3}{HTML}{8DA0CB}\n"
-        "\\definecolor{Set2-4}{HTML}{E78AC3}\n"
-        "\\definecolor{Set2-5}{HTML}{A6D854}\n"
-        "\\definecolor{Set2-6}{HTML}{FFD92F}\n"
-        "\\definecolor{Set3-4}{HTML}{FB8072}\n"
-        "\\definecolor{CalloutAlert}{HTML}{F94144}\n"
-        "\\definecolor{CalloutWarning}{HTML}{F3722C}\n"
-        "\\definecolor{CalloutInfo}{HTML}{577590}\n"
-        "\\definecolor{CalloutPositive}{HTML}{43AA8B}\n"
-        "\\definecolor{AccentPrimary}{HTML}{1F2933}\n"
-        "\\definecolor{AccentSecondary}{HTML}{3D5AFE}\n"
-        "\\definecolor{NeutralLight}{HTML}{F5F7FA}\n"
-        "\\definecolor{NeutralBorder}{HTML}{D5DBE5}\n"
-        "\\renewcommand{\\familydefault}{\\sfdefault}\n"
-        "\\newcommand{\\sectiondivider}{\\noindent\\color{AccentPrimary}\\rule{\\textwidth}{0.8pt}\\par\\medskip}\n"
-        "\\geometry{margin=1in}\n"
-        "\\hypersetup{colorlinks=false}\n"
-        "\\begin{document}\n\n")) goto cleanup;
+    if (!append_latex_preamble(&buf, &g_overview_latex_format)) goto cleanup;
+    if (!buffer_append_cstr(&buf, "\\begin{document}\n\n")) goto cleanup;
 
     if (!buffer_append_cstr(&buf, "\\begin{titlepage}\n\\centering\n")) goto cleanup;
     if (!buffer_append_cstr(&buf, "\\vspace*{1cm}\n")) goto cleanup;
@@ -15597,7 +17390,7 @@ static int build_location_overview_tex(const ReportJob *job,
                     goto cleanup;
                 }
                 free(label_tex);
-                if (!buffer_appendf(&buf, "%.2f", hours_clamped)) {
+                if (!buffer_append_fixed(&buf, hours_clamped, 2)) {
                     log_error("Failed to append service activity hours (label=%s, hours=%.4f)", label ? label : "Unknown", hours_clamped);
                     goto cleanup;
                 }
@@ -16307,7 +18100,7 @@ static int build_location_overview_tex(const ReportJob *job,
             free(range_tex);
 
             if (isfinite(win->tickets_per_device)) {
-                if (!buffer_appendf(&buf, "%.2f", win->tickets_per_device)) goto cleanup;
+                if (!buffer_append_fixed(&buf, win->tickets_per_device, 2)) goto cleanup;
             } else {
                 if (!buffer_append_cstr(&buf, "—")) goto cleanup;
             }
@@ -16335,7 +18128,7 @@ static int build_location_overview_tex(const ReportJob *job,
             if (!buffer_append_cstr(&buf, " & ")) goto cleanup;
 
             if (isfinite(win->open_per_device)) {
-                if (!buffer_appendf(&buf, "%.2f", win->open_per_device)) goto cleanup;
+                if (!buffer_append_fixed(&buf, win->open_per_device, 2)) goto cleanup;
             } else {
                 if (!buffer_append_cstr(&buf, "—")) goto cleanup;
             }
@@ -16460,14 +18253,101 @@ cleanup:
     return success;
 }
 
+/* Cover street on one line, "City, ST zip" on the next; *out stays NULL when the job has no cover address. */
+static int build_cover_address_plain(const ReportJob *job, char **out) {
+    *out = NULL;
+    if (!((job->cover_street && job->cover_street[0]) ||
+        (job->cover_city && job->cover_city[0]) ||
+        (job->cover_state && job->cover_state[0]) ||
+        (job->cover_zip && job->cover_zip[0]))) {
+        return 1;
+    }
+    Buffer cover_buf;
+    if (!buffer_init(&cover_buf)) {
+        return 0;
+    }
+    int cover_ok = 1;
+
+    if (job->cover_street && job->cover_street[0]) {
+        char *street_clean = sanitize_ascii(job->cover_street);
+        const char *street_text = street_clean ? street_clean : job->cover_street;
+        if (!buffer_appendf(&cover_buf, "%s", street_text)) {
+            cover_ok = 0;
+        }
+        free(street_clean);
+    }
+
+    bool have_city = job->cover_city && job->cover_city[0];
+    bool have_state = job->cover_state && job->cover_state[0];
+    bool have_zip = job->cover_zip && job->cover_zip[0];
+    if (cover_ok && (have_city || have_state || have_zip)) {
+        if (cover_buf.length > 0) {
+            if (!buffer_append_char(&cover_buf, '\n')) {
+                cover_ok = 0;
+            }
+        }
+        bool wrote_any = false;
+        if (cover_ok && have_city) {
+            char *city_clean = sanitize_ascii(job->cover_city);
+            const char *city_text = city_clean ? city_clean : job->cover_city;
+            if (!buffer_appendf(&cover_buf, "%s", city_text)) {
+                cover_ok = 0;
+            }
+            free(city_clean);
+            wrote_any = cover_ok ? true : wrote_any;
+        }
+        if (cover_ok && have_state) {
+            if (wrote_any) {
+                if (!buffer_append_cstr(&cover_buf, ", ")) {
+                    cover_ok = 0;
+                }
+            }
+            if (cover_ok) {
+                char *state_clean = sanitize_ascii(job->cover_state);
+                const char *state_text = state_clean ? state_clean : job->cover_state;
+                if (!buffer_appendf(&cover_buf, "%s", state_text)) {
+                    cover_ok = 0;
+                }
+                free(state_clean);
+            }
+            wrote_any = cover_ok ? true : wrote_any;
+        }
+        if (cover_ok && have_zip) {
+            if (wrote_any) {
+                if (!buffer_append_char(&cover_buf, ' ')) {
+                    cover_ok = 0;
+                }
+            }
+            if (cover_ok) {
+                char *zip_clean = sanitize_ascii(job->cover_zip);
+                const char *zip_text = zip_clean ? zip_clean : job->cover_zip;
+                if (!buffer_appendf(&cover_buf, "%s", zip_text)) {
+                    cover_ok = 0;
+                }
+                free(zip_clean);
+            }
+        }
+    }
+
+    if (!cover_ok) {
+        buffer_free(&cover_buf);
+        return 0;
+    }
+    *out = cover_buf.data;
+    cover_buf.data = NULL;
+    buffer_free(&cover_buf);
+    return 1;
+}
+
 static int build_report_latex(PGconn *conn,
                               const ReportData *report,
                               const NarrativeSet *narratives,
                               const ReportJob *job,
                               const LocationProfile *profile,
+                              LatexFragmentStats *fragments,
                               const char *output_path,
                               char **error_out) {
-    if (!conn || !report || !narratives || !job || !output_path) {
+    if (!conn || !report || !narratives || !job || !fragments || !output_path) {
         if (error_out && !*error_out) {
             *error_out = strdup("Invalid report parameters");
         }
@@ -16507,12 +18387,9 @@ static int build_report_latex(PGconn *conn,
     const char *address_src = (report->summary.building_address && report->summary.building_address[0])
         ? report->summary.building_address
         : (job->address && job->address[0] ? job->address : "Unknown address");
-    char *address_case = normalize_caps_if_all_upper(address_src);
-    const char *address_source = address_case ? address_case : address_src;
-    address_clean = sanitize_ascii(address_source);
-    const char *address_text = address_clean ? address_clean : address_source;
+    address_clean = sanitize_ascii_caps(address_src);
+    const char *address_text = address_clean ? address_clean : address_src;
     address_tex = latex_escape(address_text);
-    free(address_case);
     if (!address_tex) goto cleanup;
 
     const char *owner_src = (report->summary.building_owner && report->summary.building_owner[0])
@@ -16551,86 +18428,10 @@ static int build_report_latex(PGconn *conn,
     } else {
         snprintf(date_range_buf, sizeof(date_range_buf), "—");
     }
-    date_range_tex = latex_escape(date_range_buf);
-    if (!date_range_tex) goto cleanup;
-
-    if ((job->cover_street && job->cover_street[0]) ||
-        (job->cover_city && job->cover_city[0]) ||
-        (job->cover_state && job->cover_state[0]) ||
-        (job->cover_zip && job->cover_zip[0])) {
-        Buffer cover_buf;
-        if (!buffer_init(&cover_buf)) goto cleanup;
-        int cover_ok = 1;
-
-        if (job->cover_street && job->cover_street[0]) {
-            char *street_clean = sanitize_ascii(job->cover_street);
-            const char *street_text = street_clean ? street_clean : job->cover_street;
-            if (!buffer_appendf(&cover_buf, "%s", street_text)) {
-                cover_ok = 0;
-            }
-            free(street_clean);
-        }
-
-        bool have_city = job->cover_city && job->cover_city[0];
-        bool have_state = job->cover_state && job->cover_state[0];
-        bool have_zip = job->cover_zip && job->cover_zip[0];
-        if (cover_ok && (have_city || have_state || have_zip)) {
-            if (cover_buf.length > 0) {
-                if (!buffer_append_char(&cover_buf, '\n')) {
-                    cover_ok = 0;
-                }
-            }
-            bool wrote_any = false;
-            if (cover_ok && have_city) {
-                char *city_clean = sanitize_ascii(job->cover_city);
-                const char *city_text = city_clean ? city_clean : job->cover_city;
-                if (!buffer_appendf(&cover_buf, "%s", city_text)) {
-                    cover_ok = 0;
-                }
-                free(city_clean);
-                wrote_any = cover_ok ? true : wrote_any;
-            }
-            if (cover_ok && have_state) {
-                if (wrote_any) {
-                    if (!buffer_append_cstr(&cover_buf, ", ")) {
-                        cover_ok = 0;
-                    }
-                }
-                if (cover_ok) {
-                    char *state_clean = sanitize_ascii(job->cover_state);
-                    const char *state_text = state_clean ? state_clean : job->cover_state;
-                    if (!buffer_appendf(&cover_buf, "%s", state_text)) {
-                        cover_ok = 0;
-                    }
-                    free(state_clean);
-                }
-                wrote_any = cover_ok ? true : wrote_any;
-            }
-            if (cover_ok && have_zip) {
-                if (wrote_any) {
-                    if (!buffer_append_char(&cover_buf, ' ')) {
-                        cover_ok = 0;
-                    }
-                }
-                if (cover_ok) {
-                    char *zip_clean = sanitize_ascii(job->cover_zip);
-                    const char *zip_text = zip_clean ? zip_clean : job->cover_zip;
-                    if (!buffer_appendf(&cover_buf, "%s", zip_text)) {
-                        cover_ok = 0;
-                    }
-                    free(zip_clean);
-                }
-            }
-        }
-
-        if (!cover_ok) {
-            buffer_free(&cover_buf);
-            goto cleanup;
-        }
-        cover_address_plain = cover_buf.data;
-        cover_buf.data = NULL;
-        buffer_free(&cover_buf);
-    }
+    date_range_tex = latex_escape(date_range_buf);
+    if (!date_range_tex) goto cleanup;
+
+    if (!build_cover_address_plain(job, &cover_address_plain)) goto cleanup;
 
     client_name_env = trim_copy(getenv("REPORT_CLIENT_NAME"));
     const char *client_name_src = NULL;
@@ -16700,35 +18501,7 @@ static int build_report_latex(PGconn *conn,
     free(asset_location_clean);
     if (!asset_location_tex) goto cleanup;
 
-    if (!buffer_append_cstr(&buf,
-        "\\PassOptionsToPackage{table}{xcolor}\n"
-        "\\documentclass[12pt]{article}\n"
-        "\\usepackage[utf8]{inputenc}\n"
-        "\\usepackage[T1]{fontenc}\n"
-        "\\usepackage{geometry}\n"
-        "\\usepackage{fancyhdr}\n"
-        "\\usepackage{graphicx}\n"
-        "\\usepackage{datetime}\n"
-        "\\usepackage{hyperref}\n"
-        "\\usepackage{etoolbox}\n"
-        "\\usepackage{array}\n"
-        "\\usepackage{helvet}\n"
-        "\\usepackage{tabularx}\n"
-        "\\usepackage{booktabs}\n"
-        "\\usepackage{pgfplots}\n"
-        "\\usepackage{tikz}\n"
-        "\\usepackage{lmodern}\n"
-        "\\usepackage{xcolor}\n"
-        "\\usepackage{float}\n"
-        "\\usepackage{eso-pic}\n"
-        "\\geometry{a4paper, left=0.5in, right=0.5in, top=1in, bottom=1in}\n"
-        "\\setlength{\\headheight}{26pt}\n"
-        "\\pgfplotsset{compat=1.18}\n"
-        "\\graphicspath{{./}{./assets/}}\n"
-        "\\usepgfplotslibrary{colorbrewer}\n"
-        "\\definecolor{tabblue}{RGB}{31,119,180}\n"
-        "\\definecolor{CitywideAccent}{HTML}{46A6B4}\n"
-        "\\newcommand{\\generatedtimestamp}{\\today~\\currenttime}\n")) goto cleanup;
+    if (!append_latex_preamble(&buf, &g_report_latex_format)) goto cleanup;
 
     if (!buffer_append_cstr(&buf, "\\newcommand{\\clientname}{")) goto cleanup;
     if (!buffer_appendf(&buf, "%s", client_name_tex)) goto cleanup;
@@ -16887,109 +18660,977 @@ static int build_report_latex(PGconn *conn,
                 }
                 free(device_id_tex);
 
-                if (!append_device_deficiencies(&buf, device, true, true)) goto cleanup;
+                if (!append_device_deficiencies(&buf, device, true, true, fragments)) goto cleanup;
+            }
+        }
+
+        goto finalize;
+    }
+
+    if (!buffer_append_cstr(&buf, "\\section{Executive Summary}\n\n")) goto cleanup;
+    if (!buffer_append_cstr(&buf, "\\subsection{Overview}\n")) goto cleanup;
+    if (!append_narrative_block(&buf, narratives->executive_summary)) goto cleanup;
+    if (!buffer_append_cstr(&buf, "\\subsection{Key Findings}\n")) goto cleanup;
+    if (!append_narrative_block(&buf, narratives->key_findings)) goto cleanup;
+
+    if (!buffer_append_cstr(&buf, "\\section{Scope of Work}\n\n")) goto cleanup;
+    if (!buffer_append_cstr(&buf, "\\subsection{Methodology}\n")) goto cleanup;
+    if (!append_narrative_block(&buf, narratives->methodology)) goto cleanup;
+    if (!buffer_append_cstr(&buf,
+        "\\subsection{Audit Process}\n"
+        "The audit process involved a comprehensive evaluation of all elevator equipment, including mechanical components, electrical systems, safety devices, and maintenance records. Each device was inspected according to applicable codes and industry standards.\n\n")) goto cleanup;
+
+    if (!buffer_append_cstr(&buf,
+        "\\section{Equipment Summary}\n\n"
+        "\\subsection{General Equipment Condition}\n"
+        "The following analysis provides an overview of the equipment condition across all devices inspected.\n\n")) goto cleanup;
+
+    if (!buffer_append_cstr(&buf, "\\begin{center}\n\\begin{tabular}{ll}\n\\toprule\n\\textbf{Metric} & \\textbf{Value} \\\\ \\midrule\n")) goto cleanup;
+
+    char number_buf[NUMBER_FORMAT_MAX];
+    if (!buffer_appendf(&buf, "Address & %s \\\\ \n", address_tex)) goto cleanup;
+    if (!buffer_appendf(&buf, "Owner & %s \\\\ \n", owner_tex)) goto cleanup;
+    if (!buffer_appendf(&buf, "Elevator Contractor & %s \\\\ \n", contractor_tex)) goto cleanup;
+    if (!buffer_appendf(&buf, "Audit Date Range & %s \\\\ \n", date_range_tex)) goto cleanup;
+    format_int64(number_buf, report->summary.total_devices);
+    if (!buffer_appendf(&buf, "Total Devices & %s \\\\ \n", number_buf)) goto cleanup;
+    format_int64(number_buf, report->summary.audit_count);
+    if (!buffer_appendf(&buf, "Audit Count & %s \\\\ \n", number_buf)) goto cleanup;
+    format_int64(number_buf, report->summary.total_deficiencies);
+    if (!buffer_appendf(&buf, "Total Deficiencies & %s \\\\ \n", number_buf)) goto cleanup;
+    format_double_fixed(number_buf, report->summary.average_deficiencies_per_device, 2, false);
+    if (!buffer_appendf(&buf, "Average Deficiencies / Device & %s \\\\ \n", number_buf)) goto cleanup;
+
+    if (!buffer_append_cstr(&buf, "\\bottomrule\n\\end{tabular}\n\\end{center}\n\n")) goto cleanup;
+    if (!buffer_append_cstr(&buf, "These metrics summarize all submissions included in this report and frame the analyses that follow.\n\n")) goto cleanup;
+
+    if (!buffer_append_cstr(&buf, "\\subsection{Deficiency Patterns}\n")) goto cleanup;
+    if (!append_deficiency_code_chart(&buf, report, fragments)) goto cleanup;
+    if (!append_deficiencies_per_device_chart(&buf, report, fragments)) goto cleanup;
+    if (!append_controller_age_chart(&buf, report, fragments)) goto cleanup;
+
+    if (!append_service_summary_section(&buf, conn, job, profile, error_out)) goto cleanup;
+    if (!append_financial_summary_section(&buf, conn, job, profile, error_out)) goto cleanup;
+
+    if (!append_device_sections(&buf, report, fragments)) goto cleanup;
+    if (!buffer_append_cstr(&buf, "\\newpage\n")) goto cleanup;
+
+    if (!append_narrative_section(&buf, "Maintenance Performance", narratives->maintenance_performance)) goto cleanup;
+    if (!append_narrative_section(&buf, "Recommendations", narratives->recommendations)) goto cleanup;
+    if (!append_narrative_section(&buf, "Conclusion", narratives->conclusion)) goto cleanup;
+
+finalize:
+    if (!buffer_append_cstr(&buf, "\\end{document}\n")) goto cleanup;
+
+    if (write_buffer_to_file(output_path, buf.data, buf.length) != 0) {
+        if (error_out && !*error_out) {
+            char *msg = malloc(128);
+            if (msg) {
+                snprintf(msg, 128, "Failed to write %s: %s", output_path, strerror(errno));
+                *error_out = msg;
+            }
+        }
+        goto cleanup;
+    }
+
+    success = 1;
+
+cleanup:
+    free(address_clean);
+    free(address_tex);
+    free(owner_clean);
+    free(owner_tex);
+    free(contractor_clean);
+    free(contractor_tex);
+    free(city_clean);
+    free(city_tex);
+    free(date_range_tex);
+    free(client_name_env);
+    free(client_name_tex);
+    free(client_address_env);
+    free(client_address_tex);
+    free(contact_name_env);
+    free(contact_name_tex);
+    free(contact_email_env);
+    free(contact_email_tex);
+    free(asset_location_tex);
+    free(cover_address_plain);
+    buffer_free(&buf);
+    if (!success && error_out && !*error_out) {
+        *error_out = strdup("Failed to build LaTeX report");
+    }
+    return success;
+}
+
+
+typedef struct {
+    PdfDocument *doc;
+    int logo; /* square.png, -1 when the asset is unavailable */
+    const char *client_name;
+    const char *asset_location;
+    const char *generated;
+    double y; /* next baseline, in points from the bottom edge */
+} DeficiencyPdfLayout;
+
+static const PdfColor DEFICIENCY_PDF_TEXT = {0.0, 0.0, 0.0};
+static const PdfColor DEFICIENCY_PDF_MUTED = {0.5, 0.5, 0.5};
+static const PdfColor DEFICIENCY_PDF_ACCENT = {70.0 / 255.0, 166.0 / 255.0, 180.0 / 255.0};
+static const PdfColor DEFICIENCY_PDF_ACCENT_FADED = {162.5 / 255.0, 210.5 / 255.0, 217.5 / 255.0};
+static const PdfColor DEFICIENCY_PDF_DIVIDER = {31.0 / 255.0, 41.0 / 255.0, 51.0 / 255.0};
+static const PdfColor DEFICIENCY_PDF_ROW = {238.0 / 255.0, 242.0 / 255.0, 247.0 / 255.0};
+
+/* Page chrome mirrors the LaTeX deficiency list: watermark, header logo, timestamp and footer. */
+static int deficiency_pdf_new_page(DeficiencyPdfLayout *layout) {
+    PdfDocument *doc = layout->doc;
+    if (!pdf_begin_page(doc)) {
+        return 0;
+    }
+    const double width = PDF_A4_WIDTH;
+    const double height = PDF_A4_HEIGHT;
+    if (layout->logo >= 0) {
+        double mark = width * 1.1;
+        if (!pdf_draw_image(doc, layout->logo, (width - mark) / 2.0, (height - mark) / 2.0, mark, mark, 0.07)) {
+            return 0;
+        }
+        double icon = (width - 2.0 * DEFICIENCY_PDF_MARGIN_X) * 0.065;
+        if (!pdf_draw_image(doc, layout->logo, width - DEFICIENCY_PDF_MARGIN_X - icon,
+                            height - DEFICIENCY_PDF_MARGIN_TOP + 12.0, icon, icon, 1.0)) {
+            return 0;
+        }
+    }
+
+    char banner[128];
+    snprintf(banner, sizeof(banner), "Generated on %s", layout->generated);
+    double banner_width = pdf_text_width(PDF_FONT_REGULAR, 14.0, banner);
+    if (!pdf_draw_text(doc, PDF_FONT_REGULAR, 14.0, (width - banner_width) / 2.0, height - 38.0,
+                       DEFICIENCY_PDF_ACCENT_FADED, banner)) {
+        return 0;
+    }
+
+    char generated_line[96];
+    snprintf(generated_line, sizeof(generated_line), "Generated %s", layout->generated);
+    const char *footer[] = {layout->client_name, layout->asset_location, generated_line};
+    for (size_t i = 0; i < 3; ++i) {
+        if (!pdf_draw_text(doc, PDF_FONT_REGULAR, 6.0, DEFICIENCY_PDF_MARGIN_X, 46.0 - 7.0 * (double)i,
+                           DEFICIENCY_PDF_ACCENT, footer[i])) {
+            return 0;
+        }
+    }
+    char page_number[16];
+    snprintf(page_number, sizeof(page_number), "%zu", pdf_page_count(doc));
+    double number_width = pdf_text_width(PDF_FONT_REGULAR, 10.0, page_number);
+    if (!pdf_draw_text(doc, PDF_FONT_REGULAR, 10.0, width - DEFICIENCY_PDF_MARGIN_X - number_width, 36.0,
+                       DEFICIENCY_PDF_TEXT, page_number)) {
+        return 0;
+    }
+
+    layout->y = height - DEFICIENCY_PDF_MARGIN_TOP;
+    return 1;
+}
+
+/* Starts a new page unless `needed` points still fit above the bottom margin. */
+static int deficiency_pdf_reserve(DeficiencyPdfLayout *layout, double needed) {
+    if (layout->y - needed >= DEFICIENCY_PDF_MARGIN_BOTTOM) {
+        return 1;
+    }
+    return deficiency_pdf_new_page(layout);
+}
+
+static int deficiency_pdf_paragraph(DeficiencyPdfLayout *layout, PdfFont font, double size, const char *text, double space_after) {
+    const double text_width = PDF_A4_WIDTH - 2.0 * DEFICIENCY_PDF_MARGIN_X;
+    const double leading = size * 1.25;
+    StringArray lines;
+    string_array_init(&lines);
+    int ok = pdf_wrap_text(font, size, text, text_width, &lines);
+    for (size_t i = 0; ok && i < lines.count; ++i) {
+        ok = deficiency_pdf_reserve(layout, leading) &&
+             pdf_draw_text(layout->doc, font, size, DEFICIENCY_PDF_MARGIN_X, layout->y - size, DEFICIENCY_PDF_TEXT, lines.values[i]);
+        layout->y -= leading;
+    }
+    layout->y -= space_after;
+    string_array_clear(&lines);
+    return ok;
+}
+
+/* Headings keep at least `keep` points of the following content on the same page. */
+static int deficiency_pdf_heading(DeficiencyPdfLayout *layout, double size, const char *text, double keep) {
+    layout->y -= size * 0.6;
+    return deficiency_pdf_reserve(layout, size * 1.25 + keep) &&
+           deficiency_pdf_paragraph(layout, PDF_FONT_BOLD, size, text, size * 0.4);
+}
+
+static int deficiency_pdf_labeled(DeficiencyPdfLayout *layout, const char *label, const char *value) {
+    const double size = 11.0;
+    const double leading = size * 1.25;
+    double label_width = pdf_text_width(PDF_FONT_BOLD, size, label);
+    double value_x = DEFICIENCY_PDF_MARGIN_X + label_width;
+    StringArray lines;
+    string_array_init(&lines);
+    int ok = pdf_wrap_text(PDF_FONT_REGULAR, size, value, PDF_A4_WIDTH - DEFICIENCY_PDF_MARGIN_X - value_x, &lines);
+    for (size_t i = 0; ok && i < lines.count; ++i) {
+        ok = deficiency_pdf_reserve(layout, leading) &&
+             (i > 0 || pdf_draw_text(layout->doc, PDF_FONT_BOLD, size, DEFICIENCY_PDF_MARGIN_X, layout->y - size, DEFICIENCY_PDF_TEXT, label)) &&
+             pdf_draw_text(layout->doc, PDF_FONT_REGULAR, size, value_x, layout->y - size, DEFICIENCY_PDF_TEXT, lines.values[i]);
+        layout->y -= leading;
+    }
+    string_array_clear(&lines);
+    return ok;
+}
+
+#define DEFICIENCY_PDF_COLUMNS 4
+#define DEFICIENCY_PDF_TABLE_SIZE 9.5
+#define DEFICIENCY_PDF_CELL_PAD 3.0
+
+typedef struct {
+    StringArray lines[DEFICIENCY_PDF_COLUMNS];
+    size_t line_count;
+    bool closed;
+    bool shaded;
+} DeficiencyPdfRow;
+
+static void deficiency_pdf_columns(double x_out[DEFICIENCY_PDF_COLUMNS], double width_out[DEFICIENCY_PDF_COLUMNS]) {
+    const double text_width = PDF_A4_WIDTH - 2.0 * DEFICIENCY_PDF_MARGIN_X;
+    const double fractions[DEFICIENCY_PDF_COLUMNS - 1] = {0.18, 0.18, 0.18};
+    double x = DEFICIENCY_PDF_MARGIN_X;
+    double used = 0.0;
+    for (size_t i = 0; i < DEFICIENCY_PDF_COLUMNS; ++i) {
+        double width = i + 1 < DEFICIENCY_PDF_COLUMNS ? text_width * fractions[i] : text_width - used;
+        x_out[i] = x;
+        width_out[i] = width;
+        x += width;
+        used += width;
+    }
+}
+
+static int deficiency_pdf_table_header(DeficiencyPdfLayout *layout) {
+    static const char *const titles[DEFICIENCY_PDF_COLUMNS] = {"Equipment", "Condition", "Remedy", "Note"};
+    const double size = DEFICIENCY_PDF_TABLE_SIZE;
+    const double right = PDF_A4_WIDTH - DEFICIENCY_PDF_MARGIN_X;
+    double x[DEFICIENCY_PDF_COLUMNS];
+    double width[DEFICIENCY_PDF_COLUMNS];
+    deficiency_pdf_columns(x, width);
+    if (!pdf_draw_line(layout->doc, DEFICIENCY_PDF_MARGIN_X, layout->y, right, layout->y, 0.8, DEFICIENCY_PDF_TEXT)) {
+        return 0;
+    }
+    layout->y -= DEFICIENCY_PDF_CELL_PAD;
+    for (size_t i = 0; i < DEFICIENCY_PDF_COLUMNS; ++i) {
+        if (!pdf_draw_text(layout->doc, PDF_FONT_BOLD, size, x[i] + DEFICIENCY_PDF_CELL_PAD, layout->y - size,
+                           DEFICIENCY_PDF_TEXT, titles[i])) {
+            return 0;
+        }
+    }
+    layout->y -= size * 1.25 + DEFICIENCY_PDF_CELL_PAD;
+    return pdf_draw_line(layout->doc, DEFICIENCY_PDF_MARGIN_X, layout->y, right, layout->y, 0.5, DEFICIENCY_PDF_TEXT);
+}
+
+/* Draws a row, carrying it onto following pages (with the header repeated) when it cannot fit. */
+static int deficiency_pdf_table_row(DeficiencyPdfLayout *layout, const DeficiencyPdfRow *row) {
+    const double size = DEFICIENCY_PDF_TABLE_SIZE;
+    const double leading = size * 1.25;
+    const double header_height = leading + 2.0 * DEFICIENCY_PDF_CELL_PAD;
+    const double page_room = PDF_A4_HEIGHT - DEFICIENCY_PDF_MARGIN_TOP - DEFICIENCY_PDF_MARGIN_BOTTOM - header_height;
+    double x[DEFICIENCY_PDF_COLUMNS];
+    double width[DEFICIENCY_PDF_COLUMNS];
+    deficiency_pdf_columns(x, width);
+
+    double row_height = (double)row->line_count * leading + 2.0 * DEFICIENCY_PDF_CELL_PAD;
+    if (layout->y - row_height < DEFICIENCY_PDF_MARGIN_BOTTOM && row_height <= page_room) {
+        if (!deficiency_pdf_new_page(layout) || !deficiency_pdf_table_header(layout)) {
+            return 0;
+        }
+    }
+
+    size_t start = 0;
+    while (start < row->line_count) {
+        double room = layout->y - DEFICIENCY_PDF_MARGIN_BOTTOM - 2.0 * DEFICIENCY_PDF_CELL_PAD;
+        size_t fit = room > 0.0 ? (size_t)(room / leading) : 0;
+        if (fit == 0) {
+            if (!deficiency_pdf_new_page(layout) || !deficiency_pdf_table_header(layout)) {
+                return 0;
+            }
+            continue;
+        }
+        size_t chunk = row->line_count - start < fit ? row->line_count - start : fit;
+        double chunk_height = (double)chunk * leading + 2.0 * DEFICIENCY_PDF_CELL_PAD;
+        if (row->shaded &&
+            !pdf_fill_rect(layout->doc, DEFICIENCY_PDF_MARGIN_X, layout->y - chunk_height,
+                           PDF_A4_WIDTH - 2.0 * DEFICIENCY_PDF_MARGIN_X, chunk_height, DEFICIENCY_PDF_ROW)) {
+            return 0;
+        }
+        for (size_t col = 0; col < DEFICIENCY_PDF_COLUMNS; ++col) {
+            const StringArray *lines = &row->lines[col];
+            for (size_t i = start; i < start + chunk && i < lines->count; ++i) {
+                const char *text = lines->values[i];
+                double baseline = layout->y - DEFICIENCY_PDF_CELL_PAD - (double)(i - start) * leading - size;
+                double text_x = x[col] + DEFICIENCY_PDF_CELL_PAD;
+                /* The note column ends with an unstruck "(Closed)" marker line for closed items. */
+                bool marker = row->closed && col + 1 == DEFICIENCY_PDF_COLUMNS && i + 1 == lines->count;
+                PdfColor color = row->closed ? DEFICIENCY_PDF_MUTED : DEFICIENCY_PDF_TEXT;
+                if (!pdf_draw_text(layout->doc, PDF_FONT_REGULAR, size, text_x, baseline, color, text)) {
+                    return 0;
+                }
+                if (row->closed && !marker && text[0] &&
+                    !pdf_draw_line(layout->doc, text_x, baseline + size * 0.3,
+                                   text_x + pdf_text_width(PDF_FONT_REGULAR, size, text), baseline + size * 0.3,
+                                   0.4, DEFICIENCY_PDF_MUTED)) {
+                    return 0;
+                }
+            }
+        }
+        layout->y -= chunk_height;
+        start += chunk;
+    }
+    return 1;
+}
+
+static int deficiency_pdf_device_table(DeficiencyPdfLayout *layout, const ReportDevice *device) {
+    const double size = DEFICIENCY_PDF_TABLE_SIZE;
+    double x[DEFICIENCY_PDF_COLUMNS];
+    double width[DEFICIENCY_PDF_COLUMNS];
+    deficiency_pdf_columns(x, width);
+
+    if (!deficiency_pdf_reserve(layout, 3.0 * size * 1.25 + 4.0 * DEFICIENCY_PDF_CELL_PAD) ||
+        !deficiency_pdf_table_header(layout)) {
+        return 0;
+    }
+    int ok = 1;
+    for (size_t j = 0; ok && j < device->deficiencies.count; ++j) {
+        const ReportDeficiency *def = &device->deficiencies.items[j];
+        const char *sources[DEFICIENCY_PDF_COLUMNS] = {def->equipment, def->condition, def->remedy, def->note};
+        DeficiencyPdfRow row;
+        memset(&row, 0, sizeof(row));
+        row.closed = def->resolved.has_value && def->resolved.value;
+        row.shaded = j % 2 == 0;
+        for (size_t col = 0; col < DEFICIENCY_PDF_COLUMNS; ++col) {
+            string_array_init(&row.lines[col]);
+        }
+        for (size_t col = 0; ok && col < DEFICIENCY_PDF_COLUMNS; ++col) {
+            char *clean = sources[col] ? sanitize_ascii(sources[col]) : NULL;
+            const char *text = clean && clean[0] ? clean : "-";
+            ok = pdf_wrap_text(PDF_FONT_REGULAR, size, text, width[col] - 2.0 * DEFICIENCY_PDF_CELL_PAD, &row.lines[col]);
+            if (ok && row.closed && col + 1 == DEFICIENCY_PDF_COLUMNS) {
+                ok = string_array_append_copy(&row.lines[col], "(Closed)");
+            }
+            free(clean);
+            if (row.lines[col].count > row.line_count) {
+                row.line_count = row.lines[col].count;
+            }
+        }
+        ok = ok && deficiency_pdf_table_row(layout, &row);
+        for (size_t col = 0; col < DEFICIENCY_PDF_COLUMNS; ++col) {
+            string_array_clear(&row.lines[col]);
+        }
+    }
+    ok = ok && pdf_draw_line(layout->doc, DEFICIENCY_PDF_MARGIN_X, layout->y,
+                             PDF_A4_WIDTH - DEFICIENCY_PDF_MARGIN_X, layout->y, 0.8, DEFICIENCY_PDF_TEXT);
+    layout->y -= 12.0;
+    return ok;
+}
+
+/*
+ * Lays the deficiency list out directly as PDF. Same content and page chrome as the LaTeX
+ * deficiency branch of build_report_latex, in a fraction of the time of a pdflatex run.
+ */
+static int build_deficiency_list_pdf(const ReportData *report,
+                                     const ReportJob *job,
+                                     const char *job_dir,
+                                     const char *output_path,
+                                     char **error_out) {
+    if (!report || !job || !output_path) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Invalid report parameters");
+        }
+        return 0;
+    }
+
+    int success = 0;
+    PdfDocument *doc = pdf_document_create(PDF_A4_WIDTH, PDF_A4_HEIGHT);
+    char *cover_address_plain = NULL;
+    char *address_clean = NULL;
+    char *owner_clean = NULL;
+    char *client_name_env = NULL;
+    char *client_name_clean = NULL;
+    char *location_clean = NULL;
+    char *logo_path = NULL;
+    if (!doc || !build_cover_address_plain(job, &cover_address_plain)) {
+        goto cleanup;
+    }
+
+    const char *address_src = (report->summary.building_address && report->summary.building_address[0])
+        ? report->summary.building_address
+        : (job->address && job->address[0] ? job->address : "Unknown address");
+    address_clean = sanitize_ascii_caps(address_src);
+    const char *address_text = address_clean ? address_clean : address_src;
+
+    const char *owner_src = (report->summary.building_owner && report->summary.building_owner[0])
+        ? report->summary.building_owner
+        : "Unknown owner";
+    owner_clean = sanitize_ascii(owner_src);
+    const char *owner_text = owner_clean ? owner_clean : owner_src;
+
+    client_name_env = trim_copy(getenv("REPORT_CLIENT_NAME"));
+    const char *client_name_src = owner_text;
+    if (job->cover_building_owner && job->cover_building_owner[0]) {
+        client_name_src = job->cover_building_owner;
+    } else if (client_name_env && client_name_env[0]) {
+        client_name_src = client_name_env;
+    }
+    client_name_clean = sanitize_ascii(client_name_src);
+
+    /* The cover address spans two lines; the footer and summary want it on one. */
+    const char *location_src = (cover_address_plain && cover_address_plain[0]) ? cover_address_plain : address_text;
+    location_clean = sanitize_ascii(location_src);
+    if (location_clean) {
+        for (char *p = location_clean; *p; ++p) {
+            if (*p == '\n') {
+                *p = ' ';
+            }
+        }
+    }
+
+    char generated[64];
+    time_t now = time(NULL);
+    struct tm local_now;
+    localtime_r(&now, &local_now);
+    strftime(generated, sizeof(generated), "%B %d, %Y %H:%M", &local_now);
+
+    DeficiencyPdfLayout layout = {
+        .doc = doc,
+        .logo = -1,
+        .client_name = client_name_clean ? client_name_clean : client_name_src,
+        .asset_location = location_clean ? location_clean : location_src,
+        .generated = generated,
+        .y = 0.0
+    };
+    logo_path = job_dir ? join_path(job_dir, "square.png") : NULL;
+    if (logo_path && access(logo_path, R_OK) == 0) {
+        char *logo_error = NULL;
+        layout.logo = pdf_document_add_png(doc, logo_path, &logo_error);
+        if (layout.logo < 0) {
+            log_error("Deficiency list logo skipped: %s", logo_error ? logo_error : "unknown error");
+        }
+        free(logo_error);
+    }
+
+    if (!deficiency_pdf_new_page(&layout)) goto cleanup;
+    if (!deficiency_pdf_paragraph(&layout, PDF_FONT_BOLD, 17.0, "Deficiency List", 4.0)) goto cleanup;
+    if (!pdf_draw_line(doc, DEFICIENCY_PDF_MARGIN_X, layout.y, PDF_A4_WIDTH - DEFICIENCY_PDF_MARGIN_X, layout.y,
+                       0.8, DEFICIENCY_PDF_DIVIDER)) goto cleanup;
+    layout.y -= 10.0;
+    if (!deficiency_pdf_labeled(&layout, "Location: ", layout.asset_location)) goto cleanup;
+    if (!deficiency_pdf_labeled(&layout, "Owner: ", layout.client_name)) goto cleanup;
+    if (!deficiency_pdf_labeled(&layout, "Generated: ", generated)) goto cleanup;
+    if (!deficiency_pdf_heading(&layout, 14.0, "1   Deficiency Summary", 40.0)) goto cleanup;
+
+    size_t device_count = report->devices.count;
+    if (device_count == 0) {
+        if (!deficiency_pdf_paragraph(&layout, PDF_FONT_ITALIC, 11.0, "No devices found for this location.", 0.0)) goto cleanup;
+    } else {
+        int total_open = 0;
+        int total_closed = 0;
+        for (size_t i = 0; i < device_count; ++i) {
+            const ReportDevice *device = &report->devices.items[i];
+            for (size_t j = 0; j < device->deficiencies.count; ++j) {
+                const ReportDeficiency *def = &device->deficiencies.items[j];
+                if (def->resolved.has_value && def->resolved.value) {
+                    total_closed++;
+                } else {
+                    total_open++;
+                }
+            }
+        }
+        char count_text[32];
+        snprintf(count_text, sizeof(count_text), "%zu", device_count);
+        if (!deficiency_pdf_labeled(&layout, "Devices evaluated: ", count_text)) goto cleanup;
+        snprintf(count_text, sizeof(count_text), "%d", total_open);
+        if (!deficiency_pdf_labeled(&layout, "Open deficiencies: ", count_text)) goto cleanup;
+        snprintf(count_text, sizeof(count_text), "%d", total_closed);
+        if (!deficiency_pdf_labeled(&layout, "Closed deficiencies: ", count_text)) goto cleanup;
+
+        for (size_t i = 0; i < device_count; ++i) {
+            const ReportDevice *device = &report->devices.items[i];
+            const char *id_src = device->device_id ? device->device_id :
+                                (device->submission_id ? device->submission_id : device->audit_uuid);
+            char *id_clean = sanitize_ascii(id_src ? id_src : "Device");
+            char heading[256];
+            snprintf(heading, sizeof(heading), "Unit %s", id_clean ? id_clean : (id_src ? id_src : "Device"));
+            free(id_clean);
+            if (!deficiency_pdf_heading(&layout, 12.0, heading, 60.0)) goto cleanup;
+
+            if (device->deficiencies.count == 0) {
+                if (!deficiency_pdf_paragraph(&layout, PDF_FONT_ITALIC, 11.0, "No deficiencies recorded for this device.", 6.0)) goto cleanup;
+                continue;
+            }
+            int open_count = 0;
+            int closed_count = 0;
+            for (size_t j = 0; j < device->deficiencies.count; ++j) {
+                const ReportDeficiency *def = &device->deficiencies.items[j];
+                if (def->resolved.has_value && def->resolved.value) {
+                    closed_count++;
+                } else {
+                    open_count++;
+                }
             }
+            char summary[64];
+            snprintf(summary, sizeof(summary), "Open: %d    Closed: %d", open_count, closed_count);
+            if (!deficiency_pdf_paragraph(&layout, PDF_FONT_ITALIC, 11.0, summary, 6.0)) goto cleanup;
+            if (!deficiency_pdf_device_table(&layout, device)) goto cleanup;
         }
+    }
+
+    if (!pdf_document_save(doc, output_path, error_out)) goto cleanup;
+    success = 1;
+
+cleanup:
+    pdf_document_free(doc);
+    free(logo_path);
+    free(location_clean);
+    free(client_name_clean);
+    free(client_name_env);
+    free(owner_clean);
+    free(address_clean);
+    free(cover_address_plain);
+    if (!success && error_out && !*error_out) {
+        *error_out = strdup("Failed to build deficiency list PDF");
+    }
+    return success;
+}
+
+static const char REPORT_PREVIEW_STYLE[] =
+    "body{font-family:Helvetica,Arial,sans-serif;color:#1f2933;margin:0 auto;max-width:960px;padding:24px;line-height:1.45}"
+    "h1{font-size:26px;margin:0 0 4px}h2{font-size:19px;border-bottom:2px solid #0b3d91;padding-bottom:4px;margin-top:32px}"
+    "h3{font-size:16px;margin:24px 0 8px}.sub{color:#52606d;margin:0}"
+    ".banner{background:#fff8e1;border:1px solid #f0c36d;padding:8px 12px;margin:16px 0;font-size:14px}"
+    ".metrics{display:flex;flex-wrap:wrap;gap:12px;margin:16px 0}"
+    ".metric{border:1px solid #d9e2ec;border-radius:4px;padding:8px 14px;min-width:120px}"
+    ".metric b{display:block;font-size:22px}.metric span{color:#52606d;font-size:13px}"
+    ".narrative{white-space:pre-wrap}.fallback{color:#8a6d3b;font-size:12px;font-style:italic}"
+    "table{border-collapse:collapse;width:100%;font-size:13px;margin:8px 0}"
+    "th,td{border:1px solid #d9e2ec;padding:4px 8px;text-align:left;vertical-align:top}"
+    "th{background:#f0f4f8}td.num{text-align:right}.closed{color:#3f9142}.open{color:#b42318}";
+
+/* Sends what the preview has buffered as one chunk and empties the buffer. */
+static int report_preview_flush(int client_fd, Buffer *html) {
+    if (html->length == 0) {
+        return 1;
+    }
+    int ok = send_http_chunk(client_fd, html->data, html->length);
+    html->length = 0;
+    html->data[0] = '\0';
+    return ok;
+}
+
+static int report_preview_append_metric(Buffer *html, const char *label, const char *value) {
+    return buffer_append_cstr(html, "<div class=\"metric\"><b>") &&
+           buffer_append_html_escaped(html, value) &&
+           buffer_append_cstr(html, "</b><span>") &&
+           buffer_append_html_escaped(html, label) &&
+           buffer_append_cstr(html, "</span></div>");
+}
+
+static int report_preview_append_row(Buffer *html, const char *label, const char *value) {
+    if (!value || !value[0]) {
+        return 1;
+    }
+    return buffer_append_cstr(html, "<tr><th>") &&
+           buffer_append_html_escaped(html, label) &&
+           buffer_append_cstr(html, "</th><td>") &&
+           buffer_append_html_escaped(html, value) &&
+           buffer_append_cstr(html, "</td></tr>");
+}
+
+static int report_preview_append_int_row(Buffer *html, const char *label, const OptionalInt *value) {
+    if (!value->has_value) {
+        return 1;
+    }
+    char digits[NUMBER_FORMAT_MAX];
+    format_int64(digits, value->value);
+    return report_preview_append_row(html, label, digits);
+}
 
-        goto finalize;
+/* Cached narratives print as-is; anything else gets the deterministic fallback, flagged as such. */
+static int report_preview_append_narrative(Buffer *html, const char *cached, char *(*fallback)(const void *), const void *arg) {
+    char *generated = cached ? NULL : fallback(arg);
+    bool ok = buffer_append_cstr(html, "<div class=\"narrative\">") &&
+              buffer_append_html_escaped(html, cached ? cached : (generated ? generated : "")) &&
+              buffer_append_cstr(html, "</div>");
+    if (ok && !cached) {
+        ok = buffer_append_cstr(html, "<p class=\"fallback\">Preliminary text; the generated narrative is written when a PDF report is requested.</p>");
     }
+    free(generated);
+    return ok;
+}
 
-    if (!buffer_append_cstr(&buf, "\\section{Executive Summary}\n\n")) goto cleanup;
-    if (!buffer_append_cstr(&buf, "\\subsection{Overview}\n")) goto cleanup;
-    if (!append_narrative_block(&buf, narratives->executive_summary)) goto cleanup;
-    if (!buffer_append_cstr(&buf, "\\subsection{Key Findings}\n")) goto cleanup;
-    if (!append_narrative_block(&buf, narratives->key_findings)) goto cleanup;
+typedef struct {
+    const char *title;
+    const ReportSummary *summary;
+} ReportPreviewSectionArg;
 
-    if (!buffer_append_cstr(&buf, "\\section{Scope of Work}\n\n")) goto cleanup;
-    if (!buffer_append_cstr(&buf, "\\subsection{Methodology}\n")) goto cleanup;
-    if (!append_narrative_block(&buf, narratives->methodology)) goto cleanup;
-    if (!buffer_append_cstr(&buf,
-        "\\subsection{Audit Process}\n"
-        "The audit process involved a comprehensive evaluation of all elevator equipment, including mechanical components, electrical systems, safety devices, and maintenance records. Each device was inspected according to applicable codes and industry standards.\n\n")) goto cleanup;
+static char *report_preview_section_fallback(const void *arg) {
+    const ReportPreviewSectionArg *section = (const ReportPreviewSectionArg *)arg;
+    return build_section_narrative_fallback(section->title, section->summary);
+}
 
-    if (!buffer_append_cstr(&buf,
-        "\\section{Equipment Summary}\n\n"
-        "\\subsection{General Equipment Condition}\n"
-        "The following analysis provides an overview of the equipment condition across all devices inspected.\n\n")) goto cleanup;
+static char *report_preview_device_fallback(const void *arg) {
+    return build_device_narrative_fallback((const ReportDevice *)arg);
+}
 
-    if (!buffer_append_cstr(&buf, "\\begin{center}\n\\begin{tabular}{ll}\n\\toprule\n\\textbf{Metric} & \\textbf{Value} \\\\ \\midrule\n")) goto cleanup;
+static int report_preview_append_section(Buffer *html, size_t index, NarrativeSet *narratives, const ReportSummary *summary) {
+    const ReportSectionSpec *spec = &REPORT_SECTION_SPECS[index];
+    ReportPreviewSectionArg arg = { spec->title, summary };
+    return buffer_append_cstr(html, "<h2>") &&
+           buffer_append_html_escaped(html, spec->title) &&
+           buffer_append_cstr(html, "</h2>") &&
+           report_preview_append_narrative(html, *narrative_set_slot(narratives, spec), report_preview_section_fallback, &arg);
+}
 
-    char number_buf[32];
-    if (!buffer_appendf(&buf, "Address & %s \\\\ \n", address_tex)) goto cleanup;
-    if (!buffer_appendf(&buf, "Owner & %s \\\\ \n", owner_tex)) goto cleanup;
-    if (!buffer_appendf(&buf, "Elevator Contractor & %s \\\\ \n", contractor_tex)) goto cleanup;
-    if (!buffer_appendf(&buf, "Audit Date Range & %s \\\\ \n", date_range_tex)) goto cleanup;
-    snprintf(number_buf, sizeof(number_buf), "%d", report->summary.total_devices);
-    if (!buffer_appendf(&buf, "Total Devices & %s \\\\ \n", number_buf)) goto cleanup;
-    snprintf(number_buf, sizeof(number_buf), "%d", report->summary.audit_count);
-    if (!buffer_appendf(&buf, "Audit Count & %s \\\\ \n", number_buf)) goto cleanup;
-    snprintf(number_buf, sizeof(number_buf), "%d", report->summary.total_deficiencies);
-    if (!buffer_appendf(&buf, "Total Deficiencies & %s \\\\ \n", number_buf)) goto cleanup;
-    snprintf(number_buf, sizeof(number_buf), "%.2f", report->summary.average_deficiencies_per_device);
-    if (!buffer_appendf(&buf, "Average Deficiencies / Device & %s \\\\ \n", number_buf)) goto cleanup;
+static int report_preview_append_overview(Buffer *html, const OverviewWindow *windows, size_t count, const ReportData *report) {
+    if (!buffer_append_cstr(html, "<h2>Service and Financial Overview</h2><table><tr><th>Window</th><th>Range</th>"
+                                  "<th>Tickets</th><th>Tickets / Device</th><th>Service Hours</th><th>Spend</th>"
+                                  "<th>Savings</th><th>Open Deficiencies</th><th>Closure Rate</th></tr>")) {
+        return 0;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        const OverviewWindow *window = &windows[i];
+        char *range = format_window_range_label(window, report);
+        char tickets[NUMBER_FORMAT_MAX] = "-";
+        char per_device[NUMBER_FORMAT_MAX] = "-";
+        char hours[NUMBER_FORMAT_MAX] = "-";
+        char spend[NUMBER_FORMAT_MAX + 1] = "-";
+        char savings[NUMBER_FORMAT_MAX + 1] = "-";
+        char open[NUMBER_FORMAT_MAX];
+        char closure[NUMBER_FORMAT_MAX + 1] = "N/A";
+        if (window->service_available) {
+            format_int64(tickets, window->service_stats.total_tickets);
+            if (isfinite(window->tickets_per_device)) {
+                format_double_fixed(per_device, window->tickets_per_device, 1, true);
+            }
+            format_double_fixed(hours, window->service_hours, 1, true);
+        }
+        if (window->financial_available) {
+            spend[0] = '$';
+            format_double_fixed(spend + 1, window->spend_total, 2, true);
+            savings[0] = '$';
+            format_double_fixed(savings + 1, window->savings_total, 2, true);
+        }
+        format_int64(open, window->open_deficiencies);
+        if (isfinite(window->closure_rate)) {
+            size_t len = format_double_fixed(closure, window->closure_rate * 100.0, 1, false);
+            closure[len] = '%';
+            closure[len + 1] = '\0';
+        }
+        bool ok = buffer_append_cstr(html, "<tr><td>") &&
+                  buffer_append_html_escaped(html, window->label) &&
+                  buffer_append_cstr(html, "</td><td>") &&
+                  buffer_append_html_escaped(html, range) &&
+                  buffer_appendf(html, "</td><td class=\"num\">%s</td><td class=\"num\">%s</td><td class=\"num\">%s</td>"
+                                       "<td class=\"num\">%s</td><td class=\"num\">%s</td><td class=\"num\">%s</td>"
+                                       "<td class=\"num\">%s</td></tr>",
+                                 tickets, per_device, hours, spend, savings, open, closure);
+        free(range);
+        if (!ok) {
+            return 0;
+        }
+    }
+    if (!buffer_append_cstr(html, "</table>")) {
+        return 0;
+    }
+    if (count == 0) {
+        return 1;
+    }
+    const LocationAdvisorySummary *advisory = &windows[0].advisory;
+    const struct {
+        const char *label;
+        const char *status;
+        const char *message;
+    } notes[] = {
+        {"Maintenance", advisory->maintenance.status, advisory->maintenance.message},
+        {"Modernization", advisory->modernization.status, advisory->modernization.message},
+        {"Vendor", advisory->vendor.status, advisory->vendor.message}
+    };
+    bool opened = false;
+    for (size_t i = 0; i < ARRAY_LEN(notes); ++i) {
+        if (!notes[i].message || !notes[i].message[0]) {
+            continue;
+        }
+        if (!opened && !buffer_append_cstr(html, "<h3>Advisories</h3><table>")) {
+            return 0;
+        }
+        opened = true;
+        if (!buffer_append_cstr(html, "<tr><th>") ||
+            !buffer_append_html_escaped(html, notes[i].label) ||
+            !buffer_append_cstr(html, "</th><td>") ||
+            !buffer_append_html_escaped(html, notes[i].status ? notes[i].status : "") ||
+            !buffer_append_cstr(html, "</td><td>") ||
+            !buffer_append_html_escaped(html, notes[i].message) ||
+            !buffer_append_cstr(html, "</td></tr>")) {
+            return 0;
+        }
+    }
+    return !opened || buffer_append_cstr(html, "</table>");
+}
 
-    if (!buffer_append_cstr(&buf, "\\bottomrule\n\\end{tabular}\n\\end{center}\n\n")) goto cleanup;
-    if (!buffer_append_cstr(&buf, "These metrics summarize all submissions included in this report and frame the analyses that follow.\n\n")) goto cleanup;
+static int report_preview_append_device(Buffer *html, const ReportDevice *device) {
+    const ReportDeviceMetrics *metrics = &device->metrics;
+    bool ok = buffer_append_cstr(html, "<h3>Device ") &&
+              buffer_append_html_escaped(html, device->device_id ? device->device_id : "(unknown)") &&
+              buffer_append_cstr(html, "</h3><table>") &&
+              report_preview_append_row(html, "Type", device->device_type) &&
+              report_preview_append_row(html, "Bank", device->bank_name) &&
+              report_preview_append_row(html, "City ID", device->city_id) &&
+              report_preview_append_row(html, "Controller", device->controller_manufacturer) &&
+              report_preview_append_row(html, "Controller Model", device->controller_model) &&
+              report_preview_append_int_row(html, "Controller Installed", &metrics->controller_install_year) &&
+              report_preview_append_row(html, "Machine", device->machine_type) &&
+              report_preview_append_int_row(html, "Capacity (lbs)", &metrics->capacity) &&
+              report_preview_append_int_row(html, "Speed (fpm)", &metrics->car_speed) &&
+              report_preview_append_int_row(html, "Stops", &metrics->number_of_stops) &&
+              report_preview_append_row(html, "CAT1 Tag", device->cat1_tag_date) &&
+              report_preview_append_row(html, "CAT5 Tag", device->cat5_tag_date) &&
+              report_preview_append_row(html, "Audited", device->submitted_on_iso) &&
+              buffer_append_cstr(html, "</table>") &&
+              report_preview_append_narrative(html, device->narrative, report_preview_device_fallback, device);
+    if (!ok) {
+        return 0;
+    }
+    if (device->deficiencies.count == 0) {
+        return buffer_append_cstr(html, "<p>No deficiencies recorded.</p>");
+    }
+    if (!buffer_append_cstr(html, "<table><tr><th>Equipment</th><th>Condition</th><th>Remedy</th><th>Note</th><th>Status</th></tr>")) {
+        return 0;
+    }
+    for (size_t i = 0; i < device->deficiencies.count; ++i) {
+        const ReportDeficiency *def = &device->deficiencies.items[i];
+        bool resolved = def->resolved.has_value && def->resolved.value;
+        if (!buffer_append_cstr(html, "<tr><td>") ||
+            !buffer_append_html_escaped(html, def->equipment) ||
+            !buffer_append_cstr(html, "</td><td>") ||
+            !buffer_append_html_escaped(html, def->condition) ||
+            !buffer_append_cstr(html, "</td><td>") ||
+            !buffer_append_html_escaped(html, def->remedy) ||
+            !buffer_append_cstr(html, "</td><td>") ||
+            !buffer_append_html_escaped(html, def->note) ||
+            !buffer_append_cstr(html, resolved ? "</td><td class=\"closed\">Closed" : "</td><td class=\"open\">Open") ||
+            (resolved && def->resolved_at && (!buffer_append_cstr(html, " ") || !buffer_append_html_escaped(html, def->resolved_at))) ||
+            !buffer_append_cstr(html, "</td></tr>")) {
+            return 0;
+        }
+    }
+    return buffer_append_cstr(html, "</table>");
+}
 
-    if (!buffer_append_cstr(&buf, "\\subsection{Deficiency Patterns}\n")) goto cleanup;
-    if (!append_deficiency_code_chart(&buf, report)) goto cleanup;
-    if (!append_deficiencies_per_device_chart(&buf, report)) goto cleanup;
-    if (!append_controller_age_chart(&buf, report)) goto cleanup;
+/*
+ * Renders the audit report for a location as one HTML page, streamed in chunks as each part
+ * is ready. Uses the report's data and overview analytics but never calls the narrative
+ * model or LaTeX: narratives come from the cache, else from the deterministic fallbacks.
+ * Returns 0 with status and error set only when nothing has been sent yet.
+ */
+static int stream_report_preview(int client_fd, PGconn *conn, const LocationDetailRequest *request, int *status_out, char **error_out) {
+    *status_out = 500;
+    if (!conn) {
+        *error_out = strdup("Database connection unavailable");
+        return 0;
+    }
 
-    if (!append_service_summary_section(&buf, conn, job, profile, error_out)) goto cleanup;
-    if (!append_financial_summary_section(&buf, conn, job, profile, error_out)) goto cleanup;
+    LocationProfile profile;
+    location_profile_init(&profile);
+    ReportData report;
+    report_data_init(&report);
+    ReportJob job;
+    report_job_init(&job);
+    NarrativeSet narratives;
+    narrative_set_init(&narratives);
+    Buffer html = {0};
+    char *lookup_address = NULL;
+    char *report_json = NULL;
+    NarrativeTask *tasks = NULL;
+    size_t task_count = 0;
+    OverviewWindow windows[OVERVIEW_WINDOW_MAX];
+    for (size_t i = 0; i < OVERVIEW_WINDOW_MAX; ++i) {
+        overview_window_init(&windows[i]);
+    }
+    size_t window_count = 0;
+    int result = 0;
 
-    if (!append_device_sections(&buf, report)) goto cleanup;
-    if (!buffer_append_cstr(&buf, "\\newpage\n")) goto cleanup;
+    if (!resolve_location_profile(conn, request, &profile, &lookup_address, error_out)) {
+        if (!*error_out) {
+            *status_out = 400;
+        }
+        goto cleanup;
+    }
+    if (!lookup_address || lookup_address[0] == '\0') {
+        *error_out = strdup("Unable to determine canonical address for location");
+        *status_out = 400;
+        goto cleanup;
+    }
+    char *load_error = NULL;
+    if (!load_report_for_building(conn, lookup_address, &profile.row_id, NULL, &report, &load_error)) {
+        if (load_error && strcmp(load_error, "No audits found for building address") == 0) {
+            *status_out = 404;
+        }
+        *error_out = load_error ? load_error : strdup("Failed to load report");
+        goto cleanup;
+    }
+    if (!buffer_init(&html)) {
+        *error_out = strdup("Out of memory");
+        goto cleanup;
+    }
 
-    if (!append_narrative_section(&buf, "Maintenance Performance", narratives->maintenance_performance)) goto cleanup;
-    if (!append_narrative_section(&buf, "Recommendations", narratives->recommendations)) goto cleanup;
-    if (!append_narrative_section(&buf, "Conclusion", narratives->conclusion)) goto cleanup;
+    /* From here on the response is committed; failures end the stream early. */
+    result = 1;
+    if (!send_http_stream_start(client_fd, 200, "OK", "text/html; charset=utf-8")) {
+        goto cleanup;
+    }
 
-finalize:
-    if (!buffer_append_cstr(&buf, "\\end{document}\n")) goto cleanup;
+    const ReportSummary *summary = &report.summary;
+    const char *title = (profile.address_label && profile.address_label[0]) ? profile.address_label
+                        : (summary->building_address ? summary->building_address : lookup_address);
+    char *range_start = format_pretty_date(summary->audit_range.start);
+    char *range_end = format_pretty_date(summary->audit_range.end);
+    char devices[NUMBER_FORMAT_MAX];
+    char deficiencies[NUMBER_FORMAT_MAX];
+    char open_count[NUMBER_FORMAT_MAX];
+    char average[NUMBER_FORMAT_MAX];
+    char audits[NUMBER_FORMAT_MAX];
+    int open_deficiencies = report_open_deficiency_count(&report);
+    format_int64(devices, summary->total_devices);
+    format_int64(deficiencies, summary->total_deficiencies);
+    format_int64(open_count, open_deficiencies);
+    format_double_fixed(average, summary->average_deficiencies_per_device, 1, false);
+    format_int64(audits, summary->audit_count);
+    bool ok = buffer_append_cstr(&html, "<!DOCTYPE html><html lang=\"en\"><head><meta charset=\"utf-8\"><title>Audit Report Preview - ") &&
+              buffer_append_html_escaped(&html, title) &&
+              buffer_append_cstr(&html, "</title><style>") &&
+              buffer_append_cstr(&html, REPORT_PREVIEW_STYLE) &&
+              buffer_append_cstr(&html, "</style></head><body><h1>") &&
+              buffer_append_html_escaped(&html, title) &&
+              buffer_append_cstr(&html, "</h1><p class=\"sub\">Elevator audit report preview") &&
+              (!range_start || (buffer_append_cstr(&html, " &middot; ") && buffer_append_html_escaped(&html, range_start))) &&
+              (!range_end || (buffer_append_cstr(&html, range_start ? " &ndash; " : " &middot; ") &&
+                              buffer_append_html_escaped(&html, range_end))) &&
+              buffer_append_cstr(&html, "</p><div class=\"banner\">Preview only. Request a PDF report for the formatted document.</div>"
+                                        "<div class=\"metrics\">") &&
+              report_preview_append_metric(&html, "Devices", devices) &&
+              report_preview_append_metric(&html, "Deficiencies", deficiencies) &&
+              report_preview_append_metric(&html, "Open", open_count) &&
+              report_preview_append_metric(&html, "Per Device", average) &&
+              report_preview_append_metric(&html, "Audits", audits) &&
+              buffer_append_cstr(&html, "</div><table>") &&
+              report_preview_append_row(&html, "Owner", profile.owner_name ? profile.owner_name : summary->building_owner) &&
+              report_preview_append_row(&html, "Elevator Contractor", profile.vendor_name ? profile.vendor_name : summary->elevator_contractor) &&
+              report_preview_append_row(&html, "City ID", summary->city_id) &&
+              buffer_append_cstr(&html, "</table>");
+    free(range_start);
+    free(range_end);
+    if (!ok || !report_preview_flush(client_fd, &html)) {
+        goto cleanup;
+    }
 
-    if (write_buffer_to_file(output_path, buf.data, buf.length) != 0) {
-        if (error_out && !*error_out) {
-            char *msg = malloc(128);
-            if (msg) {
-                snprintf(msg, 128, "Failed to write %s: %s", output_path, strerror(errno));
-                *error_out = msg;
+    /* Same prompts a report job without notes would send, so cache hits line up with real reports. */
+    char *narrative_error = NULL;
+    report_json = report_data_to_json(&report);
+    size_t task_slots = REPORT_SECTION_COUNT + report.devices.count;
+    tasks = report_json ? calloc(task_slots, sizeof(*tasks)) : NULL;
+    if (tasks &&
+        narrative_tasks_add_sections(tasks, task_slots, &task_count, &narratives, report_json, &job, &narrative_error) &&
+        narrative_tasks_add_devices(tasks, task_slots, &task_count, &report, &job, &narrative_error)) {
+        narrative_tasks_fill_cached(conn, tasks, task_count);
+        for (size_t i = 0; i < task_count; ++i) {
+            if (tasks[i].cached) {
+                *(tasks[i].slot) = tasks[i].request.response;
+                tasks[i].request.response = NULL;
             }
         }
+    } else {
+        log_error("Report preview for %s is using fallback narratives: %s", lookup_address,
+                  narrative_error ? narrative_error : "Out of memory");
+    }
+    free(narrative_error);
+
+    ok = report_preview_append_section(&html, 0, &narratives, summary) &&
+         report_preview_append_section(&html, 1, &narratives, summary);
+    if (!ok || !report_preview_flush(client_fd, &html)) {
         goto cleanup;
     }
 
-    success = 1;
+    int installed_devices = profile.device_count.has_value ? profile.device_count.value : 0;
+    int device_count = installed_devices > 0 ? installed_devices : summary->total_devices;
+    int total_deficiencies = summary->total_deficiencies;
+    double closure_rate = total_deficiencies > 0
+                              ? safe_divide((double)(total_deficiencies - open_deficiencies), (double)total_deficiencies)
+                              : NAN;
+    double open_per_device = device_count > 0 ? (double)open_deficiencies / (double)device_count : NAN;
+    char *window_error = NULL;
+    if (collect_overview_windows(conn, lookup_address, &profile, &report, OVERVIEW_WINDOW_SPECS, OVERVIEW_WINDOW_COUNT,
+                                 device_count, total_deficiencies, open_deficiencies, closure_rate, open_per_device,
+                                 windows, &window_count, &window_error)) {
+        ok = report_preview_append_overview(&html, windows, window_count, &report);
+    } else {
+        log_error("Report preview for %s skipped overview analytics: %s", lookup_address,
+                  window_error ? window_error : "unknown error");
+        window_count = 0;
+        ok = buffer_append_cstr(&html, "<h2>Service and Financial Overview</h2><p>Analytics are unavailable for this location.</p>");
+    }
+    free(window_error);
+    if (ok && summary->deficiencies_by_code.count > 0) {
+        ok = buffer_append_cstr(&html, "<h2>Deficiencies by Condition</h2><table><tr><th>Condition</th><th>Count</th></tr>");
+        for (size_t i = 0; ok && i < summary->deficiencies_by_code.count; ++i) {
+            const KeyCountEntry *entry = &summary->deficiencies_by_code.items[i];
+            ok = buffer_append_cstr(&html, "<tr><td>") &&
+                 buffer_append_html_escaped(&html, entry->key) &&
+                 buffer_appendf(&html, "</td><td class=\"num\">%d</td></tr>", entry->count);
+        }
+        ok = ok && buffer_append_cstr(&html, "</table>");
+    }
+    if (!ok || !report_preview_flush(client_fd, &html)) {
+        goto cleanup;
+    }
+
+    if (!buffer_append_cstr(&html, "<h2>Equipment Detail</h2>")) {
+        goto cleanup;
+    }
+    for (size_t i = 0; i < report.devices.count; ++i) {
+        if (!report_preview_append_device(&html, &report.devices.items[i]) || !report_preview_flush(client_fd, &html)) {
+            goto cleanup;
+        }
+    }
+
+    for (size_t i = 2; i < REPORT_SECTION_COUNT; ++i) {
+        if (!report_preview_append_section(&html, i, &narratives, summary)) {
+            goto cleanup;
+        }
+    }
+    char generated[64] = "";
+    time_t now = time(NULL);
+    struct tm tm_now;
+    if (gmtime_r(&now, &tm_now)) {
+        strftime(generated, sizeof(generated), "%Y-%m-%d %H:%M UTC", &tm_now);
+    }
+    if (buffer_appendf(&html, "<p class=\"sub\">Preview generated %s.</p></body></html>", generated) &&
+        report_preview_flush(client_fd, &html)) {
+        send_http_stream_end(client_fd);
+    }
 
 cleanup:
-    free(address_clean);
-    free(address_tex);
-    free(owner_clean);
-    free(owner_tex);
-    free(contractor_clean);
-    free(contractor_tex);
-    free(city_clean);
-    free(city_tex);
-    free(date_range_tex);
-    free(client_name_env);
-    free(client_name_tex);
-    free(client_address_env);
-    free(client_address_tex);
-    free(contact_name_env);
-    free(contact_name_tex);
-    free(contact_email_env);
-    free(contact_email_tex);
-    free(asset_location_tex);
-    free(cover_address_plain);
-    buffer_free(&buf);
-    if (!success && error_out && !*error_out) {
-        *error_out = strdup("Failed to build LaTeX report");
+    for (size_t i = 0; i < window_count; ++i) {
+        overview_window_clear(&windows[i]);
     }
-    return success;
+    for (size_t i = 0; tasks && i < task_count; ++i) {
+        free(tasks[i].prompt);
+        free(tasks[i].system_prompt_owned);
+        free(tasks[i].request.response);
+    }
+    free(tasks);
+    free(report_json);
+    buffer_free(&html);
+    narrative_set_clear(&narratives);
+    report_job_clear(&job);
+    report_data_clear(&report);
+    location_profile_clear(&profile);
+    free(lookup_address);
+    return result;
 }
 
-
 static void handle_client(int client_fd, void *ctx) {
     PGconn *conn = (PGconn *)ctx;
     char header_buffer[MAX_HEADER_SIZE];
@@ -17070,7 +19711,7 @@ static void handle_client(int client_fd, void *ctx) {
 
             if (strcmp(method, "GET") == 0) {
                 if (is_api_path) {
-                    routes_handle_get(client_fd, conn, api_path, query_string);
+                    routes_handle_get(client_fd, conn, api_path, query_string, header_lines);
                 } else {
                     serve_static_file(client_fd, path);
                 }
@@ -17749,7 +20390,6 @@ static void handle_client(int client_fd, void *ctx) {
 
                 send_report_job_response(client_fd, 202, "queued", job_id, &request, NULL);
                 report_job_clear(&request);
-                signal_report_worker();
                 return;
             }
 
@@ -17855,11 +20495,31 @@ static void handle_client(int client_fd, void *ctx) {
 }
 
 int main(int argc, char **argv) {
-    (void)argc;
-    (void)argv;
+    bool migrate_artifacts_only = false;
+    bool render_photo_derivatives_only = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--migrate-artifacts") == 0) {
+            migrate_artifacts_only = true;
+        } else if (strcmp(argv[i], "--render-photo-derivatives") == 0) {
+            render_photo_derivatives_only = true;
+        } else {
+            log_error("Unknown argument: %s", argv[i]);
+            return 2;
+        }
+    }
 
     signal(SIGPIPE, SIG_IGN);
 
+    /* Blocked before any thread starts: every thread inherits the mask, so in the worker
+       shutdown signals are only seen by the sigwait in main. */
+    sigset_t shutdown_signals;
+    sigemptyset(&shutdown_signals);
+    sigaddset(&shutdown_signals, SIGINT);
+    sigaddset(&shutdown_signals, SIGTERM);
+    if (AUDIT_REPORT_WORKER_ONLY) {
+        pthread_sigmask(SIG_BLOCK, &shutdown_signals, NULL);
+    }
+
     int exit_code = 1;
     PGconn *conn = NULL;
 
@@ -17890,9 +20550,12 @@ int main(int argc, char **argv) {
 
     char *api_key_trimmed = trim_copy(getenv("API_KEY"));
     if (!api_key_trimmed || api_key_trimmed[0] == '\0') {
-        log_error("API_KEY must be set");
         free(api_key_trimmed);
-        goto cleanup;
+        api_key_trimmed = NULL;
+        if (!AUDIT_REPORT_WORKER_ONLY) {
+            log_error("API_KEY must be set");
+            goto cleanup;
+        }
     }
     g_api_key = api_key_trimmed;
 
@@ -17962,6 +20625,22 @@ int main(int argc, char **argv) {
     }
     g_report_output_dir = report_dir_trimmed;
 
+    char *artifact_dir_trimmed = trim_copy(getenv("REPORT_ARTIFACT_DIR"));
+    if (!artifact_dir_trimmed || artifact_dir_trimmed[0] == '\0') {
+        free(artifact_dir_trimmed);
+        artifact_dir_trimmed = join_path(g_report_output_dir, "artifacts");
+    }
+    char *artifact_store_error = NULL;
+    if (!artifact_dir_trimmed || !artifact_store_open_directory(&g_artifact_store, artifact_dir_trimmed, &artifact_store_error)) {
+        log_error("Failed to open report artifact store %s: %s",
+                  artifact_dir_trimmed ? artifact_dir_trimmed : "(none)",
+                  artifact_store_error ? artifact_store_error : "out of memory");
+        free(artifact_store_error);
+        free(artifact_dir_trimmed);
+        goto cleanup;
+    }
+    free(artifact_dir_trimmed);
+
     char *assets_dir_trimmed = trim_copy(getenv("REPORT_ASSETS_DIR"));
     if (!assets_dir_trimmed || assets_dir_trimmed[0] == '\0') {
         free(assets_dir_trimmed);
@@ -17985,6 +20664,100 @@ int main(int argc, char **argv) {
         }
     }
 
+    const char *native_pdf_env = getenv("NATIVE_DEFICIENCY_PDF");
+    if (native_pdf_env && native_pdf_env[0] != '\0') {
+        if (strcasecmp(native_pdf_env, "off") == 0 || strcmp(native_pdf_env, "0") == 0 ||
+            strcasecmp(native_pdf_env, "false") == 0) {
+            g_native_deficiency_pdf = 0;
+        } else if (strcasecmp(native_pdf_env, "on") == 0 || strcmp(native_pdf_env, "1") == 0 ||
+                   strcasecmp(native_pdf_env, "true") == 0) {
+            g_native_deficiency_pdf = 1;
+        } else {
+            log_info("Ignoring invalid NATIVE_DEFICIENCY_PDF value: %s", native_pdf_env);
+        }
+    }
+    const char *latex_format_env = getenv("LATEX_PRECOMPILED_FORMAT");
+    if (latex_format_env && latex_format_env[0] != '\0') {
+        if (strcasecmp(latex_format_env, "off") == 0 || strcmp(latex_format_env, "0") == 0 ||
+            strcasecmp(latex_format_env, "false") == 0) {
+            g_latex_format_enabled = 0;
+        } else if (strcasecmp(latex_format_env, "on") == 0 || strcmp(latex_format_env, "1") == 0 ||
+                   strcasecmp(latex_format_env, "true") == 0) {
+            g_latex_format_enabled = 1;
+        } else {
+            log_info("Ignoring invalid LATEX_PRECOMPILED_FORMAT value: %s", latex_format_env);
+        }
+    }
+    const char *assembly_threads_env = getenv("LATEX_ASSEMBLY_THREADS");
+    if (assembly_threads_env && assembly_threads_env[0] != '\0') {
+        int parsed = atoi(assembly_threads_env);
+        if (parsed >= 1 && parsed <= LATEX_ASSEMBLY_MAX_THREADS) {
+            g_latex_assembly_threads = parsed;
+        } else {
+            log_info("Ignoring invalid LATEX_ASSEMBLY_THREADS value: %s", assembly_threads_env);
+        }
+    }
+    const char *fragment_cache_env = getenv("LATEX_FRAGMENT_CACHE_MB");
+    if (fragment_cache_env && fragment_cache_env[0] != '\0') {
+        char *end = NULL;
+        long parsed = strtol(fragment_cache_env, &end, 10);
+        if (end && *end == '\0' && parsed >= 0 && parsed <= LATEX_FRAGMENT_CACHE_MAX_MB) {
+            g_latex_fragment_cache_mb = (int)parsed;
+        } else {
+            log_info("Ignoring invalid LATEX_FRAGMENT_CACHE_MB value: %s", fragment_cache_env);
+        }
+    }
+    fragment_cache_set_limit((size_t)g_latex_fragment_cache_mb * 1024 * 1024);
+    const char *narrative_cache_env = getenv("NARRATIVE_CACHE");
+    if (narrative_cache_env && narrative_cache_env[0] != '\0') {
+        if (strcasecmp(narrative_cache_env, "off") == 0 || strcmp(narrative_cache_env, "0") == 0 ||
+            strcasecmp(narrative_cache_env, "false") == 0) {
+            g_narrative_cache_enabled = 0;
+        } else if (strcasecmp(narrative_cache_env, "on") == 0 || strcmp(narrative_cache_env, "1") == 0 ||
+                   strcasecmp(narrative_cache_env, "true") == 0) {
+            g_narrative_cache_enabled = 1;
+        } else {
+            log_info("Ignoring invalid NARRATIVE_CACHE value: %s", narrative_cache_env);
+        }
+    }
+    const char *narrative_cache_version_env = getenv("NARRATIVE_CACHE_VERSION");
+    if (narrative_cache_version_env && narrative_cache_version_env[0] != '\0') {
+        int parsed = atoi(narrative_cache_version_env);
+        if (parsed >= 1) {
+            g_narrative_cache_version = parsed;
+        } else {
+            log_info("Ignoring invalid NARRATIVE_CACHE_VERSION value: %s", narrative_cache_version_env);
+        }
+    }
+    const char *narrative_cache_age_env = getenv("NARRATIVE_CACHE_MAX_AGE_DAYS");
+    if (narrative_cache_age_env && narrative_cache_age_env[0] != '\0') {
+        int parsed = atoi(narrative_cache_age_env);
+        if (parsed >= 0 && (parsed > 0 || strcmp(narrative_cache_age_env, "0") == 0)) {
+            g_narrative_cache_max_age_days = parsed;
+        } else {
+            log_info("Ignoring invalid NARRATIVE_CACHE_MAX_AGE_DAYS value: %s", narrative_cache_age_env);
+        }
+    }
+
+    const char *deadline_env = getenv("NARRATIVE_DEADLINE_SECONDS");
+    if (deadline_env && deadline_env[0] != '\0') {
+        int parsed = atoi(deadline_env);
+        if (parsed > 0 || strcmp(deadline_env, "0") == 0) {
+            g_narrative_deadline_seconds = parsed;
+        } else {
+            log_info("Ignoring invalid NARRATIVE_DEADLINE_SECONDS value: %s", deadline_env);
+        }
+    }
+    const char *device_batch_env = getenv("NARRATIVE_DEVICE_BATCH_SIZE");
+    if (device_batch_env && device_batch_env[0] != '\0') {
+        int parsed = atoi(device_batch_env);
+        if (parsed >= 1 && parsed <= NARRATIVE_MAX_DEVICE_BATCH) {
+            g_narrative_device_batch_size = parsed;
+        } else {
+            log_info("Ignoring invalid NARRATIVE_DEVICE_BATCH_SIZE value: %s", device_batch_env);
+        }
+    }
+
     const char *fiscal_month_env = getenv("FISCAL_YEAR_START_MONTH");
     if (fiscal_month_env && fiscal_month_env[0] != '\0') {
         int month = atoi(fiscal_month_env);
@@ -18008,8 +20781,9 @@ int main(int argc, char **argv) {
     RouteHelpers route_helpers = {
         .build_location_detail = build_location_detail_payload,
         .build_report_json = build_report_json_payload,
-        .prepare_report_download = prepare_report_download,
-        .cleanup_report_download = cleanup_report_download
+        .stream_report_preview = stream_report_preview,
+        .stream_report_download = stream_report_download,
+        .build_report_worker_status = build_report_worker_status_json
     };
     routes_register_helpers(&route_helpers);
     routes_set_prefix(g_api_prefix);
@@ -18042,12 +20816,70 @@ int main(int argc, char **argv) {
     }
     g_google_region_code = google_region_trimmed;
 
+    /* Endpoint overrides, mainly for pointing outbound calls at a local stub server. */
+    char *xai_url_trimmed = trim_copy(getenv("XAI_API_URL"));
+    if (xai_url_trimmed && xai_url_trimmed[0] == '\0') {
+        free(xai_url_trimmed);
+        xai_url_trimmed = NULL;
+    }
+    g_xai_api_url = xai_url_trimmed;
+    char *google_url_trimmed = trim_copy(getenv("GOOGLE_ADDRESS_VALIDATION_URL"));
+    if (google_url_trimmed && google_url_trimmed[0] == '\0') {
+        free(google_url_trimmed);
+        google_url_trimmed = NULL;
+    }
+    g_google_address_url = google_url_trimmed;
+
     if (curl_global_init(CURL_GLOBAL_DEFAULT) != 0) {
         log_error("Failed to initialize HTTP client");
         goto cleanup;
     }
     g_curl_initialized = true;
 
+    HttpClientConfig http_config = {
+        .max_host_connections = HTTP_CLIENT_DEFAULT_HOST_CONNECTIONS,
+        .max_total_connections = HTTP_CLIENT_DEFAULT_TOTAL_CONNECTIONS
+    };
+    const char *host_connections_env = getenv("HTTP_CLIENT_MAX_HOST_CONNECTIONS");
+    if (host_connections_env && host_connections_env[0] != '\0') {
+        int parsed = atoi(host_connections_env);
+        if (parsed >= 1 && parsed <= 256) {
+            http_config.max_host_connections = parsed;
+        } else {
+            log_info("Ignoring invalid HTTP_CLIENT_MAX_HOST_CONNECTIONS value: %s", host_connections_env);
+        }
+    }
+    if (http_config.max_total_connections < http_config.max_host_connections * 2) {
+        http_config.max_total_connections = http_config.max_host_connections * 2;
+    }
+    if (!http_client_start(&http_config)) {
+        log_error("Shared HTTP client unavailable; outbound calls will open their own connections");
+    }
+
+    int narrative_threads = NARRATIVE_DEFAULT_CONCURRENCY;
+    const char *narrative_threads_env = getenv("NARRATIVE_CONCURRENCY");
+    if (narrative_threads_env && narrative_threads_env[0] != '\0') {
+        int parsed = atoi(narrative_threads_env);
+        if (parsed >= 1 && parsed <= NARRATIVE_MAX_CONCURRENCY) {
+            narrative_threads = parsed;
+        } else {
+            log_info("Ignoring invalid NARRATIVE_CONCURRENCY value: %s", narrative_threads_env);
+        }
+    }
+    int narrative_attempts = NARRATIVE_DEFAULT_ATTEMPTS;
+    const char *narrative_attempts_env = getenv("NARRATIVE_MAX_ATTEMPTS");
+    if (narrative_attempts_env && narrative_attempts_env[0] != '\0') {
+        int parsed = atoi(narrative_attempts_env);
+        if (parsed >= 1 && parsed <= 10) {
+            narrative_attempts = parsed;
+        } else {
+            log_info("Ignoring invalid NARRATIVE_MAX_ATTEMPTS value: %s", narrative_attempts_env);
+        }
+    }
+    if (!narrative_pool_start(narrative_threads, narrative_attempts)) {
+        log_error("Failed to start narrative threads; narratives will run on report workers");
+    }
+
     conn = PQconnectdb(dsn);
     if (PQstatus(conn) != CONNECTION_OK) {
         log_error("Failed to connect to database: %s", PQerrorMessage(conn));
@@ -18059,11 +20891,86 @@ int main(int argc, char **argv) {
         goto cleanup;
     }
 
-    if (pthread_create(&g_report_thread, NULL, report_worker_main, NULL) != 0) {
-        log_error("Failed to start report worker thread");
+    if (migrate_artifacts_only || render_photo_derivatives_only) {
+        bool ok = true;
+        if (migrate_artifacts_only) {
+            ok = migrate_report_artifacts(conn) && ok;
+        }
+        if (render_photo_derivatives_only) {
+            ok = backfill_photo_derivatives(conn) && ok;
+        }
+        exit_code = ok ? 0 : 1;
+        goto cleanup;
+    }
+
+    resolve_report_lease_settings();
+
+    if (g_narrative_cache_enabled) {
+        char *prune_error = NULL;
+        if (!db_narrative_cache_prune(conn, g_narrative_cache_version, g_narrative_cache_max_age_days, &prune_error)) {
+            log_error("Failed to prune narrative cache: %s", prune_error ? prune_error : "unknown error");
+        }
+        free(prune_error);
+    }
+
+    if (!AUDIT_REPORT_WORKER_ONLY) {
+        /* Catches blobs orphaned by deleted audits or by an ingest-time prune that failed. */
+        long pruned = 0;
+        char *prune_error = NULL;
+        if (!db_prune_photo_blobs(conn, NULL, 0, &pruned, &prune_error)) {
+            log_error("Failed to prune photo blobs: %s", prune_error ? prune_error : "unknown error");
+        } else if (pruned > 0) {
+            log_info("Pruned %ld unreferenced photo blobs", pruned);
+        }
+        free(prune_error);
+    }
+
+    if (AUDIT_REPORT_WORKER_ONLY) {
+        PQfinish(conn);
+        conn = NULL;
+        if (!start_report_workers(resolve_report_worker_count())) {
+            goto cleanup;
+        }
+        int received = 0;
+        sigwait(&shutdown_signals, &received);
+        log_info("Received signal %d; stopping report workers", received);
+        exit_code = 0;
+        goto cleanup;
+    }
+
+    if (!start_report_workers(resolve_report_worker_count())) {
         goto cleanup;
     }
-    g_report_thread_started = true;
+
+    const char *prefetch_env = getenv("NARRATIVE_PREFETCH");
+    bool prefetch_enabled = false;
+    if (prefetch_env && prefetch_env[0] != '\0') {
+        if (strcasecmp(prefetch_env, "on") == 0 || strcmp(prefetch_env, "1") == 0 || strcasecmp(prefetch_env, "true") == 0) {
+            prefetch_enabled = true;
+        } else if (strcasecmp(prefetch_env, "off") != 0 && strcmp(prefetch_env, "0") != 0 && strcasecmp(prefetch_env, "false") != 0) {
+            log_info("Ignoring invalid NARRATIVE_PREFETCH value: %s", prefetch_env);
+        }
+    }
+    if (prefetch_enabled) {
+        int prefetch_threads = NARRATIVE_PREFETCH_DEFAULT_CONCURRENCY;
+        const char *prefetch_threads_env = getenv("NARRATIVE_PREFETCH_CONCURRENCY");
+        if (prefetch_threads_env && prefetch_threads_env[0] != '\0') {
+            int parsed = atoi(prefetch_threads_env);
+            if (parsed >= 1 && parsed <= NARRATIVE_MAX_CONCURRENCY) {
+                prefetch_threads = parsed;
+            } else {
+                log_info("Ignoring invalid NARRATIVE_PREFETCH_CONCURRENCY value: %s", prefetch_threads_env);
+            }
+        }
+        if (!g_narrative_cache_enabled || !g_xai_api_key) {
+            log_info("Narrative prefetch needs NARRATIVE_CACHE and XAI_API_KEY; not starting it");
+        } else {
+            narrative_pool_set_background_limit(prefetch_threads);
+            if (start_narrative_prefetch()) {
+                log_info("Narrative prefetch enabled (%d concurrent call%s)", prefetch_threads, prefetch_threads == 1 ? "" : "s");
+            }
+        }
+    }
 
     int port = DEFAULT_PORT;
     const char *port_env = getenv("WEBHOOK_PORT");
@@ -18081,14 +20988,10 @@ cleanup:
         PQfinish(conn);
         conn = NULL;
     }
-    pthread_mutex_lock(&g_report_mutex);
-    g_report_stop = true;
-    pthread_cond_broadcast(&g_report_cond);
-    pthread_mutex_unlock(&g_report_mutex);
-    if (g_report_thread_started) {
-        pthread_join(g_report_thread, NULL);
-        g_report_thread_started = false;
-    }
+    stop_report_workers();
+    narrative_pool_stop();
+    stop_narrative_prefetch();
+    http_client_stop();
     free(g_api_key);
     g_api_key = NULL;
     free(g_api_prefix);
@@ -18097,6 +21000,7 @@ cleanup:
     g_static_dir = NULL;
     free(g_report_output_dir);
     g_report_output_dir = NULL;
+    artifact_store_close(&g_artifact_store);
     free(g_report_assets_dir);
     g_report_assets_dir = NULL;
     free(g_xai_api_key);
@@ -18105,6 +21009,10 @@ cleanup:
     g_google_api_key = NULL;
     free(g_google_region_code);
     g_google_region_code = NULL;
+    free(g_xai_api_url);
+    g_xai_api_url = NULL;
+    free(g_google_address_url);
+    g_google_address_url = NULL;
     if (g_curl_initialized) {
         curl_global_cleanup();
         g_curl_initialized = false;
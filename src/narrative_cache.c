@@ -0,0 +1,183 @@
+#include "narrative_cache.h"
+
+#include "buffer.h"
+#include "log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void narrative_cache_key(int version,
+                         const char *model,
+                         const char *system_prompt,
+                         const char *user_prompt,
+                         char key_out[SHA256_HEX_SIZE]) {
+    char version_buf[16];
+    int version_len = snprintf(version_buf, sizeof(version_buf), "v%d", version);
+    const char *parts[] = { model ? model : "", system_prompt ? system_prompt : "", user_prompt ? user_prompt : "" };
+
+    Sha256 ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, version_buf, (size_t)version_len);
+    for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]); ++i) {
+        /* The terminator separates fields so moving text between prompts changes the key. */
+        sha256_update(&ctx, parts[i], strlen(parts[i]) + 1);
+    }
+    sha256_final_hex(&ctx, key_out);
+}
+
+int db_narrative_cache_lookup(PGconn *conn,
+                              const char *const *keys,
+                              size_t count,
+                              int max_age_days,
+                              char **responses_out,
+                              size_t *hits_out,
+                              char **error_out) {
+    if (hits_out) {
+        *hits_out = 0;
+    }
+    if (!conn || (!keys && count > 0) || (!responses_out && count > 0)) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Invalid narrative cache parameters");
+        }
+        return 0;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        responses_out[i] = NULL;
+    }
+    if (count == 0) {
+        return 1;
+    }
+
+    Buffer array;
+    int ok = buffer_init(&array) && buffer_append_char(&array, '{');
+    for (size_t i = 0; ok && i < count; ++i) {
+        ok = (i == 0 || buffer_append_char(&array, ',')) && buffer_append_cstr(&array, keys[i]);
+    }
+    ok = ok && buffer_append_char(&array, '}');
+    if (!ok) {
+        buffer_free(&array);
+        if (error_out && !*error_out) {
+            *error_out = strdup("Out of memory building narrative cache lookup");
+        }
+        return 0;
+    }
+
+    char age_buf[16];
+    snprintf(age_buf, sizeof(age_buf), "%d", max_age_days);
+    const char *params[2] = { array.data, age_buf };
+    PGresult *res = PQexecParams(conn,
+                                 "UPDATE narrative_cache "
+                                 "SET last_used_at = NOW(), hit_count = hit_count + 1 "
+                                 "WHERE prompt_hash = ANY($1::text[]) "
+                                 "AND ($2::int <= 0 OR created_at > NOW() - make_interval(days => $2::int)) "
+                                 "RETURNING prompt_hash, response",
+                                 2, NULL, params, NULL, NULL, 0);
+    buffer_free(&array);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        if (error_out && !*error_out) {
+            const char *msg = PQresultErrorMessage(res);
+            *error_out = strdup(msg && msg[0] ? msg : "Narrative cache lookup failed");
+        }
+        PQclear(res);
+        return 0;
+    }
+
+    size_t hits = 0;
+    int rows = PQntuples(res);
+    for (int row = 0; row < rows; ++row) {
+        const char *hash = PQgetvalue(res, row, 0);
+        const char *response = PQgetvalue(res, row, 1);
+        /* The same prompt can appear twice in one report (identical devices). */
+        for (size_t i = 0; i < count; ++i) {
+            if (responses_out[i] || strcmp(keys[i], hash) != 0) {
+                continue;
+            }
+            responses_out[i] = strdup(response);
+            if (!responses_out[i]) {
+                for (size_t j = 0; j < count; ++j) {
+                    free(responses_out[j]);
+                    responses_out[j] = NULL;
+                }
+                PQclear(res);
+                if (error_out && !*error_out) {
+                    *error_out = strdup("Out of memory reading narrative cache");
+                }
+                return 0;
+            }
+            hits++;
+        }
+    }
+    PQclear(res);
+    if (hits_out) {
+        *hits_out = hits;
+    }
+    return 1;
+}
+
+int db_narrative_cache_store(PGconn *conn,
+                             const char *key,
+                             const char *model,
+                             int version,
+                             const char *response,
+                             char **error_out) {
+    if (!conn || !key || !response) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Invalid narrative cache parameters");
+        }
+        return 0;
+    }
+    char version_buf[16];
+    snprintf(version_buf, sizeof(version_buf), "%d", version);
+    const char *params[4] = { key, model ? model : "", version_buf, response };
+    PGresult *res = PQexecParams(conn,
+                                 "INSERT INTO narrative_cache (prompt_hash, model, cache_version, response) "
+                                 "VALUES ($1, $2, $3::int, $4) "
+                                 "ON CONFLICT (prompt_hash) DO UPDATE "
+                                 "SET response = EXCLUDED.response, model = EXCLUDED.model, "
+                                 "cache_version = EXCLUDED.cache_version, created_at = NOW(), last_used_at = NOW()",
+                                 4, NULL, params, NULL, NULL, 0);
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        if (error_out && !*error_out) {
+            const char *msg = PQresultErrorMessage(res);
+            *error_out = strdup(msg && msg[0] ? msg : "Failed to store narrative");
+        }
+        PQclear(res);
+        return 0;
+    }
+    PQclear(res);
+    return 1;
+}
+
+int db_narrative_cache_prune(PGconn *conn, int version, int max_age_days, char **error_out) {
+    if (!conn) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Invalid narrative cache parameters");
+        }
+        return 0;
+    }
+    char version_buf[16];
+    char age_buf[16];
+    snprintf(version_buf, sizeof(version_buf), "%d", version);
+    snprintf(age_buf, sizeof(age_buf), "%d", max_age_days);
+    const char *params[2] = { version_buf, age_buf };
+    PGresult *res = PQexecParams(conn,
+                                 "DELETE FROM narrative_cache "
+                                 "WHERE cache_version <> $1::int "
+                                 "OR ($2::int > 0 AND created_at <= NOW() - make_interval(days => $2::int))",
+                                 2, NULL, params, NULL, NULL, 0);
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        if (error_out && !*error_out) {
+            const char *msg = PQresultErrorMessage(res);
+            *error_out = strdup(msg && msg[0] ? msg : "Failed to prune narrative cache");
+        }
+        PQclear(res);
+        return 0;
+    }
+    const char *affected = PQcmdTuples(res);
+    if (affected && affected[0] && strcmp(affected, "0") != 0) {
+        log_info("Pruned %s narrative cache entr%s", affected, strcmp(affected, "1") == 0 ? "y" : "ies");
+    }
+    PQclear(res);
+    return 1;
+}
@@ -0,0 +1,417 @@
+#include "narrative_pool.h"
+
+#include "log.h"
+#include "narrative.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NARRATIVE_RETRY_BASE_MS 1000
+#define NARRATIVE_RETRY_CAP_MS 30000
+#define NARRATIVE_RETRY_AFTER_CAP_S 120
+
+struct NarrativeBatch {
+    NarrativeRequest *head;
+    NarrativeRequest *tail;
+    size_t outstanding;
+    bool ready;
+    bool background;
+    /* Set when a timed wait gave up; later completions no longer mark requests finished. */
+    bool frozen;
+    bool released;
+    void (*on_drained)(void *context);
+    void *drained_context;
+    struct NarrativeBatch *ready_next;
+    pthread_cond_t done;
+};
+
+static pthread_mutex_t g_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_pool_work = PTHREAD_COND_INITIALIZER;
+static pthread_t *g_pool_threads = NULL;
+static int g_pool_thread_count = 0;
+static bool g_pool_stop = false;
+static int g_pool_max_attempts = 4;
+/* Batches with queued requests, served one request at a time in rotation. Background
+   batches are only served when no report batch is waiting, by at most
+   g_pool_background_limit threads at once. */
+static NarrativeBatch *g_ready_head = NULL;
+static NarrativeBatch *g_ready_tail = NULL;
+static NarrativeBatch *g_background_head = NULL;
+static NarrativeBatch *g_background_tail = NULL;
+static int g_pool_background_limit = 1;
+static int g_pool_background_active = 0;
+/* CLOCK_MONOTONIC milliseconds before which no thread may start a call (set by 429s). */
+static int64_t g_pool_paused_until = 0;
+
+static int64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int64_t narrative_pool_now_ms(void) {
+    return monotonic_ms();
+}
+
+static void narrative_batch_free(NarrativeBatch *batch) {
+    pthread_cond_destroy(&batch->done);
+    free(batch);
+}
+
+static void sleep_ms(int64_t ms) {
+    if (ms <= 0) {
+        return;
+    }
+    struct timespec ts = { (time_t)(ms / 1000), (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+static uint64_t next_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+static uint64_t random_seed(const void *salt) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t seed = ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)ts.tv_nsec ^ (uint64_t)(uintptr_t)salt;
+    return seed ? seed : 0x9e3779b97f4a7c15ULL;
+}
+
+static void wait_for_pause(void) {
+    pthread_mutex_lock(&g_pool_mutex);
+    int64_t remaining = g_pool_paused_until - monotonic_ms();
+    pthread_mutex_unlock(&g_pool_mutex);
+    sleep_ms(remaining);
+}
+
+static void extend_pause(int64_t until) {
+    pthread_mutex_lock(&g_pool_mutex);
+    if (until > g_pool_paused_until) {
+        g_pool_paused_until = until;
+    }
+    pthread_mutex_unlock(&g_pool_mutex);
+}
+
+static void execute_request(NarrativeRequest *request, uint64_t *rng) {
+    request->success = 0;
+    for (int attempt = 1;; ++attempt) {
+        wait_for_pause();
+        char *response = NULL;
+        char *error = NULL;
+        long status = 0;
+        long retry_after = 0;
+        request->attempts = attempt;
+        if (generate_grok_completion_ex(request->system_prompt, request->user_prompt, request->max_tokens, &response, &status, &retry_after, &error)) {
+            free(request->error);
+            request->error = NULL;
+            request->response = response;
+            request->success = 1;
+            return;
+        }
+        free(request->error);
+        request->error = error ? error : strdup("Narrative generation failed");
+
+        bool retryable = status == 0 || status == 429 || status >= 500;
+        if (!retryable || attempt >= g_pool_max_attempts) {
+            return;
+        }
+
+        /* A random point in the upper half of the exponential step keeps retries from
+           several jobs from landing on the provider in lockstep. */
+        int64_t step = NARRATIVE_RETRY_BASE_MS << (attempt - 1);
+        if (step > NARRATIVE_RETRY_CAP_MS) {
+            step = NARRATIVE_RETRY_CAP_MS;
+        }
+        int64_t delay = step / 2 + (int64_t)(next_random(rng) % (uint64_t)(step / 2 + 1));
+        if (retry_after > 0) {
+            int64_t server_delay = (retry_after > NARRATIVE_RETRY_AFTER_CAP_S ? NARRATIVE_RETRY_AFTER_CAP_S : retry_after) * 1000;
+            if (server_delay > delay) {
+                delay = server_delay;
+            }
+        }
+        log_info("Narrative request failed (HTTP %ld); retrying in %lld ms (attempt %d of %d)",
+                 status,
+                 (long long)delay,
+                 attempt + 1,
+                 g_pool_max_attempts);
+        if (status == 429) {
+            extend_pause(monotonic_ms() + delay);
+        } else {
+            sleep_ms(delay);
+        }
+    }
+}
+
+static bool background_runnable(void) {
+    return g_background_head && (g_pool_stop || g_pool_background_active < g_pool_background_limit);
+}
+
+static void *narrative_pool_main(void *arg) {
+    uint64_t rng = random_seed(arg);
+    pthread_mutex_lock(&g_pool_mutex);
+    for (;;) {
+        while (!g_ready_head && !background_runnable() && !(g_pool_stop && !g_background_head)) {
+            pthread_cond_wait(&g_pool_work, &g_pool_mutex);
+        }
+        if (!g_ready_head && !g_background_head) {
+            break;
+        }
+
+        bool background = !g_ready_head;
+        NarrativeBatch **head = background ? &g_background_head : &g_ready_head;
+        NarrativeBatch **tail = background ? &g_background_tail : &g_ready_tail;
+        NarrativeBatch *batch = *head;
+        *head = batch->ready_next;
+        if (!*head) {
+            *tail = NULL;
+        }
+        batch->ready_next = NULL;
+
+        NarrativeRequest *request = batch->head;
+        batch->head = request->next;
+        if (!batch->head) {
+            batch->tail = NULL;
+        }
+        request->next = NULL;
+
+        if (batch->head) {
+            /* Back of the line: every other job gets a request in before this one's next. */
+            if (*tail) {
+                (*tail)->ready_next = batch;
+            } else {
+                *head = batch;
+            }
+            *tail = batch;
+        } else {
+            batch->ready = false;
+        }
+        bool skip = background && g_pool_stop;
+        if (background) {
+            g_pool_background_active++;
+        }
+        pthread_mutex_unlock(&g_pool_mutex);
+
+        if (skip) {
+            /* Speculative work is dropped at shutdown rather than holding it up. */
+            request->success = 0;
+            request->error = strdup("Narrative pool stopping");
+        } else {
+            execute_request(request, &rng);
+        }
+
+        pthread_mutex_lock(&g_pool_mutex);
+        if (background) {
+            g_pool_background_active--;
+            pthread_cond_signal(&g_pool_work);
+        }
+        if (!batch->frozen) {
+            request->finished = 1;
+        }
+        batch->outstanding--;
+        if (batch->outstanding == 0) {
+            if (batch->released) {
+                pthread_mutex_unlock(&g_pool_mutex);
+                if (batch->on_drained) {
+                    batch->on_drained(batch->drained_context);
+                }
+                narrative_batch_free(batch);
+                pthread_mutex_lock(&g_pool_mutex);
+            } else {
+                pthread_cond_broadcast(&batch->done);
+            }
+        }
+    }
+    pthread_mutex_unlock(&g_pool_mutex);
+    return NULL;
+}
+
+int narrative_pool_start(int threads, int max_attempts) {
+    if (threads <= 0) {
+        return 0;
+    }
+    pthread_mutex_lock(&g_pool_mutex);
+    if (g_pool_threads) {
+        pthread_mutex_unlock(&g_pool_mutex);
+        return 1;
+    }
+    g_pool_threads = calloc((size_t)threads, sizeof(pthread_t));
+    if (!g_pool_threads) {
+        pthread_mutex_unlock(&g_pool_mutex);
+        return 0;
+    }
+    g_pool_stop = false;
+    g_pool_max_attempts = max_attempts > 0 ? max_attempts : 1;
+    pthread_mutex_unlock(&g_pool_mutex);
+
+    for (int i = 0; i < threads; ++i) {
+        if (pthread_create(&g_pool_threads[i], NULL, narrative_pool_main, (void *)(intptr_t)(i + 1)) != 0) {
+            log_error("Failed to start narrative thread %d", i);
+            break;
+        }
+        pthread_mutex_lock(&g_pool_mutex);
+        g_pool_thread_count = i + 1;
+        pthread_mutex_unlock(&g_pool_mutex);
+    }
+    if (g_pool_thread_count == 0) {
+        free(g_pool_threads);
+        g_pool_threads = NULL;
+        return 0;
+    }
+    log_info("Started %d narrative thread%s", g_pool_thread_count, g_pool_thread_count == 1 ? "" : "s");
+    return 1;
+}
+
+void narrative_pool_set_background_limit(int threads) {
+    pthread_mutex_lock(&g_pool_mutex);
+    g_pool_background_limit = threads > 0 ? threads : 1;
+    pthread_cond_broadcast(&g_pool_work);
+    pthread_mutex_unlock(&g_pool_mutex);
+}
+
+void narrative_pool_stop(void) {
+    pthread_mutex_lock(&g_pool_mutex);
+    g_pool_stop = true;
+    pthread_cond_broadcast(&g_pool_work);
+    int count = g_pool_thread_count;
+    pthread_mutex_unlock(&g_pool_mutex);
+    for (int i = 0; i < count; ++i) {
+        pthread_join(g_pool_threads[i], NULL);
+    }
+    pthread_mutex_lock(&g_pool_mutex);
+    free(g_pool_threads);
+    g_pool_threads = NULL;
+    g_pool_thread_count = 0;
+    pthread_mutex_unlock(&g_pool_mutex);
+}
+
+NarrativeBatch *narrative_batch_create(void) {
+    NarrativeBatch *batch = calloc(1, sizeof(*batch));
+    if (!batch) {
+        return NULL;
+    }
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&batch->done, &attr);
+    pthread_condattr_destroy(&attr);
+    return batch;
+}
+
+NarrativeBatch *narrative_batch_create_background(void) {
+    NarrativeBatch *batch = narrative_batch_create();
+    if (batch) {
+        batch->background = true;
+    }
+    return batch;
+}
+
+void narrative_batch_submit(NarrativeBatch *batch, NarrativeRequest *request) {
+    if (!batch || !request) {
+        return;
+    }
+    request->response = NULL;
+    request->error = NULL;
+    request->success = 0;
+    request->attempts = 0;
+    request->finished = 0;
+    request->next = NULL;
+
+    pthread_mutex_lock(&g_pool_mutex);
+    if ((g_pool_thread_count == 0 || g_pool_stop) && batch->background) {
+        pthread_mutex_unlock(&g_pool_mutex);
+        request->error = strdup("Narrative pool not running");
+        request->finished = 1;
+        return;
+    }
+    if (g_pool_thread_count == 0 || g_pool_stop) {
+        pthread_mutex_unlock(&g_pool_mutex);
+        uint64_t rng = random_seed(request);
+        execute_request(request, &rng);
+        request->finished = 1;
+        return;
+    }
+    if (batch->tail) {
+        batch->tail->next = request;
+    } else {
+        batch->head = request;
+    }
+    batch->tail = request;
+    batch->outstanding++;
+    if (!batch->ready) {
+        batch->ready = true;
+        NarrativeBatch **head = batch->background ? &g_background_head : &g_ready_head;
+        NarrativeBatch **tail = batch->background ? &g_background_tail : &g_ready_tail;
+        if (*tail) {
+            (*tail)->ready_next = batch;
+        } else {
+            *head = batch;
+        }
+        *tail = batch;
+    }
+    pthread_cond_signal(&g_pool_work);
+    pthread_mutex_unlock(&g_pool_mutex);
+}
+
+void narrative_batch_wait(NarrativeBatch *batch) {
+    if (!batch) {
+        return;
+    }
+    pthread_mutex_lock(&g_pool_mutex);
+    while (batch->outstanding > 0) {
+        pthread_cond_wait(&batch->done, &g_pool_mutex);
+    }
+    pthread_mutex_unlock(&g_pool_mutex);
+    narrative_batch_free(batch);
+}
+
+int narrative_batch_wait_until(NarrativeBatch *batch, int64_t deadline_ms) {
+    if (!batch) {
+        return 1;
+    }
+    struct timespec deadline = { (time_t)(deadline_ms / 1000), (long)(deadline_ms % 1000) * 1000000L };
+    pthread_mutex_lock(&g_pool_mutex);
+    while (batch->outstanding > 0) {
+        if (pthread_cond_timedwait(&batch->done, &g_pool_mutex, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    if (batch->outstanding > 0) {
+        batch->frozen = true;
+        pthread_mutex_unlock(&g_pool_mutex);
+        return 0;
+    }
+    pthread_mutex_unlock(&g_pool_mutex);
+    narrative_batch_free(batch);
+    return 1;
+}
+
+void narrative_batch_release(NarrativeBatch *batch, void (*on_drained)(void *context), void *context) {
+    if (!batch) {
+        return;
+    }
+    pthread_mutex_lock(&g_pool_mutex);
+    batch->frozen = true;
+    if (batch->outstanding > 0) {
+        batch->released = true;
+        batch->on_drained = on_drained;
+        batch->drained_context = context;
+        pthread_mutex_unlock(&g_pool_mutex);
+        return;
+    }
+    pthread_mutex_unlock(&g_pool_mutex);
+    if (on_drained) {
+        on_drained(context);
+    }
+    narrative_batch_free(batch);
+}
@@ -0,0 +1,352 @@
+#include "number_format.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EXACT_INT_LIMIT 9007199254740992.0 /* 2^53 */
+
+static const char DIGIT_PAIRS[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const double POW10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const uint64_t POW10_U64[] = {
+    1ULL,
+    10ULL,
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL
+};
+
+/* Writes digits right-aligned ending at `end` and returns the first written position. */
+static char *write_digits_backwards(char *end, uint64_t value) {
+    char *p = end;
+    while (value >= 100) {
+        unsigned idx = (unsigned)(value % 100) * 2;
+        value /= 100;
+        p -= 2;
+        p[0] = DIGIT_PAIRS[idx];
+        p[1] = DIGIT_PAIRS[idx + 1];
+    }
+    if (value >= 10) {
+        unsigned idx = (unsigned)value * 2;
+        p -= 2;
+        p[0] = DIGIT_PAIRS[idx];
+        p[1] = DIGIT_PAIRS[idx + 1];
+    } else {
+        *--p = (char)('0' + value);
+    }
+    return p;
+}
+
+size_t format_uint64(char *out, uint64_t value) {
+    char tmp[20];
+    char *end = tmp + sizeof(tmp);
+    char *start = write_digits_backwards(end, value);
+    size_t len = (size_t)(end - start);
+    memcpy(out, start, len);
+    out[len] = '\0';
+    return len;
+}
+
+size_t format_int64(char *out, int64_t value) {
+    uint64_t magnitude = (uint64_t)value;
+    size_t neg = value < 0;
+    /* Two's complement negate keeps INT64_MIN well defined. */
+    magnitude = neg ? (~magnitude + 1) : magnitude;
+    out[0] = '-';
+    return neg + format_uint64(out + neg, magnitude);
+}
+
+static size_t format_grouped_uint64(char *out, uint64_t value) {
+    char tmp[32];
+    char *p = tmp + sizeof(tmp);
+    int digits = 0;
+    do {
+        if (digits > 0 && digits % 3 == 0) {
+            *--p = ',';
+        }
+        *--p = (char)('0' + value % 10);
+        value /= 10;
+        digits++;
+    } while (value > 0);
+    size_t len = (size_t)(tmp + sizeof(tmp) - p);
+    memcpy(out, p, len);
+    out[len] = '\0';
+    return len;
+}
+
+static size_t format_fixed_fallback(char *out, double value, int precision, bool group_thousands) {
+    char tmp[NUMBER_FORMAT_MAX * 8];
+    int written = snprintf(tmp, sizeof(tmp), "%.*f", precision, value);
+    if (written < 0 || (size_t)written >= sizeof(tmp) ||
+        (!group_thousands && (size_t)written >= NUMBER_FORMAT_MAX)) {
+        out[0] = '\0';
+        return 0;
+    }
+    if (!group_thousands || !isfinite(value)) {
+        memcpy(out, tmp, (size_t)written + 1);
+        return (size_t)written;
+    }
+    const char *digits = tmp;
+    size_t o = 0;
+    if (*digits == '-') {
+        out[o++] = *digits++;
+    }
+    size_t int_len = strcspn(digits, ".");
+    for (size_t i = 0; i < int_len; ++i) {
+        if (o + 2 >= NUMBER_FORMAT_MAX) {
+            break;
+        }
+        if (i > 0 && (int_len - i) % 3 == 0) {
+            out[o++] = ',';
+        }
+        out[o++] = digits[i];
+    }
+    size_t rest = strlen(digits + int_len);
+    if (o + rest >= NUMBER_FORMAT_MAX) {
+        rest = NUMBER_FORMAT_MAX - 1 - o;
+    }
+    memcpy(out + o, digits + int_len, rest);
+    o += rest;
+    out[o] = '\0';
+    return o;
+}
+
+size_t format_double_fixed(char *out, double value, int precision, bool group_thousands) {
+    if (precision < 0) {
+        precision = 0;
+    } else if (precision > 9) {
+        precision = 9;
+    }
+    double scale = POW10[precision];
+    double magnitude = fabs(value);
+    double scaled = magnitude * scale;
+    if (!isfinite(value) || scaled >= EXACT_INT_LIMIT) {
+        return format_fixed_fallback(out, value, precision, group_thousands);
+    }
+
+    /* Round the exact binary value half-to-even, as printf does. The product is
+       exact below 2^53 except for its last bit, so only a computed tie needs the
+       FMA residual to learn which side of the midpoint the true value lies on. */
+    double whole = floor(scaled);
+    double frac = scaled - whole;
+    if (frac > 0.5) {
+        whole += 1.0;
+    } else if (frac == 0.5) {
+        double residual = fma(magnitude, scale, -scaled);
+        if (residual > 0.0 || (residual == 0.0 && fmod(whole, 2.0) != 0.0)) {
+            whole += 1.0;
+        }
+    }
+
+    uint64_t units = (uint64_t)whole;
+    uint64_t divisor = POW10_U64[precision];
+    uint64_t int_part = units / divisor;
+    uint64_t frac_part = units % divisor;
+
+    size_t o = 0;
+    if (signbit(value)) {
+        out[o++] = '-';
+    }
+    if (group_thousands) {
+        o += format_grouped_uint64(out + o, int_part);
+    } else {
+        o += format_uint64(out + o, int_part);
+    }
+    if (precision > 0) {
+        out[o++] = '.';
+        char *end = out + o + precision;
+        char *start = write_digits_backwards(end, frac_part);
+        while (start > out + o) {
+            *--start = '0';
+        }
+        o += (size_t)precision;
+    }
+    out[o] = '\0';
+    return o;
+}
+
+size_t format_double_shortest(char *out, double value) {
+    if (!isfinite(value)) {
+        int written = snprintf(out, NUMBER_FORMAT_MAX, "%g", value);
+        return written > 0 ? (size_t)written : 0;
+    }
+    double magnitude = fabs(value);
+    size_t o = 0;
+    if (signbit(value)) {
+        out[o++] = '-';
+    }
+    if (magnitude < EXACT_INT_LIMIT && magnitude == floor(magnitude)) {
+        return o + format_uint64(out + o, (uint64_t)magnitude);
+    }
+
+    /* Fewest fractional digits whose correctly rounded quotient reproduces the
+       input is also the fewest significant digits in fixed notation. Both operands
+       are exact integers below 2^53, so the division is the same rounding strtod
+       would perform on the emitted text. */
+    if (magnitude >= 1e-5 && magnitude < 1e15) {
+        for (int k = 1; k <= 17; ++k) {
+            double scaled = nearbyint(magnitude * POW10[k]);
+            if (scaled >= EXACT_INT_LIMIT) {
+                break;
+            }
+            if (scaled / POW10[k] != magnitude) {
+                continue;
+            }
+            uint64_t units = (uint64_t)scaled;
+            uint64_t int_part = (uint64_t)(units / (uint64_t)POW10[k]);
+            uint64_t frac_part = units - int_part * (uint64_t)POW10[k];
+            o += format_uint64(out + o, int_part);
+            out[o++] = '.';
+            char *end = out + o + k;
+            char *start = write_digits_backwards(end, frac_part);
+            while (start > out + o) {
+                *--start = '0';
+            }
+            o += (size_t)k;
+            out[o] = '\0';
+            return o;
+        }
+    }
+
+    for (int digits = 15; digits <= 17; ++digits) {
+        int written = snprintf(out, NUMBER_FORMAT_MAX, "%.*g", digits, value);
+        if (written <= 0) {
+            break;
+        }
+        if (digits == 17 || strtod(out, NULL) == value) {
+            return (size_t)written;
+        }
+    }
+    out[0] = '\0';
+    return 0;
+}
+
+double parse_decimal_double(const char *text, const char **end_out) {
+    if (!text) {
+        if (end_out) {
+            *end_out = NULL;
+        }
+        return 0.0;
+    }
+    const char *p = text;
+    while (isspace((unsigned char)*p)) {
+        p++;
+    }
+    bool negative = false;
+    if (*p == '-' || *p == '+') {
+        negative = *p == '-';
+        p++;
+    }
+    if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+        goto slow_path;
+    }
+
+    uint64_t mantissa = 0;
+    int significant = 0;
+    int exponent = 0;
+    bool any_digit = false;
+    while (*p >= '0' && *p <= '9') {
+        any_digit = true;
+        if (mantissa != 0 || *p != '0') {
+            if (significant >= 19) {
+                goto slow_path;
+            }
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            significant++;
+        }
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        while (*p >= '0' && *p <= '9') {
+            any_digit = true;
+            if (mantissa != 0 || *p != '0') {
+                if (significant >= 19) {
+                    goto slow_path;
+                }
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                significant++;
+            }
+            exponent--;
+            p++;
+        }
+    }
+    if (!any_digit) {
+        goto slow_path;
+    }
+    if (*p == 'e' || *p == 'E') {
+        const char *q = p + 1;
+        bool exp_negative = false;
+        if (*q == '-' || *q == '+') {
+            exp_negative = *q == '-';
+            q++;
+        }
+        if (*q >= '0' && *q <= '9') {
+            int exp_value = 0;
+            while (*q >= '0' && *q <= '9') {
+                if (exp_value > 10000) {
+                    goto slow_path;
+                }
+                exp_value = exp_value * 10 + (*q - '0');
+                q++;
+            }
+            exponent += exp_negative ? -exp_value : exp_value;
+            p = q;
+        }
+    }
+
+    /* Clinger's fast path: both factors are exact doubles, so one IEEE operation
+       yields the correctly rounded result. */
+    if (mantissa > (1ULL << 53) || exponent < -22 || exponent > 22) {
+        if (mantissa == 0) {
+            if (end_out) {
+                *end_out = p;
+            }
+            return negative ? -0.0 : 0.0;
+        }
+        goto slow_path;
+    }
+    double result = (double)mantissa;
+    if (exponent < 0) {
+        result /= POW10[-exponent];
+    } else {
+        result *= POW10[exponent];
+    }
+    if (end_out) {
+        *end_out = p;
+    }
+    return negative ? -result : result;
+
+slow_path:
+    {
+        char *end = NULL;
+        double value = strtod(text, &end);
+        if (end_out) {
+            *end_out = end;
+        }
+        return value;
+    }
+}
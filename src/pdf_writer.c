@@ -0,0 +1,650 @@
+#include "pdf_writer.h"
+
+#include "buffer.h"
+#include "fsutil.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#define PDF_MAX_OPACITIES 8
+#define PDF_MAX_IMAGE_SIDE 16384
+
+typedef struct {
+    unsigned width;
+    unsigned height;
+    int components; /* 1 = gray, 3 = RGB */
+    unsigned char *color;
+    size_t color_size;
+    unsigned char *alpha; /* NULL when fully opaque */
+    size_t alpha_size;
+} PdfImage;
+
+struct PdfDocument {
+    double width;
+    double height;
+    Buffer *pages;
+    size_t page_count;
+    size_t page_capacity;
+    PdfImage *images;
+    size_t image_count;
+    size_t image_capacity;
+    double opacities[PDF_MAX_OPACITIES];
+    size_t opacity_count;
+};
+
+static const char *const FONT_NAMES[PDF_FONT_COUNT] = {"Helvetica", "Helvetica-Bold", "Helvetica-Oblique"};
+
+/* AFM advance widths for ASCII 32..126; the oblique face shares Helvetica's. */
+static const unsigned short HELVETICA_WIDTHS[95] = {
+    278, 278, 355, 556, 556, 889, 667, 191, 333, 333, 389, 584, 278, 333, 278, 278,
+    556, 556, 556, 556, 556, 556, 556, 556, 556, 556, 278, 278, 584, 584, 584, 556,
+    1015, 667, 667, 722, 722, 667, 611, 778, 722, 278, 500, 667, 556, 833, 722, 778,
+    667, 778, 722, 667, 611, 722, 667, 944, 667, 667, 611, 278, 278, 278, 469, 556,
+    333, 556, 556, 500, 556, 556, 278, 556, 556, 222, 222, 500, 222, 833, 556, 556,
+    556, 556, 333, 500, 278, 556, 500, 722, 500, 500, 500, 334, 260, 334, 584
+};
+
+static const unsigned short HELVETICA_BOLD_WIDTHS[95] = {
+    278, 333, 474, 556, 556, 889, 722, 238, 333, 333, 389, 584, 278, 333, 278, 278,
+    556, 556, 556, 556, 556, 556, 556, 556, 556, 556, 333, 333, 584, 584, 584, 611,
+    975, 722, 722, 722, 722, 667, 611, 778, 722, 278, 556, 722, 611, 833, 722, 778,
+    667, 778, 722, 667, 611, 722, 667, 944, 667, 667, 611, 333, 278, 333, 584, 556,
+    333, 556, 611, 556, 611, 556, 333, 611, 611, 278, 278, 556, 278, 889, 611, 611,
+    611, 611, 389, 556, 333, 611, 556, 778, 556, 556, 500, 389, 280, 389, 584
+};
+
+/* Maps a byte to what the page will show: controls become spaces, non-ASCII '?'. */
+static unsigned char pdf_display_char(unsigned char c) {
+    if (c < 32) {
+        return ' ';
+    }
+    if (c > 126) {
+        return '?';
+    }
+    return c;
+}
+
+static double text_width_n(PdfFont font, double size, const char *text, size_t len) {
+    const unsigned short *widths = font == PDF_FONT_BOLD ? HELVETICA_BOLD_WIDTHS : HELVETICA_WIDTHS;
+    unsigned long total = 0;
+    for (size_t i = 0; i < len; ++i) {
+        total += widths[pdf_display_char((unsigned char)text[i]) - 32];
+    }
+    return (double)total * size / 1000.0;
+}
+
+double pdf_text_width(PdfFont font, double size, const char *text) {
+    return text ? text_width_n(font, size, text, strlen(text)) : 0.0;
+}
+
+static int wrap_flush(Buffer *line, StringArray *lines_out) {
+    int ok = string_array_append_copy(lines_out, line->data ? line->data : "");
+    line->length = 0;
+    if (line->data) {
+        line->data[0] = '\0';
+    }
+    return ok;
+}
+
+int pdf_wrap_text(PdfFont font, double size, const char *text, double max_width, StringArray *lines_out) {
+    if (!lines_out) {
+        return 0;
+    }
+    Buffer line;
+    if (!buffer_init(&line)) {
+        return 0;
+    }
+    size_t initial_count = lines_out->count;
+    double space = text_width_n(font, size, " ", 1);
+    const char *p = text ? text : "";
+    int ok = 1;
+    while (ok && *p) {
+        if (*p == '\n') {
+            if (line.length > 0) {
+                ok = wrap_flush(&line, lines_out);
+            }
+            p++;
+            continue;
+        }
+        if (isspace((unsigned char)*p)) {
+            p++;
+            continue;
+        }
+        const char *word = p;
+        while (*p && !isspace((unsigned char)*p)) {
+            p++;
+        }
+        size_t word_len = (size_t)(p - word);
+        double word_width = text_width_n(font, size, word, word_len);
+        if (line.length > 0) {
+            double line_width = text_width_n(font, size, line.data, line.length);
+            if (line_width + space + word_width <= max_width) {
+                ok = buffer_append_char(&line, ' ') && buffer_append_bytes(&line, word, word_len);
+                continue;
+            }
+            ok = wrap_flush(&line, lines_out);
+        }
+        while (ok && word_len > 0 && word_width > max_width) {
+            size_t take = 1;
+            while (take < word_len && text_width_n(font, size, word, take + 1) <= max_width) {
+                take++;
+            }
+            ok = buffer_append_bytes(&line, word, take) && wrap_flush(&line, lines_out);
+            word += take;
+            word_len -= take;
+            word_width = text_width_n(font, size, word, word_len);
+        }
+        if (ok && word_len > 0) {
+            ok = buffer_append_bytes(&line, word, word_len);
+        }
+    }
+    if (ok && (line.length > 0 || lines_out->count == initial_count)) {
+        ok = wrap_flush(&line, lines_out);
+    }
+    buffer_free(&line);
+    return ok;
+}
+
+PdfDocument *pdf_document_create(double page_width, double page_height) {
+    PdfDocument *doc = calloc(1, sizeof(*doc));
+    if (!doc) {
+        return NULL;
+    }
+    doc->width = page_width;
+    doc->height = page_height;
+    return doc;
+}
+
+void pdf_document_free(PdfDocument *doc) {
+    if (!doc) {
+        return;
+    }
+    for (size_t i = 0; i < doc->page_count; ++i) {
+        buffer_free(&doc->pages[i]);
+    }
+    free(doc->pages);
+    for (size_t i = 0; i < doc->image_count; ++i) {
+        free(doc->images[i].color);
+        free(doc->images[i].alpha);
+    }
+    free(doc->images);
+    free(doc);
+}
+
+int pdf_begin_page(PdfDocument *doc) {
+    if (!doc) {
+        return 0;
+    }
+    if (doc->page_count == doc->page_capacity) {
+        size_t capacity = doc->page_capacity ? doc->page_capacity * 2 : 8;
+        Buffer *pages = realloc(doc->pages, capacity * sizeof(*pages));
+        if (!pages) {
+            return 0;
+        }
+        doc->pages = pages;
+        doc->page_capacity = capacity;
+    }
+    if (!buffer_init(&doc->pages[doc->page_count])) {
+        return 0;
+    }
+    doc->page_count++;
+    return 1;
+}
+
+size_t pdf_page_count(const PdfDocument *doc) {
+    return doc ? doc->page_count : 0;
+}
+
+static Buffer *current_page(PdfDocument *doc) {
+    return doc && doc->page_count > 0 ? &doc->pages[doc->page_count - 1] : NULL;
+}
+
+int pdf_draw_text(PdfDocument *doc, PdfFont font, double size, double x, double y, PdfColor color, const char *text) {
+    Buffer *page = current_page(doc);
+    if (!page || (unsigned)font >= PDF_FONT_COUNT) {
+        return 0;
+    }
+    if (!text || !*text) {
+        return 1;
+    }
+    if (!buffer_appendf(page, "BT /F%d %.2f Tf %.3f %.3f %.3f rg %.2f %.2f Td (",
+                        (int)font + 1, size, color.r, color.g, color.b, x, y)) {
+        return 0;
+    }
+    for (const unsigned char *p = (const unsigned char *)text; *p; ++p) {
+        unsigned char c = pdf_display_char(*p);
+        if ((c == '(' || c == ')' || c == '\\') && !buffer_append_char(page, '\\')) {
+            return 0;
+        }
+        if (!buffer_append_char(page, (char)c)) {
+            return 0;
+        }
+    }
+    return buffer_append_cstr(page, ") Tj ET\n");
+}
+
+int pdf_fill_rect(PdfDocument *doc, double x, double y, double width, double height, PdfColor color) {
+    Buffer *page = current_page(doc);
+    if (!page) {
+        return 0;
+    }
+    return buffer_appendf(page, "%.3f %.3f %.3f rg %.2f %.2f %.2f %.2f re f\n",
+                          color.r, color.g, color.b, x, y, width, height);
+}
+
+int pdf_draw_line(PdfDocument *doc, double x1, double y1, double x2, double y2, double line_width, PdfColor color) {
+    Buffer *page = current_page(doc);
+    if (!page) {
+        return 0;
+    }
+    return buffer_appendf(page, "%.3f %.3f %.3f RG %.2f w %.2f %.2f m %.2f %.2f l S\n",
+                          color.r, color.g, color.b, line_width, x1, y1, x2, y2);
+}
+
+static int opacity_index(PdfDocument *doc, double opacity) {
+    for (size_t i = 0; i < doc->opacity_count; ++i) {
+        if (doc->opacities[i] == opacity) {
+            return (int)i;
+        }
+    }
+    if (doc->opacity_count == PDF_MAX_OPACITIES) {
+        return -1;
+    }
+    doc->opacities[doc->opacity_count] = opacity;
+    return (int)doc->opacity_count++;
+}
+
+int pdf_draw_image(PdfDocument *doc, int image, double x, double y, double width, double height, double opacity) {
+    Buffer *page = current_page(doc);
+    if (!page || image < 0 || (size_t)image >= doc->image_count) {
+        return 0;
+    }
+    if (!buffer_append_cstr(page, "q ")) {
+        return 0;
+    }
+    if (opacity < 1.0) {
+        int gs = opacity_index(doc, opacity);
+        if (gs >= 0 && !buffer_appendf(page, "/GS%d gs ", gs)) {
+            return 0;
+        }
+    }
+    return buffer_appendf(page, "%.2f 0 0 %.2f %.2f %.2f cm /Im%d Do Q\n", width, height, x, y, image);
+}
+
+static uint32_t read_be32(const unsigned char *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static unsigned char paeth(unsigned char a, unsigned char b, unsigned char c) {
+    int p = (int)a + (int)b - (int)c;
+    int pa = abs(p - (int)a);
+    int pb = abs(p - (int)b);
+    int pc = abs(p - (int)c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+/* Reverses the per-scanline PNG filters of raw into pixels (height * stride bytes). */
+static int png_unfilter(const unsigned char *raw, unsigned char *pixels, size_t height, size_t stride, size_t bpp) {
+    for (size_t y = 0; y < height; ++y) {
+        unsigned char filter = raw[y * (stride + 1)];
+        const unsigned char *in = raw + y * (stride + 1) + 1;
+        unsigned char *out = pixels + y * stride;
+        const unsigned char *prev = y > 0 ? out - stride : NULL;
+        for (size_t i = 0; i < stride; ++i) {
+            unsigned char left = i >= bpp ? out[i - bpp] : 0;
+            unsigned char up = prev ? prev[i] : 0;
+            unsigned char up_left = (prev && i >= bpp) ? prev[i - bpp] : 0;
+            switch (filter) {
+                case 0: out[i] = in[i]; break;
+                case 1: out[i] = (unsigned char)(in[i] + left); break;
+                case 2: out[i] = (unsigned char)(in[i] + up); break;
+                case 3: out[i] = (unsigned char)(in[i] + ((left + up) >> 1)); break;
+                case 4: out[i] = (unsigned char)(in[i] + paeth(left, up, up_left)); break;
+                default: return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static int deflate_bytes(const unsigned char *data, size_t size, unsigned char **out, size_t *out_size) {
+    uLongf bound = compressBound((uLong)size);
+    unsigned char *compressed = malloc(bound);
+    if (!compressed) {
+        return 0;
+    }
+    if (compress2(compressed, &bound, data, (uLong)size, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        free(compressed);
+        return 0;
+    }
+    *out = compressed;
+    *out_size = bound;
+    return 1;
+}
+
+static int png_decode(const unsigned char *data, size_t size, PdfImage *image, const char **problem) {
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    if (size < 8 || memcmp(data, signature, 8) != 0) {
+        *problem = "not a PNG file";
+        return 0;
+    }
+    uint32_t width = 0;
+    uint32_t height = 0;
+    int bit_depth = 0;
+    int color_type = -1;
+    int interlace = 0;
+    Buffer idat;
+    if (!buffer_init(&idat)) {
+        *problem = "out of memory";
+        return 0;
+    }
+    size_t pos = 8;
+    while (pos + 12 <= size) {
+        uint32_t length = read_be32(data + pos);
+        const unsigned char *type = data + pos + 4;
+        const unsigned char *body = data + pos + 8;
+        if (length > size - pos - 12) {
+            break;
+        }
+        if (memcmp(type, "IHDR", 4) == 0 && length >= 13) {
+            width = read_be32(body);
+            height = read_be32(body + 4);
+            bit_depth = body[8];
+            color_type = body[9];
+            interlace = body[12];
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            if (!buffer_append_bytes(&idat, body, length)) {
+                buffer_free(&idat);
+                *problem = "out of memory";
+                return 0;
+            }
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            break;
+        }
+        pos += 12 + (size_t)length;
+    }
+
+    size_t channels = color_type == 0 ? 1 : color_type == 2 ? 3 : color_type == 4 ? 2 : color_type == 6 ? 4 : 0;
+    if (width == 0 || height == 0 || width > PDF_MAX_IMAGE_SIDE || height > PDF_MAX_IMAGE_SIDE || idat.length == 0) {
+        buffer_free(&idat);
+        *problem = "missing or oversized image data";
+        return 0;
+    }
+    if (bit_depth != 8 || channels == 0 || interlace != 0) {
+        buffer_free(&idat);
+        *problem = "only 8-bit non-interlaced gray/RGB PNGs are supported";
+        return 0;
+    }
+
+    size_t stride = (size_t)width * channels;
+    size_t raw_size = (size_t)height * (stride + 1);
+    unsigned char *raw = malloc(raw_size);
+    unsigned char *pixels = malloc((size_t)height * stride);
+    uLongf inflated = (uLongf)raw_size;
+    int ok = raw && pixels &&
+             uncompress(raw, &inflated, (const unsigned char *)idat.data, (uLong)idat.length) == Z_OK &&
+             inflated == raw_size &&
+             png_unfilter(raw, pixels, height, stride, channels);
+    buffer_free(&idat);
+    free(raw);
+    if (!ok) {
+        free(pixels);
+        *problem = "corrupt image data";
+        return 0;
+    }
+
+    bool has_alpha = color_type == 4 || color_type == 6;
+    size_t components = has_alpha ? channels - 1 : channels;
+    size_t pixel_count = (size_t)width * height;
+    unsigned char *alpha = NULL;
+    bool translucent = false;
+    if (has_alpha) {
+        alpha = malloc(pixel_count);
+        if (!alpha) {
+            free(pixels);
+            *problem = "out of memory";
+            return 0;
+        }
+        /* Compact colour samples in place and peel the alpha channel off. */
+        for (size_t i = 0; i < pixel_count; ++i) {
+            const unsigned char *src = pixels + i * channels;
+            memmove(pixels + i * components, src, components);
+            alpha[i] = src[components];
+            translucent = translucent || alpha[i] != 0xff;
+        }
+    }
+
+    image->width = width;
+    image->height = height;
+    image->components = (int)components;
+    ok = deflate_bytes(pixels, pixel_count * components, &image->color, &image->color_size);
+    if (ok && translucent) {
+        ok = deflate_bytes(alpha, pixel_count, &image->alpha, &image->alpha_size);
+    }
+    free(pixels);
+    free(alpha);
+    if (!ok) {
+        free(image->color);
+        image->color = NULL;
+        *problem = "failed to compress image";
+        return 0;
+    }
+    return 1;
+}
+
+int pdf_document_add_png(PdfDocument *doc, const char *path, char **error_out) {
+    if (!doc || !path) {
+        return -1;
+    }
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        if (error_out && !*error_out) {
+            size_t len = strlen(path) + 64;
+            *error_out = malloc(len);
+            if (*error_out) {
+                snprintf(*error_out, len, "Failed to open %s: %s", path, strerror(errno));
+            }
+        }
+        return -1;
+    }
+    Buffer data;
+    int ok = buffer_init(&data);
+    unsigned char chunk[8192];
+    size_t read;
+    while (ok && (read = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+        ok = buffer_append_bytes(&data, chunk, read);
+    }
+    fclose(fp);
+
+    const char *problem = ok ? NULL : "out of memory";
+    PdfImage image;
+    memset(&image, 0, sizeof(image));
+    if (ok) {
+        ok = png_decode((const unsigned char *)data.data, data.length, &image, &problem);
+    }
+    buffer_free(&data);
+    if (ok && doc->image_count == doc->image_capacity) {
+        size_t capacity = doc->image_capacity ? doc->image_capacity * 2 : 4;
+        PdfImage *images = realloc(doc->images, capacity * sizeof(*images));
+        if (images) {
+            doc->images = images;
+            doc->image_capacity = capacity;
+        } else {
+            ok = 0;
+            problem = "out of memory";
+            free(image.color);
+            free(image.alpha);
+        }
+    }
+    if (!ok) {
+        if (error_out && !*error_out) {
+            size_t len = strlen(path) + strlen(problem) + 32;
+            *error_out = malloc(len);
+            if (*error_out) {
+                snprintf(*error_out, len, "Failed to load %s: %s", path, problem);
+            }
+        }
+        return -1;
+    }
+    doc->images[doc->image_count] = image;
+    return (int)doc->image_count++;
+}
+
+static int begin_object(Buffer *out, size_t *offsets, size_t id) {
+    offsets[id] = out->length;
+    return buffer_appendf(out, "%zu 0 obj\n", id);
+}
+
+static int append_stream(Buffer *out, const char *dict, const unsigned char *data, size_t size) {
+    return buffer_appendf(out, "<< %s /Length %zu >>\nstream\n", dict, size) &&
+           buffer_append_bytes(out, data, size) &&
+           buffer_append_cstr(out, "\nendstream\nendobj\n");
+}
+
+static int pdf_serialize(PdfDocument *doc, Buffer *out) {
+    /* Object numbers: catalog, page tree, fonts, graphics states, images (+ soft masks), pages with contents. */
+    size_t font_base = 3;
+    size_t gs_base = font_base + PDF_FONT_COUNT;
+    size_t image_base = gs_base + doc->opacity_count;
+    size_t *image_ids = calloc(doc->image_count + 1, sizeof(size_t));
+    if (!image_ids) {
+        return 0;
+    }
+    size_t next = image_base;
+    for (size_t i = 0; i < doc->image_count; ++i) {
+        image_ids[i] = next;
+        next += doc->images[i].alpha ? 2 : 1;
+    }
+    size_t page_base = next;
+    size_t object_count = page_base + doc->page_count * 2;
+    size_t *offsets = calloc(object_count, sizeof(size_t));
+    Buffer resources;
+    int resources_ready = buffer_init(&resources);
+    int ok = offsets && resources_ready;
+
+    ok = ok && buffer_append_cstr(out, "%PDF-1.4\n%\xe2\xe3\xcf\xd3\n");
+    ok = ok && begin_object(out, offsets, 1) &&
+         buffer_append_cstr(out, "<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
+    ok = ok && begin_object(out, offsets, 2) && buffer_append_cstr(out, "<< /Type /Pages /Kids [");
+    for (size_t i = 0; ok && i < doc->page_count; ++i) {
+        ok = buffer_appendf(out, "%s%zu 0 R", i ? " " : "", page_base + i * 2);
+    }
+    ok = ok && buffer_appendf(out, "] /Count %zu >>\nendobj\n", doc->page_count);
+
+    for (int f = 0; ok && f < PDF_FONT_COUNT; ++f) {
+        ok = begin_object(out, offsets, font_base + (size_t)f) &&
+             buffer_appendf(out, "<< /Type /Font /Subtype /Type1 /BaseFont /%s /Encoding /WinAnsiEncoding >>\nendobj\n",
+                            FONT_NAMES[f]);
+    }
+    for (size_t i = 0; ok && i < doc->opacity_count; ++i) {
+        ok = begin_object(out, offsets, gs_base + i) &&
+             buffer_appendf(out, "<< /Type /ExtGState /ca %.3f /CA %.3f >>\nendobj\n", doc->opacities[i], doc->opacities[i]);
+    }
+    for (size_t i = 0; ok && i < doc->image_count; ++i) {
+        const PdfImage *image = &doc->images[i];
+        char dict[256];
+        int len = snprintf(dict, sizeof(dict),
+                           "/Type /XObject /Subtype /Image /Width %u /Height %u /ColorSpace /%s /BitsPerComponent 8 /Filter /FlateDecode",
+                           image->width, image->height, image->components == 1 ? "DeviceGray" : "DeviceRGB");
+        if (image->alpha) {
+            snprintf(dict + len, sizeof(dict) - (size_t)len, " /SMask %zu 0 R", image_ids[i] + 1);
+        }
+        ok = begin_object(out, offsets, image_ids[i]) && append_stream(out, dict, image->color, image->color_size);
+        if (ok && image->alpha) {
+            snprintf(dict, sizeof(dict),
+                     "/Type /XObject /Subtype /Image /Width %u /Height %u /ColorSpace /DeviceGray /BitsPerComponent 8 /Filter /FlateDecode",
+                     image->width, image->height);
+            ok = begin_object(out, offsets, image_ids[i] + 1) && append_stream(out, dict, image->alpha, image->alpha_size);
+        }
+    }
+
+    ok = ok && buffer_append_cstr(&resources, "<< /Font <<");
+    for (int f = 0; ok && f < PDF_FONT_COUNT; ++f) {
+        ok = buffer_appendf(&resources, " /F%d %zu 0 R", f + 1, font_base + (size_t)f);
+    }
+    ok = ok && buffer_append_cstr(&resources, " >>");
+    if (ok && doc->opacity_count > 0) {
+        ok = buffer_append_cstr(&resources, " /ExtGState <<");
+        for (size_t i = 0; ok && i < doc->opacity_count; ++i) {
+            ok = buffer_appendf(&resources, " /GS%zu %zu 0 R", i, gs_base + i);
+        }
+        ok = ok && buffer_append_cstr(&resources, " >>");
+    }
+    if (ok && doc->image_count > 0) {
+        ok = buffer_append_cstr(&resources, " /XObject <<");
+        for (size_t i = 0; ok && i < doc->image_count; ++i) {
+            ok = buffer_appendf(&resources, " /Im%zu %zu 0 R", i, image_ids[i]);
+        }
+        ok = ok && buffer_append_cstr(&resources, " >>");
+    }
+    ok = ok && buffer_append_cstr(&resources, " >>");
+
+    for (size_t i = 0; ok && i < doc->page_count; ++i) {
+        size_t page_id = page_base + i * 2;
+        ok = begin_object(out, offsets, page_id) &&
+             buffer_appendf(out, "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 %.3f %.3f] /Resources %s /Contents %zu 0 R >>\nendobj\n",
+                            doc->width, doc->height, resources.data, page_id + 1);
+        unsigned char *content = NULL;
+        size_t content_size = 0;
+        const Buffer *page = &doc->pages[i];
+        ok = ok && deflate_bytes((const unsigned char *)(page->data ? page->data : ""), page->length, &content, &content_size);
+        ok = ok && begin_object(out, offsets, page_id + 1) && append_stream(out, "/Filter /FlateDecode", content, content_size);
+        free(content);
+    }
+
+    size_t xref_offset = out->length;
+    ok = ok && buffer_appendf(out, "xref\n0 %zu\n0000000000 65535 f \n", object_count);
+    for (size_t id = 1; ok && id < object_count; ++id) {
+        ok = buffer_appendf(out, "%010zu 00000 n \n", offsets[id]);
+    }
+    ok = ok && buffer_appendf(out, "trailer\n<< /Size %zu /Root 1 0 R >>\nstartxref\n%zu\n%%%%EOF\n", object_count, xref_offset);
+
+    if (resources_ready) {
+        buffer_free(&resources);
+    }
+    free(offsets);
+    free(image_ids);
+    return ok;
+}
+
+int pdf_document_save(PdfDocument *doc, const char *path, char **error_out) {
+    if (!doc || !path || doc->page_count == 0) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Nothing to write");
+        }
+        return 0;
+    }
+    Buffer out;
+    if (!buffer_init(&out)) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Out of memory");
+        }
+        return 0;
+    }
+    int ok = pdf_serialize(doc, &out);
+    if (!ok) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Failed to assemble PDF");
+        }
+    } else if (write_buffer_to_file(path, out.data, out.length) != 0) {
+        ok = 0;
+        if (error_out && !*error_out) {
+            size_t len = strlen(path) + 64;
+            *error_out = malloc(len);
+            if (*error_out) {
+                snprintf(*error_out, len, "Failed to write %s: %s", path, strerror(errno));
+            }
+        }
+    }
+    buffer_free(&out);
+    return ok;
+}
@@ -0,0 +1,387 @@
+#include "photo_derivatives.h"
+
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <jpeglib.h>
+#include <png.h>
+
+#define PHOTO_JPEG_QUALITY 82
+/* Decoded size cap, about 200MB of RGB; anything larger is not a phone photo. */
+#define PHOTO_MAX_PIXELS ((size_t)64 * 1024 * 1024)
+
+typedef struct {
+    unsigned char *pixels;
+    unsigned int width;
+    unsigned int height;
+} RgbImage;
+
+typedef struct {
+    struct jpeg_error_mgr base;
+    jmp_buf jump;
+    char message[JMSG_LENGTH_MAX];
+} JpegErrorManager;
+
+static void set_error(char **error_out, const char *what, const char *detail) {
+    if (!error_out || *error_out) {
+        return;
+    }
+    char msg[512];
+    snprintf(msg, sizeof(msg), "%s%s%s", what, detail && detail[0] ? ": " : "", detail ? detail : "");
+    *error_out = strdup(msg);
+}
+
+static void jpeg_error_exit(j_common_ptr cinfo) {
+    JpegErrorManager *err = (JpegErrorManager *)cinfo->err;
+    err->base.format_message(cinfo, err->message);
+    longjmp(err->jump, 1);
+}
+
+/* Corrupt-data warnings would otherwise go to stderr for every damaged upload. */
+static void jpeg_ignore_message(j_common_ptr cinfo) {
+    (void)cinfo;
+}
+
+static uint16_t read_u16(const unsigned char *p, int little_endian) {
+    return little_endian ? (uint16_t)(p[0] | (p[1] << 8)) : (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t read_u32(const unsigned char *p, int little_endian) {
+    return little_endian ? (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24)
+                         : ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+/* Orientation tag (0x0112) from IFD0 of an Exif APP1 payload; 1 when absent or malformed. */
+static int exif_orientation(const unsigned char *data, size_t len) {
+    if (len < 14 || memcmp(data, "Exif\0\0", 6) != 0) {
+        return 1;
+    }
+    const unsigned char *tiff = data + 6;
+    size_t tiff_len = len - 6;
+    int little_endian;
+    if (memcmp(tiff, "II*\0", 4) == 0) {
+        little_endian = 1;
+    } else if (memcmp(tiff, "MM\0*", 4) == 0) {
+        little_endian = 0;
+    } else {
+        return 1;
+    }
+    uint32_t ifd = read_u32(tiff + 4, little_endian);
+    if (ifd > tiff_len - 2) {
+        return 1;
+    }
+    uint16_t entries = read_u16(tiff + ifd, little_endian);
+    for (uint16_t i = 0; i < entries; ++i) {
+        size_t entry = (size_t)ifd + 2 + (size_t)i * 12;
+        if (entry + 12 > tiff_len) {
+            break;
+        }
+        if (read_u16(tiff + entry, little_endian) == 0x0112) {
+            uint16_t value = read_u16(tiff + entry + 8, little_endian);
+            return value >= 1 && value <= 8 ? value : 1;
+        }
+    }
+    return 1;
+}
+
+/* Decodes at the smallest DCT scale whose longest edge still reaches target_edge. */
+static int decode_jpeg(const unsigned char *data, size_t len, unsigned int target_edge, RgbImage *out,
+                       unsigned int *source_edge_out, int *orientation_out, char **error_out) {
+    struct jpeg_decompress_struct cinfo;
+    JpegErrorManager jerr;
+    unsigned char *volatile pixels = NULL;
+    jerr.message[0] = '\0';
+    cinfo.err = jpeg_std_error(&jerr.base);
+    jerr.base.error_exit = jpeg_error_exit;
+    jerr.base.output_message = jpeg_ignore_message;
+    if (setjmp(jerr.jump)) {
+        set_error(error_out, "Failed to decode JPEG", jerr.message);
+        jpeg_destroy_decompress(&cinfo);
+        free(pixels);
+        return 0;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, data, (unsigned long)len);
+    jpeg_save_markers(&cinfo, JPEG_APP0 + 1, 0xFFFF);
+    jpeg_read_header(&cinfo, TRUE);
+
+    if (cinfo.jpeg_color_space == JCS_CMYK || cinfo.jpeg_color_space == JCS_YCCK) {
+        set_error(error_out, "Unsupported JPEG color space", "CMYK");
+        jpeg_destroy_decompress(&cinfo);
+        return 0;
+    }
+    int orientation = 1;
+    for (jpeg_saved_marker_ptr marker = cinfo.marker_list; marker; marker = marker->next) {
+        if (marker->marker == JPEG_APP0 + 1) {
+            orientation = exif_orientation(marker->data, marker->data_length);
+            break;
+        }
+    }
+
+    unsigned int edge = cinfo.image_width > cinfo.image_height ? cinfo.image_width : cinfo.image_height;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = 1;
+    for (unsigned int denom = 8; denom > 1; denom /= 2) {
+        if ((edge + denom - 1) / denom >= target_edge) {
+            cinfo.scale_denom = denom;
+            break;
+        }
+    }
+    cinfo.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&cinfo);
+
+    size_t width = cinfo.output_width;
+    size_t height = cinfo.output_height;
+    if (width == 0 || height == 0 || width * height > PHOTO_MAX_PIXELS || cinfo.output_components != 3) {
+        set_error(error_out, "JPEG dimensions out of range", NULL);
+        jpeg_destroy_decompress(&cinfo);
+        return 0;
+    }
+    size_t stride = width * 3;
+    pixels = malloc(stride * height);
+    if (!pixels) {
+        set_error(error_out, "Out of memory decoding JPEG", NULL);
+        jpeg_destroy_decompress(&cinfo);
+        return 0;
+    }
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW row = pixels + (size_t)cinfo.output_scanline * stride;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+
+    out->pixels = pixels;
+    out->width = (unsigned int)width;
+    out->height = (unsigned int)height;
+    *source_edge_out = edge;
+    *orientation_out = orientation;
+    return 1;
+}
+
+/* Transparent areas are flattened onto white, which is how the gallery shows them anyway. */
+static int decode_png(const unsigned char *data, size_t len, RgbImage *out, char **error_out) {
+    png_image image;
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_memory(&image, data, len)) {
+        set_error(error_out, "Failed to decode PNG", image.message);
+        png_image_free(&image);
+        return 0;
+    }
+    if ((size_t)image.width * image.height > PHOTO_MAX_PIXELS) {
+        set_error(error_out, "PNG dimensions out of range", NULL);
+        png_image_free(&image);
+        return 0;
+    }
+    image.format = PNG_FORMAT_RGB;
+    unsigned char *pixels = malloc(PNG_IMAGE_SIZE(image));
+    if (!pixels) {
+        set_error(error_out, "Out of memory decoding PNG", NULL);
+        png_image_free(&image);
+        return 0;
+    }
+    png_color background = { 255, 255, 255 };
+    if (!png_image_finish_read(&image, &background, pixels, 0, NULL)) {
+        set_error(error_out, "Failed to decode PNG", image.message);
+        png_image_free(&image);
+        free(pixels);
+        return 0;
+    }
+    out->pixels = pixels;
+    out->width = image.width;
+    out->height = image.height;
+    return 1;
+}
+
+/* Box filter: every destination pixel is the mean of the source pixels it covers. */
+static int resize_to_fit(const RgbImage *src, unsigned int max_edge, RgbImage *out) {
+    unsigned int edge = src->width > src->height ? src->width : src->height;
+    unsigned int width = src->width;
+    unsigned int height = src->height;
+    if (edge > max_edge) {
+        width = (unsigned int)(((uint64_t)src->width * max_edge + edge / 2) / edge);
+        height = (unsigned int)(((uint64_t)src->height * max_edge + edge / 2) / edge);
+        if (width == 0) width = 1;
+        if (height == 0) height = 1;
+    }
+    out->pixels = malloc((size_t)width * height * 3);
+    if (!out->pixels) {
+        return 0;
+    }
+    out->width = width;
+    out->height = height;
+    if (width == src->width && height == src->height) {
+        memcpy(out->pixels, src->pixels, (size_t)width * height * 3);
+        return 1;
+    }
+
+    for (unsigned int y = 0; y < height; ++y) {
+        unsigned int y0 = (unsigned int)((uint64_t)y * src->height / height);
+        unsigned int y1 = (unsigned int)((uint64_t)(y + 1) * src->height / height);
+        if (y1 <= y0) y1 = y0 + 1;
+        unsigned char *dst = out->pixels + (size_t)y * width * 3;
+        for (unsigned int x = 0; x < width; ++x) {
+            unsigned int x0 = (unsigned int)((uint64_t)x * src->width / width);
+            unsigned int x1 = (unsigned int)((uint64_t)(x + 1) * src->width / width);
+            if (x1 <= x0) x1 = x0 + 1;
+            uint64_t sum[3] = { 0, 0, 0 };
+            for (unsigned int sy = y0; sy < y1; ++sy) {
+                const unsigned char *row = src->pixels + ((size_t)sy * src->width + x0) * 3;
+                for (unsigned int sx = x0; sx < x1; ++sx, row += 3) {
+                    sum[0] += row[0];
+                    sum[1] += row[1];
+                    sum[2] += row[2];
+                }
+            }
+            uint64_t count = (uint64_t)(y1 - y0) * (x1 - x0);
+            for (int c = 0; c < 3; ++c) {
+                *dst++ = (unsigned char)((sum[c] + count / 2) / count);
+            }
+        }
+    }
+    return 1;
+}
+
+/* Applies an EXIF orientation (2-8) so the image displays upright without metadata. */
+static int apply_orientation(RgbImage *image, int orientation) {
+    if (orientation <= 1 || orientation > 8) {
+        return 1;
+    }
+    unsigned int w = image->width;
+    unsigned int h = image->height;
+    bool swap = orientation >= 5;
+    unsigned int out_w = swap ? h : w;
+    unsigned char *pixels = malloc((size_t)w * h * 3);
+    if (!pixels) {
+        return 0;
+    }
+    for (unsigned int y = 0; y < h; ++y) {
+        const unsigned char *src = image->pixels + (size_t)y * w * 3;
+        for (unsigned int x = 0; x < w; ++x, src += 3) {
+            unsigned int dx;
+            unsigned int dy;
+            switch (orientation) {
+                case 2: dx = w - 1 - x; dy = y; break;
+                case 3: dx = w - 1 - x; dy = h - 1 - y; break;
+                case 4: dx = x; dy = h - 1 - y; break;
+                case 5: dx = y; dy = x; break;
+                case 6: dx = h - 1 - y; dy = x; break;
+                case 7: dx = h - 1 - y; dy = w - 1 - x; break;
+                default: dx = y; dy = w - 1 - x; break;
+            }
+            memcpy(pixels + ((size_t)dy * out_w + dx) * 3, src, 3);
+        }
+    }
+    free(image->pixels);
+    image->pixels = pixels;
+    image->width = out_w;
+    image->height = swap ? w : h;
+    return 1;
+}
+
+static int encode_jpeg(const RgbImage *image, unsigned char **out, size_t *out_len, char **error_out) {
+    struct jpeg_compress_struct cinfo;
+    JpegErrorManager jerr;
+    /* Only written through the pointer handed to jpeg_mem_dest, so it survives the longjmp. */
+    unsigned char *buffer = NULL;
+    unsigned long size = 0;
+    jerr.message[0] = '\0';
+    cinfo.err = jpeg_std_error(&jerr.base);
+    jerr.base.error_exit = jpeg_error_exit;
+    jerr.base.output_message = jpeg_ignore_message;
+    if (setjmp(jerr.jump)) {
+        set_error(error_out, "Failed to encode JPEG", jerr.message);
+        jpeg_destroy_compress(&cinfo);
+        free(buffer);
+        return 0;
+    }
+    jpeg_create_compress(&cinfo);
+    jpeg_mem_dest(&cinfo, &buffer, &size);
+    cinfo.image_width = image->width;
+    cinfo.image_height = image->height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, PHOTO_JPEG_QUALITY, TRUE);
+    cinfo.optimize_coding = TRUE;
+    jpeg_start_compress(&cinfo, TRUE);
+    size_t stride = (size_t)image->width * 3;
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW row = image->pixels + (size_t)cinfo.next_scanline * stride;
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    *out = buffer;
+    *out_len = size;
+    return 1;
+}
+
+int photo_derivatives_render(const unsigned char *data, size_t len, PhotoDerivatives *out, char **error_out) {
+    if (!out) {
+        return 0;
+    }
+    memset(out, 0, sizeof(*out));
+    if (!data || len < 8) {
+        set_error(error_out, "Photo is empty", NULL);
+        return 0;
+    }
+
+    RgbImage decoded = {0};
+    unsigned int source_edge = 0;
+    int orientation = 1;
+    bool is_jpeg = data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF;
+    if (is_jpeg) {
+        if (!decode_jpeg(data, len, PHOTO_PREVIEW_MAX_EDGE, &decoded, &source_edge, &orientation, error_out)) {
+            return 0;
+        }
+    } else if (png_sig_cmp(data, 0, 8) == 0) {
+        if (!decode_png(data, len, &decoded, error_out)) {
+            return 0;
+        }
+        source_edge = decoded.width > decoded.height ? decoded.width : decoded.height;
+    } else {
+        set_error(error_out, "Unsupported photo format", NULL);
+        return 0;
+    }
+
+    /* Orientation is applied after shrinking, where it is cheap. */
+    RgbImage preview = {0};
+    RgbImage thumb = {0};
+    int ok = resize_to_fit(&decoded, PHOTO_PREVIEW_MAX_EDGE, &preview) &&
+             apply_orientation(&preview, orientation) &&
+             resize_to_fit(&preview, PHOTO_THUMB_MAX_EDGE, &thumb);
+    free(decoded.pixels);
+    if (!ok) {
+        set_error(error_out, "Out of memory resizing photo", NULL);
+    }
+
+    /* An upright JPEG that already fits is its own derivative. */
+    bool as_is = is_jpeg && orientation == 1;
+    if (ok && !(as_is && source_edge <= PHOTO_PREVIEW_MAX_EDGE)) {
+        ok = encode_jpeg(&preview, &out->preview, &out->preview_size, error_out);
+    }
+    if (ok && !(as_is && source_edge <= PHOTO_THUMB_MAX_EDGE)) {
+        ok = encode_jpeg(&thumb, &out->thumb, &out->thumb_size, error_out);
+    }
+    free(preview.pixels);
+    free(thumb.pixels);
+    if (!ok) {
+        photo_derivatives_free(out);
+    }
+    return ok;
+}
+
+void photo_derivatives_free(PhotoDerivatives *derivatives) {
+    if (!derivatives) {
+        return;
+    }
+    free(derivatives->thumb);
+    free(derivatives->preview);
+    memset(derivatives, 0, sizeof(*derivatives));
+}
@@ -3,6 +3,8 @@
 #include "buffer.h"
 #include "log.h"
 
+#include <errno.h>
+#include <poll.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <limits.h>
@@ -202,33 +204,222 @@ int db_insert_report_job(PGconn *conn, const char *job_id, const ReportJob *job,
         free(audit_error);
     }
 
+    /* Sent last so listeners never claim a job before its audit selection exists. */
+    const char *notify_params[2] = { REPORT_JOBS_NOTIFY_CHANNEL, job_id };
+    PGresult *notify_res = PQexecParams(conn, "SELECT pg_notify($1, $2)", 2, NULL, notify_params, NULL, NULL, 0);
+    if (PQresultStatus(notify_res) != PGRES_TUPLES_OK) {
+        /* The job is queued regardless; workers still find it on their next sweep. */
+        log_error("Failed to notify report workers: %s", PQresultErrorMessage(notify_res));
+    }
+    PQclear(notify_res);
+
     return 1;
 }
 
-int db_claim_next_report_job(PGconn *conn, ReportJob *job, char **error_out) {
-    if (!conn || !job) {
+/* Array elements are double-quoted because the host part of a lease owner is not ours to control. */
+static int append_text_array_element(Buffer *buf, const char *value) {
+    if (!buffer_append_char(buf, '"')) {
+        return 0;
+    }
+    for (const char *p = value; *p; ++p) {
+        if ((*p == '"' || *p == '\\') && !buffer_append_char(buf, '\\')) {
+            return 0;
+        }
+        if (!buffer_append_char(buf, *p)) {
+            return 0;
+        }
+    }
+    return buffer_append_char(buf, '"');
+}
+
+int db_renew_report_job_leases(PGconn *conn, const StringArray *lease_owners, int lease_seconds, char **error_out) {
+    if (!conn || !lease_owners || lease_seconds <= 0) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Invalid report job lease parameters");
+        }
+        return 0;
+    }
+    if (lease_owners->count == 0) {
+        return 1;
+    }
+    Buffer owners;
+    if (!buffer_init(&owners) || !buffer_append_char(&owners, '{')) {
+        buffer_free(&owners);
+        if (error_out && !*error_out) {
+            *error_out = strdup("Out of memory renewing report job leases");
+        }
+        return 0;
+    }
+    for (size_t i = 0; i < lease_owners->count; ++i) {
+        if ((i > 0 && !buffer_append_char(&owners, ',')) || !append_text_array_element(&owners, lease_owners->values[i])) {
+            buffer_free(&owners);
+            if (error_out && !*error_out) {
+                *error_out = strdup("Out of memory renewing report job leases");
+            }
+            return 0;
+        }
+    }
+    if (!buffer_append_char(&owners, '}')) {
+        buffer_free(&owners);
+        if (error_out && !*error_out) {
+            *error_out = strdup("Out of memory renewing report job leases");
+        }
+        return 0;
+    }
+    char lease_buf[16];
+    snprintf(lease_buf, sizeof(lease_buf), "%d", lease_seconds);
+    const char *params[2] = { owners.data, lease_buf };
+    PGresult *res = PQexecParams(conn,
+                                 "UPDATE report_jobs "
+                                 "SET lease_expires_at = NOW() + make_interval(secs => $2::int) "
+                                 "WHERE status = 'processing' AND lease_owner = ANY($1::text[])",
+                                 2, NULL, params, NULL, NULL, 0);
+    buffer_free(&owners);
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        if (error_out && !*error_out) {
+            const char *msg = PQresultErrorMessage(res);
+            *error_out = strdup(msg ? msg : "Failed to renew report job leases");
+        }
+        PQclear(res);
+        return 0;
+    }
+    PQclear(res);
+    return 1;
+}
+
+int db_listen_report_jobs(PGconn *conn, char **error_out) {
+    if (!conn) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Invalid connection for report job listener");
+        }
+        return 0;
+    }
+    PGresult *res = PQexec(conn, "LISTEN " REPORT_JOBS_NOTIFY_CHANNEL);
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        if (error_out && !*error_out) {
+            const char *msg = PQresultErrorMessage(res);
+            *error_out = strdup(msg ? msg : "Failed to listen for report jobs");
+        }
+        PQclear(res);
+        return 0;
+    }
+    PQclear(res);
+    return 1;
+}
+
+static int drain_report_job_notifications(PGconn *conn) {
+    int received = 0;
+    PGnotify *notify;
+    while ((notify = PQnotifies(conn)) != NULL) {
+        received++;
+        PQfreemem(notify);
+    }
+    return received;
+}
+
+int db_wait_report_job_notification(PGconn *conn, int wake_fd, int timeout_ms, char **error_out) {
+    int sock = conn ? PQsocket(conn) : -1;
+    if (sock < 0) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Report job listener has no database socket");
+        }
+        return -1;
+    }
+    /* Notifications that arrived alongside earlier query results are already buffered. */
+    if (!PQconsumeInput(conn)) {
+        if (error_out && !*error_out) {
+            *error_out = strdup(PQerrorMessage(conn));
+        }
+        return -1;
+    }
+    if (drain_report_job_notifications(conn) > 0) {
+        return 1;
+    }
+
+    struct pollfd fds[2];
+    fds[0].fd = sock;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = wake_fd;
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+    int rc = poll(fds, wake_fd >= 0 ? 2 : 1, timeout_ms);
+    if (rc < 0) {
+        if (errno == EINTR) {
+            return 0;
+        }
+        if (error_out && !*error_out) {
+            *error_out = strdup(strerror(errno));
+        }
+        return -1;
+    }
+    if (rc == 0 || fds[0].revents == 0) {
+        return 0;
+    }
+    if (!PQconsumeInput(conn)) {
+        if (error_out && !*error_out) {
+            *error_out = strdup(PQerrorMessage(conn));
+        }
+        return -1;
+    }
+    return drain_report_job_notifications(conn) > 0 ? 1 : 0;
+}
+
+static void fail_abandoned_report_jobs(PGconn *conn) {
+    char attempts_buf[16];
+    snprintf(attempts_buf, sizeof(attempts_buf), "%d", REPORT_JOB_MAX_ATTEMPTS);
+    const char *params[1] = { attempts_buf };
+    PGresult *res = PQexecParams(conn,
+                                 "UPDATE report_jobs "
+                                 "SET status = 'failed', "
+                                 "    error = 'Report worker stopped responding on every attempt', "
+                                 "    lease_owner = NULL, lease_expires_at = NULL, "
+                                 "    completed_at = NOW(), updated_at = NOW() "
+                                 "WHERE status = 'processing' AND lease_expires_at < NOW() AND attempts >= $1::int",
+                                 1, NULL, params, NULL, NULL, 0);
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        log_error("Failed to expire abandoned report jobs: %s", PQresultErrorMessage(res));
+    } else if (strcmp(PQcmdTuples(res), "0") != 0) {
+        log_error("Marked %s abandoned report job(s) failed", PQcmdTuples(res));
+    }
+    PQclear(res);
+}
+
+int db_claim_next_report_job(PGconn *conn, const char *lease_owner, int lease_seconds, ReportJob *job, char **error_out) {
+    if (!conn || !job || !lease_owner || lease_seconds <= 0) {
         if (error_out && !*error_out) {
             *error_out = strdup("Invalid report job request");
         }
         return -1;
     }
+    fail_abandoned_report_jobs(conn);
+
+    /* A processing job whose lease lapsed belonged to a worker that crashed or lost its
+       connection, so it is claimable again until it runs out of attempts. */
     const char *sql =
         "WITH job AS ("
         "    SELECT id, job_id::text AS job_id_text, address, notes, recommendations, "
         "           cover_building_owner, cover_street, cover_city, cover_state, cover_zip, cover_contact_name, cover_contact_email, deficiency_only, job_type, range_start, range_end, range_preset, location_id, include_all "
         "    FROM report_jobs "
         "    WHERE status = 'queued' "
+        "       OR (status = 'processing' AND lease_expires_at < NOW() AND attempts < $3::int) "
         "    ORDER BY created_at "
         "    LIMIT 1 "
         "    FOR UPDATE SKIP LOCKED"
         ") "
         "UPDATE report_jobs r "
-        "SET status = 'processing', started_at = COALESCE(r.started_at, NOW()), updated_at = NOW() "
+        "SET status = 'processing', started_at = COALESCE(r.started_at, NOW()), updated_at = NOW(), "
+        "    lease_owner = $1, lease_expires_at = NOW() + make_interval(secs => $2::int), attempts = r.attempts + 1 "
         "FROM job "
         "WHERE r.id = job.id "
         "RETURNING job.job_id_text, job.address, job.notes, job.recommendations, "
         "          job.cover_building_owner, job.cover_street, job.cover_city, job.cover_state, job.cover_zip, job.cover_contact_name, job.cover_contact_email, job.deficiency_only, job.job_type, job.range_start, job.range_end, job.range_preset, job.location_id, job.include_all";
-    PGresult *res = PQexec(conn, sql);
+    char lease_buf[16];
+    char attempts_buf[16];
+    snprintf(lease_buf, sizeof(lease_buf), "%d", lease_seconds);
+    snprintf(attempts_buf, sizeof(attempts_buf), "%d", REPORT_JOB_MAX_ATTEMPTS);
+    const char *claim_params[3] = { lease_owner, lease_buf, attempts_buf };
+    PGresult *res = PQexecParams(conn, sql, 3, NULL, claim_params, NULL, NULL, 0);
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
         if (error_out && !*error_out) {
             const char *msg = PQresultErrorMessage(res);
@@ -432,40 +623,35 @@ int db_claim_next_report_job(PGconn *conn, ReportJob *job, char **error_out) {
 
 int db_complete_report_job(PGconn *conn,
                            const char *job_id,
+                           const char *lease_owner,
                            const char *status,
                            const char *error_text,
                            const char *artifact_filename,
                            const char *artifact_mime,
-                           const unsigned char *artifact_bytes,
+                           const char *artifact_sha256,
                            size_t artifact_size,
                            char **error_out) {
-    if (!conn || !job_id || !status) {
+    if (!conn || !job_id || !lease_owner || !status) {
         if (error_out && !*error_out) {
             *error_out = strdup("Invalid report job completion parameters");
         }
-        return 0;
+        return -1;
     }
 
     bool completed = strcmp(status, "completed") == 0;
     const char *resolved_mime = artifact_mime;
     if (completed) {
-        if (!artifact_bytes || artifact_size == 0 || !artifact_filename || artifact_filename[0] == '\0') {
+        if (!artifact_sha256 || artifact_size == 0 || !artifact_filename || artifact_filename[0] == '\0') {
             if (error_out && !*error_out) {
                 *error_out = strdup("Artifact data missing for completed report");
             }
-            return 0;
+            return -1;
         }
         if (!resolved_mime || resolved_mime[0] == '\0') {
             resolved_mime = "application/pdf";
         }
-        if (artifact_size > (size_t)INT_MAX) {
-            if (error_out && !*error_out) {
-                *error_out = strdup("Artifact too large to store");
-            }
-            return 0;
-        }
     } else {
-        artifact_bytes = NULL;
+        artifact_sha256 = NULL;
         artifact_size = 0;
         artifact_filename = NULL;
         resolved_mime = NULL;
@@ -502,50 +688,139 @@ int db_complete_report_job(PGconn *conn,
         "    output_path = NULL, "
         "    artifact_filename = CASE WHEN $2 = 'completed' THEN $4 ELSE NULL END, "
         "    artifact_mime = CASE WHEN $2 = 'completed' THEN $5 ELSE NULL END, "
-        "    artifact_bytes = CASE WHEN $2 = 'completed' THEN $6::bytea ELSE NULL END, "
+        "    artifact_sha256 = CASE WHEN $2 = 'completed' THEN $6 ELSE NULL END, "
+        "    artifact_bytes = NULL, "
         "    artifact_size = CASE WHEN $2 = 'completed' THEN $7::bigint ELSE NULL END, "
         "    artifact_version = CASE WHEN $2 = 'completed' THEN COALESCE((SELECT next_version FROM version_calc), 1) ELSE artifact_version END, "
         "    completed_at = CASE WHEN $2 IN ('completed','failed') THEN NOW() ELSE completed_at END, "
+        "    lease_owner = NULL, "
+        "    lease_expires_at = NULL, "
         "    updated_at = NOW() "
         "FROM target "
         "LEFT JOIN version_calc ON version_calc.id = target.id "
-        "WHERE r.id = target.id";
+        "WHERE r.id = target.id AND r.status = 'processing' AND r.lease_owner = $8";
 
-    const char *paramValues[7] = {0};
-    int paramLengths[7] = {0};
-    int paramFormats[7] = {0};
-    Oid paramTypes[7] = {0};
+    const char *paramValues[8] = {0};
+    Oid paramTypes[8] = {0};
 
     paramValues[0] = job_id;
     paramValues[1] = status;
     paramValues[2] = error_text;
     paramValues[3] = artifact_filename;
     paramValues[4] = resolved_mime;
-    if (completed) {
-        paramValues[5] = (const char *)artifact_bytes;
-        paramLengths[5] = (int)artifact_size;
-        paramFormats[5] = 1;
-    } else {
-        paramValues[5] = NULL;
-        paramLengths[5] = 0;
-        paramFormats[5] = 0;
-    }
-    paramTypes[5] = 17; /* BYTEAOID */
+    paramValues[5] = artifact_sha256;
+    paramTypes[5] = 25; /* TEXTOID */
     paramValues[6] = size_param;
     paramTypes[6] = 20; /* INT8OID */
+    paramValues[7] = lease_owner;
 
-    PGresult *res = PQexecParams(conn, sql, 7, paramTypes, paramValues, paramLengths, paramFormats, 0);
+    PGresult *res = PQexecParams(conn, sql, 8, paramTypes, paramValues, NULL, NULL, 0);
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
         if (error_out && !*error_out) {
             const char *msg = PQresultErrorMessage(res);
             *error_out = strdup(msg ? msg : "Failed updating report job");
         }
         PQclear(res);
+        return -1;
+    }
+    /* No row means the lease lapsed and the job was reclaimed (or removed). */
+    int updated = PQcmdTuples(res)[0] != '0';
+    PQclear(res);
+    return updated;
+}
+
+int db_list_legacy_report_artifacts(PGconn *conn, StringArray *job_ids, char **error_out) {
+    if (!conn || !job_ids) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Invalid legacy artifact parameters");
+        }
         return 0;
     }
-    if (PQcmdTuples(res)[0] == '0') {
+    PGresult *res = PQexec(conn,
+                           "SELECT job_id::text FROM report_jobs "
+                           "WHERE artifact_bytes IS NOT NULL AND artifact_sha256 IS NULL "
+                           "ORDER BY id");
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
         if (error_out && !*error_out) {
-            *error_out = strdup("Report job not found");
+            const char *msg = PQresultErrorMessage(res);
+            *error_out = strdup(msg && msg[0] ? msg : "Failed to list legacy report artifacts");
+        }
+        PQclear(res);
+        return 0;
+    }
+    int rows = PQntuples(res);
+    for (int i = 0; i < rows; ++i) {
+        if (!string_array_append_copy(job_ids, PQgetvalue(res, i, 0))) {
+            if (error_out && !*error_out) {
+                *error_out = strdup("Out of memory listing legacy report artifacts");
+            }
+            PQclear(res);
+            return 0;
+        }
+    }
+    PQclear(res);
+    return 1;
+}
+
+int db_fetch_legacy_report_artifact(PGconn *conn, const char *job_id, unsigned char **data_out, size_t *size_out, char **error_out) {
+    if (data_out) *data_out = NULL;
+    if (size_out) *size_out = 0;
+    if (!conn || !job_id || !data_out || !size_out) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Invalid legacy artifact parameters");
+        }
+        return 0;
+    }
+    const char *params[1] = { job_id };
+    /* Binary results hand the bytes over as-is instead of as hex escapes twice the size. */
+    PGresult *res = PQexecParams(conn,
+                                 "SELECT artifact_bytes FROM report_jobs WHERE job_id = $1::uuid",
+                                 1, NULL, params, NULL, NULL, 1);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        if (error_out && !*error_out) {
+            const char *msg = PQresultErrorMessage(res);
+            *error_out = strdup(msg && msg[0] ? msg : "Failed to fetch legacy report artifact");
+        }
+        PQclear(res);
+        return 0;
+    }
+    if (PQntuples(res) == 0 || PQgetisnull(res, 0, 0) || PQgetlength(res, 0, 0) == 0) {
+        PQclear(res);
+        return 1;
+    }
+    size_t len = (size_t)PQgetlength(res, 0, 0);
+    unsigned char *data = malloc(len);
+    if (!data) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Out of memory fetching legacy report artifact");
+        }
+        PQclear(res);
+        return 0;
+    }
+    memcpy(data, PQgetvalue(res, 0, 0), len);
+    PQclear(res);
+    *data_out = data;
+    *size_out = len;
+    return 1;
+}
+
+int db_move_report_artifact_to_store(PGconn *conn, const char *job_id, const char *artifact_sha256, char **error_out) {
+    if (!conn || !job_id || !artifact_sha256) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Invalid legacy artifact parameters");
+        }
+        return 0;
+    }
+    const char *params[2] = { job_id, artifact_sha256 };
+    PGresult *res = PQexecParams(conn,
+                                 "UPDATE report_jobs "
+                                 "SET artifact_sha256 = $2, artifact_bytes = NULL "
+                                 "WHERE job_id = $1::uuid AND artifact_bytes IS NOT NULL",
+                                 2, NULL, params, NULL, NULL, 0);
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        if (error_out && !*error_out) {
+            const char *msg = PQresultErrorMessage(res);
+            *error_out = strdup(msg && msg[0] ? msg : "Failed to move report artifact");
         }
         PQclear(res);
         return 0;
@@ -577,7 +852,10 @@ char *db_fetch_report_job_status(PGconn *conn, const char *job_id, const char *p
         "       r.artifact_size, "
         "       r.artifact_filename, "
         "       r.artifact_version, "
-        "       COALESCE(sel.selection_count, 0) "
+        "       COALESCE(sel.selection_count, 0), "
+        "       array_to_json(r.degraded_sections)::text, "
+        "       r.fragment_cache_hits, "
+        "       r.fragment_cache_lookups "
         "FROM report_jobs r "
         "LEFT JOIN ("
         "    SELECT job_id, COUNT(*) AS selection_count "
@@ -621,6 +899,9 @@ char *db_fetch_report_job_status(PGconn *conn, const char *job_id, const char *p
     const char *artifact_filename_val = PQgetisnull(res, 0, 15) ? NULL : PQgetvalue(res, 0, 15);
     const char *artifact_version_val = PQgetisnull(res, 0, 16) ? NULL : PQgetvalue(res, 0, 16);
     const char *selection_count_val = PQgetisnull(res, 0, 17) ? NULL : PQgetvalue(res, 0, 17);
+    const char *degraded_val = PQgetisnull(res, 0, 18) ? NULL : PQgetvalue(res, 0, 18);
+    const char *fragment_hits_val = PQgetisnull(res, 0, 19) ? NULL : PQgetvalue(res, 0, 19);
+    const char *fragment_lookups_val = PQgetisnull(res, 0, 20) ? NULL : PQgetvalue(res, 0, 20);
     long long artifact_size_num = 0;
     if (artifact_size_val) {
         artifact_size_num = atoll(artifact_size_val);
@@ -748,6 +1029,20 @@ char *db_fetch_report_job_status(PGconn *conn, const char *job_id, const char *p
         if (!buffer_append_cstr(&buf, "null")) goto fail;
     }
 
+    /* Already JSON: array_to_json renders the text[] column. */
+    if (!buffer_append_cstr(&buf, ",\"degraded_sections\":")) goto fail;
+    if (!buffer_append_cstr(&buf, degraded_val ? degraded_val : "[]")) goto fail;
+
+    if (!buffer_append_cstr(&buf, ",\"fragment_cache\":")) goto fail;
+    long long fragment_lookups = fragment_lookups_val ? atoll(fragment_lookups_val) : 0;
+    if (fragment_lookups > 0) {
+        long long fragment_hits = fragment_hits_val ? atoll(fragment_hits_val) : 0;
+        if (!buffer_appendf(&buf, "{\"hits\":%lld,\"lookups\":%lld,\"hit_ratio\":%.4f}",
+                            fragment_hits, fragment_lookups, (double)fragment_hits / (double)fragment_lookups)) goto fail;
+    } else {
+        if (!buffer_append_cstr(&buf, "null")) goto fail;
+    }
+
     if (!buffer_append_cstr(&buf, ",\"download_url\":")) goto fail;
     if (download_ready && job_id_val) {
         Buffer url_buf;
@@ -780,6 +1075,78 @@ fail:
     return NULL;
 }
 
+int db_set_report_job_degraded_sections(PGconn *conn, const char *job_id, const StringArray *sections, char **error_out) {
+    if (!conn || !job_id) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Invalid degraded section parameters");
+        }
+        return 0;
+    }
+    Buffer json = {0};
+    bool has_sections = sections && sections->count > 0;
+    if (has_sections) {
+        int ok = buffer_init(&json) && buffer_append_char(&json, '[');
+        for (size_t i = 0; ok && i < sections->count; ++i) {
+            ok = (i == 0 || buffer_append_char(&json, ',')) && buffer_append_json_string(&json, sections->values[i]);
+        }
+        if (!ok || !buffer_append_char(&json, ']')) {
+            buffer_free(&json);
+            if (error_out && !*error_out) {
+                *error_out = strdup("Out of memory recording degraded sections");
+            }
+            return 0;
+        }
+    }
+    const char *params[2] = { job_id, has_sections ? json.data : NULL };
+    PGresult *res = PQexecParams(conn,
+                                 "UPDATE report_jobs "
+                                 "SET degraded_sections = CASE WHEN $2::jsonb IS NULL THEN NULL "
+                                 "ELSE ARRAY(SELECT jsonb_array_elements_text($2::jsonb)) END, "
+                                 "updated_at = NOW() "
+                                 "WHERE job_id = $1::uuid",
+                                 2, NULL, params, NULL, NULL, 0);
+    buffer_free(&json);
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        if (error_out && !*error_out) {
+            const char *msg = PQresultErrorMessage(res);
+            *error_out = strdup(msg && msg[0] ? msg : "Failed to record degraded sections");
+        }
+        PQclear(res);
+        return 0;
+    }
+    PQclear(res);
+    return 1;
+}
+
+int db_set_report_job_fragment_stats(PGconn *conn, const char *job_id, size_t hits, size_t lookups, char **error_out) {
+    if (!conn || !job_id) {
+        if (error_out && !*error_out) {
+            *error_out = strdup("Invalid fragment stats parameters");
+        }
+        return 0;
+    }
+    char hits_buf[32];
+    char lookups_buf[32];
+    snprintf(hits_buf, sizeof(hits_buf), "%zu", hits);
+    snprintf(lookups_buf, sizeof(lookups_buf), "%zu", lookups);
+    const char *params[3] = { job_id, hits_buf, lookups_buf };
+    PGresult *res = PQexecParams(conn,
+                                 "UPDATE report_jobs "
+                                 "SET fragment_cache_hits = $2::int, fragment_cache_lookups = $3::int, updated_at = NOW() "
+                                 "WHERE job_id = $1::uuid",
+                                 3, NULL, params, NULL, NULL, 0);
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        if (error_out && !*error_out) {
+            const char *msg = PQresultErrorMessage(res);
+            *error_out = strdup(msg && msg[0] ? msg : "Failed to record fragment cache stats");
+        }
+        PQclear(res);
+        return 0;
+    }
+    PQclear(res);
+    return 1;
+}
+
 int db_find_existing_report_job(PGconn *conn,
                                 const ReportJob *job,
                                 char **job_id_out,
@@ -6,6 +6,7 @@
 #include "json.h"
 #include "log.h"
 #include "report_jobs.h"
+#include "sha256.h"
 #include "util.h"
 
 #include <stdio.h>
@@ -18,6 +19,102 @@
 static RouteHelpers g_route_helpers = {0};
 static const char *g_route_prefix = "";
 
+/* Chunked 200 response whose headers go out with the first piece of body. */
+typedef struct {
+    int client_fd;
+    bool started;
+} RouteStream;
+
+static int route_stream_write(void *ctx, const void *data, size_t len) {
+    RouteStream *stream = (RouteStream *)ctx;
+    if (!stream->started) {
+        if (!send_http_stream_start(stream->client_fd, 200, "OK", "application/json")) {
+            return 0;
+        }
+        stream->started = true;
+    }
+    return send_http_chunk(stream->client_fd, data, len);
+}
+
+static bool parse_photo_size(const char *value, AuditPhotoSize *size_out) {
+    if (!value || value[0] == '\0' || strcmp(value, "original") == 0) {
+        *size_out = AUDIT_PHOTO_ORIGINAL;
+    } else if (strcmp(value, "preview") == 0) {
+        *size_out = AUDIT_PHOTO_PREVIEW;
+    } else if (strcmp(value, "thumb") == 0) {
+        *size_out = AUDIT_PHOTO_THUMB;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/* A photo never changes under its digest, so the digest (suffixed per rendition) is the ETag and
+   revalidation skips loading the bytes. A rendition that is not there yet falls back to a larger
+   one, which must not be cached for good: a later --render-photo-derivatives run adds it. Once
+   rendering is done a fallback is final and cached like any rendition. */
+static void photo_etag(const AuditPhoto *photo, char *etag, size_t etag_size) {
+    static const char *const suffixes[] = { "", "-preview", "-thumb" };
+    snprintf(etag, etag_size, "%s%s", photo->sha256, suffixes[photo->served]);
+}
+
+/* GET /audits/{uuid}/photos/{id}[?size=thumb|preview|original] */
+static void route_audit_photo(int client_fd, PGconn *conn, const char *uuid, const char *id_text,
+                              const char *query_string, const char *header_lines) {
+    char *endptr = NULL;
+    long photo_id = strtol(id_text, &endptr, 10);
+    if (photo_id <= 0 || !endptr || *endptr != '\0') {
+        char *body = build_error_response("Invalid photo ID");
+        send_http_json(client_fd, 400, "Bad Request", body);
+        free(body);
+        return;
+    }
+    char *size_param = http_extract_query_param(query_string, "size");
+    AuditPhotoSize size;
+    bool size_ok = parse_photo_size(size_param, &size);
+    free(size_param);
+    if (!size_ok) {
+        char *body = build_error_response("size must be thumb, preview or original");
+        send_http_json(client_fd, 400, "Bad Request", body);
+        free(body);
+        return;
+    }
+
+    char *if_none_match = http_extract_header(header_lines, "If-None-Match");
+    char *error = NULL;
+    char etag[SHA256_HEX_SIZE + 16];
+    AuditPhoto photo;
+    int found = db_fetch_audit_photo(conn, uuid, photo_id, size, if_none_match == NULL, &photo, &error);
+    if (found > 0 && if_none_match) {
+        photo_etag(&photo, etag, sizeof(etag));
+        if (http_etag_matches(if_none_match, etag)) {
+            send_http_not_modified(client_fd, etag, photo.served == size || photo.renditions_done);
+            audit_photo_clear(&photo);
+            free(if_none_match);
+            return;
+        }
+        audit_photo_clear(&photo);
+        found = db_fetch_audit_photo(conn, uuid, photo_id, size, true, &photo, &error);
+    }
+    free(if_none_match);
+
+    if (found > 0) {
+        photo_etag(&photo, etag, sizeof(etag));
+        send_http_tagged(client_fd, photo.content_type, etag, photo.served == size || photo.renditions_done,
+                         photo.data, photo.size);
+        audit_photo_clear(&photo);
+    } else if (found < 0) {
+        char *body = build_error_response("Photo not found");
+        send_http_json(client_fd, 404, "Not Found", body);
+        free(body);
+    } else {
+        char *body = build_error_response(error ? error : "Database query failed");
+        send_http_json(client_fd, 500, "Internal Server Error", body);
+        free(body);
+    }
+    free(error);
+}
+
 void routes_register_helpers(const RouteHelpers *helpers) {
     if (helpers) {
         g_route_helpers = *helpers;
@@ -30,13 +127,66 @@ void routes_set_prefix(const char *prefix) {
     g_route_prefix = (prefix && prefix[0]) ? prefix : "";
 }
 
-void routes_handle_get(int client_fd, PGconn *conn, const char *path, const char *query_string) {
+void routes_handle_get(int client_fd, PGconn *conn, const char *path, const char *query_string, const char *header_lines) {
     if (!path) {
         path = "/";
     }
 
     if (strcmp(path, "/") == 0 || strcmp(path, "/health") == 0) {
-        send_http_json(client_fd, 200, "OK", "{\"status\":\"ok\"}");
+        char *workers = g_route_helpers.build_report_worker_status ? g_route_helpers.build_report_worker_status() : NULL;
+        Buffer body = {0};
+        if (workers && buffer_init(&body) &&
+            buffer_append_cstr(&body, "{\"status\":\"ok\",\"report_workers\":") &&
+            buffer_append_cstr(&body, workers) &&
+            buffer_append_char(&body, '}')) {
+            send_http_json(client_fd, 200, "OK", body.data);
+        } else {
+            send_http_json(client_fd, 200, "OK", "{\"status\":\"ok\"}");
+        }
+        buffer_free(&body);
+        free(workers);
+        return;
+    }
+
+    if (strcmp(path, "/reports/preview") == 0) {
+        char *address_value = http_extract_query_param(query_string, "address");
+        char *location_id_value = http_extract_query_param(query_string, "location_id");
+        bool has_key = (address_value && address_value[0] != '\0') || (location_id_value && location_id_value[0] != '\0');
+        const char *message = NULL;
+        int status = 400;
+        if (!has_key) {
+            message = "address or location_id query parameter required";
+        } else if (!g_route_helpers.stream_report_preview) {
+            message = "Report preview helper not configured";
+            status = 500;
+        }
+        if (message) {
+            free(address_value);
+            free(location_id_value);
+            char *body = build_error_response(message);
+            send_http_json(client_fd, status, status == 400 ? "Bad Request" : "Internal Server Error", body);
+            free(body);
+            return;
+        }
+
+        LocationDetailRequest request = {
+            .address = address_value,
+            .location_id = location_id_value,
+            .visit_ids = NULL,
+            .audit_ids = NULL
+        };
+        char *error = NULL;
+        status = 500;
+        if (!g_route_helpers.stream_report_preview(client_fd, conn, &request, &status, &error)) {
+            char *body = build_error_response(error ? error : "Failed to build report preview");
+            send_http_json(client_fd, status,
+                           status == 404 ? "Not Found" : (status == 400 ? "Bad Request" : "Internal Server Error"),
+                           body);
+            free(body);
+        }
+        free(error);
+        free(address_value);
+        free(location_id_value);
         return;
     }
 
@@ -73,44 +223,23 @@ void routes_handle_get(int client_fd, PGconn *conn, const char *path, const char
         }
 
         if (suffix && strcmp(suffix, "/download") == 0) {
-            if (!g_route_helpers.prepare_report_download || !g_route_helpers.cleanup_report_download) {
+            if (!g_route_helpers.stream_report_download) {
                 char *body = build_error_response("Report downloads are not configured");
                 send_http_json(client_fd, 500, "Internal Server Error", body);
                 free(body);
                 return;
             }
 
-            ReportDownloadArtifact artifact = {0};
             char *error = NULL;
-            if (!g_route_helpers.prepare_report_download(conn, job_id, &artifact, &error)) {
+            int status = 500;
+            if (!g_route_helpers.stream_report_download(client_fd, conn, job_id, &status, &error)) {
                 char *body = build_error_response(error ? error : "Report not available");
-                int status = 500;
-                if (error) {
-                    if (strcmp(error, "Report not ready") == 0) {
-                        status = 409;
-                    } else if (strcmp(error, "Report job not found") == 0) {
-                        status = 404;
-                    }
-                }
                 send_http_json(client_fd, status,
                                status == 404 ? "Not Found" : (status == 409 ? "Conflict" : "Internal Server Error"),
                                body);
                 free(body);
-                free(error);
-                g_route_helpers.cleanup_report_download(&artifact);
-                return;
-            }
-
-            const char *mime = artifact.mime ? artifact.mime : "application/zip";
-
-            char download_name[64];
-            const char *final_name = artifact.filename;
-            if (!final_name || final_name[0] == '\0') {
-                snprintf(download_name, sizeof(download_name), "audit-report-%s.zip", job_id);
-                final_name = download_name;
             }
-            send_file_download(client_fd, artifact.path, mime, final_name);
-            g_route_helpers.cleanup_report_download(&artifact);
+            free(error);
             return;
         }
 
@@ -320,7 +449,25 @@ void routes_handle_get(int client_fd, PGconn *conn, const char *path, const char
             free(body);
             return;
         }
-        if (strchr(uuid_start, '/')) {
+        const char *slash = strchr(uuid_start, '/');
+        if (slash && strncmp(slash, "/photos/", 8) == 0 && slash[8] != '\0') {
+            char uuid[64];
+            size_t uuid_len = (size_t)(slash - uuid_start);
+            if (uuid_len >= sizeof(uuid)) {
+                uuid_len = 0;
+            }
+            memcpy(uuid, uuid_start, uuid_len);
+            uuid[uuid_len] = '\0';
+            if (!is_valid_uuid(uuid)) {
+                char *body = build_error_response("Invalid audit ID");
+                send_http_json(client_fd, 400, "Bad Request", body);
+                free(body);
+                return;
+            }
+            route_audit_photo(client_fd, conn, uuid, slash + 8, query_string, header_lines);
+            return;
+        }
+        if (slash) {
             char *body = build_error_response("Unknown resource");
             send_http_json(client_fd, 404, "Not Found", body);
             free(body);
@@ -333,22 +480,22 @@ void routes_handle_get(int client_fd, PGconn *conn, const char *path, const char
             return;
         }
         char *error = NULL;
-        char *json = db_fetch_audit_detail(conn, uuid_start, &error);
-        if (!json) {
-            if (error) {
-                char *body = build_error_response(error);
-                send_http_json(client_fd, 500, "Internal Server Error", body);
-                free(body);
-                free(error);
-            } else {
-                char *body = build_error_response("Audit not found");
-                send_http_json(client_fd, 404, "Not Found", body);
-                free(body);
-            }
-            return;
+        RouteStream stream = { .client_fd = client_fd, .started = false };
+        int written = db_write_audit_detail(conn, uuid_start, route_stream_write, &stream, &error);
+        if (written > 0) {
+            send_http_stream_end(client_fd);
+        } else if (stream.started) {
+            /* Headers are gone; closing without the last chunk marks the body incomplete. */
+            log_error("Audit detail for %s aborted: %s", uuid_start, error ? error : "unknown error");
+        } else if (written < 0) {
+            char *body = build_error_response("Audit not found");
+            send_http_json(client_fd, 404, "Not Found", body);
+            free(body);
+        } else {
+            char *body = build_error_response(error ? error : "Database query failed");
+            send_http_json(client_fd, 500, "Internal Server Error", body);
+            free(body);
         }
-        send_http_json(client_fd, 200, "OK", json);
-        free(json);
         free(error);
         return;
     }
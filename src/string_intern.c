@@ -0,0 +1,104 @@
+#include "string_intern.h"
+
+#include "hash_index.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INTERN_CHUNK_SIZE 16384
+
+typedef struct InternChunk {
+    struct InternChunk *next;
+    size_t used;
+    size_t capacity;
+    char data[];
+} InternChunk;
+
+static pthread_mutex_t g_intern_mutex = PTHREAD_MUTEX_INITIALIZER;
+static InternChunk *g_intern_chunks = NULL;
+static const char **g_intern_strings = NULL;
+static size_t g_intern_count = 0;
+static size_t g_intern_capacity = 0;
+static HashIndex g_intern_index = {NULL, 0, 0};
+
+static uint32_t hash_bytes(const char *text, size_t len) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (unsigned char)text[i];
+        h *= 0x100000001b3ULL;
+    }
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+static char *intern_alloc(size_t size) {
+    InternChunk *chunk = g_intern_chunks;
+    if (!chunk || chunk->capacity - chunk->used < size) {
+        size_t capacity = size > INTERN_CHUNK_SIZE ? size : INTERN_CHUNK_SIZE;
+        chunk = malloc(sizeof(InternChunk) + capacity);
+        if (!chunk) {
+            return NULL;
+        }
+        chunk->next = g_intern_chunks;
+        chunk->used = 0;
+        chunk->capacity = capacity;
+        g_intern_chunks = chunk;
+    }
+    char *out = chunk->data + chunk->used;
+    chunk->used += size;
+    return out;
+}
+
+const char *string_intern_n(const char *text, size_t len) {
+    if (!text) {
+        return NULL;
+    }
+    uint32_t hash = hash_bytes(text, len);
+    const char *result = NULL;
+
+    pthread_mutex_lock(&g_intern_mutex);
+    HashIndexProbe probe;
+    hash_index_probe_init(&probe, &g_intern_index, hash);
+    for (size_t i; (i = hash_index_probe_next(&probe)) != HASH_INDEX_NONE;) {
+        const char *candidate = g_intern_strings[i];
+        if (strncmp(candidate, text, len) == 0 && candidate[len] == '\0') {
+            result = candidate;
+            break;
+        }
+    }
+    if (!result) {
+        if (g_intern_count == g_intern_capacity) {
+            size_t new_cap = g_intern_capacity == 0 ? 256 : g_intern_capacity * 2;
+            const char **tmp = realloc(g_intern_strings, new_cap * sizeof(const char *));
+            if (!tmp) {
+                pthread_mutex_unlock(&g_intern_mutex);
+                return NULL;
+            }
+            g_intern_strings = tmp;
+            g_intern_capacity = new_cap;
+        }
+        char *copy = intern_alloc(len + 1);
+        if (copy && hash_index_insert(&g_intern_index, hash, g_intern_count)) {
+            memcpy(copy, text, len);
+            copy[len] = '\0';
+            g_intern_strings[g_intern_count++] = copy;
+            result = copy;
+        }
+    }
+    pthread_mutex_unlock(&g_intern_mutex);
+    return result;
+}
+
+const char *string_intern(const char *text) {
+    if (!text) {
+        return NULL;
+    }
+    return string_intern_n(text, strlen(text));
+}
+
+size_t string_intern_count(void) {
+    pthread_mutex_lock(&g_intern_mutex);
+    size_t count = g_intern_count;
+    pthread_mutex_unlock(&g_intern_mutex);
+    return count;
+}
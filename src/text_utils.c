@@ -7,6 +7,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 static const char *const CP1252_REPLACEMENTS[32] = {
     "EUR",  NULL,   ",",    "f",    "\"",   "...",  "+",    "++",
     "^",    "%",    "S",    "<",    "OE",   NULL,   "Z",    NULL,
@@ -14,159 +18,384 @@ static const char *const CP1252_REPLACEMENTS[32] = {
     "~",    "(TM)", "s",    ">",    "oe",   NULL,   "z",    "Y"
 };
 
+/* Decodes one transliteration unit at p and returns the bytes consumed. The out and out_len
+   receive the ASCII replacement, which may be empty when the input is dropped. */
+static size_t ascii_transliterate(const unsigned char *p, size_t len, const char **out, size_t *out_len, char single[2]) {
+    unsigned char c = p[0];
+    single[1] = '\0';
+    *out = single;
+    *out_len = 0;
+    if (c < 0x80) {
+        if (c >= 0x20 || c == '\n' || c == '\t') {
+            single[0] = (char)c;
+            *out_len = 1;
+        }
+        return 1;
+    }
+
+    unsigned int codepoint = 0;
+    size_t advance = 0;
+    if ((c & 0xE0) == 0xC0 && len > 1) {
+        unsigned char c1 = p[1];
+        if ((c1 & 0xC0) == 0x80) {
+            codepoint = ((c & 0x1F) << 6) | (c1 & 0x3F);
+            advance = 1;
+        }
+    } else if ((c & 0xF0) == 0xE0 && len > 2) {
+        unsigned char c1 = p[1];
+        unsigned char c2 = p[2];
+        if (((c1 & 0xC0) == 0x80) && ((c2 & 0xC0) == 0x80)) {
+            codepoint = ((c & 0x0F) << 12) | ((c1 & 0x3F) << 6) | (c2 & 0x3F);
+            advance = 2;
+        }
+    } else if ((c & 0xF8) == 0xF0 && len > 3) {
+        unsigned char c1 = p[1];
+        unsigned char c2 = p[2];
+        unsigned char c3 = p[3];
+        if (((c1 & 0xC0) == 0x80) && ((c2 & 0xC0) == 0x80) && ((c3 & 0xC0) == 0x80)) {
+            codepoint = ((c & 0x07) << 18) | ((c1 & 0x3F) << 12) | ((c2 & 0x3F) << 6) | (c3 & 0x3F);
+            advance = 3;
+        }
+    }
+
+    if (advance > 0) {
+        const char *replacement = NULL;
+        switch (codepoint) {
+            case 0x00A0: single[0] = ' '; replacement = single; break;
+            case 0x00B0: replacement = "deg"; break;
+            case 0x2015: replacement = "--"; break;
+            case 0x2018:
+            case 0x2019:
+            case 0x2032: single[0] = '\''; replacement = single; break;
+            case 0x201C:
+            case 0x201D:
+            case 0x2033: single[0] = '"'; replacement = single; break;
+            case 0x2010:
+            case 0x2011:
+            case 0x2012:
+            case 0x2013: single[0] = '-'; replacement = single; break;
+            case 0x2014:
+                replacement = "--";
+                break;
+            case 0x2212:
+                single[0] = '-';
+                replacement = single;
+                break;
+            case 0x2022: single[0] = '*'; replacement = single; break;
+            case 0x2026: replacement = "..."; break;
+            case 0x2122: replacement = "(TM)"; break;
+            default:
+                if (codepoint < 0x80 && codepoint >= 0x20) {
+                    single[0] = (char)codepoint;
+                    replacement = single;
+                }
+                break;
+        }
+        if (!replacement) {
+            single[0] = '?';
+            replacement = single;
+        }
+        *out = replacement;
+        *out_len = strlen(replacement);
+        return advance + 1;
+    }
+
+    if (c <= 0x9F) {
+        const char *rep = CP1252_REPLACEMENTS[c - 0x80];
+        if (rep) {
+            *out = rep;
+            *out_len = strlen(rep);
+        }
+        return 1;
+    }
+
+    single[0] = '?';
+    *out_len = 1;
+    return 1;
+}
+
 char *sanitize_ascii(const char *text) {
     if (!text) {
         return NULL;
     }
     size_t len = strlen(text);
-    char *out = malloc(len * 4 + 1);
-    if (!out) {
-        return NULL;
-    }
-    size_t o = 0;
-    for (size_t i = 0; i < len; ++i) {
-        unsigned char c = (unsigned char)text[i];
-        if (c == '\r') {
-            continue;
+    Buffer buf = {0};
+    const unsigned char *p = (const unsigned char *)text;
+    size_t i = 0;
+    while (i < len) {
+        size_t run = i;
+        while (run < len && p[run] >= 0x20 && p[run] < 0x80) {
+            run++;
         }
-        if (c < 0x80) {
-            if (c >= 0x20 || c == '\n' || c == '\t') {
-                out[o++] = (char)c;
+        if (run > i) {
+            if (!buffer_append_bytes(&buf, text + i, run - i)) {
+                buffer_free(&buf);
+                return NULL;
             }
+            i = run;
             continue;
         }
+        const char *rep = NULL;
+        size_t rep_len = 0;
+        char single[2];
+        i += ascii_transliterate(p + i, len - i, &rep, &rep_len, single);
+        if (rep_len > 0 && !buffer_append_bytes(&buf, rep, rep_len)) {
+            buffer_free(&buf);
+            return NULL;
+        }
+    }
+    if (!buf.data) {
+        return strdup("");
+    }
+    return buf.data;
+}
 
-        unsigned int codepoint = 0;
-        size_t advance = 0;
-        if ((c & 0xE0) == 0xC0 && i + 1 < len) {
-            unsigned char c1 = (unsigned char)text[i + 1];
-            if ((c1 & 0xC0) == 0x80) {
-                codepoint = ((c & 0x1F) << 6) | (c1 & 0x3F);
-                advance = 1;
-            }
-        } else if ((c & 0xF0) == 0xE0 && i + 2 < len) {
-            unsigned char c1 = (unsigned char)text[i + 1];
-            unsigned char c2 = (unsigned char)text[i + 2];
-            if (((c1 & 0xC0) == 0x80) && ((c2 & 0xC0) == 0x80)) {
-                codepoint = ((c & 0x0F) << 12) | ((c1 & 0x3F) << 6) | (c2 & 0x3F);
-                advance = 2;
-            }
-        } else if ((c & 0xF8) == 0xF0 && i + 3 < len) {
-            unsigned char c1 = (unsigned char)text[i + 1];
-            unsigned char c2 = (unsigned char)text[i + 2];
-            unsigned char c3 = (unsigned char)text[i + 3];
-            if (((c1 & 0xC0) == 0x80) && ((c2 & 0xC0) == 0x80) && ((c3 & 0xC0) == 0x80)) {
-                codepoint = ((c & 0x07) << 18) | ((c1 & 0x3F) << 12) | ((c2 & 0x3F) << 6) | (c3 & 0x3F);
-                advance = 3;
-            }
+static const char *const LATEX_ESCAPES[128] = {
+    ['\\'] = "\\textbackslash{}",
+    ['{'] = "\\{",
+    ['}'] = "\\}",
+    ['#'] = "\\#",
+    ['$'] = "\\$",
+    ['%'] = "\\%",
+    ['&'] = "\\&",
+    ['_'] = "\\_",
+    ['^'] = "\\textasciicircum{}",
+    ['~'] = "\\textasciitilde{}",
+    ['\n'] = "\\\\\n"
+};
+
+static int latex_append_escaped_char(Buffer *buf, unsigned char c) {
+    const char *escape = c < 0x80 ? LATEX_ESCAPES[c] : NULL;
+    if (escape) {
+        return buffer_append_cstr(buf, escape);
+    }
+    if (c < 0x20) {
+        // Skip control characters
+        return 1;
+    }
+    return buffer_append_char(buf, (char)c);
+}
+
+/* Length of the leading run of printable ASCII that passes every enabled stage unchanged. */
+static size_t latex_plain_run(const unsigned char *p, size_t len, bool markdown) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i low = _mm_set1_epi8(0x20);
+    const __m128i star = _mm_set1_epi8(markdown ? '*' : '\\');
+    static const char specials[] = {'\\', '{', '}', '#', '$', '%', '&', '_', '^', '~'};
+    __m128i special_vec[sizeof(specials)];
+    for (size_t k = 0; k < sizeof(specials); ++k) {
+        special_vec[k] = _mm_set1_epi8(specials[k]);
+    }
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        /* Signed compare flags both control bytes and bytes >= 0x80. */
+        __m128i hit = _mm_or_si128(_mm_cmplt_epi8(v, low), _mm_cmpeq_epi8(v, star));
+        for (size_t k = 0; k < sizeof(specials); ++k) {
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, special_vec[k]));
+        }
+        unsigned mask = (unsigned)_mm_movemask_epi8(hit);
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+#endif
+    while (i < len) {
+        unsigned char c = p[i];
+        if (c < 0x20 || c >= 0x80 || LATEX_ESCAPES[c] || (markdown && c == '*')) {
+            break;
         }
+        i++;
+    }
+    return i;
+}
 
-        if (advance > 0) {
-            const char *replacement = NULL;
-            char single[4] = {0};
-            switch (codepoint) {
-                case 0x00A0: single[0] = ' '; replacement = single; break;
-                case 0x00B0: replacement = "deg"; break;
-                case 0x2015: replacement = "--"; break;
-                case 0x2018:
-                case 0x2019:
-                case 0x2032: single[0] = '\''; replacement = single; break;
-                case 0x201C:
-                case 0x201D:
-                case 0x2033: single[0] = '"'; replacement = single; break;
-                case 0x2010:
-                case 0x2011:
-                case 0x2012:
-                case 0x2013: single[0] = '-'; replacement = single; break;
-                case 0x2014:
-                    replacement = "--";
-                    break;
-                case 0x2212:
-                    single[0] = '-';
-                    replacement = single;
-                    break;
-                case 0x2022: single[0] = '*'; replacement = single; break;
-                case 0x2026: replacement = "..."; break;
-                case 0x2122: replacement = "(TM)"; break;
-                default:
-                    if (codepoint < 0x80 && codepoint >= 0x20) {
-                        single[0] = (char)codepoint;
-                        replacement = single;
-                    }
-                    break;
-            }
-            if (replacement) {
-                size_t rep_len = strlen(replacement);
-                memcpy(out + o, replacement, rep_len);
-                o += rep_len;
-            } else {
-                out[o++] = '?';
+typedef struct {
+    Buffer *buf;
+    bool escape;
+    bool markdown;
+    bool pending_star;
+    bool bold_open;
+    bool ok;
+} LatexEmitter;
+
+static void latex_emit(LatexEmitter *em, unsigned char c) {
+    if (em->markdown) {
+        if (em->pending_star) {
+            em->pending_star = false;
+            if (c == '*') {
+                em->ok = em->ok && buffer_append_cstr(em->buf, em->bold_open ? "}" : "\\textbf{");
+                em->bold_open = !em->bold_open;
+                return;
             }
-            i += advance;
-            continue;
+            em->ok = em->ok && buffer_append_char(em->buf, '*');
         }
+        if (c == '*') {
+            em->pending_star = true;
+            return;
+        }
+    }
+    em->ok = em->ok && (em->escape ? latex_append_escaped_char(em->buf, c) : buffer_append_char(em->buf, (char)c));
+}
 
-        if (c >= 0x80 && c <= 0x9F) {
-            const char *rep = CP1252_REPLACEMENTS[c - 0x80];
-            if (rep) {
-                size_t rep_len = strlen(rep);
-                memcpy(out + o, rep, rep_len);
-                o += rep_len;
-            }
-            continue;
+static void latex_emit_finish(LatexEmitter *em) {
+    if (em->pending_star) {
+        em->pending_star = false;
+        em->ok = em->ok && buffer_append_char(em->buf, '*');
+    }
+    if (em->bold_open) {
+        em->bold_open = false;
+        em->ok = em->ok && buffer_append_cstr(em->buf, "}");
+    }
+}
+
+static bool is_acronym_word(const char *text, size_t start, size_t end);
+static bool is_all_upper_alpha(const char *text);
+
+typedef struct {
+    bool start_word;
+    bool word_start_upper;
+    bool streaming;
+    char word[4];
+    size_t word_len;
+} CapsState;
+
+static void caps_flush_word(CapsState *caps, LatexEmitter *em, bool complete) {
+    if (caps->word_len > 0 && !caps->streaming) {
+        bool acronym = complete && is_acronym_word(caps->word, 0, caps->word_len);
+        for (size_t k = 0; k < caps->word_len; ++k) {
+            unsigned char lower = (unsigned char)tolower((unsigned char)caps->word[k]);
+            unsigned char out = (acronym || (k == 0 && caps->word_start_upper)) ? (unsigned char)toupper(lower) : lower;
+            latex_emit(em, out);
         }
+    }
+    caps->word_len = 0;
+    caps->streaming = false;
+}
 
-        out[o++] = '?';
+static void caps_alpha(CapsState *caps, LatexEmitter *em, unsigned char c) {
+    if (caps->streaming) {
+        latex_emit(em, (unsigned char)tolower(c));
+    } else if (caps->word_len < sizeof(caps->word)) {
+        if (caps->word_len == 0) {
+            caps->word_start_upper = caps->start_word;
+        }
+        caps->word[caps->word_len++] = (char)c;
+    } else {
+        /* Longer than any acronym, so the word can stream in title case. */
+        caps_flush_word(caps, em, false);
+        caps->streaming = true;
+        latex_emit(em, (unsigned char)tolower(c));
     }
-    out[o] = '\0';
-    char *trimmed = realloc(out, o + 1);
-    return trimmed ? trimmed : out;
+    caps->start_word = false;
 }
 
-static void latex_append_escaped_char(Buffer *buf, unsigned char c) {
+static void caps_separator(CapsState *caps, LatexEmitter *em, unsigned char c) {
+    caps_flush_word(caps, em, true);
     switch (c) {
-        case '\\': buffer_append_cstr(buf, "\\textbackslash{}"); break;
-        case '{': buffer_append_cstr(buf, "\\{"); break;
-        case '}': buffer_append_cstr(buf, "\\}"); break;
-        case '#': buffer_append_cstr(buf, "\\#"); break;
-        case '$': buffer_append_cstr(buf, "\\$"); break;
-        case '%': buffer_append_cstr(buf, "\\%"); break;
-        case '&': buffer_append_cstr(buf, "\\&"); break;
-        case '_': buffer_append_cstr(buf, "\\_"); break;
-        case '^': buffer_append_cstr(buf, "\\textasciicircum{}"); break;
-        case '~': buffer_append_cstr(buf, "\\textasciitilde{}"); break;
-        case '\n': buffer_append_cstr(buf, "\\\\\n"); break;
+        case ' ':
+        case '\t':
+        case '\n':
+        case '-':
+        case '/':
+        case '(':
+        case ')':
+        case '\'':
+        case '&':
+        case '.':
+            caps->start_word = true;
+            break;
         default:
-            if (c < 0x20) {
-                // Skip control characters
-            } else {
-                buffer_append_char(buf, (char)c);
-            }
+            caps->start_word = false;
             break;
     }
 }
 
-char *latex_escape(const char *text) {
+static int append_text(Buffer *buf, const char *text, unsigned flags, bool escape) {
+    if (!buf) {
+        return 0;
+    }
     if (!text) {
-        return strdup("");
+        return 1;
     }
+    size_t len = strlen(text);
+    const unsigned char *p = (const unsigned char *)text;
+    LatexEmitter em = {buf, escape, escape && (flags & LATEX_TEXT_MARKDOWN) != 0, false, false, true};
+    CapsState caps = {true, false, false, {0}, 0};
+    bool title_case = (flags & LATEX_TEXT_NORMALIZE_CAPS) && is_all_upper_alpha(text);
+    bool sanitize = (flags & LATEX_TEXT_SANITIZE) != 0;
+
+    size_t i = 0;
+    while (i < len && em.ok) {
+        if (!title_case && !em.pending_star) {
+            size_t run = latex_plain_run(p + i, len - i, em.markdown);
+            if (run > 0) {
+                if (!buffer_append_bytes(buf, text + i, run)) {
+                    return 0;
+                }
+                i += run;
+                continue;
+            }
+        }
+        unsigned char c = p[i];
+        if (title_case) {
+            if (isalpha(c)) {
+                caps_alpha(&caps, &em, c);
+                i++;
+                continue;
+            }
+            caps_separator(&caps, &em, c);
+        }
+        if (!sanitize) {
+            latex_emit(&em, c);
+            i++;
+            continue;
+        }
+        const char *rep = NULL;
+        size_t rep_len = 0;
+        char single[2];
+        size_t consumed = ascii_transliterate(p + i, len - i, &rep, &rep_len, single);
+        if (title_case && consumed > 1) {
+            caps.start_word = false;
+        }
+        for (size_t k = 0; k < rep_len; ++k) {
+            latex_emit(&em, (unsigned char)rep[k]);
+        }
+        i += consumed;
+    }
+    caps_flush_word(&caps, &em, true);
+    latex_emit_finish(&em);
+    return em.ok;
+}
+
+int latex_append_text(Buffer *buf, const char *text, unsigned flags) {
+    return append_text(buf, text, flags, true);
+}
+
+int ascii_append_text(Buffer *buf, const char *text, unsigned flags) {
+    return append_text(buf, text, flags, false);
+}
+
+static char *append_text_copy(const char *text, unsigned flags) {
     Buffer buf;
     if (!buffer_init(&buf)) {
         return NULL;
     }
-    for (const unsigned char *ptr = (const unsigned char *)text; *ptr; ++ptr) {
-        latex_append_escaped_char(&buf, *ptr);
+    if (!ascii_append_text(&buf, text, flags)) {
+        buffer_free(&buf);
+        return NULL;
     }
-    char *escaped = buf.data;
-    buf.data = NULL;
-    buffer_free(&buf);
-    if (!escaped) {
-        escaped = strdup("");
+    return buf.data;
+}
+
+char *sanitize_ascii_caps(const char *text) {
+    if (!text) {
+        return NULL;
     }
-    return escaped;
+    return append_text_copy(text, LATEX_TEXT_SANITIZE | LATEX_TEXT_NORMALIZE_CAPS);
 }
 
-char *latex_escape_with_markdown(const char *text) {
+char *latex_escape(const char *text) {
     if (!text) {
         return strdup("");
     }
@@ -174,31 +403,26 @@ char *latex_escape_with_markdown(const char *text) {
     if (!buffer_init(&buf)) {
         return NULL;
     }
-    bool bold_open = false;
-    for (size_t i = 0; text[i]; ++i) {
-        unsigned char c = (unsigned char)text[i];
-        if (c == '*' && text[i + 1] == '*') {
-            if (bold_open) {
-                buffer_append_cstr(&buf, "}");
-            } else {
-                buffer_append_cstr(&buf, "\\textbf{");
-            }
-            bold_open = !bold_open;
-            ++i;
-            continue;
-        }
-        latex_append_escaped_char(&buf, c);
+    if (!latex_append_text(&buf, text, 0)) {
+        buffer_free(&buf);
+        return NULL;
+    }
+    return buf.data;
+}
+
+char *latex_escape_with_markdown(const char *text) {
+    if (!text) {
+        return strdup("");
     }
-    if (bold_open) {
-        buffer_append_cstr(&buf, "}");
+    Buffer buf;
+    if (!buffer_init(&buf)) {
+        return NULL;
     }
-    char *escaped = buf.data;
-    buf.data = NULL;
-    buffer_free(&buf);
-    if (!escaped) {
-        escaped = strdup("");
+    if (!latex_append_text(&buf, text, LATEX_TEXT_MARKDOWN)) {
+        buffer_free(&buf);
+        return NULL;
     }
-    return escaped;
+    return buf.data;
 }
 
 static bool is_all_upper_alpha(const char *text) {
@@ -247,67 +471,7 @@ char *normalize_caps_if_all_upper(const char *text) {
     if (!text) {
         return NULL;
     }
-    if (!is_all_upper_alpha(text)) {
-        char *copy = strdup(text);
-        return copy;
-    }
-
-    size_t len = strlen(text);
-    char *result = malloc(len + 1);
-    if (!result) {
-        return NULL;
-    }
-
-    bool start_word = true;
-    for (size_t i = 0; i < len; ++i) {
-        unsigned char orig = (unsigned char)text[i];
-        if (isalpha(orig)) {
-            unsigned char lower = (unsigned char)tolower(orig);
-            result[i] = (char)(start_word ? toupper(lower) : lower);
-            start_word = false;
-        } else {
-            result[i] = (char)orig;
-            switch (orig) {
-                case ' ':
-                case '\t':
-                case '\n':
-                case '-':
-                case '/':
-                case '(':
-                case ')':
-                case '\'':
-                case '&':
-                case '.':
-                    start_word = true;
-                    break;
-                default:
-                    start_word = false;
-                    break;
-            }
-        }
-    }
-    result[len] = '\0';
-
-    size_t pos = 0;
-    while (pos < len) {
-        while (pos < len && !isalpha((unsigned char)text[pos])) {
-            pos++;
-        }
-        size_t word_start = pos;
-        while (pos < len && isalpha((unsigned char)text[pos])) {
-            pos++;
-        }
-        size_t word_end = pos;
-        if (word_end > word_start && is_all_upper_alpha(text + word_start)) {
-            if (is_acronym_word(text, word_start, word_end)) {
-                for (size_t j = word_start; j < word_end; ++j) {
-                    result[j] = (char)toupper((unsigned char)result[j]);
-                }
-            }
-        }
-    }
-
-    return result;
+    return append_text_copy(text, LATEX_TEXT_NORMALIZE_CAPS);
 }
 
 void normalize_caps_inplace(char **text) {
@@ -0,0 +1,469 @@
+#include "zip_writer.h"
+
+#include "hash_index.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#define ZIP_OUTPUT_BUFFER_SIZE (64 * 1024)
+#define ZIP_FILE_BLOCK_SIZE (256 * 1024)
+#define ZIP32_LIMIT 0xFFFFFFFFu
+#define ZIP16_LIMIT 0xFFFFu
+#define ZIP_VERSION_DEFAULT 20
+#define ZIP_VERSION_ZIP64 45
+/* Made by Unix (3) so the external attributes carry a file mode. */
+#define ZIP_MADE_BY ((3 << 8) | ZIP_VERSION_ZIP64)
+
+typedef struct {
+    char *name;
+    uint32_t crc;
+    uint64_t compressed_size;
+    uint64_t size;
+    uint64_t offset;
+    uint16_t method;
+} ZipEntry;
+
+struct ZipWriter {
+    ZipSinkFn sink;
+    void *ctx;
+    unsigned char out[ZIP_OUTPUT_BUFFER_SIZE];
+    size_t out_used;
+    uint64_t offset;
+    bool failed;
+    bool finished;
+    uint16_t dos_time;
+    uint16_t dos_date;
+    ZipEntry *entries;
+    size_t count;
+    size_t capacity;
+    HashIndex names;
+};
+
+static void zip_set_error(char **error_out, const char *message) {
+    if (error_out && !*error_out) {
+        *error_out = strdup(message);
+    }
+}
+
+static int zip_flush(ZipWriter *zw) {
+    if (zw->out_used > 0 && !zw->failed) {
+        if (!zw->sink(zw->ctx, zw->out, zw->out_used)) {
+            zw->failed = true;
+        }
+    }
+    zw->out_used = 0;
+    return !zw->failed;
+}
+
+/* Small header writes are batched; large entry bodies bypass the buffer. */
+static int zip_emit(ZipWriter *zw, const void *data, size_t len) {
+    if (zw->failed) {
+        return 0;
+    }
+    if (len > sizeof(zw->out) - zw->out_used && !zip_flush(zw)) {
+        return 0;
+    }
+    if (len >= sizeof(zw->out)) {
+        if (!zw->sink(zw->ctx, data, len)) {
+            zw->failed = true;
+            return 0;
+        }
+    } else {
+        memcpy(zw->out + zw->out_used, data, len);
+        zw->out_used += len;
+    }
+    zw->offset += len;
+    return 1;
+}
+
+static unsigned char *put_u16(unsigned char *p, uint16_t v) {
+    p[0] = (unsigned char)(v & 0xFF);
+    p[1] = (unsigned char)(v >> 8);
+    return p + 2;
+}
+
+static unsigned char *put_u32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+    return p + 4;
+}
+
+static unsigned char *put_u64(unsigned char *p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+    return p + 8;
+}
+
+static uint32_t clamp32(uint64_t v) {
+    return v >= ZIP32_LIMIT ? ZIP32_LIMIT : (uint32_t)v;
+}
+
+ZipWriter *zip_writer_create(ZipSinkFn sink, void *ctx) {
+    if (!sink) {
+        return NULL;
+    }
+    ZipWriter *zw = calloc(1, sizeof(*zw));
+    if (!zw) {
+        return NULL;
+    }
+    zw->sink = sink;
+    zw->ctx = ctx;
+    hash_index_init(&zw->names);
+
+    time_t now = time(NULL);
+    struct tm tm_now;
+    if (localtime_r(&now, &tm_now) && tm_now.tm_year >= 80) {
+        zw->dos_time = (uint16_t)((tm_now.tm_hour << 11) | (tm_now.tm_min << 5) | (tm_now.tm_sec / 2));
+        zw->dos_date = (uint16_t)(((tm_now.tm_year - 80) << 9) | ((tm_now.tm_mon + 1) << 5) | tm_now.tm_mday);
+    } else {
+        zw->dos_date = (1 << 5) | 1;
+    }
+    return zw;
+}
+
+void zip_writer_free(ZipWriter *zw) {
+    if (!zw) {
+        return;
+    }
+    for (size_t i = 0; i < zw->count; ++i) {
+        free(zw->entries[i].name);
+    }
+    free(zw->entries);
+    hash_index_clear(&zw->names);
+    free(zw);
+}
+
+ZipMethod zip_method_for_name(const char *name) {
+    static const char *const compressed_exts[] = {
+        ".jpg", ".jpeg", ".png", ".gif", ".webp", ".heic", ".heif", ".pdf", ".zip", ".gz", ".mp4", ".mov"
+    };
+    const char *ext = name ? strrchr(name, '.') : NULL;
+    if (!ext) {
+        return ZIP_METHOD_DEFLATE;
+    }
+    for (size_t i = 0; i < sizeof(compressed_exts) / sizeof(compressed_exts[0]); ++i) {
+        if (strcasecmp(ext, compressed_exts[i]) == 0) {
+            return ZIP_METHOD_STORE;
+        }
+    }
+    return ZIP_METHOD_DEFLATE;
+}
+
+bool zip_writer_contains(const ZipWriter *zw, const char *name) {
+    if (!zw || !name) {
+        return false;
+    }
+    HashIndexProbe probe;
+    hash_index_probe_init(&probe, &zw->names, hash_string(name));
+    for (size_t i; (i = hash_index_probe_next(&probe)) != HASH_INDEX_NONE;) {
+        if (strcmp(zw->entries[i].name, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Records the entry for the central directory and writes its local header. */
+static int zip_begin_entry(ZipWriter *zw, const char *name, uint16_t method, uint32_t crc, uint64_t compressed_size, uint64_t size, char **error_out) {
+    size_t name_len = strlen(name);
+    if (name_len == 0 || name_len > ZIP16_LIMIT) {
+        zip_set_error(error_out, "Invalid archive entry name");
+        return 0;
+    }
+    if (zip_writer_contains(zw, name)) {
+        zip_set_error(error_out, "Duplicate archive entry name");
+        return 0;
+    }
+    if (zw->count == zw->capacity) {
+        size_t new_cap = zw->capacity == 0 ? 32 : zw->capacity * 2;
+        ZipEntry *tmp = realloc(zw->entries, new_cap * sizeof(*tmp));
+        if (!tmp) {
+            zip_set_error(error_out, "Out of memory adding archive entry");
+            return 0;
+        }
+        zw->entries = tmp;
+        zw->capacity = new_cap;
+    }
+    char *name_copy = strdup(name);
+    if (!name_copy || !hash_index_insert(&zw->names, hash_string(name), zw->count)) {
+        free(name_copy);
+        zip_set_error(error_out, "Out of memory adding archive entry");
+        return 0;
+    }
+    ZipEntry *entry = &zw->entries[zw->count++];
+    entry->name = name_copy;
+    entry->crc = crc;
+    entry->compressed_size = compressed_size;
+    entry->size = size;
+    entry->offset = zw->offset;
+    entry->method = method;
+
+    bool zip64 = size >= ZIP32_LIMIT || compressed_size >= ZIP32_LIMIT;
+    unsigned char header[30 + 20];
+    unsigned char *p = header;
+    p = put_u32(p, 0x04034b50);
+    p = put_u16(p, zip64 ? ZIP_VERSION_ZIP64 : ZIP_VERSION_DEFAULT);
+    p = put_u16(p, 0);
+    p = put_u16(p, method);
+    p = put_u16(p, zw->dos_time);
+    p = put_u16(p, zw->dos_date);
+    p = put_u32(p, crc);
+    p = put_u32(p, zip64 ? ZIP32_LIMIT : (uint32_t)compressed_size);
+    p = put_u32(p, zip64 ? ZIP32_LIMIT : (uint32_t)size);
+    p = put_u16(p, (uint16_t)name_len);
+    p = put_u16(p, zip64 ? 20 : 0);
+    unsigned char extra[20];
+    unsigned char *e = extra;
+    if (zip64) {
+        e = put_u16(e, 0x0001);
+        e = put_u16(e, 16);
+        e = put_u64(e, size);
+        e = put_u64(e, compressed_size);
+    }
+    if (!zip_emit(zw, header, (size_t)(p - header)) || !zip_emit(zw, name, name_len) ||
+        !zip_emit(zw, extra, (size_t)(e - extra))) {
+        zip_set_error(error_out, "Failed to write archive");
+        return 0;
+    }
+    return 1;
+}
+
+static uint32_t zip_crc32(uint32_t crc, const unsigned char *data, size_t len) {
+    /* zlib takes uInt lengths, so very large buffers go through in slices. */
+    while (len > 0) {
+        uInt slice = len > UINT_MAX ? UINT_MAX : (uInt)len;
+        crc = (uint32_t)crc32(crc, data, slice);
+        data += slice;
+        len -= slice;
+    }
+    return crc;
+}
+
+static int zip_deflate(const unsigned char *data, size_t len, unsigned char **out, size_t *out_len) {
+    *out = NULL;
+    *out_len = 0;
+    if (len > UINT_MAX) {
+        return 0;
+    }
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    /* Negative window bits give the raw deflate stream ZIP expects, without zlib framing. */
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return 0;
+    }
+    uLong bound = deflateBound(&stream, (uLong)len);
+    unsigned char *buffer = malloc(bound > 0 ? bound : 1);
+    if (!buffer) {
+        deflateEnd(&stream);
+        return 0;
+    }
+    stream.next_in = (Bytef *)data;
+    stream.avail_in = (uInt)len;
+    stream.next_out = buffer;
+    stream.avail_out = (uInt)bound;
+    int rc = deflate(&stream, Z_FINISH);
+    size_t produced = stream.total_out;
+    deflateEnd(&stream);
+    if (rc != Z_STREAM_END) {
+        free(buffer);
+        return 0;
+    }
+    *out = buffer;
+    *out_len = produced;
+    return 1;
+}
+
+int zip_writer_add(ZipWriter *zw, const char *name, const void *data, size_t len, ZipMethod method, char **error_out) {
+    if (!zw || !name || (!data && len > 0) || zw->finished) {
+        zip_set_error(error_out, "Invalid archive entry");
+        return 0;
+    }
+    const unsigned char *bytes = (const unsigned char *)data;
+    uint32_t crc = zip_crc32((uint32_t)crc32(0L, Z_NULL, 0), bytes, len);
+    unsigned char *compressed = NULL;
+    size_t compressed_len = 0;
+    if (method == ZIP_METHOD_DEFLATE && len > 0 &&
+        (!zip_deflate(bytes, len, &compressed, &compressed_len) || compressed_len >= len)) {
+        free(compressed);
+        compressed = NULL;
+    }
+    int ok;
+    if (compressed) {
+        ok = zip_begin_entry(zw, name, ZIP_METHOD_DEFLATE, crc, compressed_len, len, error_out) &&
+             zip_emit(zw, compressed, compressed_len);
+    } else {
+        ok = zip_begin_entry(zw, name, ZIP_METHOD_STORE, crc, len, len, error_out) &&
+             (len == 0 || zip_emit(zw, bytes, len));
+    }
+    free(compressed);
+    if (!ok) {
+        zip_set_error(error_out, "Failed to write archive");
+    }
+    return ok;
+}
+
+int zip_writer_add_file(ZipWriter *zw, const char *name, const char *path, char **error_out) {
+    if (!zw || !name || !path || zw->finished) {
+        zip_set_error(error_out, "Invalid archive entry");
+        return 0;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        zip_set_error(error_out, "Failed to open archive source file");
+        return 0;
+    }
+    unsigned char *block = malloc(ZIP_FILE_BLOCK_SIZE);
+    if (!block) {
+        close(fd);
+        zip_set_error(error_out, "Out of memory reading archive source file");
+        return 0;
+    }
+
+    int ok = 0;
+    uint32_t crc = (uint32_t)crc32(0L, Z_NULL, 0);
+    uint64_t size = 0;
+    for (;;) {
+        ssize_t n = read(fd, block, ZIP_FILE_BLOCK_SIZE);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            zip_set_error(error_out, "Failed to read archive source file");
+            goto cleanup;
+        }
+        if (n == 0) break;
+        crc = zip_crc32(crc, block, (size_t)n);
+        size += (uint64_t)n;
+    }
+    if (lseek(fd, 0, SEEK_SET) != 0 || !zip_begin_entry(zw, name, ZIP_METHOD_STORE, crc, size, size, error_out)) {
+        zip_set_error(error_out, "Failed to read archive source file");
+        goto cleanup;
+    }
+    uint64_t remaining = size;
+    while (remaining > 0) {
+        ssize_t n = read(fd, block, ZIP_FILE_BLOCK_SIZE);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            /* The header already promised size bytes; a shrinking file would corrupt the archive. */
+            zw->failed = true;
+            zip_set_error(error_out, "Archive source file changed while reading");
+            goto cleanup;
+        }
+        size_t chunk = (uint64_t)n > remaining ? (size_t)remaining : (size_t)n;
+        if (!zip_emit(zw, block, chunk)) {
+            zip_set_error(error_out, "Failed to write archive");
+            goto cleanup;
+        }
+        remaining -= chunk;
+    }
+    ok = 1;
+
+cleanup:
+    free(block);
+    close(fd);
+    return ok;
+}
+
+int zip_writer_finish(ZipWriter *zw, char **error_out) {
+    if (!zw || zw->finished) {
+        zip_set_error(error_out, "Invalid archive");
+        return 0;
+    }
+    zw->finished = true;
+    uint64_t cd_offset = zw->offset;
+    for (size_t i = 0; i < zw->count; ++i) {
+        const ZipEntry *entry = &zw->entries[i];
+        bool big_size = entry->size >= ZIP32_LIMIT;
+        bool big_compressed = entry->compressed_size >= ZIP32_LIMIT;
+        bool big_offset = entry->offset >= ZIP32_LIMIT;
+        /* The ZIP64 extra lists only the fields saturated in the fixed header, in this order. */
+        unsigned char extra[4 + 24];
+        unsigned char *e = extra;
+        if (big_size || big_compressed || big_offset) {
+            e = put_u16(e, 0x0001);
+            e = put_u16(e, (uint16_t)(8 * (big_size + big_compressed + big_offset)));
+            if (big_size) e = put_u64(e, entry->size);
+            if (big_compressed) e = put_u64(e, entry->compressed_size);
+            if (big_offset) e = put_u64(e, entry->offset);
+        }
+        size_t name_len = strlen(entry->name);
+        unsigned char header[46];
+        unsigned char *p = header;
+        p = put_u32(p, 0x02014b50);
+        p = put_u16(p, ZIP_MADE_BY);
+        p = put_u16(p, e != extra ? ZIP_VERSION_ZIP64 : ZIP_VERSION_DEFAULT);
+        p = put_u16(p, 0);
+        p = put_u16(p, entry->method);
+        p = put_u16(p, zw->dos_time);
+        p = put_u16(p, zw->dos_date);
+        p = put_u32(p, entry->crc);
+        p = put_u32(p, clamp32(entry->compressed_size));
+        p = put_u32(p, clamp32(entry->size));
+        p = put_u16(p, (uint16_t)name_len);
+        p = put_u16(p, (uint16_t)(e - extra));
+        p = put_u16(p, 0);
+        p = put_u16(p, 0);
+        p = put_u16(p, 0);
+        p = put_u32(p, (uint32_t)0100644 << 16);
+        p = put_u32(p, clamp32(entry->offset));
+        if (!zip_emit(zw, header, sizeof(header)) || !zip_emit(zw, entry->name, name_len) ||
+            !zip_emit(zw, extra, (size_t)(e - extra))) {
+            zip_set_error(error_out, "Failed to write archive");
+            return 0;
+        }
+    }
+    uint64_t cd_size = zw->offset - cd_offset;
+
+    if (zw->count >= ZIP16_LIMIT || cd_offset >= ZIP32_LIMIT || cd_size >= ZIP32_LIMIT) {
+        uint64_t record_offset = zw->offset;
+        unsigned char record[56 + 20];
+        unsigned char *p = record;
+        p = put_u32(p, 0x06064b50);
+        p = put_u64(p, 44);
+        p = put_u16(p, ZIP_MADE_BY);
+        p = put_u16(p, ZIP_VERSION_ZIP64);
+        p = put_u32(p, 0);
+        p = put_u32(p, 0);
+        p = put_u64(p, zw->count);
+        p = put_u64(p, zw->count);
+        p = put_u64(p, cd_size);
+        p = put_u64(p, cd_offset);
+        p = put_u32(p, 0x07064b50);
+        p = put_u32(p, 0);
+        p = put_u64(p, record_offset);
+        p = put_u32(p, 1);
+        if (!zip_emit(zw, record, (size_t)(p - record))) {
+            zip_set_error(error_out, "Failed to write archive");
+            return 0;
+        }
+    }
+
+    unsigned char end[22];
+    unsigned char *p = end;
+    p = put_u32(p, 0x06054b50);
+    p = put_u16(p, 0);
+    p = put_u16(p, 0);
+    p = put_u16(p, zw->count >= ZIP16_LIMIT ? ZIP16_LIMIT : (uint16_t)zw->count);
+    p = put_u16(p, zw->count >= ZIP16_LIMIT ? ZIP16_LIMIT : (uint16_t)zw->count);
+    p = put_u32(p, clamp32(cd_size));
+    p = put_u32(p, clamp32(cd_offset));
+    p = put_u16(p, 0);
+    if (!zip_emit(zw, end, sizeof(end)) || !zip_flush(zw)) {
+        zip_set_error(error_out, "Failed to write archive");
+        return 0;
+    }
+    return 1;
+}
+
+uint64_t zip_writer_bytes_written(const ZipWriter *zw) {
+    return zw ? zw->offset : 0;
+}